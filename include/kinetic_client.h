@@ -263,4 +263,80 @@ KineticStatus KineticClient_P2POperation(KineticSession* const session,
                                          KineticP2P_Operation* const p2pOp,
                                          KineticCompletionClosure* closure);
 
+/**
+ * @brief Reports the GET value verification counters for a session.
+ *
+ * @param session       The KineticSession to report on
+ * @param stats         KineticTagStats to populate
+ *
+ * @return              Returns the resulting KineticStatus
+ */
+KineticStatus KineticClient_GetTagStats(KineticSession* const session,
+                                        KineticTagStats* const stats);
+
+/**
+ * @brief Reports the response HMAC validation counters for a session.
+ *
+ * @param session       The KineticSession to report on
+ * @param stats         KineticResponseAuthStats to populate
+ *
+ * @return              Returns the resulting KineticStatus
+ */
+KineticStatus KineticClient_GetResponseAuthStats(KineticSession* const session,
+                                                 KineticResponseAuthStats* const stats);
+
+/**
+ * @brief Reports operation statistics for a session: latency histograms,
+ * byte counts and completion statuses, in total and per message type.
+ *
+ * Counters are updated lock-free as operations complete. Resetting a
+ * session's counters also removes them from its client's statistics.
+ *
+ * @param session       The KineticSession to report on
+ * @param stats         KineticStats to populate
+ * @param reset         If true, the counters are zeroed as they are read
+ *
+ * @return              Returns the resulting KineticStatus
+ */
+KineticStatus KineticClient_GetSessionStats(KineticSession* const session,
+                                           KineticStats* const stats, bool reset);
+
+/**
+ * @brief Reports operation statistics for all sessions of a client, including
+ * sessions already destroyed (see `KineticClient_GetSessionStats`).
+ *
+ * @param client        The KineticClient to report on
+ * @param stats         KineticStats to populate
+ * @param reset         If true, the counters are zeroed as they are read, so
+ *                      successive calls report intervals
+ *
+ * @return              Returns the resulting KineticStatus
+ */
+KineticStatus KineticClient_GetStats(KineticClient* const client,
+                                     KineticStats* const stats, bool reset);
+
+/**
+ * @brief Starts or stops recording per-operation traces.
+ *
+ * While enabled, the time each operation spends in each stage (build, pack,
+ * HMAC, send turn, throttle, socket write, listener match, threadpool queue
+ * wait, unpack and callback) is recorded into a ring buffer per thread,
+ * which retains the most recent spans.
+ *
+ * @param enable        true to record traces, false to stop
+ */
+void KineticClient_SetTracing(bool enable);
+
+/**
+ * @brief Writes the recorded operation traces to a file.
+ *
+ * @param path          Path of the file to write
+ * @param format        KINETIC_TRACE_FORMAT_CHROME for a Chrome trace-event
+ *                      JSON file, or KINETIC_TRACE_FORMAT_FOLDED for folded
+ *                      stacks to render with vendor/FlameGraph/flamegraph.pl
+ *
+ * @return              Returns the resulting KineticStatus
+ */
+KineticStatus KineticClient_WriteTrace(const char* path, KineticTraceFormat format);
+
 #endif // _KINETIC_CLIENT_H
@@ -73,10 +73,10 @@
 typedef enum _KineticAlgorithm {
     KINETIC_ALGORITHM_INVALID = -1, ///< Invalid algorithm value
     KINETIC_ALGORITHM_SHA1 = 2,     ///< SHA1
-    KINETIC_ALGORITHM_SHA2 = 3,     ///< SHA2
-    KINETIC_ALGORITHM_SHA3 = 4,     ///< SHA3
-    KINETIC_ALGORITHM_CRC32 = 5,    ///< CRC32
-    KINETIC_ALGORITHM_CRC64 = 6     ///< CRC64
+    KINETIC_ALGORITHM_SHA2 = 3,     ///< SHA2 (SHA-256)
+    KINETIC_ALGORITHM_SHA3 = 4,     ///< SHA3 (SHA3-256)
+    KINETIC_ALGORITHM_CRC32 = 5,    ///< CRC32 (CRC-32C)
+    KINETIC_ALGORITHM_CRC64 = 6     ///< CRC64 (CRC-64/XZ)
 } KineticAlgorithm;
 
 
@@ -142,6 +142,15 @@ typedef struct _KineticSessionConfig {
 
     /// Operation timeout. If 0, use the default (10 seconds).
     uint16_t timeoutSeconds;
+
+    /// Set to `true' to verify every value received by a GET against the
+    /// tag stored with it (see `KineticEntry.verifyTag`)
+    bool verifyTags;
+
+    /// Set to `true' to authenticate responses to HMAC-signed requests by
+    /// their HMAC. Responses which fail fail their operation with
+    /// `KINETIC_STATUS_HMAC_FAILURE`.
+    bool verifyResponseHmac;
 } KineticSessionConfig;
 
 /**
@@ -188,6 +197,7 @@ typedef enum {
     KINETIC_STATUS_INVALID_LOG_TYPE,        ///< The device log type specified was invalid
     KINETIC_STATUS_HMAC_FAILURE,            ///< An HMAC validation error was detected
     KINETIC_STATUS_SESSION_TERMINATED,      ///< The session has been terminated by the Kinetic device
+    KINETIC_STATUS_TAG_MISMATCH,            ///< A received value did not match its tag
     KINETIC_STATUS_COUNT                    ///< Number of status codes in KineticStatusDescriptor
 } KineticStatus;
 
@@ -200,14 +210,35 @@ typedef enum {
  */
 const char* Kinetic_GetStatusDescription(KineticStatus status);
 
+/**
+ * @brief Monotonic timestamps of an operation's progress through the client,
+ * in nanoseconds
+ *
+ * A stage the operation never reached is 0. The difference between two
+ * successive stages is the time spent between them, e.g. `throttled - sendTurn`
+ * is the wait for the session's limit on outstanding operations, and
+ * `received - sent` is mostly time spent on the device.
+ */
+typedef struct _KineticOperationTimestamps {
+    uint64_t submitted;     ///< Request submitted
+    uint64_t sendTurn;      ///< Request packed and signed, and its turn to be sent came up
+    uint64_t throttled;     ///< A slot under the session's outstanding operation limit was taken
+    uint64_t sent;          ///< Request written to the socket
+    uint64_t received;      ///< Response read and matched to the request by a listener thread
+    uint64_t queued;        ///< Response queued for a worker thread
+    uint64_t dequeued;      ///< Response picked up by a worker thread
+    uint64_t completed;     ///< Response unpacked and checked, just before the completion callback
+} KineticOperationTimestamps;
+
 /**
  * @brief Completion data which will be provided to KineticCompletionClosure for asynchronous operations.
  */
 typedef struct _KineticCompletionData {
     int64_t connectionID;       ///< Connection ID for the session
     int64_t sequence;           ///< Sequence count for the operation
-    struct timeval requestTime; ///< Time at which the operation request was queued up
+    struct timeval requestTime; ///< Unused; see timestamps
     KineticStatus status;       ///< Resultant status of the operation
+    KineticOperationTimestamps timestamps;  ///< When the operation reached each stage
 } KineticCompletionData;
 
 /**
@@ -227,6 +258,39 @@ typedef struct _KineticCompletionClosure {
     void* clientData;                   ///< Optional client-supplied data which will be supplied to callback
 } KineticCompletionClosure;
 
+/**
+ * @brief Export formats for operation traces (see `KineticClient_WriteTrace`)
+ */
+typedef enum {
+    KINETIC_TRACE_FORMAT_CHROME = 0,    ///< Chrome trace-event JSON (chrome://tracing, Perfetto)
+    KINETIC_TRACE_FORMAT_FOLDED,        ///< Folded stacks for FlameGraph's flamegraph.pl
+} KineticTraceFormat;
+
+/**
+ * @brief Counters for GET value verification on a session (see `KineticEntry.verifyTag`)
+ */
+typedef struct _KineticTagStats {
+    uint64_t verified;          ///< Values which matched their tag
+    uint64_t mismatched;        ///< Values rejected with `KINETIC_STATUS_TAG_MISMATCH`
+    uint64_t skipped;           ///< Values which could not be verified, having no tag or an unsupported algorithm
+    uint64_t bytes;             ///< Value bytes checked
+    uint64_t nanoseconds;       ///< Time spent copying and checking values; bytes/nanoseconds is the verification throughput
+} KineticTagStats;
+
+/**
+ * @brief Counters for response HMAC validation on a session (see
+ * `KineticSessionConfig.verifyResponseHmac`)
+ *
+ * Validation runs on the worker threads as its own stage, before the
+ * operation callback; nanoseconds / (validated + failed) is its mean latency.
+ */
+typedef struct _KineticResponseAuthStats {
+    uint64_t validated;         ///< Responses with a valid HMAC
+    uint64_t failed;            ///< Responses rejected with `KINETIC_STATUS_HMAC_FAILURE`
+    uint64_t nanoseconds;       ///< Time spent validating
+    uint64_t maxNanoseconds;    ///< Longest single validation
+} KineticResponseAuthStats;
+
 /**
  * @brief Kinetic object instance
  *
@@ -245,7 +309,8 @@ typedef struct _KineticEntry {
     ByteBuffer newVersion;      ///< New version for the object to assume once written to disk (optional)
     bool metadataOnly;          ///< If set for a GET request, will return only the metadata for the specified object (`value` will not be retrieved)
     bool force;                 ///< If set for a GET/DELETE request, will override `version` checking
-    bool computeTag;            ///< If set and an algorithm is specified, the tag will be populated with the calculated hash for integrity checking
+    bool computeTag;            ///< If set for a PUT request, the tag will be populated with the hash of the value per `algorithm` (`tag` must hold up to 32 bytes)
+    bool verifyTag;             ///< If set for a GET request, the value will be checked against the returned `tag`, failing with `KINETIC_STATUS_TAG_MISMATCH`
     KineticSynchronization synchronization; ///< Synchronization method to use for PUT/DELETE requests.
 } KineticEntry;
 
@@ -392,6 +457,50 @@ typedef enum {
     KINETIC_MESSAGE_TYPE_MEDIAOPTIMIZE,             ///< MEDIAOPTIMIZE
 } KineticMessageType;
 
+#define KINETIC_MESSAGE_TYPE_COUNT (KINETIC_MESSAGE_TYPE_MEDIAOPTIMIZE + 1)
+
+/**
+ * @brief Number of buckets in a `KineticLatencyHistogram`
+ *
+ * Bucket i < 8 counts latencies of exactly i nanoseconds. Above that, each
+ * power of two is split into 8 equal buckets, so a bucket's width is at most
+ * 1/8 of its lower bound. The last bucket also counts everything over 2^36 ns.
+ */
+#define KINETIC_LATENCY_BUCKETS (272)
+
+/**
+ * @brief Log-bucketed latency histogram, in nanoseconds
+ */
+typedef struct _KineticLatencyHistogram {
+    uint64_t count;                             ///< Latencies recorded
+    uint64_t sumNanoseconds;                    ///< Sum of all latencies; sumNanoseconds/count is the mean
+    uint64_t maxNanoseconds;                    ///< Longest latency
+    uint64_t buckets[KINETIC_LATENCY_BUCKETS];  ///< Latencies per bucket (see `KINETIC_LATENCY_BUCKETS`)
+} KineticLatencyHistogram;
+
+/**
+ * @brief Completion counters for one message type, or for all of them
+ *
+ * Latency runs from the request being submitted until just before its
+ * completion callback is called, so it includes throttling, packing, the
+ * device and the response queues, but not the callback itself.
+ */
+typedef struct _KineticOperationStats {
+    uint64_t bytesSent;                             ///< Request PDU bytes, including values
+    uint64_t bytesReceived;                         ///< Response PDU bytes, including values
+    uint64_t statusCounts[KINETIC_STATUS_COUNT];    ///< Completions per `KineticStatus`
+    uint64_t invalidStatusCount;                    ///< Completions with `KINETIC_STATUS_INVALID` or an unknown status
+    KineticLatencyHistogram latency;                ///< Latency of all completions
+} KineticOperationStats;
+
+/**
+ * @brief Operation statistics for a session or a client (see `KineticClient_GetStats`)
+ */
+typedef struct _KineticStats {
+    KineticOperationStats total;                                ///< All operations
+    KineticOperationStats byType[KINETIC_MESSAGE_TYPE_COUNT];   ///< Operations by request `KineticMessageType`
+} KineticStats;
+
 /**
  * @brief Log info statistics entry
  */
@@ -501,7 +610,10 @@ typedef struct {
     const char *logFile;            ///< Path to log file. Specify 'stdout' to log to STDOUT or NULL to disable logging.
     int logLevel;                   ///< Logging level (-1:none, 0:error, 1:info, 2:verbose, 3:full)
     uint8_t readerThreads;          ///< Number of threads used for handling incoming responses and status messages
-    uint8_t maxThreadpoolThreads;   ///< Max number of threads to use for the threadpool that handles response callbacks.
+    uint16_t maxThreadpoolThreads;  ///< Max number of threads to use for the threadpool that handles response callbacks.
+    uint16_t minThreadpoolThreads;  ///< Number of threadpool threads kept alive while idle. Threads above this exit after idling.
+    bool serialCompletions;         ///< If true, callbacks for each session run one at a time, in the order responses arrive.
+    bool batchHmac;                 ///< If true, requests signed concurrently on the same session are HMACed together through the multi-buffer SIMD engine.
 } KineticClientConfig;
 
 /**
@@ -513,4 +625,16 @@ typedef struct {
  */
 const char* KineticMessageType_GetName(KineticMessageType type);
 
+/**
+ * @brief Estimates a percentile of the latencies in a histogram.
+ *
+ * @param histogram     The histogram, e.g. from a `KineticStats` snapshot.
+ * @param percentile    The percentile, from 0.0 to 100.0 (e.g. 99.9).
+ *
+ * @return              Upper bound in nanoseconds of the bucket holding the
+ *                      percentile, capped at the histogram's maximum, or 0 if
+ *                      the histogram is empty.
+ */
+uint64_t KineticLatencyHistogram_Percentile(const KineticLatencyHistogram* histogram, double percentile);
+
 #endif // _KINETIC_TYPES_H
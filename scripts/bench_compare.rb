@@ -0,0 +1,55 @@
+#!/usr/bin/env ruby
+##################################################
+# Compare microbenchmark results (micro_bench --json) against a stored
+# baseline, flagging benchmarks whose median ns/op grew by more than the
+# threshold plus their noise band. A run's noise is half the spread of its
+# repetitions (max - min) relative to its median; the band is the larger of
+# the baseline's and the current run's. Exits non-zero if any regressed.
+#
+# Usage: bench_compare.rb BASELINE.json CURRENT.json [THRESHOLD_PERCENT]
+##################################################
+require 'json'
+
+if ARGV.length < 2 || ARGV.length > 3
+  abort "Usage: #{File.basename($0)} BASELINE.json CURRENT.json [THRESHOLD_PERCENT (default 10)]"
+end
+
+def load_results(path)
+  JSON.parse(File.read(path))['benchmarks'].map { |b| [b['name'], b] }.to_h
+rescue StandardError => e
+  abort "Failed reading #{path}: #{e.message}"
+end
+
+baseline = load_results(ARGV[0])
+current = load_results(ARGV[1])
+threshold = (ARGV[2] || 10).to_f
+
+# Half the spread of a run's repetitions, as a percentage of its median
+def noise_percent(result)
+  (result['max_ns_per_op'] - result['min_ns_per_op']) * 50.0 / result['ns_per_op']
+end
+
+regressions = 0
+printf("%-32s %12s %12s %9s %8s\n", 'benchmark', 'baseline', 'current', 'change', 'noise')
+current.each do |name, cur|
+  base = baseline[name]
+  if base.nil?
+    printf("%-32s %12s %12.1f %9s\n", name, '-', cur['ns_per_op'], 'new')
+    next
+  end
+  change = (cur['ns_per_op'] - base['ns_per_op']) * 100.0 / base['ns_per_op']
+  noise = [noise_percent(base), noise_percent(cur)].max
+  regressed = change > threshold + noise
+  regressions += 1 if regressed
+  printf("%-32s %12.1f %12.1f %+8.1f%% %7.1f%%%s\n", name, base['ns_per_op'], cur['ns_per_op'],
+         change, noise, regressed ? '  REGRESSION' : '')
+end
+(baseline.keys - current.keys).each do |name|
+  printf("%-32s %12.1f %12s %9s\n", name, baseline[name]['ns_per_op'], '-', 'missing')
+end
+
+if regressions > 0
+  puts "\n#{regressions} benchmark(s) regressed by more than #{threshold}% beyond their noise"
+  exit 1
+end
+puts "\nNo regressions beyond #{threshold}% plus noise"
@@ -0,0 +1,66 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _BENCH_UTIL_H
+#define _BENCH_UTIL_H
+
+#include "kinetic_stats.h"
+#include <stdint.h>
+#include <time.h>
+
+// Timing, random numbers and latency histograms for the benchmarks, the load
+// generator and the stand-in server's fault injection.
+
+/* CLOCK_MONOTONIC nanoseconds. Read directly rather than with
+ * KineticClock_Now, so measurements keep their resolution in
+ * KINETIC_CLOCK_COARSE builds. */
+static inline uint64_t BenchUtil_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* xorshift64*, from a nonzero state. The same seed always gives the same
+ * sequence, and one state per thread needs no locking. */
+static inline uint64_t BenchUtil_NextRandom(uint64_t* state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1Dull;
+}
+
+/* Uniformly distributed in [0, 1). */
+static inline double BenchUtil_NextUnit(uint64_t* state)
+{
+    return (double)(BenchUtil_NextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Count a latency, bucketed as the client's own statistics are. */
+static inline void BenchUtil_RecordLatency(KineticLatencyHistogram* h, uint64_t ns)
+{
+    h->count++;
+    h->sumNanoseconds += ns;
+    if (ns > h->maxNanoseconds) { h->maxNanoseconds = ns; }
+    h->buckets[KineticStats_LatencyBucket(ns)]++;
+}
+
+#endif // _BENCH_UTIL_H
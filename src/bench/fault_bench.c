@@ -0,0 +1,482 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+// Benchmark: how the client's timeout, backpressure and failure handling
+// behave against a misbehaving drive. Each scenario serves a closed-loop
+// PUT/GET workload from an in-process stand-in server injecting one kind of
+// fault -- delayed, reordered or dropped responses, SERVICE_BUSY refusals,
+// or a terminated connection -- and reports throughput, the latency tail,
+// how long timed out and failed operations took to be reported, and the
+// bus's timeout, send failure, retry and backpressure counters.
+//
+//   fault_bench [--seconds S] [--threads N] [--depth N] [--filter SUBSTRING] [--json FILE]
+
+#include "kinetic_client.h"
+#include "kinetic_types_internal.h"
+#include "kinetic_stats.h"
+#include "kinetic_standin.h"
+#include "bench_util.h"
+#include "bus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define KEY_COUNT 1000
+#define KEY_LEN 16
+#define VALUE_LEN 1024
+#define SAMPLE_INTERVAL_NS (10 * 1000 * 1000)
+#define MAX_LISTENERS 16
+
+typedef struct {
+    const char* name;
+    KineticStandinFaults faults;
+    uint16_t timeoutSeconds;
+} Scenario;
+
+static const Scenario Scenarios[] = {
+    {"baseline", {.delay = KINETIC_STANDIN_DELAY_NONE}, 10},
+    {"delay_fixed_1ms", {.delay = KINETIC_STANDIN_DELAY_FIXED, .delayMicros = 1000}, 10},
+    {"delay_exp_1ms", {.delay = KINETIC_STANDIN_DELAY_EXPONENTIAL, .delayMicros = 1000}, 10},
+    {"delay_bimodal_1pct_50ms", {.delay = KINETIC_STANDIN_DELAY_BIMODAL, .delayMicros = 200,
+        .slowDelayMicros = 50000, .slowFraction = 0.01}, 10},
+    {"reorder_10pct", {.reorderRate = 0.1}, 10},
+    {"busy_5pct", {.busyRate = 0.05}, 10},
+    {"drop_0.1pct", {.dropRate = 0.001}, 2},
+    {"terminate_after_20000", {.closeAfter = 20000}, 10},
+};
+
+typedef struct {
+    uint64_t statuses[KINETIC_STATUS_COUNT];
+    uint64_t rejected;                  // refused before being sent
+    KineticLatencyHistogram succeeded;  // including NOT_FOUND
+    KineticLatencyHistogram timedOut;
+    KineticLatencyHistogram failed;     // every other status
+} Results;
+
+struct Worker;
+
+typedef struct Slot {
+    struct Worker* worker;
+    KineticEntry entry;
+    uint8_t key[KEY_LEN + 1];   // formatted with a terminator, which is not sent
+    uint8_t value[VALUE_LEN];
+    uint8_t version[16];
+    uint8_t tag[64];
+    uint64_t startNs;
+    struct Slot* nextFree;
+} Slot;
+
+typedef struct Worker {
+    KineticSession* session;
+    int depth;
+    uint64_t endNs;
+    uint64_t rng;
+    pthread_t thread;
+
+    pthread_mutex_t mutex;      // guards everything below
+    pthread_cond_t slotFreed;
+    Slot* freeSlots;
+    int freeCount;
+    Results results;
+} Worker;
+
+static void merge_latency(KineticLatencyHistogram* dst, const KineticLatencyHistogram* src)
+{
+    dst->count += src->count;
+    dst->sumNanoseconds += src->sumNanoseconds;
+    if (src->maxNanoseconds > dst->maxNanoseconds) { dst->maxNanoseconds = src->maxNanoseconds; }
+    for (size_t i = 0; i < KINETIC_LATENCY_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+}
+
+/*******************************************************************************
+ * Workload
+*******************************************************************************/
+
+static void release_slot(Worker* w, Slot* s, KineticStatus status, bool sent)
+{
+    uint64_t ns = BenchUtil_Now() - s->startNs;
+    pthread_mutex_lock(&w->mutex);
+    Results* r = &w->results;
+    if (!sent) {
+        r->rejected++;
+    } else {
+        if ((int)status >= 0 && status < KINETIC_STATUS_COUNT) { r->statuses[status]++; }
+        if (status == KINETIC_STATUS_SUCCESS || status == KINETIC_STATUS_NOT_FOUND) {
+            BenchUtil_RecordLatency(&r->succeeded, ns);
+        } else if (status == KINETIC_STATUS_OPERATION_TIMEDOUT) {
+            BenchUtil_RecordLatency(&r->timedOut, ns);
+        } else {
+            BenchUtil_RecordLatency(&r->failed, ns);
+        }
+    }
+    s->nextFree = w->freeSlots;
+    w->freeSlots = s;
+    w->freeCount++;
+    pthread_cond_signal(&w->slotFreed);
+    pthread_mutex_unlock(&w->mutex);
+}
+
+static void operation_done(KineticCompletionData* data, void* clientData)
+{
+    Slot* s = clientData;
+    release_slot(s->worker, s, data->status, true);
+}
+
+static void* worker_main(void* arg)
+{
+    Worker* w = arg;
+    while (BenchUtil_Now() < w->endNs) {
+        pthread_mutex_lock(&w->mutex);
+        while (w->freeSlots == NULL) {
+            pthread_cond_wait(&w->slotFreed, &w->mutex);
+        }
+        Slot* s = w->freeSlots;
+        w->freeSlots = s->nextFree;
+        w->freeCount--;
+        pthread_mutex_unlock(&w->mutex);
+
+        uint64_t key = BenchUtil_NextRandom(&w->rng) % KEY_COUNT;
+        snprintf((char*)s->key, sizeof(s->key), "k%015llu", (unsigned long long)key);
+        s->entry = (KineticEntry) {
+            .key = ByteBuffer_Create(s->key, KEY_LEN, KEY_LEN),
+            .dbVersion = ByteBuffer_Create(s->version, sizeof(s->version), 0),
+            .tag = ByteBuffer_Create(s->tag, sizeof(s->tag), 0),
+            .force = true,
+            .synchronization = KINETIC_SYNCHRONIZATION_WRITEBACK,
+        };
+        KineticCompletionClosure closure = {.callback = operation_done, .clientData = s};
+        s->startNs = BenchUtil_Now();
+        KineticStatus status;
+        if (BenchUtil_NextRandom(&w->rng) & 1) {
+            s->entry.value = ByteBuffer_Create(s->value, VALUE_LEN, VALUE_LEN);
+            status = KineticClient_Put(w->session, &s->entry, &closure);
+        } else {
+            s->entry.value = ByteBuffer_Create(s->value, VALUE_LEN, 0);
+            status = KineticClient_Get(w->session, &s->entry, &closure);
+        }
+
+        // Once the session is refusing requests (e.g. it was terminated),
+        // the rest of the run would only measure how fast it refuses them
+        if (status != KINETIC_STATUS_SUCCESS) {
+            release_slot(w, s, status, false);
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&w->mutex);
+    while (w->freeCount < w->depth) {
+        pthread_cond_wait(&w->slotFreed, &w->mutex);
+    }
+    pthread_mutex_unlock(&w->mutex);
+    return NULL;
+}
+
+/*******************************************************************************
+ * Scenarios
+*******************************************************************************/
+
+typedef struct {
+    const Scenario* scenario;
+    double seconds;             // until every operation completed
+    Results results;
+    bus_stats bus;
+    bus_listener_stats listener;    // counters summed over listeners
+    uint16_t maxBackpressure;   // highest listener backpressure sampled
+    uint16_t maxRxInfoInUse;    // highest responses pending sampled
+} ScenarioResults;
+
+static void sample_bus(KineticClient* client, ScenarioResults* sr, bool final)
+{
+    bus_stats stats;
+    bus_listener_stats listeners[MAX_LISTENERS];
+    if (!Bus_GetStats(client->bus, &stats, listeners, MAX_LISTENERS)) { return; }
+    uint8_t count = (stats.listener_count < MAX_LISTENERS) ? stats.listener_count : MAX_LISTENERS;
+    if (final) {
+        sr->bus = stats;
+        memset(&sr->listener, 0, sizeof(sr->listener));
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        const bus_listener_stats* l = &listeners[i];
+        if (l->backpressure > sr->maxBackpressure) { sr->maxBackpressure = l->backpressure; }
+        if (l->rx_info_in_use > sr->maxRxInfoInUse) { sr->maxRxInfoInUse = l->rx_info_in_use; }
+        if (final) {
+            sr->listener.hold_timeouts += l->hold_timeouts;
+            sr->listener.rx_timeouts += l->rx_timeouts;
+            sr->listener.rx_failures += l->rx_failures;
+            sr->listener.holds_dropped += l->holds_dropped;
+            sr->listener.delivery_retries += l->delivery_retries;
+        }
+    }
+}
+
+static bool run_scenario(const Scenario* scenario, double seconds, int threads, int depth,
+    ScenarioResults* sr)
+{
+    memset(sr, 0, sizeof(*sr));
+    sr->scenario = scenario;
+
+    KineticStandinConfig standinConfig = {.faults = scenario->faults};
+    KineticStandin* standin = KineticStandin_Start(&standinConfig);
+    if (standin == NULL) { return false; }
+
+    KineticClientConfig clientConfig = {.logFile = "stdout", .logLevel = -1};
+    KineticClient* client = KineticClient_Init(&clientConfig);
+    KineticSessionConfig sessionConfig = {
+        .host = "127.0.0.1",
+        .port = KineticStandin_Port(standin),
+        .identity = 1,
+        .hmacKey = ByteArray_CreateWithCString("asdfasdf"),
+        .timeoutSeconds = scenario->timeoutSeconds,
+    };
+    KineticSession* session = NULL;
+    bool ok = (client != NULL) &&
+        KineticClient_CreateSession(&sessionConfig, client, &session) == KINETIC_STATUS_SUCCESS;
+
+    Worker* workers = calloc(threads, sizeof(Worker));
+    Slot* slots = calloc((size_t)threads * depth, sizeof(Slot));
+    ok = ok && workers != NULL && slots != NULL;
+    if (ok) {
+        uint64_t start = BenchUtil_Now();
+        for (int t = 0; t < threads; t++) {
+            Worker* w = &workers[t];
+            w->session = session;
+            w->depth = depth;
+            w->endNs = start + (uint64_t)(seconds * 1e9);
+            w->rng = 0x9E3779B97F4A7C15ull * (t + 1);
+            pthread_mutex_init(&w->mutex, NULL);
+            pthread_cond_init(&w->slotFreed, NULL);
+            for (int d = 0; d < depth; d++) {
+                Slot* s = &slots[t * depth + d];
+                s->worker = w;
+                memset(s->value, 'v', sizeof(s->value));
+                s->nextFree = w->freeSlots;
+                w->freeSlots = s;
+                w->freeCount++;
+            }
+            pthread_create(&w->thread, NULL, worker_main, w);
+        }
+
+        // Watch the gauges until the workers have finished
+        uint64_t nextSample = start;
+        for (int t = 0; t < threads; t++) {
+            for (;;) {
+                pthread_mutex_lock(&workers[t].mutex);
+                bool busy = (workers[t].freeCount < depth) || BenchUtil_Now() < workers[t].endNs;
+                pthread_mutex_unlock(&workers[t].mutex);
+                if (!busy) { break; }
+                if (BenchUtil_Now() >= nextSample) {
+                    sample_bus(client, sr, false);
+                    nextSample += SAMPLE_INTERVAL_NS;
+                }
+                struct timespec pause = {.tv_sec = 0, .tv_nsec = 1000 * 1000};
+                nanosleep(&pause, NULL);
+            }
+            pthread_join(workers[t].thread, NULL);
+        }
+        sr->seconds = (double)(BenchUtil_Now() - start) / 1e9;
+        sample_bus(client, sr, true);
+
+        for (int t = 0; t < threads; t++) {
+            Results* r = &workers[t].results;
+            for (int i = 0; i < KINETIC_STATUS_COUNT; i++) {
+                sr->results.statuses[i] += r->statuses[i];
+            }
+            sr->results.rejected += r->rejected;
+            merge_latency(&sr->results.succeeded, &r->succeeded);
+            merge_latency(&sr->results.timedOut, &r->timedOut);
+            merge_latency(&sr->results.failed, &r->failed);
+            pthread_mutex_destroy(&workers[t].mutex);
+            pthread_cond_destroy(&workers[t].slotFreed);
+        }
+    } else {
+        fprintf(stderr, "Failed setting up scenario %s\n", scenario->name);
+    }
+
+    free(slots);
+    free(workers);
+    if (session != NULL) { KineticClient_DestroySession(session); }
+    if (client != NULL) { KineticClient_Shutdown(client); }
+    KineticStandin_Stop(standin);
+    return ok;
+}
+
+/*******************************************************************************
+ * Reporting
+*******************************************************************************/
+
+static double ms(uint64_t ns)
+{
+    return (double)ns / 1e6;
+}
+
+static double mean_ms(const KineticLatencyHistogram* h)
+{
+    return (h->count > 0) ? ms(h->sumNanoseconds) / h->count : 0.0;
+}
+
+static uint64_t completed(const Results* r)
+{
+    return r->succeeded.count + r->timedOut.count + r->failed.count;
+}
+
+static void print_scenario(FILE* f, const ScenarioResults* sr)
+{
+    const Results* r = &sr->results;
+    const KineticLatencyHistogram* ok = &r->succeeded;
+    fprintf(f, "%s (timeout %us)\n", sr->scenario->name, sr->scenario->timeoutSeconds);
+    fprintf(f, "  %llu ops in %.2f s (%.0f ops/s): %llu succeeded, %llu busy, %llu timed out, "
+        "%llu failed, %llu rejected\n",
+        (unsigned long long)completed(r), sr->seconds, completed(r) / sr->seconds,
+        (unsigned long long)ok->count,
+        (unsigned long long)r->statuses[KINETIC_STATUS_DEVICE_BUSY],
+        (unsigned long long)r->timedOut.count,
+        (unsigned long long)(r->failed.count - r->statuses[KINETIC_STATUS_DEVICE_BUSY]),
+        (unsigned long long)r->rejected);
+    fprintf(f, "  succeeded latency ms: mean %.3f p50 %.3f p99 %.3f p999 %.3f max %.3f\n",
+        mean_ms(ok), ms(KineticLatencyHistogram_Percentile(ok, 50.0)),
+        ms(KineticLatencyHistogram_Percentile(ok, 99.0)),
+        ms(KineticLatencyHistogram_Percentile(ok, 99.9)), ms(ok->maxNanoseconds));
+    if (r->timedOut.count > 0 || r->failed.count > 0) {
+        fprintf(f, "  reported after ms: timed out mean %.1f max %.1f; failed mean %.1f max %.1f\n",
+            mean_ms(&r->timedOut), ms(r->timedOut.maxNanoseconds),
+            mean_ms(&r->failed), ms(r->failed.maxNanoseconds));
+    }
+    fprintf(f, "  bus: rx_timeouts %llu hold_timeouts %llu rx_failures %llu send_failures %llu "
+        "tx_timeouts %llu failure_retries %llu listener_retries %llu delivery_retries %llu\n",
+        (unsigned long long)sr->listener.rx_timeouts, (unsigned long long)sr->listener.hold_timeouts,
+        (unsigned long long)sr->listener.rx_failures, (unsigned long long)sr->bus.send_failures,
+        (unsigned long long)sr->bus.tx_timeouts, (unsigned long long)sr->bus.failure_retries,
+        (unsigned long long)sr->bus.listener_retries, (unsigned long long)sr->listener.delivery_retries);
+    fprintf(f, "  max sampled: backpressure %u, responses pending %u\n\n",
+        sr->maxBackpressure, sr->maxRxInfoInUse);
+}
+
+static void write_latency_json(FILE* f, const char* name, const KineticLatencyHistogram* h)
+{
+    fprintf(f, "\"%s\": {\"count\": %llu, \"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p99_ms\": %.3f, "
+        "\"p999_ms\": %.3f, \"max_ms\": %.3f}",
+        name, (unsigned long long)h->count, mean_ms(h),
+        ms(KineticLatencyHistogram_Percentile(h, 50.0)),
+        ms(KineticLatencyHistogram_Percentile(h, 99.0)),
+        ms(KineticLatencyHistogram_Percentile(h, 99.9)), ms(h->maxNanoseconds));
+}
+
+static bool write_json(const char* path, const ScenarioResults* results, size_t count)
+{
+    bool toStdout = (strcmp(path, "-") == 0);
+    FILE* f = toStdout ? stdout : fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Failed opening '%s' for writing\n", path);
+        return false;
+    }
+    fprintf(f, "{\n  \"suite\": \"kinetic-c-faultbench\",\n  \"scenarios\": [");
+    for (size_t i = 0; i < count; i++) {
+        const ScenarioResults* sr = &results[i];
+        const Results* r = &sr->results;
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"timeout_seconds\": %u, \"seconds\": %.3f, "
+            "\"ops_per_sec\": %.1f, \"rejected\": %llu,\n     \"statuses\": {",
+            (i == 0) ? "" : ",", sr->scenario->name, sr->scenario->timeoutSeconds, sr->seconds,
+            completed(r) / sr->seconds, (unsigned long long)r->rejected);
+        bool first = true;
+        for (int s = 0; s < KINETIC_STATUS_COUNT; s++) {
+            if (r->statuses[s] == 0) { continue; }
+            fprintf(f, "%s\"%s\": %llu", first ? "" : ", ",
+                Kinetic_GetStatusDescription((KineticStatus)s), (unsigned long long)r->statuses[s]);
+            first = false;
+        }
+        fprintf(f, "},\n     ");
+        write_latency_json(f, "succeeded", &r->succeeded);
+        fprintf(f, ",\n     ");
+        write_latency_json(f, "timed_out", &r->timedOut);
+        fprintf(f, ",\n     ");
+        write_latency_json(f, "failed", &r->failed);
+        fprintf(f, ",\n     \"bus\": {\"rx_timeouts\": %llu, \"hold_timeouts\": %llu, \"rx_failures\": %llu, "
+            "\"send_failures\": %llu, \"tx_timeouts\": %llu, \"failure_retries\": %llu, "
+            "\"listener_retries\": %llu, \"delivery_retries\": %llu, \"max_backpressure\": %u, "
+            "\"max_responses_pending\": %u}}",
+            (unsigned long long)sr->listener.rx_timeouts, (unsigned long long)sr->listener.hold_timeouts,
+            (unsigned long long)sr->listener.rx_failures, (unsigned long long)sr->bus.send_failures,
+            (unsigned long long)sr->bus.tx_timeouts, (unsigned long long)sr->bus.failure_retries,
+            (unsigned long long)sr->bus.listener_retries,
+            (unsigned long long)sr->listener.delivery_retries,
+            sr->maxBackpressure, sr->maxRxInfoInUse);
+    }
+    fprintf(f, "\n  ]\n}\n");
+    if (!toStdout) { fclose(f); }
+    return true;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: fault_bench [--seconds S] [--threads N] [--depth N] "
+        "[--filter SUBSTRING] [--json FILE]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 5.0;
+    int threads = 2;
+    int depth = 16;
+    const char* filter = NULL;
+    const char* jsonPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 == argc) { usage(); }
+        if (strcmp(argv[i], "--seconds") == 0) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--depth") == 0) {
+            depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0) {
+            jsonPath = argv[++i];
+        } else {
+            usage();
+        }
+    }
+    if (seconds <= 0.0 || threads < 1 || depth < 1) { usage(); }
+
+    // Keep stdout clean for JSON when it goes there
+    FILE* out = (jsonPath != NULL && strcmp(jsonPath, "-") == 0) ? stderr : stdout;
+    fprintf(out, "Closed-loop 50/50 PUT/GET of %d-byte values, %d threads x depth %d, %.1f s per scenario\n\n",
+        VALUE_LEN, threads, depth, seconds);
+
+    ScenarioResults results[NUM_ELEMENTS(Scenarios)];
+    size_t count = 0;
+    int rc = 0;
+    for (size_t i = 0; i < NUM_ELEMENTS(Scenarios); i++) {
+        if (filter != NULL && strstr(Scenarios[i].name, filter) == NULL) { continue; }
+        if (!run_scenario(&Scenarios[i], seconds, threads, depth, &results[count])) {
+            rc = 1;
+            continue;
+        }
+        print_scenario(out, &results[count]);
+        fflush(out);
+        count++;
+    }
+    if (jsonPath != NULL && !write_json(jsonPath, results, count)) { rc = 1; }
+    return rc;
+}
@@ -0,0 +1,173 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+// Microbenchmark: cost of disabled log statements on a PDU-sized hot path,
+// calling the logger unconditionally (as the LOG macros used to), through the
+// guarded macros with the level disabled at runtime, and compiled out with
+// KINETIC_LOG_LEVEL_MAX. Reports instructions per op where perf counters
+// are available, and nanoseconds per op regardless.
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "kinetic_logger.h"
+#include "kinetic_types_internal.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define OPS (2 * 1000 * 1000)
+
+static volatile uint32_t Sink;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Stands in for the accessors PDU log statements pass as arguments
+__attribute__((noinline)) static uint32_t pdu_length(const KineticPDUHeader* header)
+{
+    return header->protobufLength + header->valueLength;
+}
+
+__attribute__((noinline)) static uint32_t op_unguarded(KineticPDUHeader* header,
+    Com__Seagate__Kinetic__Proto__Message* proto)
+{
+    KineticLogger_LogPrintf(2, "[PDU TX] header: %p, protoLen: %u, valueLen: %u, total: %u",
+        (void*)header, header->protobufLength, header->valueLength, pdu_length(header));
+    KineticLogger_LogHeader(3, header);
+    KineticLogger_LogProtobuf(3, proto);
+    KineticLogger_LogPrintf(3, "seq: %u", pdu_length(header));
+    return header->protobufLength ^ header->valueLength;
+}
+
+__attribute__((noinline)) static uint32_t op_runtime_disabled(KineticPDUHeader* header,
+    Com__Seagate__Kinetic__Proto__Message* proto)
+{
+    LOGF2("[PDU TX] header: %p, protoLen: %u, valueLen: %u, total: %u",
+        (void*)header, header->protobufLength, header->valueLength, pdu_length(header));
+    LOG_HEADER(3, header);
+    LOG_PROTOBUF(3, proto);
+    LOGF3("seq: %u", pdu_length(header));
+    return header->protobufLength ^ header->valueLength;
+}
+
+// The LOG macros test the maximum level where they are expanded
+#undef KINETIC_LOG_LEVEL_MAX
+#define KINETIC_LOG_LEVEL_MAX 1
+
+__attribute__((noinline)) static uint32_t op_compiled_out(KineticPDUHeader* header,
+    Com__Seagate__Kinetic__Proto__Message* proto)
+{
+    LOGF2("[PDU TX] header: %p, protoLen: %u, valueLen: %u, total: %u",
+        (void*)header, header->protobufLength, header->valueLength, pdu_length(header));
+    LOG_HEADER(3, header);
+    LOG_PROTOBUF(3, proto);
+    LOGF3("seq: %u", pdu_length(header));
+    return header->protobufLength ^ header->valueLength;
+}
+
+typedef uint32_t (*op_fn)(KineticPDUHeader*, Com__Seagate__Kinetic__Proto__Message*);
+
+static int open_instruction_counter(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void bench(const char* name, op_fn op, int counter)
+{
+    KineticPDUHeader header = {.versionPrefix = 'F', .protobufLength = 120, .valueLength = 4096};
+    Com__Seagate__Kinetic__Proto__Message proto = COM__SEAGATE__KINETIC__PROTO__MESSAGE__INIT;
+    uint32_t acc = 0;
+    long long instructions = -1;
+
+#ifdef __linux__
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+    int64_t start = now_ns();
+    for (uint32_t i = 0; i < OPS; i++) {
+        header.valueLength = i;
+        acc += op(&header, &proto);
+    }
+    int64_t elapsed = now_ns() - start;
+#ifdef __linux__
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &instructions, sizeof(instructions)) != sizeof(instructions)) {
+            instructions = -1;
+        }
+    }
+#endif
+    Sink = acc;
+
+    if (instructions >= 0) {
+        printf("%-18s %12.1f %10.2f\n", name, (double)instructions / OPS, (double)elapsed / OPS);
+    }
+    else {
+        printf("%-18s %12s %10.2f\n", name, "n/a", (double)elapsed / OPS);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    // Levels 2 and 3 are disabled at runtime, as in production
+    KineticLogger_Init("/dev/null", 1);
+    int counter = open_instruction_counter();
+
+    printf("Disabled PDU logging, %d ops\n\n", OPS);
+    printf("%-18s %12s %10s\n", "mode", "instr/op", "ns/op");
+    bench("unguarded", op_unguarded, counter);
+    bench("runtime-disabled", op_runtime_disabled, counter);
+    bench("compiled-out", op_compiled_out, counter);
+
+#ifdef __linux__
+    if (counter >= 0) {
+        close(counter);
+    }
+#endif
+    KineticLogger_Close();
+    return 0;
+}
@@ -0,0 +1,687 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+// Microbenchmarks for the client's hot paths: packing each request type,
+// the listener-side response unpack, HMAC signing, the bus's FD table and
+// sequence ID lookup, threadpool scheduling, the counting semaphore and
+// ByteBuffer appends. Every benchmark is run for several repetitions and
+// the median is reported, as a table and optionally as JSON for comparison
+// against a stored baseline (see scripts/bench_compare.rb).
+//
+//   micro_bench [--json FILE] [--filter SUBSTRING] [--repetitions N] [--min-ms MS]
+
+#include "kinetic_types_internal.h"
+#include "kinetic_allocator.h"
+#include "kinetic_bus.h"
+#include "kinetic_builder.h"
+#include "kinetic_request.h"
+#include "kinetic_response.h"
+#include "kinetic_hmac.h"
+#include "kinetic_countingsemaphore.h"
+#include "kinetic.pb-c.h"
+#include "byte_array.h"
+#include "yacht.h"
+#include "listener_helper.h"
+#include "threadpool.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define DEFAULT_REPETITIONS 5
+#define DEFAULT_MIN_MS 50
+#define MAX_BENCHMARKS 64
+#define KEY_LEN 16
+
+typedef void (BenchFn)(void* ctx, uint64_t iterations);
+
+typedef struct {
+    const char* name;
+    BenchFn* fn;
+    void* ctx;
+} Benchmark;
+
+typedef struct {
+    const char* name;
+    uint64_t iterations;        // per repetition
+    double median;              // ns per op
+    double min;
+    double max;
+} BenchResult;
+
+static Benchmark Benchmarks[MAX_BENCHMARKS];
+static size_t BenchmarkCount = 0;
+static volatile uint64_t Sink;
+
+static void add(const char* name, BenchFn* fn, void* ctx)
+{
+    if (BenchmarkCount == MAX_BENCHMARKS) {
+        fprintf(stderr, "Too many benchmarks\n");
+        exit(1);
+    }
+    Benchmarks[BenchmarkCount++] = (Benchmark) {.name = name, .fn = fn, .ctx = ctx};
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Size a repetition to take at least minNs, then time each repetition
+static BenchResult run(const Benchmark* bench, int repetitions, int64_t minNs)
+{
+    uint64_t iterations = 1;
+    for (;;) {
+        uint64_t start = BenchUtil_Now();
+        bench->fn(bench->ctx, iterations);
+        int64_t elapsed = (int64_t)(BenchUtil_Now() - start);
+        if (elapsed >= minNs / 4) {
+            double scale = (double)minNs / (elapsed > 0 ? elapsed : 1);
+            iterations = (uint64_t)(iterations * scale) + 1;
+            break;
+        }
+        iterations *= 4;
+    }
+
+    double samples[repetitions];
+    for (int r = 0; r < repetitions; r++) {
+        uint64_t start = BenchUtil_Now();
+        bench->fn(bench->ctx, iterations);
+        samples[r] = (double)(BenchUtil_Now() - start) / iterations;
+    }
+    qsort(samples, repetitions, sizeof(samples[0]), compare_doubles);
+    return (BenchResult) {
+        .name = bench->name,
+        .iterations = iterations,
+        .median = samples[repetitions / 2],
+        .min = samples[0],
+        .max = samples[repetitions - 1],
+    };
+}
+
+/*******************************************************************************
+ * Request packing (KineticRequest_PackPDU, per message type)
+*******************************************************************************/
+
+typedef enum {
+    PACK_NOOP,
+    PACK_PUT,
+    PACK_GET,
+    PACK_GETNEXT,
+    PACK_DELETE,
+    PACK_GETKEYRANGE,
+    PACK_FLUSH,
+} PackType;
+
+typedef struct {
+    KineticSession* session;
+    PackType type;
+    size_t valueLen;
+    uint8_t key[KEY_LEN];
+    uint8_t* value;
+    uint8_t version[16];
+    uint8_t tag[20];
+    ByteBuffer rangeKeys[16];
+} PackContext;
+
+// Build and pack a request as the client does, from pooled operation to PDU
+static void bench_pack(void* ctx, uint64_t iterations)
+{
+    PackContext* c = ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        KineticOperation* op = KineticAllocator_NewOperation(c->session);
+        KineticEntry entry = {
+            .key = ByteBuffer_Create(c->key, sizeof(c->key), sizeof(c->key)),
+            .value = (c->valueLen > 0) ?
+                ByteBuffer_Create(c->value, c->valueLen, c->valueLen) : BYTE_BUFFER_NONE,
+            .dbVersion = ByteBuffer_Create(c->version, sizeof(c->version), 4),
+            .tag = ByteBuffer_Create(c->tag, sizeof(c->tag), sizeof(c->tag)),
+            .algorithm = KINETIC_ALGORITHM_SHA1,
+            .synchronization = KINETIC_SYNCHRONIZATION_WRITEBACK,
+        };
+        KineticKeyRange range = {
+            .startKey = entry.key,
+            .endKey = entry.key,
+            .startKeyInclusive = true,
+            .endKeyInclusive = true,
+            .maxReturned = NUM_ELEMENTS(c->rangeKeys),
+        };
+        ByteBufferArray buffers = {.buffers = c->rangeKeys, .count = NUM_ELEMENTS(c->rangeKeys)};
+
+        switch (c->type) {
+        case PACK_NOOP: KineticBuilder_BuildNoop(op); break;
+        case PACK_PUT: KineticBuilder_BuildPut(op, &entry); break;
+        case PACK_GET: KineticBuilder_BuildGet(op, &entry); break;
+        case PACK_GETNEXT: KineticBuilder_BuildGetNext(op, &entry); break;
+        case PACK_DELETE: KineticBuilder_BuildDelete(op, &entry); break;
+        case PACK_GETKEYRANGE: KineticBuilder_BuildGetKeyRange(op, &range, &buffers); break;
+        case PACK_FLUSH: KineticBuilder_BuildFlush(op); break;
+        }
+
+        uint8_t* msg = NULL;
+        size_t msgSize = 0;
+        if (KineticRequest_PackPDU(op, &msg, &msgSize) != KINETIC_STATUS_SUCCESS) {
+            fprintf(stderr, "Failed packing request\n");
+            exit(1);
+        }
+        Sink += msgSize;
+        KineticAllocator_FreeOperation(op);
+    }
+}
+
+/*******************************************************************************
+ * Response unpacking (KineticBus_UnpackResponse, then the deferred full decode)
+*******************************************************************************/
+
+typedef struct {
+    KineticSession* session;
+    socket_info* si;            // the PDU as the bus's sink_cb accumulates it
+    bool decode;                // also run KineticResponse_Unpack
+} UnpackContext;
+
+// A signed GET response carrying valueLen bytes, as a drive would send it
+static void make_response(UnpackContext* c, const KineticHMACKey* key, size_t valueLen)
+{
+    uint8_t keyData[KEY_LEN] = "k000000000001234";
+    uint8_t version[4] = {0, 0, 0, 1};
+    uint8_t tag[20] = {0};
+
+    Com__Seagate__Kinetic__Proto__Command command = COM__SEAGATE__KINETIC__PROTO__COMMAND__INIT;
+    Com__Seagate__Kinetic__Proto__Command__Header header = COM__SEAGATE__KINETIC__PROTO__COMMAND__HEADER__INIT;
+    Com__Seagate__Kinetic__Proto__Command__Body body = COM__SEAGATE__KINETIC__PROTO__COMMAND__BODY__INIT;
+    Com__Seagate__Kinetic__Proto__Command__KeyValue keyValue = COM__SEAGATE__KINETIC__PROTO__COMMAND__KEY_VALUE__INIT;
+    Com__Seagate__Kinetic__Proto__Command__Status status = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__INIT;
+    header.has_connectionid = true;
+    header.connectionid = 1234567;
+    header.has_acksequence = true;
+    header.acksequence = 42;
+    header.has_messagetype = true;
+    header.messagetype = COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET_RESPONSE;
+    keyValue.has_key = true;
+    keyValue.key = (ProtobufCBinaryData) {.len = sizeof(keyData), .data = keyData};
+    keyValue.has_dbversion = true;
+    keyValue.dbversion = (ProtobufCBinaryData) {.len = sizeof(version), .data = version};
+    keyValue.has_tag = true;
+    keyValue.tag = (ProtobufCBinaryData) {.len = sizeof(tag), .data = tag};
+    keyValue.has_algorithm = true;
+    keyValue.algorithm = COM__SEAGATE__KINETIC__PROTO__COMMAND__ALGORITHM__SHA1;
+    body.keyvalue = &keyValue;
+    status.has_code = true;
+    status.code = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__SUCCESS;
+    command.header = &header;
+    command.body = &body;
+    command.status = &status;
+
+    size_t commandLen = com__seagate__kinetic__proto__command__get_packed_size(&command);
+    uint8_t* commandBytes = malloc(commandLen);
+    com__seagate__kinetic__proto__command__pack(&command, commandBytes);
+
+    uint8_t hmacData[KINETIC_HMAC_SHA1_LEN];
+    Com__Seagate__Kinetic__Proto__Message__HMACauth auth = COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
+    auth.has_identity = true;
+    auth.identity = 1;
+    auth.hmac = (ProtobufCBinaryData) {.len = sizeof(hmacData), .data = hmacData};
+    Com__Seagate__Kinetic__Proto__Message msg = COM__SEAGATE__KINETIC__PROTO__MESSAGE__INIT;
+    msg.has_authtype = true;
+    msg.authtype = COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__HMACAUTH;
+    msg.hmacauth = &auth;
+    msg.has_commandbytes = true;
+    msg.commandbytes = (ProtobufCBinaryData) {.len = commandLen, .data = commandBytes};
+    KineticHMAC hmac;
+    KineticHMAC_Populate(&hmac, &msg, key);
+
+    size_t protoLen = com__seagate__kinetic__proto__message__get_packed_size(&msg);
+    c->si = malloc(sizeof(*c->si) + protoLen + valueLen);
+    *c->si = (socket_info) {
+        .state = STATE_AWAITING_HEADER,
+        .header = {
+            .versionPrefix = 'F',
+            .protobufLength = protoLen,
+            .valueLength = valueLen,
+        },
+        .unpack_status = UNPACK_ERROR_SUCCESS,
+        .accumulated = protoLen + valueLen,
+    };
+    com__seagate__kinetic__proto__message__pack(&msg, c->si->buf);
+    memset(&c->si->buf[protoLen], 'v', valueLen);
+    free(commandBytes);
+}
+
+static void bench_unpack(void* ctx, uint64_t iterations)
+{
+    UnpackContext* c = ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        bus_unpack_cb_res_t res = KineticBus_UnpackResponse(c->si, c->session);
+        if (!res.ok) {
+            fprintf(stderr, "Failed scanning response\n");
+            exit(1);
+        }
+        KineticResponse* response = res.u.success.msg;
+        Sink += (uint64_t)res.u.success.seq_id;
+        if (c->decode && !KineticResponse_Unpack(response)) {
+            fprintf(stderr, "Failed unpacking response\n");
+            exit(1);
+        }
+        KineticAllocator_FreeKineticResponse(response);
+    }
+}
+
+/*******************************************************************************
+ * HMAC
+*******************************************************************************/
+
+typedef struct {
+    const KineticHMACKey* key;
+    Com__Seagate__Kinetic__Proto__Message msg;
+    Com__Seagate__Kinetic__Proto__Message__HMACauth auth;
+    uint8_t hmacData[KINETIC_HMAC_SHA1_LEN];
+} HMACContext;
+
+static void init_hmac(HMACContext* c, const KineticHMACKey* key, size_t commandLen)
+{
+    c->key = key;
+    c->auth = (Com__Seagate__Kinetic__Proto__Message__HMACauth)COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
+    c->auth.hmac = (ProtobufCBinaryData) {.len = sizeof(c->hmacData), .data = c->hmacData};
+    c->msg = (Com__Seagate__Kinetic__Proto__Message)COM__SEAGATE__KINETIC__PROTO__MESSAGE__INIT;
+    c->msg.hmacauth = &c->auth;
+    c->msg.has_commandbytes = true;
+    c->msg.commandbytes = (ProtobufCBinaryData) {.len = commandLen, .data = malloc(commandLen)};
+    memset(c->msg.commandbytes.data, 'c', commandLen);
+}
+
+static void bench_hmac(void* ctx, uint64_t iterations)
+{
+    HMACContext* c = ctx;
+    KineticHMAC hmac;
+    for (uint64_t i = 0; i < iterations; i++) {
+        KineticHMAC_Populate(&hmac, &c->msg, c->key);
+    }
+    Sink += hmac.data[0];
+}
+
+/*******************************************************************************
+ * Bus lookups (Yacht FD table, listener RX info table)
+*******************************************************************************/
+
+typedef struct {
+    struct yacht* yacht;
+    int keys;
+} YachtContext;
+
+// File descriptors are small and dense, as the bus sees them
+static void init_yacht(YachtContext* c, int keys)
+{
+    c->yacht = Yacht_Init(DEF_FD_SET_SIZE2);
+    c->keys = keys;
+    for (int fd = 0; fd < keys; fd++) {
+        Yacht_Set(c->yacht, fd + 3, NULL, NULL);
+    }
+}
+
+static void bench_yacht_get(void* ctx, uint64_t iterations)
+{
+    YachtContext* c = ctx;
+    void* value = NULL;
+    for (uint64_t i = 0; i < iterations; i++) {
+        Sink += Yacht_Get(c->yacht, (int)(i % c->keys) + 3, &value);
+    }
+}
+
+static void bench_yacht_set(void* ctx, uint64_t iterations)
+{
+    YachtContext* c = ctx;
+    void* old = NULL;
+    for (uint64_t i = 0; i < iterations; i++) {
+        Sink += Yacht_Set(c->yacht, (int)(i % c->keys) + 3, (void*)(uintptr_t)i, &old);
+    }
+}
+
+typedef struct {
+    struct bus bus;
+    listener* listener;
+    boxed_msg* boxes;
+    int occupancy;
+    bool miss;
+} FindInfoContext;
+
+// The first `occupancy` records await responses on one connection
+static void init_find_info(FindInfoContext* c, int occupancy, bool miss)
+{
+    memset(&c->bus, 0, sizeof(c->bus));
+    c->listener = calloc(1, sizeof(listener));
+    c->boxes = calloc(occupancy, sizeof(boxed_msg));
+    c->occupancy = occupancy;
+    c->miss = miss;
+    c->listener->bus = &c->bus;
+    for (int i = 0; i < MAX_PENDING_MESSAGES; i++) {
+        c->listener->rx_info[i].state = RIS_INACTIVE;
+    }
+    for (int i = 0; i < occupancy; i++) {
+        c->boxes[i].fd = 5;
+        c->boxes[i].out_seq_id = i;
+        c->listener->rx_info[i].state = RIS_EXPECT;
+        c->listener->rx_info[i].u.expect.box = &c->boxes[i];
+    }
+    c->listener->rx_info_in_use = occupancy;
+    c->listener->rx_info_max_used = occupancy - 1;
+}
+
+static void bench_find_info(void* ctx, uint64_t iterations)
+{
+    FindInfoContext* c = ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        int64_t seq = c->miss ? -1 : (int64_t)(i % c->occupancy);
+        Sink += (ListenerHelper_FindInfoBySequenceID(c->listener, 5, seq) != NULL);
+    }
+}
+
+/*******************************************************************************
+ * Threadpool and counting semaphore
+*******************************************************************************/
+
+typedef struct {
+    struct threadpool* pool;
+    volatile int completed;
+} ThreadpoolContext;
+
+static void count_task(void* udata)
+{
+    ThreadpoolContext* c = udata;
+    (void)__sync_add_and_fetch(&c->completed, 1);
+}
+
+// Tasks scheduled per second, including running them to completion
+static void bench_threadpool(void* ctx, uint64_t iterations)
+{
+    ThreadpoolContext* c = ctx;
+    struct threadpool_task task = {.task = count_task, .udata = c};
+    c->completed = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        while (!Threadpool_Schedule(c->pool, &task, NULL)) {
+            sched_yield();
+        }
+    }
+    while ((uint64_t)c->completed < iterations) {
+        sched_yield();
+    }
+}
+
+typedef struct {
+    KineticCountingSemaphore* sem;
+    int threads;
+    uint64_t iterations;        // per thread, for the current run
+} SemaphoreContext;
+
+static void* semaphore_thread(void* arg)
+{
+    SemaphoreContext* c = arg;
+    for (uint64_t i = 0; i < c->iterations; i++) {
+        KineticCountingSemaphore_Take(c->sem);
+        KineticCountingSemaphore_Give(c->sem);
+    }
+    return NULL;
+}
+
+static void bench_semaphore(void* ctx, uint64_t iterations)
+{
+    SemaphoreContext* c = ctx;
+    c->iterations = iterations / c->threads + 1;
+    if (c->threads == 1) {
+        semaphore_thread(c);
+        return;
+    }
+    pthread_t threads[c->threads];
+    for (int t = 0; t < c->threads; t++) {
+        pthread_create(&threads[t], NULL, semaphore_thread, c);
+    }
+    for (int t = 0; t < c->threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+/*******************************************************************************
+ * ByteBuffer
+*******************************************************************************/
+
+typedef struct {
+    ByteBuffer buffer;
+    uint8_t* data;
+    size_t len;
+} AppendContext;
+
+static void bench_append(void* ctx, uint64_t iterations)
+{
+    AppendContext* c = ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        if (c->buffer.bytesUsed + c->len > c->buffer.array.len) {
+            ByteBuffer_Reset(&c->buffer);
+        }
+        ByteBuffer_Append(&c->buffer, c->data, c->len);
+    }
+    Sink += c->buffer.bytesUsed;
+}
+
+/*******************************************************************************
+ * Reporting
+*******************************************************************************/
+
+static bool write_json(const char* path, const BenchResult* results, size_t count, int repetitions)
+{
+    bool toStdout = (strcmp(path, "-") == 0);
+    FILE* f = toStdout ? stdout : fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Failed opening '%s' for writing\n", path);
+        return false;
+    }
+    fprintf(f, "{\n  \"suite\": \"kinetic-c-microbench\",\n  \"repetitions\": %d,\n  \"benchmarks\": [", repetitions);
+    for (size_t i = 0; i < count; i++) {
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"min_ns_per_op\": %.2f, "
+            "\"max_ns_per_op\": %.2f, \"iterations\": %llu}",
+            (i == 0) ? "" : ",", results[i].name, results[i].median, results[i].min,
+            results[i].max, (unsigned long long)results[i].iterations);
+    }
+    fprintf(f, "\n  ]\n}\n");
+    if (!toStdout) { fclose(f); }
+    return true;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: micro_bench [--json FILE] [--filter SUBSTRING] "
+        "[--repetitions N] [--min-ms MS]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    const char* jsonPath = NULL;
+    const char* filter = NULL;
+    int repetitions = DEFAULT_REPETITIONS;
+    int minMs = DEFAULT_MIN_MS;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 == argc) { usage(); }
+        if (strcmp(argv[i], "--json") == 0) {
+            jsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--repetitions") == 0) {
+            repetitions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-ms") == 0) {
+            minMs = atoi(argv[++i]);
+        } else {
+            usage();
+        }
+    }
+    if (repetitions < 1 || minMs < 1) { usage(); }
+
+    uint8_t keyData[] = "asdfasdf";
+    KineticSessionConfig config = {
+        .host = "localhost",
+        .port = KINETIC_PORT,
+        .clusterVersion = 0,
+        .identity = 1,
+        .hmacKey = {.data = keyData, .len = sizeof(keyData) - 1},
+    };
+    KineticSession* session = KineticAllocator_NewSession(NULL, &config);
+    if (session == NULL) {
+        fprintf(stderr, "Failed creating session\n");
+        return 1;
+    }
+    const KineticHMACKey* key = &session->hmacKeySchedule;
+
+    // Request packing
+    static const struct { const char* name; PackType type; size_t valueLen; } packs[] = {
+        {"pack_pdu/noop", PACK_NOOP, 0},
+        {"pack_pdu/put_0", PACK_PUT, 0},
+        {"pack_pdu/put_4k", PACK_PUT, 4096},
+        {"pack_pdu/put_64k", PACK_PUT, 65536},
+        {"pack_pdu/get", PACK_GET, 0},
+        {"pack_pdu/getnext", PACK_GETNEXT, 0},
+        {"pack_pdu/delete", PACK_DELETE, 0},
+        {"pack_pdu/getkeyrange", PACK_GETKEYRANGE, 0},
+        {"pack_pdu/flush", PACK_FLUSH, 0},
+    };
+    PackContext packContexts[NUM_ELEMENTS(packs)];
+    for (size_t i = 0; i < NUM_ELEMENTS(packs); i++) {
+        PackContext* c = &packContexts[i];
+        memset(c, 0, sizeof(*c));
+        c->session = session;
+        c->type = packs[i].type;
+        c->valueLen = packs[i].valueLen;
+        memcpy(c->key, "k000000000001234", KEY_LEN);
+        if (c->valueLen > 0) {
+            c->value = malloc(c->valueLen);
+            memset(c->value, 'v', c->valueLen);
+        }
+        for (size_t k = 0; k < NUM_ELEMENTS(c->rangeKeys); k++) {
+            c->rangeKeys[k] = ByteBuffer_Malloc(KEY_LEN);
+        }
+        add(packs[i].name, bench_pack, c);
+    }
+
+    // Response unpacking
+    UnpackContext unpackContexts[4];
+    static const char* const unpackNames[] = {
+        "unpack_cb/get_0", "unpack_cb/get_4k", "response_unpack/get_0", "response_unpack/get_4k",
+    };
+    for (size_t i = 0; i < NUM_ELEMENTS(unpackContexts); i++) {
+        unpackContexts[i].session = session;
+        make_response(&unpackContexts[i], key, (i % 2) ? 4096 : 0);
+        unpackContexts[i].decode = (i >= 2);
+        add(unpackNames[i], bench_unpack, &unpackContexts[i]);
+    }
+
+    // HMAC over typical command sizes
+    static const size_t hmacSizes[] = {64, 256, 1024};
+    static const char* const hmacNames[] = {"hmac_populate/64", "hmac_populate/256", "hmac_populate/1024"};
+    HMACContext hmacContexts[NUM_ELEMENTS(hmacSizes)];
+    for (size_t i = 0; i < NUM_ELEMENTS(hmacSizes); i++) {
+        init_hmac(&hmacContexts[i], key, hmacSizes[i]);
+        add(hmacNames[i], bench_hmac, &hmacContexts[i]);
+    }
+
+    // FD table
+    static const int yachtSizes[] = {4, 256};
+    static const char* const yachtNames[] = {
+        "yacht_get/4", "yacht_set/4", "yacht_get/256", "yacht_set/256",
+    };
+    YachtContext yachtContexts[NUM_ELEMENTS(yachtSizes)];
+    for (size_t i = 0; i < NUM_ELEMENTS(yachtSizes); i++) {
+        init_yacht(&yachtContexts[i], yachtSizes[i]);
+        add(yachtNames[2 * i], bench_yacht_get, &yachtContexts[i]);
+        add(yachtNames[2 * i + 1], bench_yacht_set, &yachtContexts[i]);
+    }
+
+    // Sequence ID lookup at increasing occupancy of the RX info table
+    static const int occupancies[] = {1, 16, 128, MAX_PENDING_MESSAGES};
+    static const char* const findNames[] = {
+        "find_info_by_seq/1", "find_info_by_seq/16", "find_info_by_seq/128", "find_info_by_seq/1024",
+        "find_info_by_seq_miss/1", "find_info_by_seq_miss/16", "find_info_by_seq_miss/128",
+        "find_info_by_seq_miss/1024",
+    };
+    FindInfoContext findContexts[2 * NUM_ELEMENTS(occupancies)];
+    for (size_t i = 0; i < NUM_ELEMENTS(findContexts); i++) {
+        size_t o = i % NUM_ELEMENTS(occupancies);
+        init_find_info(&findContexts[i], occupancies[o], i >= NUM_ELEMENTS(occupancies));
+        add(findNames[i], bench_find_info, &findContexts[i]);
+    }
+
+    // Threadpool
+    struct threadpool_config poolConfig = {
+        .task_ringbuf_size2 = 12,
+        .min_threads = 4,
+        .max_threads = 4,
+    };
+    ThreadpoolContext poolContext = {.pool = Threadpool_Init(&poolConfig)};
+    if (poolContext.pool == NULL) {
+        fprintf(stderr, "Failed creating threadpool\n");
+        return 1;
+    }
+    add("threadpool_schedule/4_threads", bench_threadpool, &poolContext);
+
+    // Counting semaphore, uncontended and shared by more threads than permits
+    SemaphoreContext semContexts[] = {
+        {.sem = KineticCountingSemaphore_Create(4), .threads = 1},
+        {.sem = KineticCountingSemaphore_Create(2), .threads = 4},
+    };
+    add("semaphore_take_give/1_thread", bench_semaphore, &semContexts[0]);
+    add("semaphore_take_give/4_threads", bench_semaphore, &semContexts[1]);
+
+    // ByteBuffer appends
+    static const size_t appendSizes[] = {16, 4096};
+    static const char* const appendNames[] = {"bytebuffer_append/16", "bytebuffer_append/4k"};
+    AppendContext appendContexts[NUM_ELEMENTS(appendSizes)];
+    for (size_t i = 0; i < NUM_ELEMENTS(appendSizes); i++) {
+        appendContexts[i].buffer = ByteBuffer_Malloc(1024 * 1024);
+        appendContexts[i].len = appendSizes[i];
+        appendContexts[i].data = calloc(1, appendSizes[i]);
+        add(appendNames[i], bench_append, &appendContexts[i]);
+    }
+
+    // Keep stdout clean for JSON when it goes there
+    FILE* out = (jsonPath != NULL && strcmp(jsonPath, "-") == 0) ? stderr : stdout;
+    BenchResult results[MAX_BENCHMARKS];
+    size_t resultCount = 0;
+    fprintf(out, "%-32s %12s %12s %12s %12s\n", "benchmark", "ns/op", "min", "max", "iterations");
+    for (size_t i = 0; i < BenchmarkCount; i++) {
+        if (filter != NULL && strstr(Benchmarks[i].name, filter) == NULL) { continue; }
+        BenchResult* r = &results[resultCount++];
+        *r = run(&Benchmarks[i], repetitions, (int64_t)minMs * 1000000LL);
+        fprintf(out, "%-32s %12.1f %12.1f %12.1f %12llu\n",
+            r->name, r->median, r->min, r->max, (unsigned long long)r->iterations);
+        fflush(out);
+    }
+
+    int rc = (jsonPath == NULL || write_json(jsonPath, results, resultCount, repetitions)) ? 0 : 1;
+
+    while (!Threadpool_Shutdown(poolContext.pool, false)) {
+        sched_yield();
+    }
+    Threadpool_Free(poolContext.pool);
+    for (size_t i = 0; i < NUM_ELEMENTS(semContexts); i++) {
+        KineticCountingSemaphore_Destroy(semContexts[i].sem);
+    }
+    KineticAllocator_FreeSession(session);
+    return rc;
+}
@@ -27,6 +27,10 @@
 #define ATOMIC_BOOL_COMPARE_AND_SWAP(PTR, OLD, NEW)     \
     (__sync_bool_compare_and_swap(PTR, OLD, NEW))
 
+/* Atomically add ADJ to *PTR, returning the previous value. */
+#define ATOMIC_FETCH_AND_ADD(PTR, ADJ)                  \
+    (__sync_fetch_and_add(PTR, ADJ))
+
 /* Spin attempting to atomically adjust F by ADJ until successful */
 #define SPIN_ADJ(F, ADJ)                                                \
     do {                                                                \
@@ -40,6 +40,8 @@
 #include "atomic.h"
 
 #include "kinetic_types_internal.h"
+#include "kinetic_trace.h"
+#include "kinetic_clock.h"
 #include "listener_task.h"
 
 static int listener_id_of_socket(struct bus *b, int fd);
@@ -105,6 +107,7 @@ bool Bus_Init(bus_config *config, struct bus_result *res) {
     b->log_cb = config->log_cb;
     b->log_level = config->log_level;
     b->udata = config->bus_udata;
+    b->serial_completions = config->serial_completions;
     if (0 != pthread_mutex_init(&b->fd_set_lock, NULL)) {
         res->status = BUS_INIT_ERROR_MUTEX_INIT_FAIL;
         goto cleanup;
@@ -253,6 +256,12 @@ static boxed_msg *box_msg(struct bus *b, bus_user_msg *msg) {
     connection_info *ci = NULL;
     if (Yacht_Get(b->fd_set, box->fd, &value)) {
         ci = (connection_info *)value;
+        /* Retain while locked, since the socket may be released
+         * before the box's callback runs. */
+        if (ci->serial) {
+            Threadpool_SerialRetain(ci->serial);
+            box->serial = ci->serial;
+        }
     }
     if (0 != pthread_mutex_unlock(&b->fd_set_lock)) { assert(false); }
 
@@ -271,7 +280,7 @@ static boxed_msg *box_msg(struct bus *b, bus_user_msg *msg) {
         BUS_LOG_SNPRINTF(b, 3, LOG_MEMORY, b->udata, 256,
             "rejecting request <fd:%d, seq_id:%lld> due to non-monotonic sequence ID, largest seen is %lld",
             box->fd, (long long)msg->seq_id, (long long)ci->largest_wr_seq_id_seen);
-        free(box);
+        Bus_FreeBoxedMessage(box);
         return NULL;
     } else {
         ci->largest_wr_seq_id_seen = msg->seq_id;
@@ -316,7 +325,7 @@ bool Bus_SendRequest(struct bus *b, bus_user_msg *msg)
     if (!res) {
         BUS_LOG_SNPRINTF(b, 3, LOG_SENDING_REQUEST, b->udata, 64,
             "Freeing box since request was rejected: %p", (void *)box);
-        free(box);
+        Bus_FreeBoxedMessage(box);
     }
 
     return res;
@@ -381,6 +390,11 @@ bool Bus_RegisterSocket(struct bus *b, bus_socket_t type, int fd, void *udata) {
     ci->udata = udata;
     ci->largest_wr_seq_id_seen = BUS_NO_SEQ_ID;
 
+    if (b->serial_completions) {
+        ci->serial = Threadpool_SerialInit(b->threadpool);
+        if (ci->serial == NULL) { goto cleanup; }
+    }
+
     #ifndef TEST
     void *old_value = NULL;
     #endif
@@ -410,6 +424,7 @@ bool Bus_RegisterSocket(struct bus *b, bus_socket_t type, int fd, void *udata) {
     return true;
 cleanup:
     if (ci) {
+        if (ci->serial) { Threadpool_SerialRelease(ci->serial); }
         free(ci);
     }
     BUS_LOG(b, 2, LOG_SOCKET_REGISTERED, "failed to add socket", b->udata);
@@ -462,6 +477,8 @@ bool Bus_ReleaseSocket(struct bus *b, int fd, void **socket_udata_out) {
         res = BusSSL_Disconnect(b, ci->ssl);
     }
 
+    /* Any queued callbacks still hold a reference. */
+    if (ci->serial) { Threadpool_SerialRelease(ci->serial); }
     free(ci);
     return res;
 }
@@ -488,6 +505,7 @@ void free_connection_cb(void *value, void *udata) {
         return;
     }
 
+    if (ci->serial) { Threadpool_SerialRelease(ci->serial); }
     free(ci);
 }
 
@@ -564,14 +582,24 @@ static void box_execute_cb(void *udata) {
 
     void *out_udata = box->udata;
     bus_msg_result_t res = box->result;
+    res.dequeued_ns = KineticClock_Now();
     bus_msg_cb *cb = box->cb;
+    struct threadpool_serial *serial = box->serial;
+    KINETIC_TRACE_SPAN(KINETIC_TRACE_QUEUE_WAIT, box->fd, box->out_seq_id,
+        KINETIC_TRACE_TYPE_UNKNOWN, box->trace_enqueued);
 
     free(box);
     cb(&res, out_udata);
+    if (serial) { Threadpool_SerialRelease(serial); }
 }
 
 static void box_cleanup_cb(void *udata) {
     boxed_msg *box = (boxed_msg *)udata;
+    Bus_FreeBoxedMessage(box);
+}
+
+void Bus_FreeBoxedMessage(boxed_msg *box) {
+    if (box->serial) { Threadpool_SerialRelease(box->serial); }
     free(box);
 }
 
@@ -590,7 +618,34 @@ bool Bus_ProcessBoxedMessage(struct bus *b,
 
     BUS_LOG_SNPRINTF(b, 3, LOG_MEMORY, b->udata, 128,
         "Scheduling boxed message -- %p -- where it will be freed", (void*)box);
-    return Threadpool_Schedule(b->threadpool, &task, backpressure);
+    box->trace_enqueued = KINETIC_TRACE_START();
+    box->result.queued_ns = KineticClock_Now();
+    if (box->serial) {
+        return Threadpool_ScheduleSerial(box->serial, &task, backpressure);
+    } else {
+        return Threadpool_Schedule(b->threadpool, &task, backpressure);
+    }
+}
+
+bool Bus_GetStats(struct bus *b, bus_stats *stats,
+        bus_listener_stats *listeners, uint8_t max_listeners) {
+    if (b == NULL || stats == NULL) { return false; }
+
+    *stats = (bus_stats) {
+        .listener_count = b->listener_count,
+        .send_failures = ATOMIC_FETCH_AND_ADD(&b->send_failures, 0),
+        .tx_timeouts = ATOMIC_FETCH_AND_ADD(&b->tx_timeouts, 0),
+        .failure_retries = ATOMIC_FETCH_AND_ADD(&b->failure_retries, 0),
+        .listener_retries = ATOMIC_FETCH_AND_ADD(&b->listener_retries, 0),
+    };
+    Threadpool_Stats(b->threadpool, &stats->threadpool);
+
+    if (listeners != NULL) {
+        for (int i = 0; i < b->listener_count && i < max_listeners; i++) {
+            Listener_GetStats(b->listeners[i], &listeners[i]);
+        }
+    }
+    return true;
 }
 
 /* How many seconds should it give the thread pool to shut down? */
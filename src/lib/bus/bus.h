@@ -61,6 +61,13 @@ bool Bus_Shutdown(struct bus *b);
 /** Free internal data structures for the bus. */
 void Bus_Free(struct bus *b);
 
+/** Fill out STATS with bus-wide counters and the threadpool's state, and
+ * LISTENERS (if non-NULL) with counters and gauges for up to MAX_LISTENERS
+ * listeners. This takes no locks and is cheap enough to poll every second.
+ * Returns false if B or STATS is NULL. */
+bool Bus_GetStats(struct bus *b, bus_stats *stats,
+    bus_listener_stats *listeners, uint8_t max_listeners);
+
 /** Inward facing portion of the message bus -- functions called
  * by other parts of the message bus, like the Listener thread,
  * but not by code outside the bus. */
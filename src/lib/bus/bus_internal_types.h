@@ -50,6 +50,9 @@ typedef struct boxed_msg {
     struct timeval tv_send_start;
     struct timeval tv_send_done;
 
+    /** Time handed to the threadpool, if tracing (see kinetic_trace.h). */
+    uint64_t trace_enqueued;
+
     /** Destination filename and message body. */
     int fd;
     SSL *ssl;                   ///< valid pointer or BUS_BOXED_MSG_NO_SSL
@@ -57,6 +60,9 @@ typedef struct boxed_msg {
     uint8_t *out_msg;
     size_t out_msg_size;
     size_t out_sent_size;
+
+    /** Socket's completion queue (retained), or NULL if unordered. */
+    struct threadpool_serial *serial;
 } boxed_msg;
 
 /** Special "NO SSL" value, to distinguish from a NULL SSL handle. */
@@ -87,11 +93,18 @@ typedef struct bus {
     shutdown_state_t shutdown_state;  ///< Current shutdown state
 
     struct threadpool *threadpool;    ///< Thread pool
+    bool serial_completions;          ///< Order callbacks per socket
     SSL_CTX *ssl_ctx;                 ///< SSL context
 
     /** Locked hash table for fd -> connection_info */
     struct yacht *fd_set;
     pthread_mutex_t fd_set_lock;
+
+    /** Send-side counters for Bus_GetStats, updated atomically */
+    uint64_t send_failures;
+    uint64_t tx_timeouts;
+    uint64_t failure_retries;
+    uint64_t listener_retries;
 } bus;
 
 /** Special timeout value indicating UNBOUND. */
@@ -120,6 +133,10 @@ typedef struct {
     /** Set by client thread. Monotonically increasing max sequence ID. */
     int64_t largest_wr_seq_id_seen;
 
+    /** Serial queue for this socket's completions, if the bus was
+     * configured with serial_completions. Boxes retain a reference. */
+    struct threadpool_serial *serial;
+
     /* Set by listener thread */
     rx_error_t error;
     size_t to_read_size;
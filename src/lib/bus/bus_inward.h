@@ -33,6 +33,10 @@ struct listener *Bus_GetListenerForSocket(struct bus *b, int fd);
 bool Bus_ProcessBoxedMessage(struct bus *b,
     struct boxed_msg *box, size_t *backpressure);
 
+/** Free a boxed message that will not be delivered, releasing its
+ * reference to the socket's serial completion queue, if any. */
+void Bus_FreeBoxedMessage(struct boxed_msg *box);
+
 /** Provide backpressure by sleeping for (backpressure >> shift) msec, if
  * the value is greater than 0. */
 void Bus_BackpressureDelay(struct bus *b, size_t backpressure, uint8_t shift);
@@ -38,6 +38,14 @@ struct boxed_msg;
 /* Special sequence ID value indicating none was available. */
 #define BUS_NO_SEQ_ID (-1)
 
+/* Building with -DBUS_LOG_LEVEL_MAX=<n> compiles out every BUS_LOG and
+ * BUS_LOG_SNPRINTF above level n. */
+#ifdef BUS_LOG_LEVEL_MAX
+#define BUS_LOG_COMPILED_IN(LEVEL) ((LEVEL) <= BUS_LOG_LEVEL_MAX)
+#else
+#define BUS_LOG_COMPILED_IN(LEVEL) (1)
+#endif
+
 #ifdef TEST
 #define BUS_LOG(B, LEVEL, EVENT_KEY, MSG, UDATA) (void)B
 #define BUS_LOG_SNPRINTF(B, LEVEL, EVENT_KEY, UDATA, MAX_SZ, FMT, ...) (void)B
@@ -49,7 +57,8 @@ struct boxed_msg;
         log_event_t _event_key = EVENT_KEY;                            \
         char *_msg = MSG;                                              \
         void *_udata = UDATA;                                          \
-        if (_b->log_level >= _level && _b->log_cb != NULL) {           \
+        if (BUS_LOG_COMPILED_IN(LEVEL) &&                              \
+                _b->log_level >= _level && _b->log_cb != NULL) {       \
             _b->log_cb(_event_key, _level, _msg, _udata);              \
         }                                                              \
     } while (0)
@@ -62,7 +71,8 @@ struct boxed_msg;
         int _level = LEVEL;                                            \
         log_event_t _event_key = EVENT_KEY;                            \
         void *_udata = UDATA;                                          \
-        if (_b->log_level >= _level && _b->log_cb != NULL) {           \
+        if (BUS_LOG_COMPILED_IN(LEVEL) &&                              \
+                _b->log_level >= _level && _b->log_cb != NULL) {       \
             char _log_buf[MAX_SZ];                                     \
             if (MAX_SZ < snprintf(_log_buf, MAX_SZ,                    \
                     FMT, __VA_ARGS__)) {                               \
@@ -175,6 +185,11 @@ typedef struct bus_config {
     bus_log_cb *log_cb;         /* optional */
     
     void *bus_udata;
+
+    /* If set, each socket's message callbacks run one at a time, in the
+     * order the responses were delivered. Different sockets' callbacks
+     * still run in parallel. */
+    bool serial_completions;
 } bus_config;
 
 typedef enum {
@@ -224,6 +239,13 @@ typedef struct {
             void *opaque_msg;
         } response;
     } u;
+
+    /* When the message reached each stage, in CLOCK_MONOTONIC nanoseconds
+     * (see kinetic_clock.h), or 0 if it did not. */
+    uint64_t sent_ns;       // request written to the socket
+    uint64_t received_ns;   // response read and matched by the listener
+    uint64_t queued_ns;     // result handed to the threadpool
+    uint64_t dequeued_ns;   // result picked up by a worker thread
 } bus_msg_result_t;
 
 typedef void (bus_msg_cb)(bus_msg_result_t *res, void *udata);
@@ -268,4 +290,42 @@ typedef enum {
     BUS_RESPONSE_FAILURE_HUP,
 } bus_status_res_t;
 
+/* Counters and gauges for one listener thread. Gauges are sampled from
+ * another thread without locking, so they may be a moment stale. */
+typedef struct bus_listener_stats {
+    /* Gauges */
+    uint16_t rx_info_in_use;        // partially processed responses
+    uint16_t rx_info_max_used;      // highest rx_info slot in use
+    int16_t msgs_in_use;            // queued commands from client threads
+    uint16_t tracked_fds;           // sockets being watched
+    uint16_t inactive_fds;          // sockets disabled by errors
+    uint16_t backpressure;          // as reported to client threads
+    size_t upstream_backpressure;   // smoothed threadpool backpressure
+    size_t read_buf_size;           // current read buffer size
+
+    /* Counters, since the bus was initialized */
+    uint64_t read_buf_grows;        // read buffer reallocations
+    uint64_t holds;                 // HOLD commands received
+    uint64_t holds_dropped;         // HOLDs dropped for lack of rx_info
+    uint64_t hold_to_expect;        // HOLDs converted to EXPECT
+    uint64_t early_responses;       // ...of which already had a response
+    uint64_t hold_timeouts;         // HOLDs which never got an EXPECT
+    uint64_t rx_timeouts;           // responses not received in time
+    uint64_t rx_failures;           // responses failed by socket errors
+    uint64_t delivery_retries;      // deliveries retried after the threadpool was full
+} bus_listener_stats;
+
+/* Bus-wide statistics, see Bus_GetStats. */
+typedef struct bus_stats {
+    uint8_t listener_count;         // listeners on the bus
+
+    /* Counters, updated atomically by client threads */
+    uint64_t send_failures;         // requests failed by Send_HandleFailure
+    uint64_t tx_timeouts;           // ...of which timed out writing
+    uint64_t failure_retries;       // retries delivering those failures
+    uint64_t listener_retries;      // HOLD/EXPECT retries on a full listener queue
+
+    struct threadpool_info threadpool;
+} bus_stats;
+
 #endif
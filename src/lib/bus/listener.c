@@ -167,6 +167,18 @@ bool Listener_ExpectResponse(struct listener *l, boxed_msg *box,
     return pm;
 }
 
+void Listener_GetStats(struct listener *l, bus_listener_stats *stats) {
+    *stats = l->stats;
+    stats->rx_info_in_use = l->rx_info_in_use;
+    stats->rx_info_max_used = l->rx_info_max_used;
+    stats->msgs_in_use = l->msgs_in_use;
+    stats->tracked_fds = l->tracked_fds;
+    stats->inactive_fds = l->inactive_fds;
+    stats->backpressure = ListenerTask_GetBackpressure(l);
+    stats->upstream_backpressure = l->upstream_backpressure;
+    stats->read_buf_size = l->read_buf_size;
+}
+
 bool Listener_Shutdown(struct listener *l, int *notify_fd) {
     listener_msg *msg = ListenerHelper_GetFreeMsg(l);
     if (msg == NULL) { return false; }
@@ -194,7 +206,7 @@ void Listener_Free(struct listener *l) {
                     /* TODO: This can leak memory, since the caller's
                      * callback is not being called. It should be called
                      * with BUS_SEND_RX_FAILURE, if it's safe to do so. */
-                    free(info->u.expect.box);
+                    Bus_FreeBoxedMessage(info->u.expect.box);
                     info->u.expect.box = NULL;
                 }
                 break;
@@ -215,7 +227,7 @@ void Listener_Free(struct listener *l) {
                 ListenerCmd_NotifyCaller(l, msg->u.remove_socket.notify_fd);
                 break;
             case MSG_EXPECT_RESPONSE:
-                if (msg->u.expect.box) { free(msg->u.expect.box); }
+                if (msg->u.expect.box) { Bus_FreeBoxedMessage(msg->u.expect.box); }
                 break;
             default:
                 break;
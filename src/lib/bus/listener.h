@@ -52,6 +52,10 @@ bool Listener_HoldResponse(struct listener *l, int fd,
 bool Listener_ExpectResponse(struct listener *l, boxed_msg *box,
     uint16_t *backpressure);
 
+/** Fill out STATS with the listener's counters and current gauges.
+ * Safe to call from any thread. */
+void Listener_GetStats(struct listener *l, bus_listener_stats *stats);
+
 /** Shut down the listener. Blocking. */
 bool Listener_Shutdown(struct listener *l, int *notify_fd);
 
@@ -26,6 +26,7 @@
 #include "listener_cmd_internal.h"
 #include "listener_task.h"
 #include "listener_helper.h"
+#include "kinetic_clock.h"
 
 static void msg_handler(listener *l, listener_msg *pmsg);
 static void add_socket(listener *l, connection_info *ci, int notify_fd);
@@ -262,11 +263,13 @@ static void hold_response(listener *l, int fd, int64_t seq_id,
     BUS_LOG_SNPRINTF(b, 5, LOG_LISTENER, b->udata, 128,
         "hold_response <fd:%d, seq_id:%lld>", fd, (long long)seq_id);
 
+    l->stats.holds++;
     rx_info_t *info = ListenerHelper_GetFreeRXInfo(l);
     if (info == NULL) {
         BUS_LOG_SNPRINTF(b, 0, LOG_LISTENER, b->udata, 128,
             "failed to get free rx_info for <fd:%d, seq_id:%lld>, dropping it",
             fd, (long long)seq_id);
+        l->stats.holds_dropped++;
         ListenerCmd_NotifyCaller(l, notify_fd);
         return;
     }
@@ -296,14 +299,17 @@ static void expect_response(listener *l, struct boxed_msg *box) {
     rx_info_t *info = ListenerHelper_FindInfoBySequenceID(l, box->fd, box->out_seq_id);
     if (info && info->state == RIS_HOLD) {
         BUS_ASSERT(b, b->udata, info->state == RIS_HOLD);
+        l->stats.hold_to_expect++;
         if (info->u.hold.error == RX_ERROR_NONE && info->u.hold.has_result) {
             bus_unpack_cb_res_t result = info->u.hold.result;
+            box->result.received_ns = info->u.hold.received_ns;
 
             BUS_LOG_SNPRINTF(b, 3, LOG_LISTENER, b->udata, 256,
                 "converting HOLD to EXPECT for info %d (%p) with result, attempting delivery <box:%p, fd:%d, seq_id:%lld>",
                 info->id, (void *)info,
                 (void *)box, info->u.hold.fd, (long long)info->u.hold.seq_id);
 
+            l->stats.early_responses++;
             info->state = RIS_EXPECT;
             info->u.expect.error = RX_ERROR_READY_FOR_DELIVERY;
             info->u.expect.box = box;
@@ -103,6 +103,7 @@ typedef struct rx_info_t {
             bool has_result;
             bus_unpack_cb_res_t result;
             rx_error_t error;
+            uint64_t received_ns;   // when the result arrived, if has_result
         } hold;
         struct {
             boxed_msg *box;
@@ -184,6 +185,10 @@ typedef struct listener {
     /* Read buffer and it's size. Will be grown on demand. */
     size_t read_buf_size;
     uint8_t *read_buf;
+
+    /** Counters for Bus_GetStats. Only the listener thread updates them;
+     * the gauges are filled in when they are read. */
+    bus_listener_stats stats;
 } listener;
 
 #endif
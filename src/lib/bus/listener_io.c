@@ -26,6 +26,8 @@
 #include "listener_task.h"
 #include "syscall.h"
 #include "util.h"
+#include "kinetic_trace.h"
+#include "kinetic_clock.h"
 
 static ssize_t socket_read_plain(struct bus *b,
     listener *l, int pfd_i, connection_info *ci);
@@ -341,6 +343,8 @@ static void process_unpacked_message(listener *l,
         int64_t seq_id = result.u.success.seq_id;
         void *opaque_msg = result.u.success.msg;
 
+        uint64_t trace_start = KINETIC_TRACE_START();
+        uint64_t received_ns = KineticClock_Now();
         rx_info_t *info = ListenerHelper_FindInfoBySequenceID(l, ci->fd, seq_id);
 
         if (info) {
@@ -350,6 +354,7 @@ static void process_unpacked_message(listener *l,
                 BUS_ASSERT(b, b->udata, !info->u.hold.has_result);
                 info->u.hold.has_result = true;
                 info->u.hold.result = result;
+                info->u.hold.received_ns = received_ns;
                 break;
             case RIS_EXPECT:
             {
@@ -360,7 +365,10 @@ static void process_unpacked_message(listener *l,
                 BUS_ASSERT(b, b->udata, !info->u.hold.has_result);
                 info->u.expect.has_result = true;
                 info->u.expect.result = result;
+                info->u.expect.box->result.received_ns = received_ns;
                 ListenerTask_AttemptDelivery(l, info);
+                KINETIC_TRACE_SPAN(KINETIC_TRACE_LISTENER_MATCH, ci->fd, seq_id,
+                    KINETIC_TRACE_TYPE_UNKNOWN, trace_start);
                 break;
             }
             case RIS_INACTIVE:
@@ -159,6 +159,7 @@ static void tick_handler(listener *l) {
                     (void*)info, info->u.hold.fd, (long long)info->u.hold.seq_id,
                     (long)cur.tv_sec, (long)cur.tv_usec);
 
+                l->stats.hold_timeouts++;
                 ListenerTask_ReleaseRXInfo(l, info);
             } else {
                 BUS_LOG_SNPRINTF(b, 3, LOG_LISTENER, b->udata, 64,
@@ -259,6 +260,7 @@ static void retry_delivery(listener *l, rx_info_t *info) {
     #ifndef TEST
     size_t backpressure = 0;
     #endif
+    l->stats.delivery_retries++;
     if (Bus_ProcessBoxedMessage(l->bus, box, &backpressure)) {
         BUS_LOG_SNPRINTF(b, 3, LOG_MEMORY, b->udata, 128,
             "successfully delivered box %p (seq_id %lld) from info %d at line %d (retry)",
@@ -336,6 +338,11 @@ void ListenerTask_NotifyMessageFailure(listener *l,
         BUS_LOG_SNPRINTF(b, 3, LOG_MEMORY, b->udata, 128,
             "delivered box %p with failure message %d at line %d (info %p)",
             (void*)box, status, __LINE__, (void*)info);
+        if (status == BUS_SEND_RX_TIMEOUT) {
+            l->stats.rx_timeouts++;
+        } else {
+            l->stats.rx_failures++;
+        }
         info->u.expect.error = RX_ERROR_DONE;
         ListenerTask_ReleaseRXInfo(l, info);
     } else {
@@ -457,6 +464,7 @@ bool ListenerTask_GrowReadBuf(listener *l, size_t nsize) {
             nbuf, nsize);
         l->read_buf = nbuf;
         l->read_buf_size = nsize;
+        l->stats.read_buf_grows++;
         return true;
     } else {
         return false;
@@ -197,6 +197,7 @@ static bool attempt_to_enqueue_HOLD_message_to_listener(struct bus *b,
         if (Listener_HoldResponse(l, fd, seq_id, timeout_sec, &completion_pipe)) {
             return BusPoll_OnCompletion(b, completion_pipe);
         } else {
+            ATOMIC_FETCH_AND_ADD(&b->listener_retries, 1);
             /* Don't apply much backpressure here since the client
              * thread will get it when the message is done sending. */
             syscall_poll(NULL, 0, SEND_NOTIFY_LISTENER_RETRY_DELAY);
@@ -213,7 +214,12 @@ void Send_HandleFailure(struct bus *b, boxed_msg *box, bus_send_status_t status)
 
     box->result = (bus_msg_result_t){
         .status = status,
+        .sent_ns = box->result.sent_ns,
     };
+    ATOMIC_FETCH_AND_ADD(&b->send_failures, 1);
+    if (status == BUS_SEND_TX_TIMEOUT) {
+        ATOMIC_FETCH_AND_ADD(&b->tx_timeouts, 1);
+    }
     
     #ifndef TEST
     size_t backpressure = 0;
@@ -230,6 +236,7 @@ void Send_HandleFailure(struct bus *b, boxed_msg *box, bus_send_status_t status)
             return;
         } else {
             retries++;
+            ATOMIC_FETCH_AND_ADD(&b->failure_retries, 1);
             syscall_poll(NULL, 0, SEND_NOTIFY_LISTENER_RETRY_DELAY);
             if (retries > 0 && (retries & 255) == 0) {
                 BUS_LOG_SNPRINTF(b, 0, LOG_SENDER, b->udata, 64,
@@ -24,6 +24,8 @@
 #include "send.h"
 #include "syscall.h"
 #include "util.h"
+#include "atomic.h"
+#include "kinetic_clock.h"
 
 #include <assert.h>
 
@@ -78,6 +80,7 @@ SendHelper_HandleWrite_res SendHelper_HandleWrite(bus *b, boxed_msg *box) {
         #endif
         if (Util_Timestamp(&done, true)) {
             box->tv_send_done = done;
+            box->result.sent_ns = KineticClock_Now();
         } else {
             Send_HandleFailure(b, box, BUS_SEND_TIMESTAMP_ERROR);
             return SHHW_ERROR;
@@ -237,6 +240,7 @@ static bool enqueue_EXPECT_message_to_listener(bus *b, boxed_msg *box) {
         } else {
             BUS_LOG_SNPRINTF(b, 5, LOG_SENDER, b->udata, 64,
                 "enqueue_request_sent: failed delivery %d", retries);
+            ATOMIC_FETCH_AND_ADD(&b->listener_retries, 1);
             syscall_poll(NULL, 0, SEND_NOTIFY_LISTENER_RETRY_DELAY);
         }
     }
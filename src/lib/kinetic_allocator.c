@@ -21,11 +21,34 @@
 #include "kinetic_allocator.h"
 #include "kinetic_logger.h"
 #include "kinetic_memory.h"
+#include "kinetic_arena.h"
+#include "kinetic_hmac.h"
+#include "kinetic_hmac_batch.h"
+#include "kinetic_trace.h"
 #include "kinetic_resourcewaiter.h"
 #include "kinetic_resourcewaiter_types.h"
 #include <stdlib.h>
 #include <pthread.h>
 
+// Pools of response buffers, by the capacity of their PDU area. Buffers are
+// not zeroed, since the PDU area is always overwritten by the received PDU.
+typedef struct {
+    size_t pduCapacity;
+    size_t maxPooled;
+    pthread_mutex_t mutex;
+    KineticResponse* free;
+    size_t count;
+} KineticResponsePool;
+
+// The protobuf arrives with the value, so each class leaves room for one
+// carrying a maximum-length key; the largest takes any PDU sink_cb accepts.
+#define RESPONSE_PROTO_ROOM (2 * KINETIC_MAX_KEY_LEN)
+
+static KineticResponsePool ResponsePools[] = {
+    {.pduCapacity = 4 * 1024 + RESPONSE_PROTO_ROOM, .maxPooled = 64, .mutex = PTHREAD_MUTEX_INITIALIZER},
+    {.pduCapacity = 64 * 1024 + RESPONSE_PROTO_ROOM, .maxPooled = 16, .mutex = PTHREAD_MUTEX_INITIALIZER},
+    {.pduCapacity = KINETIC_OBJ_SIZE + PDU_PROTO_MAX_LEN, .maxPooled = 4, .mutex = PTHREAD_MUTEX_INITIALIZER},
+};
 
 KineticSession* KineticAllocator_NewSession(struct bus * b, KineticSessionConfig* config)
 {
@@ -37,11 +60,29 @@ KineticSession* KineticAllocator_NewSession(struct bus * b, KineticSessionConfig
         LOG0("Failed allocating a new session!");
         return NULL;
     }
+    if (pthread_mutex_init(&session->operationPoolMutex, NULL) != 0) {
+        LOG0("Failed initializing session operation pool mutex!");
+        KineticFree(session);
+        return NULL;
+    }
 
     // Deep copy the supplied config internally
     session->config = *config;
     memcpy(session->config.keyData, config->hmacKey.data, config->hmacKey.len);
     session->config.hmacKey.data = session->config.keyData;
+    if (!KineticHMAC_InitKey(&session->hmacKeySchedule, session->config.hmacKey)) {
+        LOG0("Failed preparing session HMAC key!");
+        pthread_mutex_destroy(&session->operationPoolMutex);
+        KineticFree(session);
+        return NULL;
+    }
+    if (!KineticHMACBatch_InitSigner(&session->hmacSigner)) {
+        LOG0("Failed initializing session HMAC signer!");
+        KineticHMAC_DestroyKey(&session->hmacKeySchedule);
+        pthread_mutex_destroy(&session->operationPoolMutex);
+        KineticFree(session);
+        return NULL;
+    }
     strncpy(session->config.host, config->host, sizeof(session->config.host));
     session->timeoutSeconds = config->timeoutSeconds; // TODO: Eliminate this, since already in config?
     KineticResourceWaiter_Init(&session->connectionReady);
@@ -54,18 +95,59 @@ KineticSession* KineticAllocator_NewSession(struct bus * b, KineticSessionConfig
 void KineticAllocator_FreeSession(KineticSession* session)
 {
     if (session != NULL) {
+        while (session->freeOperations != NULL) {
+            KineticOperationSlot* slot = session->freeOperations;
+            session->freeOperations = slot->next;
+            KineticArena_Destroy(&slot->request.txArena);
+            KineticFree(slot);
+        }
+        session->freeOperationCount = 0;
+        KineticHMAC_DestroyKey(&session->hmacKeySchedule);
+        KineticHMACBatch_DestroySigner(&session->hmacSigner);
+        pthread_mutex_destroy(&session->operationPoolMutex);
         KineticResourceWaiter_Destroy(&session->connectionReady);
         KineticFree(session);
     }
 }
 
-KineticResponse * KineticAllocator_NewKineticResponse(size_t const valueLength)
+KineticResponse * KineticAllocator_NewKineticResponse(size_t const payloadLength)
 {
-    KineticResponse * response = KineticCalloc(1, sizeof(*response) + valueLength);
+    KineticResponse * response = NULL;
+    size_t capacity = payloadLength;
+    uint8_t sizeClass = KINETIC_RESPONSE_UNPOOLED;
+
+    for (size_t i = 0; i < NUM_ELEMENTS(ResponsePools); i++) {
+        KineticResponsePool* pool = &ResponsePools[i];
+        if (payloadLength <= pool->pduCapacity) {
+            capacity = pool->pduCapacity;
+            sizeClass = i + 1;
+            pthread_mutex_lock(&pool->mutex);
+            response = pool->free;
+            if (response != NULL) {
+                pool->free = response->next;
+                pool->count--;
+            }
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+    }
+
     if (response == NULL) {
-        LOG0("Failed allocating new response!");
-        return NULL;
+        response = KineticMalloc(sizeof(*response) + capacity);
+        if (response == NULL) {
+            LOG0("Failed allocating new response!");
+            return NULL;
+        }
+        KineticArena_Init(&response->arena);
     }
+
+    // Only the fixed fields need clearing; the PDU is filled in by the caller,
+    // and a pooled response keeps its arena chunk for reuse
+    memset(&response->header, 0, sizeof(response->header));
+    response->proto = NULL;
+    response->command = NULL;
+    response->next = NULL;
+    response->sizeClass = sizeClass;
     return response;
 }
 
@@ -73,12 +155,23 @@ void KineticAllocator_FreeKineticResponse(KineticResponse * response)
 {
     KINETIC_ASSERT(response != NULL);
 
-    if (response->command != NULL) {
-        protobuf_c_message_free_unpacked(&response->command->base, NULL);
-    }
-    if (response->proto != NULL) {
-        protobuf_c_message_free_unpacked(&response->proto->base, NULL);
+    // The unpacked messages live in the arena and go away with it
+    KineticArena_Reset(&response->arena);
+
+    if (response->sizeClass != KINETIC_RESPONSE_UNPOOLED) {
+        KineticResponsePool* pool = &ResponsePools[response->sizeClass - 1];
+        bool pooled = false;
+        pthread_mutex_lock(&pool->mutex);
+        if (pool->count < pool->maxPooled) {
+            response->next = pool->free;
+            pool->free = response;
+            pool->count++;
+            pooled = true;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+        if (pooled) { return; }
     }
+    KineticArena_Destroy(&response->arena);
     KineticFree(response);
 }
 
@@ -87,20 +180,40 @@ KineticOperation* KineticAllocator_NewOperation(KineticSession* const session)
     KINETIC_ASSERT(session != NULL);
 
     LOGF3("Allocating new operation on session %p", (void*)session);
-    KineticOperation* newOperation =
-        (KineticOperation*)KineticCalloc(1, sizeof(KineticOperation));
-    if (newOperation == NULL) {
-        LOGF0("Failed allocating new operation on session %p", (void*)session);
-        return NULL;
+
+    // Reuse a previously completed operation, if one is available
+    pthread_mutex_lock(&session->operationPoolMutex);
+    KineticOperationSlot* slot = session->freeOperations;
+    if (slot != NULL) {
+        session->freeOperations = slot->next;
+        session->freeOperationCount--;
+    } else {
+        session->allocatorStats.operationAllocs++;
+    }
+    session->allocatorStats.operations++;
+    pthread_mutex_unlock(&session->operationPoolMutex);
+
+    if (slot == NULL) {
+        slot = (KineticOperationSlot*)KineticCalloc(1, sizeof(KineticOperationSlot));
+        if (slot == NULL) {
+            LOGF0("Failed allocating new operation on session %p", (void*)session);
+            return NULL;
+        }
+        // Each request packs its PDU into its own arena, so that requests on
+        // the same session can be packed concurrently. Only the default
+        // amount is retained while pooled; frames for larger PDUs come from
+        // the arena's shared pool of maximum size chunks.
+        KineticArena_Init(&slot->request.txArena);
     }
+
+    // The operation is small, so clear it outright; the much larger request
+    // only has the fields it uses reset by KineticRequest_Init.
+    KineticOperation* newOperation = &slot->operation;
+    memset(newOperation, 0, sizeof(*newOperation));
     newOperation->session = session;
+    newOperation->traceStart = KINETIC_TRACE_START();
     newOperation->timeoutSeconds = session->timeoutSeconds; // TODO: use timeout in config throughput
-    newOperation->request = (KineticRequest*)KineticCalloc(1, sizeof(KineticRequest));
-    if (newOperation->request == NULL) {
-        LOGF0("Failed allocating new PDU on session %p", (void*)session);
-        KineticFree(newOperation);
-        return NULL;
-    }
+    newOperation->request = &slot->request;
     KineticRequest_Init(newOperation->request, session);
     return newOperation;
 }
@@ -108,16 +221,45 @@ KineticOperation* KineticAllocator_NewOperation(KineticSession* const session)
 void KineticAllocator_FreeOperation(KineticOperation* operation)
 {
     KINETIC_ASSERT(operation != NULL);
-    LOGF3("Freeing operation %p on session %p", (void*)operation, (void*)operation->session);
-    if (operation->request != NULL) {
-        KineticFree(operation->request);
-        operation->request = NULL;
-    }
+    KineticSession* session = operation->session;
+    LOGF3("Freeing operation %p on session %p", (void*)operation, (void*)session);
     if (operation->response != NULL) {
         KineticAllocator_FreeKineticResponse(operation->response);
         operation->response = NULL;
     }
-    KineticFree(operation);
+
+    // Operations always come from KineticAllocator_NewOperation, so this is
+    // the start of its slot
+    KineticOperationSlot* slot = (KineticOperationSlot*)operation;
+
+    // The PDU has been sent by the time the operation completes. Reset the
+    // arena before pooling, since the slot may be reused as soon as it is.
+    KineticArena_Reset(&slot->request.txArena);
+
+    bool pooled = false;
+    if (session != NULL) {
+        pthread_mutex_lock(&session->operationPoolMutex);
+        if (session->freeOperationCount < KINETIC_OPERATION_POOL_MAX) {
+            slot->next = session->freeOperations;
+            session->freeOperations = slot;
+            session->freeOperationCount++;
+            pooled = true;
+        }
+        pthread_mutex_unlock(&session->operationPoolMutex);
+    }
+    if (!pooled) {
+        KineticArena_Destroy(&slot->request.txArena);
+        KineticFree(slot);
+    }
+}
+
+void KineticAllocator_GetStats(KineticSession * const session, KineticAllocatorStats * stats)
+{
+    KINETIC_ASSERT(session != NULL);
+    KINETIC_ASSERT(stats != NULL);
+    pthread_mutex_lock(&session->operationPoolMutex);
+    *stats = session->allocatorStats;
+    pthread_mutex_unlock(&session->operationPoolMutex);
 }
 
 void KineticAllocator_FreeP2PProtobuf(Com__Seagate__Kinetic__Proto__Command__P2POperation* proto_p2pOp)
@@ -29,9 +29,11 @@ void KineticAllocator_FreeSession(KineticSession* session);
 KineticOperation* KineticAllocator_NewOperation(KineticSession* const session);
 void KineticAllocator_FreeOperation(KineticOperation* operation);
 
-KineticResponse * KineticAllocator_NewKineticResponse(size_t const valueLength);
+KineticResponse * KineticAllocator_NewKineticResponse(size_t const payloadLength);
 void KineticAllocator_FreeKineticResponse(KineticResponse * response);
 
+void KineticAllocator_GetStats(KineticSession * const session, KineticAllocatorStats * stats);
+
 void KineticAllocator_FreeP2PProtobuf(Com__Seagate__Kinetic__Proto__Command__P2POperation* proto_p2pOp);
 
 #endif // _KINETIC_ALLOCATOR
@@ -0,0 +1,160 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_arena.h"
+#include "kinetic_memory.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define ARENA_ALIGNMENT (2 * sizeof(void*))
+#define ARENA_ROUND_UP(SZ) (((SZ) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+#define ARENA_MIN_CHUNK_SIZE (4096)
+
+struct _KineticArenaChunk {
+    KineticArenaChunk* next;
+    size_t capacity;
+    size_t used;
+};
+
+#define ARENA_CHUNK_HEADER_SIZE ARENA_ROUND_UP(sizeof(KineticArenaChunk))
+
+// Only a few large chunks are kept, since each holds a maximum size PDU
+#define ARENA_LARGE_POOL_MAX (8)
+
+static struct {
+    pthread_mutex_t mutex;
+    KineticArenaChunk* free;
+    size_t count;
+} LargeChunks = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static KineticArenaChunk* new_chunk(size_t capacity)
+{
+    KineticArenaChunk* chunk = NULL;
+    if (capacity == KINETIC_ARENA_LARGE_CHUNK) {
+        pthread_mutex_lock(&LargeChunks.mutex);
+        chunk = LargeChunks.free;
+        if (chunk != NULL) {
+            LargeChunks.free = chunk->next;
+            LargeChunks.count--;
+        }
+        pthread_mutex_unlock(&LargeChunks.mutex);
+    }
+    if (chunk == NULL) {
+        chunk = KineticMalloc(ARENA_CHUNK_HEADER_SIZE + capacity);
+        if (chunk == NULL) { return NULL; }
+    }
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    return chunk;
+}
+
+static void free_chunk(KineticArenaChunk* chunk)
+{
+    if (chunk->capacity == KINETIC_ARENA_LARGE_CHUNK) {
+        pthread_mutex_lock(&LargeChunks.mutex);
+        bool pooled = (LargeChunks.count < ARENA_LARGE_POOL_MAX);
+        if (pooled) {
+            chunk->next = LargeChunks.free;
+            LargeChunks.free = chunk;
+            LargeChunks.count++;
+        }
+        pthread_mutex_unlock(&LargeChunks.mutex);
+        if (pooled) { return; }
+    }
+    KineticFree(chunk);
+}
+
+static void * arena_alloc(void *allocator_data, size_t size)
+{
+    return KineticArena_Alloc(allocator_data, size);
+}
+
+static void arena_free(void *allocator_data, void *pointer)
+{
+    // Everything is released together by KineticArena_Reset/Destroy
+    (void)allocator_data;
+    (void)pointer;
+}
+
+void KineticArena_Init(KineticArena* const arena)
+{
+    arena->allocator.alloc = arena_alloc;
+    arena->allocator.free = arena_free;
+    arena->allocator.allocator_data = arena;
+    arena->chunks = NULL;
+    arena->retainLimit = KINETIC_ARENA_DEFAULT_RETAIN;
+}
+
+void * KineticArena_Alloc(KineticArena* const arena, size_t size)
+{
+    size = ARENA_ROUND_UP(size);
+    KineticArenaChunk* chunk = arena->chunks;
+
+    if (chunk == NULL || chunk->capacity - chunk->used < size) {
+        // Grow geometrically, so a large message settles into one chunk
+        size_t capacity = (chunk == NULL) ? ARENA_MIN_CHUNK_SIZE : 2 * chunk->capacity;
+        if (capacity < size) { capacity = size; }
+        if (capacity > arena->retainLimit && size <= KINETIC_ARENA_LARGE_CHUNK) {
+            capacity = KINETIC_ARENA_LARGE_CHUNK;
+        }
+
+        KineticArenaChunk* next = new_chunk(capacity);
+        if (next == NULL) { return NULL; }
+        next->next = chunk;
+        arena->chunks = next;
+        chunk = next;
+    }
+
+    void* p = (uint8_t*)chunk + ARENA_CHUNK_HEADER_SIZE + chunk->used;
+    chunk->used += size;
+    return p;
+}
+
+void KineticArena_Reset(KineticArena* const arena)
+{
+    KineticArenaChunk* chunk = arena->chunks;
+    if (chunk == NULL) { return; }
+    if (chunk->capacity > arena->retainLimit) {
+        KineticArena_Destroy(arena);
+        return;
+    }
+
+    // Keep the newest (largest) chunk around for the next message
+    KineticArenaChunk* cur = chunk->next;
+    while (cur != NULL) {
+        KineticArenaChunk* next = cur->next;
+        free_chunk(cur);
+        cur = next;
+    }
+    chunk->next = NULL;
+    chunk->used = 0;
+}
+
+void KineticArena_Destroy(KineticArena* const arena)
+{
+    KineticArenaChunk* cur = arena->chunks;
+    while (cur != NULL) {
+        KineticArenaChunk* next = cur->next;
+        free_chunk(cur);
+        cur = next;
+    }
+    arena->chunks = NULL;
+}
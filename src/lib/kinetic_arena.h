@@ -0,0 +1,49 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_ARENA_H
+#define _KINETIC_ARENA_H
+
+#include "protobuf-c/protobuf-c.h"
+#include <stddef.h>
+
+// Bump allocator handed to protobuf-c as a ProtobufCAllocator, so an unpacked
+// message tree is released in one shot rather than field by field.
+typedef struct _KineticArenaChunk KineticArenaChunk;
+
+#define KINETIC_ARENA_DEFAULT_RETAIN (64 * 1024)
+
+// Chunks needed beyond the retain limit are this size, enough for the
+// largest PDU (PDU_MAX_LEN), and are recycled through a small process-wide
+// pool rather than freed on reset
+#define KINETIC_ARENA_LARGE_CHUNK (2 * 1024 * 1024 + 64)
+
+typedef struct _KineticArena {
+    ProtobufCAllocator allocator;
+    KineticArenaChunk* chunks;      // most recent (and largest) chunk first
+    size_t retainLimit;             // largest chunk kept across a reset
+} KineticArena;
+
+void KineticArena_Init(KineticArena* const arena);
+void * KineticArena_Alloc(KineticArena* const arena, size_t size);
+void KineticArena_Reset(KineticArena* const arena);
+void KineticArena_Destroy(KineticArena* const arena);
+
+#endif // _KINETIC_ARENA_H
@@ -20,6 +20,7 @@
 
 #include "kinetic_auth.h"
 #include "kinetic_hmac.h"
+#include "kinetic_tag.h"
 #include "kinetic.pb-c.h"
 #include "kinetic_logger.h"
 
@@ -30,9 +31,11 @@ KineticStatus KineticAuth_EnsureSslEnabled(KineticSessionConfig const * const co
     return KINETIC_STATUS_SUCCESS;
 }
 
-KineticStatus KineticAuth_PopulateHmac(KineticSessionConfig const * const config, KineticRequest * const pdu)
+KineticStatus KineticAuth_PopulateHmac(KineticSessionConfig const * const config,
+    KineticHMACKey const * const key, KineticRequest * const pdu)
 {
     KINETIC_ASSERT(config);
+    KINETIC_ASSERT(key);
     KINETIC_ASSERT(pdu);
 
     LOG3("Adding HMAC auth info");
@@ -68,7 +71,9 @@ KineticStatus KineticAuth_PopulateHmac(KineticSessionConfig const * const config
     // Populate with hashed HMAC
     KineticHMAC hmac;
     KineticHMAC_Init(&hmac, COM__SEAGATE__KINETIC__PROTO__COMMAND__SECURITY__ACL__HMACALGORITHM__HmacSHA1);
-    KineticHMAC_Populate(&hmac, &pdu->message.message, config->hmacKey);
+    if (!KineticHMAC_Populate(&hmac, &pdu->message.message, key)) {
+        return KINETIC_STATUS_MEMORY_ERROR;
+    }
 
     return KINETIC_STATUS_SUCCESS;
 }
@@ -104,10 +109,64 @@ KineticStatus KineticAuth_PopulatePin(KineticSessionConfig const * const config,
     return KINETIC_STATUS_SUCCESS;
 }
 
-KineticStatus KineticAuth_PopulateTag(ByteBuffer * const tag, KineticAlgorithm algorithm, ByteArray const * const key)
+KineticStatus KineticAuth_ValidateResponse(KineticHMACKey const * const key,
+    KineticResponse const * const response)
 {
-    (void)tag;
-    (void)algorithm;
-    (void)key;
-    return KINETIC_STATUS_INVALID;
+    KINETIC_ASSERT(key);
+    KINETIC_ASSERT(response);
+    KINETIC_ASSERT(response->proto);
+
+    const Com__Seagate__Kinetic__Proto__Message* proto = response->proto;
+    if (!proto->has_commandbytes || proto->commandbytes.data == NULL || proto->commandbytes.len == 0) {
+        LOG0("Response has no command bytes to authenticate!");
+        return KINETIC_STATUS_HMAC_FAILURE;
+    }
+    if (!KineticHMAC_Validate(proto, key)) {
+        return KINETIC_STATUS_HMAC_FAILURE;
+    }
+    return KINETIC_STATUS_SUCCESS;
+}
+
+static KineticStatus populate_tag(ByteBuffer * const tag, KineticAlgorithm algorithm,
+    uint8_t * const dst, ByteArray const * const value)
+{
+    KINETIC_ASSERT(tag);
+    KINETIC_ASSERT(value);
+    KINETIC_ASSERT(value->data != NULL || value->len == 0);
+
+    size_t len = KineticTag_Length(algorithm);
+    if (len == 0) {
+        LOGF0("Cannot compute tag for unsupported algorithm %d", algorithm);
+        return KINETIC_STATUS_INVALID_REQUEST;
+    }
+    if (tag->array.data == NULL || tag->array.len < len) {
+        LOGF0("Tag buffer too small for algorithm %d (%zu < %zu)", algorithm, tag->array.len, len);
+        return KINETIC_STATUS_BUFFER_OVERRUN;
+    }
+
+    KineticTagContext ctx;
+    if (!KineticTag_Init(&ctx, algorithm)) {
+        return KINETIC_STATUS_MEMORY_ERROR;
+    }
+    bool success = (dst != NULL)
+        ? KineticTag_CopyAndUpdate(&ctx, dst, value->data, value->len)
+        : KineticTag_Update(&ctx, value->data, value->len);
+    if (!KineticTag_Final(&ctx, success ? tag->array.data : NULL) || !success) {
+        LOG0("Failed computing tag!");
+        return KINETIC_STATUS_MEMORY_ERROR;
+    }
+    tag->bytesUsed = len;
+    return KINETIC_STATUS_SUCCESS;
+}
+
+KineticStatus KineticAuth_PopulateTag(ByteBuffer * const tag, KineticAlgorithm algorithm, ByteArray const * const value)
+{
+    return populate_tag(tag, algorithm, NULL, value);
+}
+
+KineticStatus KineticAuth_CopyAndPopulateTag(ByteBuffer * const tag, KineticAlgorithm algorithm,
+    uint8_t * const dst, ByteArray const * const value)
+{
+    KINETIC_ASSERT(dst != NULL || value->len == 0);
+    return populate_tag(tag, algorithm, dst, value);
 }
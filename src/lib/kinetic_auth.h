@@ -24,8 +24,13 @@
 #include "kinetic_types_internal.h"
 
 KineticStatus KineticAuth_EnsureSslEnabled(KineticSessionConfig const * const config);
-KineticStatus KineticAuth_PopulateHmac(KineticSessionConfig const * const config, KineticRequest * const request);
+KineticStatus KineticAuth_PopulateHmac(KineticSessionConfig const * const config,
+    KineticHMACKey const * const key, KineticRequest * const request);
 KineticStatus KineticAuth_PopulatePin(KineticSessionConfig const * const config, KineticRequest * const request, ByteArray pin);
-KineticStatus KineticAuth_PopulateTag(ByteBuffer * const tag, KineticAlgorithm algorithm, ByteArray const * const key);
+KineticStatus KineticAuth_ValidateResponse(KineticHMACKey const * const key,
+    KineticResponse const * const response);
+KineticStatus KineticAuth_PopulateTag(ByteBuffer * const tag, KineticAlgorithm algorithm, ByteArray const * const value);
+KineticStatus KineticAuth_CopyAndPopulateTag(ByteBuffer * const tag, KineticAlgorithm algorithm,
+    uint8_t * const dst, ByteArray const * const value);
 
 #endif // _KINETIC_AUTH_H
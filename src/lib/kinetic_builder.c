@@ -30,6 +30,7 @@
 #include "kinetic_request.h"
 #include "kinetic_acl.h"
 #include "kinetic_callbacks.h"
+#include "kinetic_tag.h"
 
 #include <stdlib.h>
 #include <errno.h>
@@ -61,6 +62,21 @@ KineticStatus KineticBuilder_BuildPut(KineticOperation* const op,
         return KINETIC_STATUS_BUFFER_OVERRUN;
     }
 
+    if (entry->computeTag) {
+        size_t tagLen = KineticTag_Length(entry->algorithm);
+        if (tagLen == 0) {
+            LOGF0("Cannot compute tag for unsupported algorithm %d", entry->algorithm);
+            return KINETIC_STATUS_INVALID_REQUEST;
+        }
+        if (entry->tag.array.data == NULL || entry->tag.array.len < tagLen) {
+            LOGF0("Tag buffer too small for algorithm %d", entry->algorithm);
+            return KINETIC_STATUS_BUFFER_OVERRUN;
+        }
+        // Reserve the tag now; it is computed as the value is packed
+        entry->tag.bytesUsed = tagLen;
+        op->computeValueTag = true;
+    }
+
     op->request->message.command.header->messagetype = COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PUT;
     op->request->message.command.header->has_messagetype = true;
     op->entry = entry;
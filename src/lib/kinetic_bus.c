@@ -29,7 +29,7 @@
 #include "kinetic_allocator.h"
 #include "kinetic_controller.h"
 #include "bus.h"
-#include "kinetic_pdu_unpack.h"
+#include "kinetic_pdu_scan.h"
 
 #include <time.h>
 
@@ -170,7 +170,7 @@ static void log_response_seq_id(int fd, int64_t seq_id) {
     #endif
 }
 
-STATIC bus_unpack_cb_res_t unpack_cb(void *msg, void *socket_udata) {
+bus_unpack_cb_res_t KineticBus_UnpackResponse(void *msg, void *socket_udata) {
     KineticSession * session = (KineticSession*)socket_udata;
     KINETIC_ASSERT(session);
     
@@ -185,7 +185,8 @@ STATIC bus_unpack_cb_res_t unpack_cb(void *msg, void *socket_udata) {
         };
     }
 
-    KineticResponse * response = KineticAllocator_NewKineticResponse(si->header.valueLength);
+    KineticResponse * response = KineticAllocator_NewKineticResponse(
+        si->header.valueLength + si->header.protobufLength);
 
     if (response == NULL) {
         bus_unpack_cb_res_t res = {
@@ -195,35 +196,32 @@ STATIC bus_unpack_cb_res_t unpack_cb(void *msg, void *socket_udata) {
         return res;
     } else {
         response->header = si->header;
-        
-        response->proto = KineticPDU_unpack_message(NULL, si->header.protobufLength, si->buf);
-        if (response->proto->has_commandbytes &&
-            response->proto->commandbytes.data != NULL &&
-            response->proto->commandbytes.len > 0)
-        {
-            response->command = KineticPDU_unpack_command(NULL,
-                response->proto->commandbytes.len, response->proto->commandbytes.data);
-        } else {
-            response->command = NULL;
-        }
 
-        if (response->header.valueLength > 0)
-        {
-            memcpy(response->value, &si->buf[si->header.protobufLength], si->header.valueLength);
+        // Only scan for what is needed to route the response and report its
+        // status; the body is unpacked on the worker thread, if it is needed
+        // at all (see KineticController_UnpackResponse)
+        if (!KineticPDU_Scan(si->buf, si->header.protobufLength, &response->scan)) {
+            KineticAllocator_FreeKineticResponse(response);
+            return (bus_unpack_cb_res_t) {
+                .ok = false,
+                .u.error.opaque_error_id = UNPACK_ERROR_INVALID_PROTOBUF,
+            };
         }
 
+        // Keep the protobuf and value as they arrived, for the worker to unpack
+        memcpy(response->pdu, si->buf, si->header.protobufLength + si->header.valueLength);
+
         int64_t seq_id = BUS_NO_SEQ_ID;
-        if (response->command != NULL &&
-            response->command->header != NULL)
+        if (response->scan.hasHeader)
         {
-            if (response->proto->has_authtype &&
-                response->proto->authtype == COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__UNSOLICITEDSTATUS
+            if (response->scan.hasAuthType &&
+                response->scan.authType == COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__UNSOLICITEDSTATUS
                 && KineticSession_GetConnectionID(session) == 0)
             {
                 /* Ignore the unsolicited status message on connect. */
                 seq_id = BUS_NO_SEQ_ID;
             } else {
-                seq_id = response->command->header->acksequence;
+                seq_id = response->scan.ackSequence;
             }
             log_response_seq_id(session->socket, seq_id);
         }
@@ -247,11 +245,13 @@ bool KineticBus_Init(KineticClient * client, KineticClientConfig * config)
         .log_cb = log_cb,
         .log_level = (log_level <= 1) ? 0 : log_level,
         .sink_cb = sink_cb,
-        .unpack_cb = unpack_cb,
+        .unpack_cb = KineticBus_UnpackResponse,
         .unexpected_msg_cb = KineticController_HandleUnexpectedResponse,
         .bus_udata = NULL,
         .listener_count = config->readerThreads,
+        .serial_completions = config->serialCompletions,
         .threadpool_cfg = {
+            .min_threads = config->minThreadpoolThreads,
             .max_threads = config->maxThreadpoolThreads,
         },
     };
@@ -22,8 +22,15 @@
 #define _KINETIC_BUS_H
 
 #include "kinetic_types_internal.h"
+#include "bus_types.h"
 
 bool KineticBus_Init(KineticClient * client, KineticClientConfig * config);
 void KineticBus_Shutdown(KineticClient * const client);
 
+/* The bus's unpack callback: route the complete PDU in msg (a socket_info)
+ * for the session in socket_udata to its request, by sequence ID, leaving
+ * the full unpack to the callbacks which read the body (see
+ * KineticController_UnpackResponse). */
+bus_unpack_cb_res_t KineticBus_UnpackResponse(void *msg, void *socket_udata);
+
 #endif // _KINETIC_BUS_H
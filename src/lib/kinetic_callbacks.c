@@ -28,8 +28,12 @@
 #include "kinetic_logger.h"
 #include "kinetic_request.h"
 #include "kinetic_acl.h"
+#include "kinetic_tag.h"
+#include "kinetic_clock.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <errno.h>
 #include <sys/time.h>
 #include <stdio.h>
@@ -77,6 +81,48 @@ KineticStatus KineticCallbacks_Put(KineticOperation* const operation, KineticSta
     return status;
 }
 
+// Deliver a GET value into the entry, checking it against the entry's tag
+// as it is copied, so the value is only read once
+static KineticStatus deliver_verified_value(KineticOperation* const operation, ByteArray const value)
+{
+    KineticEntry* entry = operation->entry;
+    KineticTagStats* stats = &operation->session->tagStats;
+    ByteBuffer* dst = &entry->value;
+
+    size_t tagLen = KineticTag_Length(entry->algorithm);
+    if (tagLen == 0 || entry->tag.bytesUsed != tagLen) {
+        LOGF1("Cannot verify value without a supported tag (algorithm %d, tag length %zu)",
+            entry->algorithm, entry->tag.bytesUsed);
+        __sync_fetch_and_add(&stats->skipped, 1);
+        ByteBuffer_AppendArray(dst, value);
+        return KINETIC_STATUS_SUCCESS;
+    }
+    if (dst->bytesUsed + value.len > dst->array.len) {
+        return KINETIC_STATUS_BUFFER_OVERRUN;
+    }
+
+    uint64_t start = KineticClock_Now();
+    KineticTagContext ctx;
+    uint8_t actual[KINETIC_TAG_MAX_LEN];
+    bool computed = KineticTag_Init(&ctx, entry->algorithm)
+        && KineticTag_CopyAndUpdate(&ctx, &dst->array.data[dst->bytesUsed], value.data, value.len);
+    computed = KineticTag_Final(&ctx, computed ? actual : NULL) && computed;
+    __sync_fetch_and_add(&stats->nanoseconds, KineticClock_Now() - start);
+    if (!computed) {
+        return KINETIC_STATUS_MEMORY_ERROR;
+    }
+    __sync_fetch_and_add(&stats->bytes, value.len);
+
+    if (memcmp(actual, entry->tag.array.data, tagLen) != 0) {
+        LOGF0("Value of %zu bytes does not match its tag (algorithm %d)!", value.len, entry->algorithm);
+        __sync_fetch_and_add(&stats->mismatched, 1);
+        return KINETIC_STATUS_TAG_MISMATCH;
+    }
+    __sync_fetch_and_add(&stats->verified, 1);
+    dst->bytesUsed += value.len;
+    return KINETIC_STATUS_SUCCESS;
+}
+
 KineticStatus KineticCallbacks_Get(KineticOperation* const operation, KineticStatus const status)
 {
     KINETIC_ASSERT(operation != NULL);
@@ -86,6 +132,9 @@ KineticStatus KineticCallbacks_Get(KineticOperation* const operation, KineticSta
     if (status == KINETIC_STATUS_SUCCESS)
     {
         KINETIC_ASSERT(operation->response != NULL);
+        if (!KineticController_UnpackResponse(operation)) {
+            return KINETIC_STATUS_SOCKET_ERROR;
+        }
         // Update the entry upon success
         Com__Seagate__Kinetic__Proto__Command__KeyValue* keyValue = KineticResponse_GetKeyValue(operation->response);
         if (keyValue != NULL) {
@@ -97,10 +146,14 @@ KineticStatus KineticCallbacks_Get(KineticOperation* const operation, KineticSta
         if (!operation->entry->metadataOnly &&
             !ByteBuffer_IsNull(operation->entry->value))
         {
-            ByteBuffer_AppendArray(&operation->entry->value, (ByteArray){
-                .data = operation->response->value,
+            ByteArray value = {
+                .data = &operation->response->pdu[operation->response->header.protobufLength],
                 .len = operation->response->header.valueLength,
-            });
+            };
+            if (operation->entry->verifyTag || operation->session->config.verifyTags) {
+                return deliver_verified_value(operation, value);
+            }
+            ByteBuffer_AppendArray(&operation->entry->value, value);
         }
     }
 
@@ -125,6 +178,9 @@ KineticStatus KineticCallbacks_GetKeyRange(KineticOperation* const operation, Ki
     if (status == KINETIC_STATUS_SUCCESS)
     {
         KINETIC_ASSERT(operation->response != NULL);
+        if (!KineticController_UnpackResponse(operation)) {
+            return KINETIC_STATUS_SOCKET_ERROR;
+        }
         // Report the key list upon success
         Com__Seagate__Kinetic__Proto__Command__Range* keyRange = KineticResponse_GetKeyRange(operation->response);
         if (keyRange != NULL) {
@@ -170,11 +226,14 @@ KineticStatus KineticCallbacks_P2POperation(KineticOperation* const operation, K
     KINETIC_ASSERT(operation != NULL);
     KINETIC_ASSERT(operation->session != NULL);
     KineticP2P_Operation* const p2pOp = operation->p2pOp;
+    KineticStatus result = status;
 
-    if (status == KINETIC_STATUS_SUCCESS)
+    if (status == KINETIC_STATUS_SUCCESS && operation->response != NULL)
     {
-        if ((operation->response != NULL) &&
-            (operation->response->command != NULL) &&
+        if (!KineticController_UnpackResponse(operation)) {
+            result = KINETIC_STATUS_SOCKET_ERROR;
+        }
+        else if ((operation->response->command != NULL) &&
             (operation->response->command->body != NULL) &&
             (operation->response->command->body->p2poperation != NULL)) {
             populateP2PStatusCodes(p2pOp, operation->response->command->body->p2poperation);
@@ -183,7 +242,7 @@ KineticStatus KineticCallbacks_P2POperation(KineticOperation* const operation, K
 
     KineticAllocator_FreeP2PProtobuf(operation->request->command->body->p2poperation);
 
-    return status;
+    return result;
 }
 
 
@@ -200,6 +259,9 @@ KineticStatus KineticCallbacks_GetLog(KineticOperation* const operation, Kinetic
     if (status == KINETIC_STATUS_SUCCESS)
     {
         KINETIC_ASSERT(operation->response != NULL);
+        if (!KineticController_UnpackResponse(operation)) {
+            return KINETIC_STATUS_SOCKET_ERROR;
+        }
         // Copy the data from the response protobuf into a new info struct
         if (operation->response->command->body->getlog == NULL) {
             return KINETIC_STATUS_OPERATION_FAILED;
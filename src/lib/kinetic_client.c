@@ -30,6 +30,8 @@
 #include "kinetic_response.h"
 #include "kinetic_bus.h"
 #include "kinetic_memory.h"
+#include "kinetic_trace.h"
+#include "kinetic_stats.h"
 #include <stdlib.h>
 #include <sys/time.h>
 
@@ -58,8 +60,12 @@ KineticClient * KineticClient_Init(KineticClientConfig *config)
         config->maxThreadpoolThreads = KINETIC_CLIENT_DEFAULT_MAX_THREADPOOL_THREADS;
     }
 
+    client->batchHmac = config->batchHmac;
+    pthread_mutex_init(&client->sessionsMutex, NULL);
+
     bool success = KineticBus_Init(client, config);
     if (!success) {
+        pthread_mutex_destroy(&client->sessionsMutex);
         KineticFree(client);
         return NULL;
     }
@@ -69,6 +75,7 @@ KineticClient * KineticClient_Init(KineticClientConfig *config)
 void KineticClient_Shutdown(KineticClient * const client)
 {
     KineticBus_Shutdown(client);
+    pthread_mutex_destroy(&client->sessionsMutex);
     KineticFree(client);
     KineticLogger_Close();
 }
@@ -118,11 +125,36 @@ KineticStatus KineticClient_CreateSession(KineticSessionConfig* const config,
         return status;
     }
 
+    // Register the session so the client can aggregate its stats
+    pthread_mutex_lock(&client->sessionsMutex);
+    s->client = client;
+    s->nextSession = client->sessions;
+    client->sessions = s;
+    pthread_mutex_unlock(&client->sessionsMutex);
+
     *session = s;
 
     return status;
 }
 
+// Fold a destroyed session's stats into its client's, so they still count
+static void retire_session_stats(KineticSession* const session)
+{
+    KineticClient* client = session->client;
+    if (client == NULL) { return; }
+
+    pthread_mutex_lock(&client->sessionsMutex);
+    for (KineticSession** s = &client->sessions; *s != NULL; s = &(*s)->nextSession) {
+        if (*s == session) {
+            *s = session->nextSession;
+            break;
+        }
+    }
+    KineticStats_Collect(&session->stats, &client->retiredStats, true);
+    pthread_mutex_unlock(&client->sessionsMutex);
+    session->client = NULL;
+}
+
 KineticStatus KineticClient_DestroySession(KineticSession* const session)
 {
     if (session == NULL) {
@@ -132,6 +164,7 @@ KineticStatus KineticClient_DestroySession(KineticSession* const session)
 
     KineticStatus status = KineticSession_Disconnect(session);
     if (status != KINETIC_STATUS_SUCCESS) {LOG0("Disconnection failed!");}
+    retire_session_stats(session);
     KineticSession_Destroy(session);
 
     return status;
@@ -332,3 +365,118 @@ KineticStatus KineticClient_P2POperation(KineticSession* const session,
     // Execute the operation
     return KineticController_ExecuteOperation(operation, closure);
 }
+
+KineticStatus KineticClient_GetTagStats(KineticSession* const session,
+                                        KineticTagStats* const stats)
+{
+    if (session == NULL) {
+        LOG0("Specified session is NULL");
+        return KINETIC_STATUS_SESSION_INVALID;
+    }
+    if (stats == NULL) {
+        LOG0("Specified stats is NULL");
+        return KINETIC_STATUS_INVALID_REQUEST;
+    }
+
+    KineticTagStats* counters = &session->tagStats;
+    *stats = (KineticTagStats) {
+        .verified = __sync_fetch_and_add(&counters->verified, 0),
+        .mismatched = __sync_fetch_and_add(&counters->mismatched, 0),
+        .skipped = __sync_fetch_and_add(&counters->skipped, 0),
+        .bytes = __sync_fetch_and_add(&counters->bytes, 0),
+        .nanoseconds = __sync_fetch_and_add(&counters->nanoseconds, 0),
+    };
+    return KINETIC_STATUS_SUCCESS;
+}
+
+KineticStatus KineticClient_GetResponseAuthStats(KineticSession* const session,
+                                                 KineticResponseAuthStats* const stats)
+{
+    if (session == NULL) {
+        LOG0("Specified session is NULL");
+        return KINETIC_STATUS_SESSION_INVALID;
+    }
+    if (stats == NULL) {
+        LOG0("Specified stats is NULL");
+        return KINETIC_STATUS_INVALID_REQUEST;
+    }
+
+    KineticResponseAuthStats* counters = &session->responseAuthStats;
+    *stats = (KineticResponseAuthStats) {
+        .validated = __sync_fetch_and_add(&counters->validated, 0),
+        .failed = __sync_fetch_and_add(&counters->failed, 0),
+        .nanoseconds = __sync_fetch_and_add(&counters->nanoseconds, 0),
+        .maxNanoseconds = __sync_fetch_and_add(&counters->maxNanoseconds, 0),
+    };
+    return KINETIC_STATUS_SUCCESS;
+}
+
+KineticStatus KineticClient_GetSessionStats(KineticSession* const session,
+                                           KineticStats* const stats, bool reset)
+{
+    if (session == NULL) {
+        LOG0("Specified session is NULL");
+        return KINETIC_STATUS_SESSION_INVALID;
+    }
+    if (stats == NULL) {
+        LOG0("Specified stats is NULL");
+        return KINETIC_STATUS_INVALID_REQUEST;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    KineticStats_Collect(&session->stats, stats, reset);
+    KineticStats_Total(stats);
+    return KINETIC_STATUS_SUCCESS;
+}
+
+KineticStatus KineticClient_GetStats(KineticClient* const client,
+                                     KineticStats* const stats, bool reset)
+{
+    if (client == NULL) {
+        LOG0("Specified client is NULL");
+        return KINETIC_STATUS_INVALID_REQUEST;
+    }
+    if (stats == NULL) {
+        LOG0("Specified stats is NULL");
+        return KINETIC_STATUS_INVALID_REQUEST;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    pthread_mutex_lock(&client->sessionsMutex);
+    KineticStats_Collect(&client->retiredStats, stats, reset);
+    for (KineticSession* s = client->sessions; s != NULL; s = s->nextSession) {
+        KineticStats_Collect(&s->stats, stats, reset);
+    }
+    pthread_mutex_unlock(&client->sessionsMutex);
+    KineticStats_Total(stats);
+    return KINETIC_STATUS_SUCCESS;
+}
+
+void KineticClient_SetTracing(bool enable)
+{
+    KineticTrace_Enable(enable);
+}
+
+KineticStatus KineticClient_WriteTrace(const char* path, KineticTraceFormat format)
+{
+    if (path == NULL) {
+        LOG0("Specified trace path is NULL");
+        return KINETIC_STATUS_INVALID_REQUEST;
+    }
+    if (format != KINETIC_TRACE_FORMAT_CHROME && format != KINETIC_TRACE_FORMAT_FOLDED) {
+        LOGF0("Unsupported trace format %d", (int)format);
+        return KINETIC_STATUS_INVALID_REQUEST;
+    }
+
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        LOGF0("Failed opening trace file '%s'", path);
+        return KINETIC_STATUS_INVALID_FILE;
+    }
+    bool written = (format == KINETIC_TRACE_FORMAT_CHROME) ?
+        KineticTrace_WriteChromeJSON(out) : KineticTrace_WriteFolded(out);
+    if (fclose(out) != 0) {
+        written = false;
+    }
+    return written ? KINETIC_STATUS_SUCCESS : KINETIC_STATUS_INVALID_FILE;
+}
@@ -0,0 +1,45 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_CLOCK_H
+#define _KINETIC_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Clock for operation stage timestamps and latency statistics.
+// CLOCK_MONOTONIC is read through the vDSO, without a system call. Building
+// with -DKINETIC_CLOCK_COARSE (make COARSE_CLOCK=1) reads
+// CLOCK_MONOTONIC_COARSE instead, which is cheaper still but only advances
+// once per scheduler tick, too coarse to split sub-millisecond operations.
+#ifdef KINETIC_CLOCK_COARSE
+#define KINETIC_CLOCK_ID CLOCK_MONOTONIC_COARSE
+#else
+#define KINETIC_CLOCK_ID CLOCK_MONOTONIC
+#endif
+
+static inline uint64_t KineticClock_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(KINETIC_CLOCK_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#endif // _KINETIC_CLOCK_H
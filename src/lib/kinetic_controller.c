@@ -28,7 +28,10 @@
 #include "kinetic_allocator.h"
 #include "kinetic_resourcewaiter.h"
 #include "kinetic_logger.h"
+#include "kinetic_trace.h"
+#include "kinetic_clock.h"
 #include <pthread.h>
+#include <time.h>
 #include "bus.h"
 
 typedef struct {
@@ -176,6 +179,19 @@ static const char *bus_error_string(bus_send_status_t t) {
     }
 }
 
+// Log a response's protobuf, unpacking it only if it will be logged
+static void log_response_protobuf(int level, KineticResponse* response)
+{
+#if !KINETIC_LOGGER_DISABLED
+    if (KINETIC_LOG_ENABLED(level) && KineticResponse_Unpack(response)) {
+        KineticLogger_LogProtobuf(level, response->proto);
+    }
+#else
+    (void)level;
+    (void)response;
+#endif
+}
+
 void KineticController_HandleUnexpectedResponse(void *msg,
                                                 int64_t seq_id,
                                                 void *bus_udata,
@@ -191,8 +207,9 @@ void KineticController_HandleUnexpectedResponse(void *msg,
 
     (void)bus_udata;
 
-    // Handle unsolicited status PDUs
-    if (response->proto->authtype == COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__UNSOLICITEDSTATUS) {
+    // Handle unsolicited status PDUs, as identified by the listener's scan
+    if (response->scan.hasAuthType &&
+        response->scan.authType == COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__UNSOLICITEDSTATUS) {
         int64_t connectionID = KineticResponse_GetConnectionID(response);
         if (connectionID != 0)
         {
@@ -228,7 +245,7 @@ void KineticController_HandleUnexpectedResponse(void *msg,
         session->socket, (long long)seq_id,
         KineticResponse_GetProtobufLength(response),
         KineticResponse_GetValueLength(response));
-    KineticLogger_LogProtobuf(protoLogAtLevel, response->proto);
+    log_response_protobuf(protoLogAtLevel, response);
 
     KineticAllocator_FreeKineticResponse(response);
 
@@ -237,6 +254,48 @@ void KineticController_HandleUnexpectedResponse(void *msg,
     }
 }
 
+bool KineticController_UnpackResponse(KineticOperation* const operation)
+{
+    KINETIC_ASSERT(operation);
+    KINETIC_ASSERT(operation->response);
+
+    uint64_t traceStart = KINETIC_TRACE_START();
+    bool unpacked = KineticResponse_Unpack(operation->response);
+    KINETIC_TRACE_SPAN(KINETIC_TRACE_UNPACK, operation->session->socket,
+        operation->request->message.header.sequence,
+        operation->request->message.header.messagetype, traceStart);
+
+    if (!unpacked) {
+        LOGF0("Failed unpacking response for op %p", (void*)operation);
+    }
+    return unpacked;
+}
+
+// Authenticate a response on the worker thread, accounting for it as its
+// own stage so its share of worker time is visible
+static KineticStatus validate_response_hmac(KineticSession* session, KineticResponse* response)
+{
+    KineticResponseAuthStats* stats = &session->responseAuthStats;
+    uint64_t start = KineticClock_Now();
+    KineticStatus status = KineticAuth_ValidateResponse(&session->hmacKeySchedule, response);
+    uint64_t elapsed = KineticClock_Now() - start;
+
+    __sync_fetch_and_add(&stats->nanoseconds, elapsed);
+    for (;;) {
+        uint64_t max = stats->maxNanoseconds;
+        if (elapsed <= max || __sync_bool_compare_and_swap(&stats->maxNanoseconds, max, elapsed)) {
+            break;
+        }
+    }
+    if (status == KINETIC_STATUS_SUCCESS) {
+        __sync_fetch_and_add(&stats->validated, 1);
+    } else {
+        LOGF0("Response HMAC validation failed on session %p!", (void*)session);
+        __sync_fetch_and_add(&stats->failed, 1);
+    }
+    return status;
+}
+
 void KineticController_HandleResult(bus_msg_result_t *res, void *udata)
 {
     KineticOperation* op = udata;
@@ -244,27 +303,48 @@ void KineticController_HandleResult(bus_msg_result_t *res, void *udata)
     KINETIC_ASSERT(op->session);
 
     KineticStatus status = bus_to_kinetic_status(res->status);
+    // op is freed on completion
+    int fd = op->session->socket;
+    int64_t seq_id = op->request->message.header.sequence;
+    int messageType = op->request->message.header.messagetype;
+
+    op->timestamps.sent = res->sent_ns;
+    op->timestamps.received = res->received_ns;
+    op->timestamps.queued = res->queued_ns;
+    op->timestamps.dequeued = res->dequeued_ns;
 
     if (status == KINETIC_STATUS_SUCCESS) {
         KineticResponse * response = res->u.response.opaque_msg;
 
+        // The status comes from the listener's scan; the body is only
+        // unpacked for the callbacks and checks which read it
         status = KineticResponse_GetStatus(response);
 
         LOGF2("[PDU RX] pdu: %p, session: %p, bus: %p, "
             "fd: %6d, seq: %8lld, protoLen: %8u, valueLen: %8u, op: %p, status: %s",
             (void*)response,
             (void*)op->session, (void*)op->session->messageBus,
-            op->session->socket, response->command->header->acksequence,
+            op->session->socket, (long long)response->scan.ackSequence,
             KineticResponse_GetProtobufLength(response),
             KineticResponse_GetValueLength(response),
             (void*)op,
             Kinetic_GetStatusDescription(status));
-        KineticLogger_LogHeader(3, &response->header);
-        KineticLogger_LogProtobuf(3, response->proto);
+        LOG_HEADER(3, &response->header);
+        log_response_protobuf(3, response);
 
         if (op->response == NULL) {
             op->response = response;
         }
+
+        // Only responses to HMAC-signed requests carry an HMAC to check
+        if (op->session->config.verifyResponseHmac && op->pin == NULL) {
+            KineticStatus authStatus = KineticController_UnpackResponse(op)
+                ? validate_response_hmac(op->session, response)
+                : KINETIC_STATUS_SOCKET_ERROR;
+            if (authStatus != KINETIC_STATUS_SUCCESS) {
+                status = authStatus;
+            }
+        }
     } else {
         LOGF0("Error receiving response, got message bus error: %s", bus_error_string(res->status));
         if (res->status == BUS_SEND_RX_TIMEOUT) {
@@ -273,10 +353,12 @@ void KineticController_HandleResult(bus_msg_result_t *res, void *udata)
     }
 
     // Call operation-specific callback, if configured
+    uint64_t traceStart = KINETIC_TRACE_START();
     if (op->opCallback != NULL) {
         status = op->opCallback(op, status);
     }
 
     KineticOperation_Complete(op, status);
+    KINETIC_TRACE_SPAN(KINETIC_TRACE_CALLBACK, fd, seq_id, messageType, traceStart);
 }
 
@@ -34,4 +34,8 @@ void KineticController_HandleUnexpectedResponse(void *msg,
 
 void KineticController_HandleResult(bus_msg_result_t *res, void *udata);
 
+// Unpack the body of an operation's response, which only callbacks that read
+// more than its status need. Returns false if it could not be unpacked.
+bool KineticController_UnpackResponse(KineticOperation* const operation);
+
 #endif // _KINETIC_CONTROLLER_H
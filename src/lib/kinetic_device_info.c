@@ -201,7 +201,8 @@ static KineticLogInfo_Statistics *KineticLogInfo_GetStatistics(
     *numStatistics = 0;
     if (stats) {
         for (size_t i = 0; i < num_stats; i++) {
-            stats[i].messageType = getLog->statistics[i]->messagetype;
+            stats[i].messageType = Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType(
+                getLog->statistics[i]->messagetype);
             if (getLog->statistics[i]->has_count) {
                 stats[i].count = getLog->statistics[i]->count;
             }
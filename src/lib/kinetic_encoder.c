@@ -0,0 +1,224 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_encoder.h"
+#include <string.h>
+
+// Field numbers, from kinetic.proto
+#define COMMAND_HEADER (1)
+#define COMMAND_BODY (2)
+#define HEADER_CLUSTER_VERSION (1)
+#define HEADER_CONNECTION_ID (3)
+#define HEADER_SEQUENCE (4)
+#define HEADER_ACK_SEQUENCE (6)
+#define HEADER_MESSAGE_TYPE (7)
+#define HEADER_TIMEOUT (9)
+#define HEADER_EARLY_EXIT (10)
+#define HEADER_PRIORITY (12)
+#define HEADER_TIME_QUANTA (13)
+#define BODY_KEY_VALUE (1)
+#define KEY_VALUE_NEW_VERSION (2)
+#define KEY_VALUE_KEY (3)
+#define KEY_VALUE_DB_VERSION (4)
+#define KEY_VALUE_TAG (5)
+#define KEY_VALUE_ALGORITHM (6)
+#define KEY_VALUE_METADATA_ONLY (7)
+#define KEY_VALUE_FORCE (8)
+#define KEY_VALUE_SYNCHRONIZATION (9)
+
+size_t KineticEncoder_VarintSize(uint64_t value)
+{
+    size_t size = 1;
+    while (value >= 0x80) { value >>= 7; size++; }
+    return size;
+}
+
+size_t KineticEncoder_PutVarint(uint8_t* out, uint64_t value)
+{
+    size_t i = 0;
+    while (value >= 0x80) {
+        out[i++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[i++] = (uint8_t)value;
+    return i;
+}
+
+// All field numbers used here fit in a single byte tag. Enums are packed as
+// int32, so negative values are sign extended to ten bytes like protobuf-c.
+
+static size_t int64_field_size(protobuf_c_boolean has, int64_t value)
+{
+    return has ? 1 + KineticEncoder_VarintSize((uint64_t)value) : 0;
+}
+
+static size_t enum_field_size(protobuf_c_boolean has, int value)
+{
+    return has ? 1 + KineticEncoder_VarintSize((uint64_t)(int64_t)value) : 0;
+}
+
+static size_t bool_field_size(protobuf_c_boolean has)
+{
+    return has ? 2 : 0;
+}
+
+static size_t bytes_field_size(protobuf_c_boolean has, ProtobufCBinaryData const * const bytes)
+{
+    return has ? 1 + KineticEncoder_VarintSize(bytes->len) + bytes->len : 0;
+}
+
+static size_t put_int64_field(uint8_t* out, int field, protobuf_c_boolean has, int64_t value)
+{
+    if (!has) { return 0; }
+    out[0] = KINETIC_WIRE_TAG(field, KINETIC_WIRE_VARINT);
+    return 1 + KineticEncoder_PutVarint(&out[1], (uint64_t)value);
+}
+
+static size_t put_enum_field(uint8_t* out, int field, protobuf_c_boolean has, int value)
+{
+    return put_int64_field(out, field, has, (int64_t)value);
+}
+
+static size_t put_bool_field(uint8_t* out, int field, protobuf_c_boolean has, protobuf_c_boolean value)
+{
+    if (!has) { return 0; }
+    out[0] = KINETIC_WIRE_TAG(field, KINETIC_WIRE_VARINT);
+    out[1] = value ? 1 : 0;
+    return 2;
+}
+
+static size_t put_length_prefix(uint8_t* out, int field, size_t len)
+{
+    out[0] = KINETIC_WIRE_TAG(field, KINETIC_WIRE_LENGTH_DELIMITED);
+    return 1 + KineticEncoder_PutVarint(&out[1], len);
+}
+
+static size_t put_bytes_field(uint8_t* out, int field, protobuf_c_boolean has,
+    ProtobufCBinaryData const * const bytes)
+{
+    if (!has) { return 0; }
+    size_t offset = put_length_prefix(out, field, bytes->len);
+    if (bytes->len > 0) {
+        memcpy(&out[offset], bytes->data, bytes->len);
+    }
+    return offset + bytes->len;
+}
+
+static size_t nested_size(size_t len)
+{
+    return 1 + KineticEncoder_VarintSize(len) + len;
+}
+
+static bool is_specialized_type(Com__Seagate__Kinetic__Proto__Command__MessageType type)
+{
+    switch (type) {
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET:
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETNEXT:
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETPREVIOUS:
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PUT:
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__DELETE:
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__NOOP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool KineticEncoder_SizeCommand(const Com__Seagate__Kinetic__Proto__Command* cmd,
+    KineticEncoderSizes* sizes)
+{
+    const Com__Seagate__Kinetic__Proto__Command__Header* hdr = cmd->header;
+    const Com__Seagate__Kinetic__Proto__Command__Body* body = cmd->body;
+
+    if (cmd->base.n_unknown_fields > 0 || cmd->status != NULL) { return false; }
+    if (hdr == NULL || hdr->base.n_unknown_fields > 0) { return false; }
+    if (!hdr->has_messagetype || !is_specialized_type(hdr->messagetype)) { return false; }
+    if (body != NULL && (body->base.n_unknown_fields > 0
+      || body->range != NULL || body->setup != NULL || body->p2poperation != NULL
+      || body->getlog != NULL || body->security != NULL || body->pinop != NULL)) {
+        return false;
+    }
+    const Com__Seagate__Kinetic__Proto__Command__KeyValue* kv = (body != NULL) ? body->keyvalue : NULL;
+    if (kv != NULL && kv->base.n_unknown_fields > 0) { return false; }
+
+    sizes->header =
+        int64_field_size(hdr->has_clusterversion, hdr->clusterversion) +
+        int64_field_size(hdr->has_connectionid, hdr->connectionid) +
+        int64_field_size(hdr->has_sequence, hdr->sequence) +
+        int64_field_size(hdr->has_acksequence, hdr->acksequence) +
+        enum_field_size(hdr->has_messagetype, hdr->messagetype) +
+        int64_field_size(hdr->has_timeout, hdr->timeout) +
+        bool_field_size(hdr->has_earlyexit) +
+        enum_field_size(hdr->has_priority, hdr->priority) +
+        int64_field_size(hdr->has_timequanta, hdr->timequanta);
+
+    sizes->keyValue = 0;
+    if (kv != NULL) {
+        sizes->keyValue =
+            bytes_field_size(kv->has_newversion, &kv->newversion) +
+            bytes_field_size(kv->has_key, &kv->key) +
+            bytes_field_size(kv->has_dbversion, &kv->dbversion) +
+            bytes_field_size(kv->has_tag, &kv->tag) +
+            enum_field_size(kv->has_algorithm, kv->algorithm) +
+            bool_field_size(kv->has_metadataonly) +
+            bool_field_size(kv->has_force) +
+            enum_field_size(kv->has_synchronization, kv->synchronization);
+    }
+
+    sizes->body = (kv != NULL) ? nested_size(sizes->keyValue) : 0;
+    sizes->command = nested_size(sizes->header) + ((body != NULL) ? nested_size(sizes->body) : 0);
+    return true;
+}
+
+size_t KineticEncoder_PackCommand(const Com__Seagate__Kinetic__Proto__Command* cmd,
+    const KineticEncoderSizes* sizes, uint8_t* out)
+{
+    const Com__Seagate__Kinetic__Proto__Command__Header* hdr = cmd->header;
+    size_t offset = 0;
+
+    offset += put_length_prefix(&out[offset], COMMAND_HEADER, sizes->header);
+    offset += put_int64_field(&out[offset], HEADER_CLUSTER_VERSION, hdr->has_clusterversion, hdr->clusterversion);
+    offset += put_int64_field(&out[offset], HEADER_CONNECTION_ID, hdr->has_connectionid, hdr->connectionid);
+    offset += put_int64_field(&out[offset], HEADER_SEQUENCE, hdr->has_sequence, hdr->sequence);
+    offset += put_int64_field(&out[offset], HEADER_ACK_SEQUENCE, hdr->has_acksequence, hdr->acksequence);
+    offset += put_enum_field(&out[offset], HEADER_MESSAGE_TYPE, hdr->has_messagetype, hdr->messagetype);
+    offset += put_int64_field(&out[offset], HEADER_TIMEOUT, hdr->has_timeout, hdr->timeout);
+    offset += put_bool_field(&out[offset], HEADER_EARLY_EXIT, hdr->has_earlyexit, hdr->earlyexit);
+    offset += put_enum_field(&out[offset], HEADER_PRIORITY, hdr->has_priority, hdr->priority);
+    offset += put_int64_field(&out[offset], HEADER_TIME_QUANTA, hdr->has_timequanta, hdr->timequanta);
+
+    if (cmd->body != NULL) {
+        offset += put_length_prefix(&out[offset], COMMAND_BODY, sizes->body);
+        const Com__Seagate__Kinetic__Proto__Command__KeyValue* kv = cmd->body->keyvalue;
+        if (kv != NULL) {
+            offset += put_length_prefix(&out[offset], BODY_KEY_VALUE, sizes->keyValue);
+            offset += put_bytes_field(&out[offset], KEY_VALUE_NEW_VERSION, kv->has_newversion, &kv->newversion);
+            offset += put_bytes_field(&out[offset], KEY_VALUE_KEY, kv->has_key, &kv->key);
+            offset += put_bytes_field(&out[offset], KEY_VALUE_DB_VERSION, kv->has_dbversion, &kv->dbversion);
+            offset += put_bytes_field(&out[offset], KEY_VALUE_TAG, kv->has_tag, &kv->tag);
+            offset += put_enum_field(&out[offset], KEY_VALUE_ALGORITHM, kv->has_algorithm, kv->algorithm);
+            offset += put_bool_field(&out[offset], KEY_VALUE_METADATA_ONLY, kv->has_metadataonly, kv->metadataonly);
+            offset += put_bool_field(&out[offset], KEY_VALUE_FORCE, kv->has_force, kv->force);
+            offset += put_enum_field(&out[offset], KEY_VALUE_SYNCHRONIZATION, kv->has_synchronization, kv->synchronization);
+        }
+    }
+
+    return offset;
+}
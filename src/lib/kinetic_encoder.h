@@ -0,0 +1,58 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_ENCODER_H
+#define _KINETIC_ENCODER_H
+
+#include "kinetic.pb-c.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Protobuf wire format helpers
+#define KINETIC_WIRE_VARINT (0)
+#define KINETIC_WIRE_LENGTH_DELIMITED (2)
+#define KINETIC_WIRE_TAG(FIELD, WIRE) ((uint8_t)(((FIELD) << 3) | (WIRE)))
+
+size_t KineticEncoder_VarintSize(uint64_t value);
+size_t KineticEncoder_PutVarint(uint8_t* out, uint64_t value);
+
+// Sizes of the nested messages of a command, computed once by
+// KineticEncoder_SizeCommand and reused while packing
+typedef struct {
+    size_t header;
+    size_t keyValue;
+    size_t body;
+    size_t command;
+} KineticEncoderSizes;
+
+// Hand-specialized encoder for the hot GET/GETNEXT/GETPREVIOUS/PUT/DELETE/NOOP
+// commands, emitting the same bytes as com__seagate__kinetic__proto__command__pack.
+// Returns false if the command uses anything the specialized encoder does not
+// handle, in which case the generic protobuf-c packer must be used instead.
+bool KineticEncoder_SizeCommand(const Com__Seagate__Kinetic__Proto__Command* cmd,
+    KineticEncoderSizes* sizes);
+
+// Packs a command accepted by KineticEncoder_SizeCommand into out, which must
+// hold sizes->command bytes. Returns the number of bytes written.
+size_t KineticEncoder_PackCommand(const Com__Seagate__Kinetic__Proto__Command* cmd,
+    const KineticEncoderSizes* sizes, uint8_t* out);
+
+#endif // _KINETIC_ENCODER_H
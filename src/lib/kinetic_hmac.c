@@ -19,14 +19,51 @@
 */
 
 #include "kinetic_hmac.h"
+#include "kinetic_hmac_batch.h"
 #include "kinetic_nbo.h"
 #include "kinetic_logger.h"
 #include <string.h>
-#include <openssl/hmac.h>
+#include <pthread.h>
+#include <openssl/crypto.h>
 
-static void KineticHMAC_Compute(KineticHMAC* hmac,
+#define HMAC_SHA1_BLOCK_LEN (64)
+#define HMAC_IPAD (0x36)
+#define HMAC_OPAD (0x5c)
+
+static bool KineticHMAC_Compute(KineticHMAC* hmac,
                                 const Com__Seagate__Kinetic__Proto__Message* proto,
-                                const ByteArray key);
+                                const KineticHMACKey* key,
+                                KineticHMACBatchSigner* signer);
+
+// Each thread keeps a working digest context to resume the cached keyed
+// states into, so signing and validating don't allocate one per message
+static pthread_once_t WorkingContextKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t WorkingContextKey;
+
+static void destroy_working_context(void* ctx)
+{
+    EVP_MD_CTX_destroy(ctx);
+}
+
+static void create_working_context_key(void)
+{
+    pthread_key_create(&WorkingContextKey, destroy_working_context);
+}
+
+static EVP_MD_CTX* working_context(void)
+{
+    pthread_once(&WorkingContextKeyOnce, create_working_context_key);
+    EVP_MD_CTX* ctx = pthread_getspecific(WorkingContextKey);
+    if (ctx == NULL) {
+        ctx = EVP_MD_CTX_create();
+        if (ctx == NULL) { return NULL; }
+        if (pthread_setspecific(WorkingContextKey, ctx) != 0) {
+            EVP_MD_CTX_destroy(ctx);
+            return NULL;
+        }
+    }
+    return ctx;
+}
 
 void KineticHMAC_Init(KineticHMAC* hmac,
                       Com__Seagate__Kinetic__Proto__Command__Security__ACL__HMACAlgorithm algorithm)
@@ -44,32 +81,92 @@ void KineticHMAC_Init(KineticHMAC* hmac,
     }
 }
 
-void KineticHMAC_Populate(KineticHMAC* hmac,
+static bool digest_padded_key(EVP_MD_CTX* ctx, uint32_t state[5],
+                              const uint8_t* key, size_t keyLen, uint8_t pad)
+{
+    uint8_t block[HMAC_SHA1_BLOCK_LEN];
+    memset(block, pad, sizeof(block));
+    for (size_t i = 0; i < keyLen; i++) {
+        block[i] ^= key[i];
+    }
+    KineticHMACBatch_BlockState(block, state);
+    bool success = EVP_DigestInit_ex(ctx, EVP_sha1(), NULL)
+        && EVP_DigestUpdate(ctx, block, sizeof(block));
+    OPENSSL_cleanse(block, sizeof(block));
+    return success;
+}
+
+bool KineticHMAC_InitKey(KineticHMACKey* key, const ByteArray keyData)
+{
+    KINETIC_ASSERT(key != NULL);
+    KINETIC_ASSERT(keyData.data != NULL || keyData.len == 0);
+
+    // Digest the padded key blocks once, so each message only has to copy
+    // the resulting inner and outer states
+    uint8_t hashedKey[SHA_DIGEST_LENGTH];
+    const uint8_t* k = keyData.data;
+    size_t kLen = keyData.len;
+    if (kLen > HMAC_SHA1_BLOCK_LEN) {
+        if (!EVP_Digest(keyData.data, keyData.len, hashedKey, NULL, EVP_sha1(), NULL)) {
+            return false;
+        }
+        k = hashedKey;
+        kLen = sizeof(hashedKey);
+    }
+
+    key->inner = EVP_MD_CTX_create();
+    key->outer = EVP_MD_CTX_create();
+    bool success = key->inner != NULL && key->outer != NULL
+        && digest_padded_key(key->inner, key->innerState, k, kLen, HMAC_IPAD)
+        && digest_padded_key(key->outer, key->outerState, k, kLen, HMAC_OPAD);
+    OPENSSL_cleanse(hashedKey, sizeof(hashedKey));
+    if (!success) {
+        LOG0("Failed preparing HMAC key!");
+        KineticHMAC_DestroyKey(key);
+    }
+    return success;
+}
+
+void KineticHMAC_DestroyKey(KineticHMACKey* key)
+{
+    KINETIC_ASSERT(key != NULL);
+    if (key->inner != NULL) { EVP_MD_CTX_destroy(key->inner); }
+    if (key->outer != NULL) { EVP_MD_CTX_destroy(key->outer); }
+    key->inner = NULL;
+    key->outer = NULL;
+    OPENSSL_cleanse(key->innerState, sizeof(key->innerState));
+    OPENSSL_cleanse(key->outerState, sizeof(key->outerState));
+}
+
+bool KineticHMAC_Populate(KineticHMAC* hmac,
                           Com__Seagate__Kinetic__Proto__Message* msg,
-                          const ByteArray key)
+                          const KineticHMACKey* key)
 {
     KINETIC_ASSERT(hmac != NULL);
     KINETIC_ASSERT(hmac->data != NULL);
     KINETIC_ASSERT(msg != NULL);
-    KINETIC_ASSERT(key.data != NULL);
-    KINETIC_ASSERT(key.len > 0);
+    KINETIC_ASSERT(key != NULL);
+    KINETIC_ASSERT(key->inner != NULL);
     KINETIC_ASSERT(msg->hmacauth->hmac.data != NULL);
 
     KineticHMAC_Init(hmac, COM__SEAGATE__KINETIC__PROTO__COMMAND__SECURITY__ACL__HMACALGORITHM__HmacSHA1);
-    KineticHMAC_Compute(hmac, msg, key);
+    if (!KineticHMAC_Compute(hmac, msg, key, key->signer)) {
+        return false;
+    }
 
     // Copy computed HMAC into message
     memcpy(msg->hmacauth->hmac.data, hmac->data, hmac->len);
     msg->hmacauth->hmac.len = hmac->len;
     msg->hmacauth->has_hmac = true;
+    return true;
 }
 
 bool KineticHMAC_Validate(const Com__Seagate__Kinetic__Proto__Message* msg,
-                          const ByteArray key)
+                          const KineticHMACKey* key)
 {
     KINETIC_ASSERT(msg != NULL);
-    KINETIC_ASSERT(key.data != NULL);
-    KINETIC_ASSERT(key.len > 0);
+    KINETIC_ASSERT(key != NULL);
+    KINETIC_ASSERT(key->inner != NULL);
 
     bool success = false;
     size_t i;
@@ -85,8 +182,12 @@ bool KineticHMAC_Validate(const Com__Seagate__Kinetic__Proto__Message* msg,
         return false;
     }
 
+    // Responses are validated on the worker threads as they arrive, so
+    // they are never held up waiting on a signing batch
     KineticHMAC_Init(&tempHMAC, COM__SEAGATE__KINETIC__PROTO__COMMAND__SECURITY__ACL__HMACALGORITHM__HmacSHA1);
-    KineticHMAC_Compute(&tempHMAC, msg, key);
+    if (!KineticHMAC_Compute(&tempHMAC, msg, key, NULL)) {
+        return false;
+    }
     if (msg->hmacauth->hmac.len == tempHMAC.len) {
         for (i = 0; i < tempHMAC.len; i++) {
             result |= msg->hmacauth->hmac.data[i] ^ tempHMAC.data[i];
@@ -97,21 +198,20 @@ bool KineticHMAC_Validate(const Com__Seagate__Kinetic__Proto__Message* msg,
     if (!success) {
         LOG0("HMAC did not compare!");
         ByteArray expected = {.data = msg->hmacauth->hmac.data, .len = msg->hmacauth->hmac.len};
-        KineticLogger_LogByteArray(1, "expected HMAC", expected);
+        LOG_BYTE_ARRAY(1, "expected HMAC", expected);
         ByteArray actual = {.data = tempHMAC.data, .len = tempHMAC.len};
-        KineticLogger_LogByteArray(1, "actual HMAC", actual);
+        LOG_BYTE_ARRAY(1, "actual HMAC", actual);
     }
 
     return success;
 }
 
-#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-
 #define LOG_HMAC 0
 
-static void KineticHMAC_Compute(KineticHMAC* hmac,
+static bool KineticHMAC_Compute(KineticHMAC* hmac,
                                 const Com__Seagate__Kinetic__Proto__Message* msg,
-                                const ByteArray key)
+                                const KineticHMACKey* key,
+                                KineticHMACBatchSigner* signer)
 {
     KINETIC_ASSERT(hmac != NULL);
     KINETIC_ASSERT(hmac->data != NULL);
@@ -121,12 +221,9 @@ static void KineticHMAC_Compute(KineticHMAC* hmac,
     KINETIC_ASSERT(msg->commandbytes.data != NULL);
     KINETIC_ASSERT(msg->commandbytes.len > 0);
 
-    uint32_t lenNBO = KineticNBO_FromHostU32(msg->commandbytes.len);
-
-    HMAC_CTX ctx;
-    HMAC_CTX_init(&ctx);
 #if LOG_HMAC
-    fprintf(stderr, "\n\nUsing hmac key [%zd]: '%s' and length '", key.len, key.data);
+    uint32_t lenNBO = KineticNBO_FromHostU32(msg->commandbytes.len);
+    fprintf(stderr, "\n\nUsing length '");
     for (size_t i = 0; i < sizeof(uint32_t); i++) {
         fprintf(stderr, "%02x", ((uint8_t *)&lenNBO)[i]);
     }
@@ -139,9 +236,50 @@ static void KineticHMAC_Compute(KineticHMAC* hmac,
     fprintf(stderr, "\n\n");
 #endif
 
-    HMAC_Init_ex(&ctx, key.data, key.len, EVP_sha1(), NULL);
-    HMAC_Update(&ctx, (uint8_t*)&lenNBO, sizeof(uint32_t));
-    HMAC_Update(&ctx, msg->commandbytes.data, msg->commandbytes.len);
-    HMAC_Final(&ctx, hmac->data, &hmac->len);
-    HMAC_CTX_cleanup(&ctx);
+    if (signer != NULL) {
+        KineticHMACBatchJob job = {
+            .key = key,
+            .data = msg->commandbytes.data,
+            .len = msg->commandbytes.len,
+        };
+        KineticHMACBatch_Sign(signer, &job);
+        memcpy(hmac->data, job.tag, KINETIC_HMAC_SHA1_LEN);
+        hmac->len = KINETIC_HMAC_SHA1_LEN;
+        return job.success;
+    }
+
+    hmac->len = KINETIC_HMAC_SHA1_LEN;
+    return KineticHMAC_ComputeTag(key, msg->commandbytes.data, msg->commandbytes.len, hmac->data);
+}
+
+bool KineticHMAC_ComputeTag(const KineticHMACKey* key,
+                            const uint8_t* data, size_t len,
+                            uint8_t tag[KINETIC_HMAC_SHA1_LEN])
+{
+    KINETIC_ASSERT(key != NULL);
+    KINETIC_ASSERT(key->inner != NULL);
+    KINETIC_ASSERT(data != NULL || len == 0);
+    KINETIC_ASSERT(tag != NULL);
+
+    uint32_t lenNBO = KineticNBO_FromHostU32(len);
+
+    // Resume from the cached keyed states: H((K^opad) || H((K^ipad) || m))
+    EVP_MD_CTX* ctx = working_context();
+    if (ctx == NULL) {
+        LOG0("Failed allocating HMAC context!");
+        return false;
+    }
+    uint8_t innerHash[SHA_DIGEST_LENGTH];
+    unsigned int innerLen = 0;
+    bool success = EVP_MD_CTX_copy_ex(ctx, key->inner)
+        && EVP_DigestUpdate(ctx, &lenNBO, sizeof(uint32_t))
+        && EVP_DigestUpdate(ctx, data, len)
+        && EVP_DigestFinal_ex(ctx, innerHash, &innerLen)
+        && EVP_MD_CTX_copy_ex(ctx, key->outer)
+        && EVP_DigestUpdate(ctx, innerHash, innerLen)
+        && EVP_DigestFinal_ex(ctx, tag, NULL);
+    if (!success) {
+        LOG0("Failed computing HMAC!");
+    }
+    return success;
 }
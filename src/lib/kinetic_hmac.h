@@ -27,11 +27,22 @@
 void KineticHMAC_Init(KineticHMAC* hmac,
                       Com__Seagate__Kinetic__Proto__Command__Security__ACL__HMACAlgorithm algorithm);
 
-void KineticHMAC_Populate(KineticHMAC* hmac,
+/* Prepare the keyed inner and outer digest states for keyData, so they can
+ * be reused for every message signed with it. Returns false on failure. */
+bool KineticHMAC_InitKey(KineticHMACKey* key, const ByteArray keyData);
+void KineticHMAC_DestroyKey(KineticHMACKey* key);
+
+bool KineticHMAC_Populate(KineticHMAC* hmac,
                           Com__Seagate__Kinetic__Proto__Message* msg,
-                          const ByteArray key);
+                          const KineticHMACKey* key);
+
+/* Compute the raw HMAC-SHA1 tag over the length-prefixed data, as signed
+ * in a message's commandbytes. */
+bool KineticHMAC_ComputeTag(const KineticHMACKey* key,
+                            const uint8_t* data, size_t len,
+                            uint8_t tag[KINETIC_HMAC_SHA1_LEN]);
 
 bool KineticHMAC_Validate(const Com__Seagate__Kinetic__Proto__Message* msg,
-                          const ByteArray key);
+                          const KineticHMACKey* key);
 
 #endif  // _KINETIC_HMAC_H
@@ -0,0 +1,462 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_hmac_batch.h"
+#include "kinetic_hmac.h"
+#include "kinetic_logger.h"
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#define SHA1_BLOCK_LEN (64)
+#define SHA1_WORDS (5)
+#define LENGTH_PREFIX_LEN (4)
+#define MAX_LANES (16)
+
+#define ROTL(X, N) (((X) << (N)) | ((X) >> (32 - (N))))
+
+static const uint32_t SHA1_IV[SHA1_WORDS] = {
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0,
+};
+
+static uint32_t load_be32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void store_be32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void store_be64(uint8_t* p, uint64_t v)
+{
+    store_be32(p, (uint32_t)(v >> 32));
+    store_be32(p + 4, (uint32_t)v);
+}
+
+static void sha1_block(uint32_t state[SHA1_WORDS], const uint8_t* block)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) { w[i] = load_be32(&block[4 * i]); }
+    for (int i = 16; i < 80; i++) { w[i] = ROTL(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1); }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+        uint32_t t = ROTL(a, 5) + f + e + k + w[i];
+        e = d; d = c; c = ROTL(b, 30); b = a; a = t;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+}
+
+void KineticHMACBatch_BlockState(const uint8_t block[64], uint32_t state[5])
+{
+    memcpy(state, SHA1_IV, sizeof(SHA1_IV));
+    sha1_block(state, block);
+}
+
+/*******************************************************************************
+ * SIMD lanes
+ *
+ * Each engine compresses one block for each of its lanes. State is laid out
+ * word-major (state[word * lanes + lane]), and lanes whose active mask is zero
+ * keep their state, so messages with different block counts can share lanes.
+ ******************************************************************************/
+
+typedef void (*sha1_lanes_fn)(uint32_t* state, const uint8_t* const* blocks,
+    const uint32_t* active);
+
+#if defined(__GNUC__)
+
+#define SHA1_ROUND(F, K)                                                    \
+    do {                                                                    \
+        __typeof__(a) t_ = ROTL(a, 5) + (F) + e + (uint32_t)(K) + w[i & 15];           \
+        e = d; d = c; c = ROTL(b, 30); b = a; a = t_;                       \
+    } while (0)
+
+#define SHA1_SCHEDULE()                                                     \
+    do {                                                                    \
+        if (i >= 16) {                                                      \
+            __typeof__(a) x_ = w[(i - 3) & 15] ^ w[(i - 8) & 15] ^ w[(i - 14) & 15] ^ w[i & 15]; \
+            w[i & 15] = ROTL(x_, 1);                                        \
+        }                                                                   \
+    } while (0)
+
+// Defines NAME, compressing LANES blocks with the LANES x 32-bit vector type VT
+#define DEFINE_SHA1_LANES(NAME, VT, LANES, ATTRS)                           \
+ATTRS static void NAME(uint32_t* state, const uint8_t* const* blocks,       \
+    const uint32_t* active)                                                 \
+{                                                                           \
+    VT w[16], s[SHA1_WORDS], mask;                                          \
+    uint32_t words[16][(LANES)];                                            \
+    for (int l = 0; l < (LANES); l++) {                                     \
+        for (int i = 0; i < 16; i++) {                                      \
+            words[i][l] = load_be32(&blocks[l][4 * i]);                     \
+        }                                                                   \
+    }                                                                       \
+    memcpy(w, words, sizeof(w));                                            \
+    memcpy(s, state, sizeof(s));                                            \
+    memcpy(&mask, active, sizeof(mask));                                    \
+    VT a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];                    \
+    int i = 0;                                                              \
+    for (; i < 20; i++) { SHA1_SCHEDULE(); SHA1_ROUND((b & c) | (~b & d), 0x5A827999); } \
+    for (; i < 40; i++) { SHA1_SCHEDULE(); SHA1_ROUND(b ^ c ^ d, 0x6ED9EBA1); } \
+    for (; i < 60; i++) { SHA1_SCHEDULE(); SHA1_ROUND((b & c) | (b & d) | (c & d), 0x8F1BBCDC); } \
+    for (; i < 80; i++) { SHA1_SCHEDULE(); SHA1_ROUND(b ^ c ^ d, 0xCA62C1D6); } \
+    s[0] = ((s[0] + a) & mask) | (s[0] & ~mask);                            \
+    s[1] = ((s[1] + b) & mask) | (s[1] & ~mask);                            \
+    s[2] = ((s[2] + c) & mask) | (s[2] & ~mask);                            \
+    s[3] = ((s[3] + d) & mask) | (s[3] & ~mask);                            \
+    s[4] = ((s[4] + e) & mask) | (s[4] & ~mask);                            \
+    memcpy(state, s, sizeof(s));                                            \
+}
+
+typedef uint32_t lanes4 __attribute__((vector_size(16)));
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KINETIC_HMAC_X86 1
+typedef uint32_t lanes8 __attribute__((vector_size(32)));
+typedef uint32_t lanes16 __attribute__((vector_size(64)));
+DEFINE_SHA1_LANES(sha1_lanes_sse2, lanes4, 4, __attribute__((target("sse2"))))
+DEFINE_SHA1_LANES(sha1_lanes_avx2, lanes8, 8, __attribute__((target("avx2"))))
+DEFINE_SHA1_LANES(sha1_lanes_avx512, lanes16, 16, __attribute__((target("avx512f"))))
+static bool has_sse2(void) { return __builtin_cpu_supports("sse2"); }
+static bool has_avx2(void) { return __builtin_cpu_supports("avx2"); }
+static bool has_avx512(void) { return __builtin_cpu_supports("avx512f"); }
+#else
+// Let the compiler map the generic vectors onto whatever SIMD unit it has
+DEFINE_SHA1_LANES(sha1_lanes_simd, lanes4, 4, )
+static bool has_simd(void) { return true; }
+#endif
+
+#endif // __GNUC__
+
+typedef struct {
+    const char* name;
+    size_t lanes;                   // 0 for the one-at-a-time OpenSSL path
+    sha1_lanes_fn compress;
+    bool (*supported)(void);
+} hmac_engine;
+
+// Widest first, so the default is the first one supported
+static const hmac_engine Engines[] = {
+#if defined(KINETIC_HMAC_X86)
+    {"avx512", 16, sha1_lanes_avx512, has_avx512},
+    {"avx2", 8, sha1_lanes_avx2, has_avx2},
+    {"sse2", 4, sha1_lanes_sse2, has_sse2},
+#elif defined(__GNUC__)
+    {"simd", 4, sha1_lanes_simd, has_simd},
+#endif
+    {"openssl", 0, NULL, NULL},
+};
+
+static const hmac_engine* Engine = NULL;
+static pthread_once_t EngineOnce = PTHREAD_ONCE_INIT;
+
+static void select_default_engine(void)
+{
+    for (size_t i = 0; i < NUM_ELEMENTS(Engines); i++) {
+        if (Engines[i].supported == NULL || Engines[i].supported()) {
+            Engine = &Engines[i];
+            break;
+        }
+    }
+    LOGF1("Using %s HMAC-SHA1 engine", Engine->name);
+}
+
+static const hmac_engine* get_engine(void)
+{
+    pthread_once(&EngineOnce, select_default_engine);
+    return Engine;
+}
+
+bool KineticHMACBatch_SetEngine(const char* name)
+{
+    KINETIC_ASSERT(name != NULL);
+    get_engine();
+    for (size_t i = 0; i < NUM_ELEMENTS(Engines); i++) {
+        if (strcmp(Engines[i].name, name) == 0) {
+            if (Engines[i].supported != NULL && !Engines[i].supported()) {
+                return false;
+            }
+            Engine = &Engines[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* KineticHMACBatch_EngineName(void)
+{
+    return get_engine()->name;
+}
+
+/*******************************************************************************
+ * Batch signing
+ ******************************************************************************/
+
+// A lane's message: the inner hash covers the 4-byte length prefix, the
+// command bytes, and SHA-1 padding, following the key block
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    uint8_t prefix[LENGTH_PREFIX_LEN];
+    size_t blocks;
+    uint8_t scratch[SHA1_BLOCK_LEN];
+} lane_message;
+
+static void lane_init(lane_message* m, const KineticHMACBatchJob* job)
+{
+    m->data = job->data;
+    m->len = job->len;
+    store_be32(m->prefix, (uint32_t)job->len);
+    m->blocks = (LENGTH_PREFIX_LEN + job->len + 1 + 8 + SHA1_BLOCK_LEN - 1) / SHA1_BLOCK_LEN;
+}
+
+// Block index of the message, pointing into the data where possible
+static const uint8_t* lane_block(lane_message* m, size_t index)
+{
+    size_t start = index * SHA1_BLOCK_LEN;
+    size_t end = start + SHA1_BLOCK_LEN;
+    size_t total = LENGTH_PREFIX_LEN + m->len;
+    if (start >= LENGTH_PREFIX_LEN && end <= total) {
+        return &m->data[start - LENGTH_PREFIX_LEN];
+    }
+
+    uint8_t* block = m->scratch;
+    memset(block, 0, SHA1_BLOCK_LEN);
+    for (size_t i = start; i < LENGTH_PREFIX_LEN && i < end; i++) {
+        block[i - start] = m->prefix[i];
+    }
+    size_t from = (start > LENGTH_PREFIX_LEN) ? start : LENGTH_PREFIX_LEN;
+    size_t to = (end < total) ? end : total;
+    if (from < to) {
+        memcpy(&block[from - start], &m->data[from - LENGTH_PREFIX_LEN], to - from);
+    }
+    if (total >= start && total < end) {
+        block[total - start] = 0x80;
+    }
+    if (index == m->blocks - 1) {
+        store_be64(&block[SHA1_BLOCK_LEN - 8], (uint64_t)(SHA1_BLOCK_LEN + total) * 8);
+    }
+    return block;
+}
+
+static void sign_lanes(const hmac_engine* engine, KineticHMACBatchJob* const* jobs, size_t count)
+{
+    static const uint8_t idleBlock[SHA1_BLOCK_LEN];
+    const size_t lanes = engine->lanes;
+    lane_message msgs[MAX_LANES];
+    uint32_t state[SHA1_WORDS * MAX_LANES];
+    uint32_t active[MAX_LANES];
+    const uint8_t* blocks[MAX_LANES];
+    size_t maxBlocks = 0;
+
+    KINETIC_ASSERT(count <= lanes);
+    for (size_t l = 0; l < lanes; l++) {
+        blocks[l] = idleBlock;
+        active[l] = 0;
+        for (size_t w = 0; w < SHA1_WORDS; w++) {
+            state[w * lanes + l] = (l < count) ? jobs[l]->key->innerState[w] : 0;
+        }
+        if (l < count) {
+            lane_init(&msgs[l], jobs[l]);
+            if (msgs[l].blocks > maxBlocks) { maxBlocks = msgs[l].blocks; }
+        }
+    }
+
+    // Inner hash: H((K ^ ipad) || prefix || data), resuming after the key block
+    for (size_t b = 0; b < maxBlocks; b++) {
+        for (size_t l = 0; l < count; l++) {
+            bool live = b < msgs[l].blocks;
+            active[l] = live ? 0xFFFFFFFF : 0;
+            blocks[l] = live ? lane_block(&msgs[l], b) : idleBlock;
+        }
+        engine->compress(state, blocks, active);
+    }
+
+    // Outer hash: H((K ^ opad) || inner), a single block
+    for (size_t l = 0; l < count; l++) {
+        uint8_t* block = msgs[l].scratch;
+        memset(block, 0, SHA1_BLOCK_LEN);
+        for (size_t w = 0; w < SHA1_WORDS; w++) {
+            store_be32(&block[4 * w], state[w * lanes + l]);
+            state[w * lanes + l] = jobs[l]->key->outerState[w];
+        }
+        block[KINETIC_HMAC_SHA1_LEN] = 0x80;
+        store_be64(&block[SHA1_BLOCK_LEN - 8], (SHA1_BLOCK_LEN + KINETIC_HMAC_SHA1_LEN) * 8);
+        blocks[l] = block;
+        active[l] = 0xFFFFFFFF;
+    }
+    engine->compress(state, blocks, active);
+
+    for (size_t l = 0; l < count; l++) {
+        for (size_t w = 0; w < SHA1_WORDS; w++) {
+            store_be32(&jobs[l]->tag[4 * w], state[w * lanes + l]);
+        }
+        jobs[l]->success = true;
+    }
+}
+
+static void sign_one(KineticHMACBatchJob* job)
+{
+    job->success = KineticHMAC_ComputeTag(job->key, job->data, job->len, job->tag);
+}
+
+void KineticHMACBatch_Compute(KineticHMACBatchJob* const* jobs, size_t count)
+{
+    const hmac_engine* engine = get_engine();
+    size_t lanes = engine->lanes;
+    if (lanes == 0 || count < lanes / 2) {
+        for (size_t i = 0; i < count; i++) { sign_one(jobs[i]); }
+        return;
+    }
+
+    // Sort by length, so messages sharing lanes finish at about the same time
+    KineticHMACBatchJob* sorted[KINETIC_HMAC_BATCH_MAX];
+    while (count > 0) {
+        size_t n = (count < KINETIC_HMAC_BATCH_MAX) ? count : KINETIC_HMAC_BATCH_MAX;
+        for (size_t i = 0; i < n; i++) {
+            KineticHMACBatchJob* job = jobs[i];
+            size_t j = i;
+            for (; j > 0 && sorted[j - 1]->len > job->len; j--) {
+                sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = job;
+        }
+
+        size_t i = 0;
+        while (n - i >= lanes / 2 && i < n) {
+            size_t group = (n - i < lanes) ? n - i : lanes;
+            sign_lanes(engine, &sorted[i], group);
+            i += group;
+        }
+        // Too few left to be worth a pass through the lanes
+        for (; i < n; i++) { sign_one(sorted[i]); }
+
+        jobs += n;
+        count -= n;
+    }
+}
+
+/*******************************************************************************
+ * Combining signer
+ ******************************************************************************/
+
+bool KineticHMACBatch_InitSigner(KineticHMACBatchSigner* signer)
+{
+    KINETIC_ASSERT(signer != NULL);
+    signer->busy = false;
+    signer->pending = NULL;
+    if (pthread_mutex_init(&signer->mutex, NULL) != 0) { return false; }
+    if (pthread_cond_init(&signer->signedCond, NULL) != 0) {
+        pthread_mutex_destroy(&signer->mutex);
+        return false;
+    }
+    return true;
+}
+
+void KineticHMACBatch_DestroySigner(KineticHMACBatchSigner* signer)
+{
+    KINETIC_ASSERT(signer != NULL);
+    KINETIC_ASSERT(!signer->busy && signer->pending == NULL);
+    pthread_cond_destroy(&signer->signedCond);
+    pthread_mutex_destroy(&signer->mutex);
+}
+
+// Take a job back off the pending list, unless a batch has claimed it
+static bool withdraw_pending(KineticHMACBatchSigner* signer, KineticHMACBatchJob* job)
+{
+    for (KineticHMACBatchJob** link = &signer->pending; *link != NULL; link = &(*link)->next) {
+        if (*link == job) {
+            *link = job->next;
+            return true;
+        }
+    }
+    return false;
+}
+
+void KineticHMACBatch_Sign(KineticHMACBatchSigner* signer, KineticHMACBatchJob* job)
+{
+    KINETIC_ASSERT(signer != NULL);
+    KINETIC_ASSERT(job != NULL);
+    KINETIC_ASSERT(job->key != NULL);
+    job->complete = false;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += KINETIC_HMAC_BATCH_MAX_WAIT_US * 1000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    bool claimed = false;   // in a batch being signed, so no longer ours to withdraw
+
+    pthread_mutex_lock(&signer->mutex);
+    job->next = signer->pending;
+    signer->pending = job;
+
+    while (!job->complete) {
+        if (signer->busy) {
+            if (claimed) {
+                pthread_cond_wait(&signer->signedCond, &signer->mutex);
+            } else if (pthread_cond_timedwait(&signer->signedCond, &signer->mutex, &deadline) == ETIMEDOUT) {
+                if (withdraw_pending(signer, job)) {
+                    // Don't wait out the batch ahead; sign this one directly
+                    pthread_mutex_unlock(&signer->mutex);
+                    sign_one(job);
+                    job->complete = true;
+                    return;
+                }
+                claimed = true;
+            }
+            continue;
+        }
+
+        // Sign everything pending (up to a batch) on this thread
+        signer->busy = true;
+        KineticHMACBatchJob* batch[KINETIC_HMAC_BATCH_MAX];
+        size_t count = 0;
+        while (signer->pending != NULL && count < KINETIC_HMAC_BATCH_MAX) {
+            batch[count++] = signer->pending;
+            signer->pending = signer->pending->next;
+        }
+        pthread_mutex_unlock(&signer->mutex);
+
+        KineticHMACBatch_Compute(batch, count);
+
+        pthread_mutex_lock(&signer->mutex);
+        for (size_t i = 0; i < count; i++) {
+            batch[i]->complete = true;
+        }
+        signer->busy = false;
+        pthread_cond_broadcast(&signer->signedCond);
+    }
+    pthread_mutex_unlock(&signer->mutex);
+}
@@ -0,0 +1,68 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_HMAC_BATCH_H
+#define _KINETIC_HMAC_BATCH_H
+
+#include "kinetic_types_internal.h"
+
+// Multi-buffer HMAC-SHA1: signs several messages at once by running their
+// SHA-1 compressions side by side in SIMD lanes. Batches too small to fill
+// the lanes are signed one at a time through OpenSSL.
+
+// Upper bound on the messages signed together by KineticHMACBatch_Sign
+#define KINETIC_HMAC_BATCH_MAX (64)
+
+// Longest a job waits for the batch ahead of it before signing itself
+#define KINETIC_HMAC_BATCH_MAX_WAIT_US (100)
+
+typedef struct _KineticHMACBatchJob {
+    const KineticHMACKey* key;
+    const uint8_t* data;                    // command bytes; signed with their length prefix
+    size_t len;
+    uint8_t tag[KINETIC_HMAC_SHA1_LEN];     // result
+    bool success;                           // false if the tag could not be computed
+    bool complete;                          // set once signed (KineticHMACBatch_Sign only)
+    struct _KineticHMACBatchJob* next;      // pending list link (KineticHMACBatch_Sign only)
+} KineticHMACBatchJob;
+
+/* Compute the SHA-1 state after compressing one block from the initial
+ * state; used for the padded HMAC key blocks. */
+void KineticHMACBatch_BlockState(const uint8_t block[64], uint32_t state[5]);
+
+/* Sign count jobs on the calling thread. */
+void KineticHMACBatch_Compute(KineticHMACBatchJob* const* jobs, size_t count);
+
+bool KineticHMACBatch_InitSigner(KineticHMACBatchSigner* signer);
+void KineticHMACBatch_DestroySigner(KineticHMACBatchSigner* signer);
+
+/* Sign a job, combining it with any jobs other threads submit to the same
+ * signer meanwhile: whichever thread finds the signer idle signs everything
+ * pending, while the others wait for their tags. A job still waiting for a
+ * batch after KINETIC_HMAC_BATCH_MAX_WAIT_US is signed by its own thread. */
+void KineticHMACBatch_Sign(KineticHMACBatchSigner* signer, KineticHMACBatchJob* job);
+
+/* Select the engine by name ("openssl", "sse2", "avx2", "avx512", or
+ * "simd" for the generic vector engine). Returns false if it is not
+ * available on this CPU. The widest available engine is used by default. */
+bool KineticHMACBatch_SetEngine(const char* name);
+const char* KineticHMACBatch_EngineName(void);
+
+#endif // _KINETIC_HMAC_BATCH_H
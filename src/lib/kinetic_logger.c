@@ -33,20 +33,50 @@
 #define BUFFER_SIZE 1024
 #define BUFFER_MAX_STRLEN (BUFFER_SIZE-2)
 
-STATIC int KineticLogLevel = -1;
+// Each logging thread owns a ring of RING_SLOTS records (power of two) which
+// the writer thread drains to the log file every WRITER_PERIOD_NS
+#define RING_SLOTS 256
+#define WRITER_PERIOD_NS (10 * 1000 * 1000)
+
+typedef struct {
+    struct timespec timestamp;  // captured at the call site
+    int len;
+    char text[BUFFER_SIZE];
+} log_record;
+
+typedef struct _log_ring {
+    struct _log_ring* next;
+    volatile uint32_t head;     // only advanced by the owning thread
+    volatile uint32_t tail;     // only advanced by the drain
+    volatile uint32_t dropped;  // records lost to overflow, not yet reported
+    volatile bool retired;      // owning thread has exited
+    uint32_t drainHead;
+    log_record records[RING_SLOTS];
+} log_ring;
+
+int KineticLogLevel = -1;
 static FILE* KineticLoggerHandle = NULL;
-static pthread_mutex_t BufferMutex = PTHREAD_MUTEX_INITIALIZER;
-static char Buffer[BUFFER_SIZE];
+
+static pthread_once_t RingKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t RingKey;
+
+// Guards the ring list and serializes draining; never taken to log a message
+// except once per thread, when its ring is registered
+static pthread_mutex_t RingsMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t WriterCond = PTHREAD_COND_INITIALIZER;
+static log_ring* Rings = NULL;
+static uint64_t DroppedTotal = 0;
+static pthread_t WriterThread;
+static volatile bool WriterRunning = false;
 
 //------------------------------------------------------------------------------
 // Private Method Declarations
 
 static inline bool is_level_enabled(int log_level);
-static inline void lock_buffer(void);
-static inline void unlock_buffer(void);
-static void flush_buffer(void);
-static inline char* get_buffer(void);
-static inline void finish_buffer(void);
+static log_ring* get_ring(void);
+static void drain_rings(void);
+static void start_writer(void);
+static void stop_writer(void);
 static void log_protobuf_message(int log_level, const ProtobufCMessage *msg, char* indent);
 static void log_version_info(void);
 
@@ -55,8 +85,8 @@ static void log_version_info(void);
 
 void KineticLogger_Init(const char* log_file, int log_level)
 {
+    KineticLogger_Close();
     KineticLogLevel = -1;
-    pthread_mutex_init(&BufferMutex, NULL);
 
     KineticLoggerHandle = NULL;
     if (log_file == NULL) {
@@ -79,18 +109,42 @@ void KineticLogger_Init(const char* log_file, int log_level)
             KineticLoggerHandle = fopen(log_file, "a+");
             KINETIC_ASSERT(KineticLoggerHandle != NULL);
         }
+        start_writer();
         log_version_info();
     }
 }
 
 void KineticLogger_Close(void)
 {
+    stop_writer();
+
+    pthread_mutex_lock(&RingsMutex);
+    drain_rings();
     if (KineticLogLevel >= 0 && KineticLoggerHandle != NULL) {
         if (KineticLoggerHandle != stdout) {
             fclose(KineticLoggerHandle);
         }
         KineticLoggerHandle = NULL;
     }
+    pthread_mutex_unlock(&RingsMutex);
+}
+
+void KineticLogger_Flush(void)
+{
+    pthread_mutex_lock(&RingsMutex);
+    drain_rings();
+    pthread_mutex_unlock(&RingsMutex);
+}
+
+uint64_t KineticLogger_GetDroppedCount(void)
+{
+    pthread_mutex_lock(&RingsMutex);
+    uint64_t dropped = DroppedTotal;
+    for (log_ring* ring = Rings; ring != NULL; ring = ring->next) {
+        dropped += ring->dropped;
+    }
+    pthread_mutex_unlock(&RingsMutex);
+    return dropped;
 }
 
 void KineticLogger_Log(int log_level, const char* message)
@@ -107,27 +161,47 @@ void KineticLogger_LogPrintf(int log_level, const char* format, ...)
         return;
     }
 
-    char* buffer = NULL;
-    buffer = get_buffer();
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
 
-    /* Add timestamp prefix */
-    struct timeval tv;
-    if (0 == gettimeofday(&tv, NULL)) {
-        fprintf(KineticLoggerHandle, "%08lld.%06lld  ",
-            (long long)tv.tv_sec, (long long)tv.tv_usec);
+    log_ring* ring = get_ring();
+    if (ring == NULL) {
+        __sync_fetch_and_add(&DroppedTotal, 1);
+        return;
     }
-    
+
+    // Never block on a full ring; the drain reports what was lost
+    uint32_t head = ring->head;
+    uint32_t used = head - ring->tail;
+    if (used >= RING_SLOTS) {
+        __sync_fetch_and_add(&ring->dropped, 1);
+        return;
+    }
+    __sync_synchronize();
+
+    log_record* record = &ring->records[head & (RING_SLOTS - 1)];
+    record->timestamp = now;
     va_list arg_ptr;
     va_start(arg_ptr, format);
-    int len = vsnprintf(buffer, BUFFER_MAX_STRLEN, format, arg_ptr);
+    int len = vsnprintf(record->text, BUFFER_MAX_STRLEN, format, arg_ptr);
     va_end(arg_ptr);
+    if (len < 0) {
+        len = 0;
+    }
+    else if (len >= BUFFER_MAX_STRLEN) {
+        len = BUFFER_MAX_STRLEN - 1;
+    }
+    record->len = len;
 
-    if (len > BUFFER_MAX_STRLEN) {
-        Buffer[BUFFER_MAX_STRLEN] = '\0';
+    __sync_synchronize();
+    ring->head = head + 1;
+
+    if (!WriterRunning) {
+        KineticLogger_Flush();
+    }
+    else if (used == RING_SLOTS / 4) {
+        pthread_cond_signal(&WriterCond);
     }
-    strcat(Buffer, "\n");
-    
-    finish_buffer();
 }
 
 static void log_version_info(void)
@@ -550,30 +624,149 @@ static inline bool is_level_enabled(int log_level)
     return (log_level <= KineticLogLevel && KineticLogLevel >= 0);
 }
 
-static inline void lock_buffer(void)
+static void retire_ring(void* arg)
 {
-    pthread_mutex_lock(&BufferMutex);
+    log_ring* ring = arg;
+    __sync_synchronize();
+    ring->retired = true;
 }
 
-static inline void unlock_buffer()
+static void create_ring_key(void)
 {
-    pthread_mutex_unlock(&BufferMutex);
+    pthread_key_create(&RingKey, retire_ring);
 }
 
-static void flush_buffer(void)
+static log_ring* get_ring(void)
 {
-    fprintf(KineticLoggerHandle, "%s", Buffer);
-    fflush(KineticLoggerHandle);
+    pthread_once(&RingKeyOnce, create_ring_key);
+    log_ring* ring = pthread_getspecific(RingKey);
+    if (ring == NULL) {
+        ring = calloc(1, sizeof(*ring));
+        if (ring == NULL) {
+            return NULL;
+        }
+        if (pthread_setspecific(RingKey, ring) != 0) {
+            free(ring);
+            return NULL;
+        }
+        pthread_mutex_lock(&RingsMutex);
+        ring->next = Rings;
+        Rings = ring;
+        pthread_mutex_unlock(&RingsMutex);
+    }
+    return ring;
 }
 
-static inline char* get_buffer()
+static inline bool is_earlier(const struct timespec* a, const struct timespec* b)
 {
-    lock_buffer();
-    return Buffer;
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
 }
 
-static inline void finish_buffer(void)
+// Write out everything published so far, merged across threads in timestamp
+// order, then release rings whose threads have exited. Called with RingsMutex
+// held.
+static void drain_rings(void)
 {
-    flush_buffer();
-    unlock_buffer();
+    FILE* handle = KineticLoggerHandle;
+
+    for (log_ring* ring = Rings; ring != NULL; ring = ring->next) {
+        ring->drainHead = ring->head;
+    }
+    __sync_synchronize();
+
+    for (;;) {
+        log_ring* oldest = NULL;
+        for (log_ring* ring = Rings; ring != NULL; ring = ring->next) {
+            if (ring->tail != ring->drainHead && (oldest == NULL ||
+                is_earlier(&ring->records[ring->tail & (RING_SLOTS - 1)].timestamp,
+                    &oldest->records[oldest->tail & (RING_SLOTS - 1)].timestamp))) {
+                oldest = ring;
+            }
+        }
+        if (oldest == NULL) {
+            break;
+        }
+
+        log_record* record = &oldest->records[oldest->tail & (RING_SLOTS - 1)];
+        if (handle != NULL) {
+            fprintf(handle, "%08lld.%06lld  %.*s\n",
+                (long long)record->timestamp.tv_sec,
+                (long long)record->timestamp.tv_nsec / 1000,
+                record->len, record->text);
+        }
+        __sync_synchronize();
+        oldest->tail = oldest->tail + 1;
+    }
+
+    uint32_t dropped = 0;
+    for (log_ring** link = &Rings; *link != NULL;) {
+        log_ring* ring = *link;
+        dropped += __sync_fetch_and_and(&ring->dropped, 0);
+        if (ring->retired && ring->tail == ring->head) {
+            *link = ring->next;
+            free(ring);
+        }
+        else {
+            link = &ring->next;
+        }
+    }
+    if (dropped > 0) {
+        __sync_fetch_and_add(&DroppedTotal, dropped);
+        if (handle != NULL) {
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            fprintf(handle, "%08lld.%06lld  kinetic-c logger: %u messages dropped (ring full)\n",
+                (long long)now.tv_sec, (long long)now.tv_nsec / 1000, dropped);
+        }
+    }
+
+    if (handle != NULL) {
+        fflush(handle);
+    }
+}
+
+static void* writer_thread(void* arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&RingsMutex);
+    while (WriterRunning) {
+        drain_rings();
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += WRITER_PERIOD_NS;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&WriterCond, &RingsMutex, &deadline);
+    }
+    drain_rings();
+    pthread_mutex_unlock(&RingsMutex);
+    return NULL;
+}
+
+static void start_writer(void)
+{
+#if KINETIC_LOGGER_FLUSH_THREAD_ENABLED
+    pthread_mutex_lock(&RingsMutex);
+    WriterRunning = true;
+    if (pthread_create(&WriterThread, NULL, writer_thread, NULL) != 0) {
+        // Fall back to writing synchronously from the logging threads
+        WriterRunning = false;
+    }
+    pthread_mutex_unlock(&RingsMutex);
+#endif
+}
+
+static void stop_writer(void)
+{
+    pthread_mutex_lock(&RingsMutex);
+    bool running = WriterRunning;
+    WriterRunning = false;
+    pthread_cond_signal(&WriterCond);
+    pthread_mutex_unlock(&RingsMutex);
+
+    if (running) {
+        pthread_join(WriterThread, NULL);
+    }
 }
@@ -26,12 +26,14 @@
 #include <stdarg.h>
 
 #define KINETIC_LOGGER_DISABLED false
-#define KINETIC_LOGGER_FLUSH_THREAD_ENABLED false
+#define KINETIC_LOGGER_FLUSH_THREAD_ENABLED true
 #define KINETIC_LOGGER_LOG_SEQUENCE_ID true
 #define KINETIC_LOG_FILE "kinetic.log"
 
 void KineticLogger_Init(const char* logFile, int log_level);
 void KineticLogger_Close(void);
+void KineticLogger_Flush(void);
+uint64_t KineticLogger_GetDroppedCount(void);
 void KineticLogger_Log(int log_level, const char* message);
 void KineticLogger_LogPrintf(int log_level, const char* format, ...);
 void KineticLogger_LogLocation(const char* filename, int line, const char * message);
@@ -47,23 +49,44 @@ int KineticLogger_ByteArraySliceToCString(char* p_buf, const ByteArray bytes, co
     KineticLogger_ByteArraySliceToCString((char*)(_buf_start), (__array), (_array_start), (_count)); \
 }
 
+// Current runtime log level, or -1 if logging is disabled
+extern int KineticLogLevel;
+
+// Building with -DKINETIC_LOG_LEVEL_MAX=<n> compiles out every log statement
+// above level n; the remaining ones test the runtime level inline, so their
+// arguments are only evaluated when the message will actually be logged.
+#ifdef KINETIC_LOG_LEVEL_MAX
+#define KINETIC_LOG_ENABLED(level) \
+    ((level) <= KINETIC_LOG_LEVEL_MAX && (level) <= KineticLogLevel)
+#else
+#define KINETIC_LOG_ENABLED(level) ((level) <= KineticLogLevel)
+#endif
+
+#define KINETIC_LOG_IF_ENABLED(level, statement) \
+    do { if (KINETIC_LOG_ENABLED(level)) { statement; } } while (0)
+
 // #define LOG(message)  KineticLogger_Log(2, message)
 #if !KINETIC_LOGGER_DISABLED
 
-#define LOG0(message) KineticLogger_Log(0, message)
-#define LOG1(message) KineticLogger_Log(1, message)
-#define LOG2(message) KineticLogger_Log(2, message)
-#define LOG3(message) KineticLogger_Log(3, message)
-#define LOGF0(message, ...) KineticLogger_LogPrintf(0, message, __VA_ARGS__)
-#define LOGF1(message, ...) KineticLogger_LogPrintf(1, message, __VA_ARGS__)
-#define LOGF2(message, ...) KineticLogger_LogPrintf(2, message, __VA_ARGS__)
-#define LOGF3(message, ...) KineticLogger_LogPrintf(3, message, __VA_ARGS__)
+#define LOG0(message) KINETIC_LOG_IF_ENABLED(0, KineticLogger_Log(0, message))
+#define LOG1(message) KINETIC_LOG_IF_ENABLED(1, KineticLogger_Log(1, message))
+#define LOG2(message) KINETIC_LOG_IF_ENABLED(2, KineticLogger_Log(2, message))
+#define LOG3(message) KINETIC_LOG_IF_ENABLED(3, KineticLogger_Log(3, message))
+#define LOGF0(message, ...) KINETIC_LOG_IF_ENABLED(0, KineticLogger_LogPrintf(0, message, __VA_ARGS__))
+#define LOGF1(message, ...) KINETIC_LOG_IF_ENABLED(1, KineticLogger_LogPrintf(1, message, __VA_ARGS__))
+#define LOGF2(message, ...) KINETIC_LOG_IF_ENABLED(2, KineticLogger_LogPrintf(2, message, __VA_ARGS__))
+#define LOGF3(message, ...) KINETIC_LOG_IF_ENABLED(3, KineticLogger_LogPrintf(3, message, __VA_ARGS__))
+#define LOG_HEADER(level, header) KINETIC_LOG_IF_ENABLED(level, KineticLogger_LogHeader(level, header))
+#define LOG_PROTOBUF(level, msg) KINETIC_LOG_IF_ENABLED(level, KineticLogger_LogProtobuf(level, msg))
+#define LOG_BYTE_ARRAY(level, title, bytes) \
+    KINETIC_LOG_IF_ENABLED(level, KineticLogger_LogByteArray(level, title, bytes))
 #define LOG_LOCATION  KineticLogger_LogLocation(__FILE__, __LINE__, __func__);
 #define KINETIC_ASSERT(cond) { \
         if(!(cond)) \
         { \
             LOGF0("ASSERT FAILURE at %s:%d in %s: assert(" #cond ")", \
             __FILE__, (int)__LINE__, __FUNCTION__); \
+            KineticLogger_Flush(); \
             assert(cond); \
         } \
     }
@@ -78,6 +101,9 @@ int KineticLogger_ByteArraySliceToCString(char* p_buf, const ByteArray bytes, co
 #define LOGF1(message, ...)
 #define LOGF2(message, ...)
 #define LOGF3(message, ...)
+#define LOG_HEADER(level, header)
+#define LOG_PROTOBUF(level, msg)
+#define LOG_BYTE_ARRAY(level, title, bytes)
 #define LOG_LOCATION
 #define KINETIC_ASSERT(cond)
 
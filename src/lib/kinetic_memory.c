@@ -26,6 +26,11 @@ void * KineticCalloc(size_t count, size_t size)
     return calloc(count, size);
 }
 
+void * KineticMalloc(size_t size)
+{
+    return malloc(size);
+}
+
 void KineticFree(void * pointer)
 {
     free(pointer);
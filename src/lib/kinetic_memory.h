@@ -24,6 +24,7 @@
 #include <stddef.h>
 
 void * KineticCalloc(size_t count, size_t size);
+void * KineticMalloc(size_t size);
 void KineticFree(void * pointer);
 
 #endif // _KINETIC_MEMORY_H
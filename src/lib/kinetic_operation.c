@@ -27,6 +27,9 @@
 #include "kinetic_allocator.h"
 #include "kinetic_logger.h"
 #include "kinetic_request.h"
+#include "kinetic_trace.h"
+#include "kinetic_stats.h"
+#include "kinetic_clock.h"
 
 #include <stdlib.h>
 #include <errno.h>
@@ -50,20 +53,8 @@ void KineticOperation_ValidateOperation(KineticOperation* op)
     KINETIC_ASSERT(op->request->command->header->has_sequence);
 }
 
-static KineticStatus send_request_in_lock(KineticOperation* const op);
-
-KineticStatus KineticOperation_SendRequest(KineticOperation* const op)
-{
-    KineticSession *session = op->session;
-    KineticOperation_ValidateOperation(op);
-    
-    if (!KineticRequest_LockSend(session)) {
-        return KINETIC_STATUS_CONNECTION_ERROR;
-    }
-    KineticStatus status = send_request_in_lock(op);
-    KineticRequest_UnlockSend(session);
-    return status;
-}
+static KineticStatus send_request_in_turn(KineticOperation* const op,
+    uint8_t * msg, size_t msgSize);
 
 static void log_request_seq_id(int fd, int64_t seq_id, KineticMessageType mt)
 {
@@ -85,48 +76,71 @@ static void log_request_seq_id(int fd, int64_t seq_id, KineticMessageType mt)
     #endif
 }
 
-/* Send request.
- * Note: This whole function operates with op->session->sendMutex locked. */
-static KineticStatus send_request_in_lock(KineticOperation* const op)
+KineticStatus KineticOperation_SendRequest(KineticOperation* const op)
 {
-    LOGF3("\nSending PDU via fd=%d", op->session->socket);
+    KineticSession *session = op->session;
+    KineticOperation_ValidateOperation(op);
+    op->timestamps.submitted = KineticClock_Now();
+    LOGF3("\nSending PDU via fd=%d", session->socket);
     KineticRequest* request = op->request;
 
-    int64_t seq_id = KineticSession_GetNextSequenceCount(op->session);
+    // Reserving the sequence number is the only step serialized across
+    // threads; the command is packed and signed concurrently, since its
+    // sequence number is part of the signed bytes.
+    int64_t seq_id = KineticSession_GetNextSequenceCount(session);
     KINETIC_ASSERT(request->message.header.sequence == KINETIC_SEQUENCE_NOT_YET_BOUND);
     request->message.header.sequence = seq_id;
 
-    size_t expectedLen = KineticRequest_PackCommand(request);
-    if (expectedLen == KINETIC_REQUEST_PACK_FAILURE) {
-        return KINETIC_STATUS_MEMORY_ERROR;
-    }
-    uint8_t * commandData = request->message.message.commandbytes.data;
-
-    log_request_seq_id(op->session->socket, seq_id, request->message.header.messagetype);
-
-    KineticSession *session = op->session;
-    KineticStatus status = KineticRequest_PopulateAuthentication(&session->config,
-        op->request, op->pin);
-    if (status != KINETIC_STATUS_SUCCESS) {
-        if (commandData) { free(commandData); }
-        return status;        
-    }
+    log_request_seq_id(session->socket, seq_id, request->message.header.messagetype);
+    int messageType = request->message.header.messagetype;
+    KINETIC_TRACE_SPAN(KINETIC_TRACE_BUILD, session->socket, seq_id, messageType, op->traceStart);
 
     #ifndef TEST
     uint8_t * msg = NULL;
     size_t msgSize = 0;
     #endif
-    status = KineticRequest_PackMessage(op, &msg, &msgSize);
-    if (status != KINETIC_STATUS_SUCCESS) {
-        if (commandData) { free(commandData); }
-        return status;
+    uint64_t traceStart = KINETIC_TRACE_START();
+    KineticStatus status = KineticRequest_PackPDU(op, &msg, &msgSize);
+    KINETIC_TRACE_SPAN(KINETIC_TRACE_PACK, session->socket, seq_id, messageType, traceStart);
+    op->bytesSent = msgSize;
+
+    // The bus requires sequence numbers to increase on the wire, so hand the
+    // packed PDUs over in the order their sequence numbers were reserved. A
+    // request that failed to pack must still pass its turn on.
+    traceStart = KINETIC_TRACE_START();
+    KineticRequest_AwaitSendTurn(session, seq_id);
+    op->timestamps.sendTurn = KineticClock_Now();
+    KINETIC_TRACE_SPAN(KINETIC_TRACE_SEND_TURN, session->socket, seq_id, messageType, traceStart);
+    if (status == KINETIC_STATUS_SUCCESS) {
+        status = send_request_in_turn(op, msg, msgSize);
     }
+    // op may already be completed and freed once sent, so only use the session
+    KineticRequest_PassSendTurn(session, seq_id);
+    return status;
+}
+
+/* Send request.
+ * Note: This is called while holding the session's send turn, so no other
+ * request on the session can be sent until it returns. */
+static KineticStatus send_request_in_turn(KineticOperation* const op,
+    uint8_t * msg, size_t msgSize)
+{
+    KineticRequest* request = op->request;
+    int64_t seq_id = request->message.header.sequence;
+    // op may be completed and freed before the send returns
+    int fd = op->session->socket;
+    int messageType = request->message.header.messagetype;
 
-    if (commandData) { free(commandData); }
     KineticCountingSemaphore * const sem = op->session->outstandingOperations;
+    uint64_t traceStart = KINETIC_TRACE_START();
     KineticCountingSemaphore_Take(sem);  // limit total concurrent requests
+    op->timestamps.throttled = KineticClock_Now();
+    KINETIC_TRACE_SPAN(KINETIC_TRACE_THROTTLE, fd, seq_id, messageType, traceStart);
 
-    if (!KineticRequest_SendRequest(op, msg, msgSize)) {
+    traceStart = KINETIC_TRACE_START();
+    bool sent = KineticRequest_SendRequest(op, msg, msgSize);
+    KINETIC_TRACE_SPAN(KINETIC_TRACE_SOCKET_WRITE, fd, seq_id, messageType, traceStart);
+    if (!sent) {
         LOGF0("Failed queuing request %p for transmit on fd=%d w/seq=%lld",
             (void*)request, op->session->socket, (long long)seq_id);
         /* A false result from bus_send_request means that the request was
@@ -134,13 +148,9 @@ static KineticStatus send_request_in_lock(KineticOperation* const op)
          * error handling for errors during the request or response will
          * not be used. */
         KineticCountingSemaphore_Give(sem);
-        status = KINETIC_STATUS_REQUEST_REJECTED;
-    } else {
-        status = KINETIC_STATUS_SUCCESS;
+        return KINETIC_STATUS_REQUEST_REJECTED;
     }
-
-    if (msg != NULL) { free(msg); }
-    return status;
+    return KINETIC_STATUS_SUCCESS;
 }
 
 KineticStatus KineticOperation_GetStatus(const KineticOperation* const op)
@@ -152,20 +162,46 @@ KineticStatus KineticOperation_GetStatus(const KineticOperation* const op)
     return status;
 }
 
+static void record_completion(KineticOperation* op, KineticStatus status)
+{
+    uint64_t bytesReceived = 0;
+    if (op->response != NULL) {
+        bytesReceived = PDU_HEADER_LEN + KineticResponse_GetProtobufLength(op->response)
+            + KineticResponse_GetValueLength(op->response);
+    }
+    const KineticOperationTimestamps* ts = &op->timestamps;
+    KineticStats_Record(&op->session->stats,
+        Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType(
+            op->request->message.header.messagetype),
+        status, (ts->completed > ts->submitted) ? ts->completed - ts->submitted : 0,
+        op->bytesSent, bytesReceived);
+}
+
 void KineticOperation_Complete(KineticOperation* op, KineticStatus status)
 {
     KINETIC_ASSERT(op);
     KINETIC_ASSERT(op->session);
 
     // ExecuteOperation should ensure a callback exists (either a user supplied one, or the a default)
-    KineticCompletionData completionData = {.status = status};
+    op->timestamps.completed = KineticClock_Now();
+    KineticCompletionData completionData = {
+        .connectionID = op->session->connectionID,
+        .sequence = op->request->message.header.sequence,
+        .status = status,
+        .timestamps = op->timestamps,
+    };
+    KineticCompletionClosure closure = op->closure;
+
+    record_completion(op, status);
 
     // Release this request so that others can be unblocked if at max (request PDUs throttled)
     KineticCountingSemaphore_Give(op->session->outstandingOperations);
 
-    if(op->closure.callback != NULL) {
-        op->closure.callback(&completionData, op->closure.clientData);
-    }
-
+    // Return the operation to its session's pool before notifying the caller,
+    // since the caller may destroy the session as soon as it is notified.
     KineticAllocator_FreeOperation(op);
+
+    if(closure.callback != NULL) {
+        closure.callback(&completionData, closure.clientData);
+    }
 }
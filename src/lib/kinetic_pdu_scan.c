@@ -0,0 +1,174 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_pdu_scan.h"
+#include <string.h>
+
+// Field numbers, from kinetic.proto
+#define MESSAGE_AUTH_TYPE (4)
+#define MESSAGE_COMMAND_BYTES (7)
+#define COMMAND_HEADER (1)
+#define COMMAND_STATUS (3)
+#define HEADER_CONNECTION_ID (3)
+#define HEADER_ACK_SEQUENCE (6)
+#define STATUS_CODE (1)
+
+#define WIRE_VARINT (0)
+#define WIRE_FIXED64 (1)
+#define WIRE_LENGTH_DELIMITED (2)
+#define WIRE_FIXED32 (5)
+
+typedef struct {
+    const uint8_t* pos;
+    const uint8_t* end;
+} cursor;
+
+typedef struct {
+    uint32_t field;
+    int wireType;
+    uint64_t varint;            // value of a varint field
+    cursor bytes;               // contents of a length-delimited field
+} wire_field;
+
+static bool read_varint(cursor* c, uint64_t* value)
+{
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && c->pos < c->end; shift += 7) {
+        uint8_t b = *c->pos++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            *value = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Read the next field, skipping over its contents. Returns false at the end
+// of the buffer or on malformed input, distinguished by *malformed.
+static bool next_field(cursor* c, wire_field* f, bool* malformed)
+{
+    *malformed = false;
+    if (c->pos >= c->end) { return false; }
+
+    uint64_t tag;
+    if (!read_varint(c, &tag) || (tag >> 3) == 0) { *malformed = true; return false; }
+    f->field = (uint32_t)(tag >> 3);
+    f->wireType = (int)(tag & 0x07);
+
+    size_t remaining;
+    switch (f->wireType) {
+    case WIRE_VARINT:
+        if (!read_varint(c, &f->varint)) { *malformed = true; return false; }
+        return true;
+    case WIRE_FIXED64:
+        remaining = (size_t)(c->end - c->pos);
+        if (remaining < 8) { *malformed = true; return false; }
+        c->pos += 8;
+        return true;
+    case WIRE_FIXED32:
+        remaining = (size_t)(c->end - c->pos);
+        if (remaining < 4) { *malformed = true; return false; }
+        c->pos += 4;
+        return true;
+    case WIRE_LENGTH_DELIMITED: {
+        uint64_t len;
+        if (!read_varint(c, &len)) { *malformed = true; return false; }
+        remaining = (size_t)(c->end - c->pos);
+        if (len > remaining) { *malformed = true; return false; }
+        f->bytes.pos = c->pos;
+        f->bytes.end = c->pos + len;
+        c->pos += len;
+        return true;
+    }
+    default:
+        // groups are not used by the Kinetic protocol
+        *malformed = true;
+        return false;
+    }
+}
+
+static bool scan_header(cursor c, KineticPDUScan* scan)
+{
+    wire_field f;
+    bool malformed;
+    scan->hasHeader = true;
+    while (next_field(&c, &f, &malformed)) {
+        if (f.wireType != WIRE_VARINT) { continue; }
+        if (f.field == HEADER_ACK_SEQUENCE) {
+            scan->hasAckSequence = true;
+            scan->ackSequence = (int64_t)f.varint;
+        } else if (f.field == HEADER_CONNECTION_ID) {
+            scan->hasConnectionID = true;
+            scan->connectionID = (int64_t)f.varint;
+        }
+    }
+    return !malformed;
+}
+
+static bool scan_status(cursor c, KineticPDUScan* scan)
+{
+    wire_field f;
+    bool malformed;
+    while (next_field(&c, &f, &malformed)) {
+        if (f.field == STATUS_CODE && f.wireType == WIRE_VARINT) {
+            scan->hasStatusCode = true;
+            scan->statusCode = (int32_t)f.varint;
+        }
+    }
+    return !malformed;
+}
+
+static bool scan_command(cursor c, KineticPDUScan* scan)
+{
+    wire_field f;
+    bool malformed;
+    while (next_field(&c, &f, &malformed)) {
+        if (f.wireType != WIRE_LENGTH_DELIMITED) { continue; }
+        if (f.field == COMMAND_HEADER) {
+            if (!scan_header(f.bytes, scan)) { return false; }
+        } else if (f.field == COMMAND_STATUS) {
+            if (!scan_status(f.bytes, scan)) { return false; }
+        }
+    }
+    return !malformed;
+}
+
+bool KineticPDU_Scan(const uint8_t* data, size_t len, KineticPDUScan* scan)
+{
+    memset(scan, 0, sizeof(*scan));
+    cursor c = {.pos = data, .end = data + len};
+    cursor command = {NULL, NULL};
+    bool hasCommand = false;
+    wire_field f;
+    bool malformed;
+
+    while (next_field(&c, &f, &malformed)) {
+        if (f.field == MESSAGE_AUTH_TYPE && f.wireType == WIRE_VARINT) {
+            scan->hasAuthType = true;
+            scan->authType = (int32_t)f.varint;
+        } else if (f.field == MESSAGE_COMMAND_BYTES && f.wireType == WIRE_LENGTH_DELIMITED) {
+            command = f.bytes;  // last one wins, as when unpacking
+            hasCommand = true;
+        }
+    }
+    if (malformed) { return false; }
+    return hasCommand ? scan_command(command, scan) : true;
+}
@@ -0,0 +1,45 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_PDU_SCAN_H
+#define _KINETIC_PDU_SCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fields of a received Message needed to route it, pulled from the raw
+// protobuf by walking the wire format rather than unpacking it
+typedef struct {
+    bool hasAuthType;
+    int32_t authType;
+    bool hasHeader;             // command carries a header
+    bool hasAckSequence;
+    int64_t ackSequence;
+    bool hasConnectionID;
+    int64_t connectionID;
+    bool hasStatusCode;
+    int32_t statusCode;
+} KineticPDUScan;
+
+// Scan a serialized Message. Returns false if the bytes are not well formed.
+bool KineticPDU_Scan(const uint8_t* data, size_t len, KineticPDUScan* scan);
+
+#endif // _KINETIC_PDU_SCAN_H
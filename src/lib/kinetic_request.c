@@ -26,66 +26,73 @@
 #include "kinetic_nbo.h"
 #include "kinetic_controller.h"
 #include "byte_array.h"
+#include "kinetic_arena.h"
+#include "kinetic_encoder.h"
+#include "kinetic_trace.h"
 #include "bus.h"
 
 #ifdef TEST
-uint8_t *cmdBuf = NULL;
 uint8_t *msg = NULL;
 #endif
 
-size_t KineticRequest_PackCommand(KineticRequest* request)
-{
-    size_t expectedLen = com__seagate__kinetic__proto__command__get_packed_size(&request->message.command);
-    #ifndef TEST
-    uint8_t *cmdBuf = (uint8_t*)malloc(expectedLen);
-    #endif
-    if (cmdBuf == NULL)
-    {
-        LOGF0("Failed to allocate command bytes: %zd", expectedLen);
-        return KINETIC_REQUEST_PACK_FAILURE;
-    }
-    request->message.message.commandbytes.data = cmdBuf;
-
-    size_t packedLen = com__seagate__kinetic__proto__command__pack(
-        &request->message.command, cmdBuf);
-    KINETIC_ASSERT(packedLen == expectedLen);
-    request->message.message.commandbytes.len = packedLen;
-    request->message.message.has_commandbytes = true;
-    KineticLogger_LogByteArray(3, "commandbytes", (ByteArray){
-        .data = request->message.message.commandbytes.data,
-        .len = request->message.message.commandbytes.len,
-    });
-
-    return packedLen;
-}
+// Field numbers of the outer Message
+#define MESSAGE_FIELD_AUTH_TYPE (4)
+#define MESSAGE_FIELD_HMAC_AUTH (5)
+#define MESSAGE_FIELD_PIN_AUTH (6)
+#define MESSAGE_FIELD_COMMAND_BYTES (7)
+#define HMACAUTH_FIELD_IDENTITY (1)
+#define HMACAUTH_FIELD_HMAC (2)
+#define PINAUTH_FIELD_PIN (1)
+#define TAG(FIELD, WIRE) KINETIC_WIRE_TAG(FIELD, KINETIC_WIRE_##WIRE)
 
 KineticStatus KineticRequest_PopulateAuthentication(KineticSessionConfig *config,
-    KineticRequest *request, ByteArray *pin)
+    KineticHMACKey const *hmacKey, KineticRequest *request, ByteArray *pin)
 {
     if (pin != NULL) {
         return KineticAuth_PopulatePin(config, request, *pin);
     } else {
-        return KineticAuth_PopulateHmac(config, request);
+        return KineticAuth_PopulateHmac(config, hmacKey, request);
     }
 }
 
-KineticStatus KineticRequest_PackMessage(KineticOperation *operation,
+KineticStatus KineticRequest_PackPDU(KineticOperation *operation,
     uint8_t **out_msg, size_t *msgSize)
 {
-    // Configure PDU header
-    Com__Seagate__Kinetic__Proto__Message* proto = &operation->request->message.message;
+    KineticSession* session = operation->session;
+    KineticRequest* request = operation->request;
+    Com__Seagate__Kinetic__Proto__Message* proto = &request->message.message;
+
+    // Size the command once; the outer Message framing around it depends only
+    // on the auth type, so it can be sized without packing anything. The hot
+    // key/value commands use the specialized encoder rather than protobuf-c.
+    KineticEncoderSizes sizes;
+    bool specialized = KineticEncoder_SizeCommand(&request->message.command, &sizes);
+    size_t cmdLen = specialized ? sizes.command :
+        com__seagate__kinetic__proto__command__get_packed_size(&request->message.command);
+    Com__Seagate__Kinetic__Proto__Message__AuthType authType;
+    size_t authLen;
+    if (operation->pin != NULL) {
+        authType = COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__PINAUTH;
+        authLen = 1 + KineticEncoder_VarintSize(operation->pin->len) + operation->pin->len;
+    } else {
+        authType = COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__HMACAUTH;
+        authLen = 1 + KineticEncoder_VarintSize((uint64_t)session->config.identity)
+            + 1 + KineticEncoder_VarintSize(KINETIC_HMAC_SHA1_LEN) + KINETIC_HMAC_SHA1_LEN;
+    }
+
     KineticPDUHeader header = {
         .versionPrefix = 'F',
-        .protobufLength = com__seagate__kinetic__proto__message__get_packed_size(proto)
+        .protobufLength = 1 + KineticEncoder_VarintSize(authType)
+            + 1 + KineticEncoder_VarintSize(authLen) + authLen
+            + 1 + KineticEncoder_VarintSize(cmdLen) + cmdLen,
+        .valueLength = operation->value.len,
     };
-    header.valueLength = operation->value.len;
     uint32_t nboProtoLength = KineticNBO_FromHostU32(header.protobufLength);
     uint32_t nboValueLength = KineticNBO_FromHostU32(header.valueLength);
 
-    // Allocate and pack protobuf message
-    size_t offset = 0;
+    size_t total = PDU_HEADER_LEN + header.protobufLength + header.valueLength;
     #ifndef TEST
-    uint8_t *msg = malloc(PDU_HEADER_LEN + header.protobufLength + header.valueLength);
+    uint8_t *msg = KineticArena_Alloc(&request->txArena, total);
     #endif
     if (msg == NULL) {
         LOG0("Failed to allocate outgoing message!");
@@ -93,36 +100,98 @@ KineticStatus KineticRequest_PackMessage(KineticOperation *operation,
     }
 
     // Pack header
-    KineticRequest* request = operation->request;
+    size_t offset = 0;
     msg[offset] = header.versionPrefix;
     offset += sizeof(header.versionPrefix);
     memcpy(&msg[offset], &nboProtoLength, sizeof(nboProtoLength));
     offset += sizeof(nboProtoLength);
     memcpy(&msg[offset], &nboValueLength, sizeof(nboValueLength));
     offset += sizeof(nboValueLength);
-    size_t len = com__seagate__kinetic__proto__message__pack(&request->message.message, &msg[offset]);
-    KINETIC_ASSERT(len == header.protobufLength);
-    offset += header.protobufLength;
+
+    // Pack Message framing, in field order as protobuf-c would
+    size_t hmacOffset = 0;
+    msg[offset++] = TAG(MESSAGE_FIELD_AUTH_TYPE, VARINT);
+    offset += KineticEncoder_PutVarint(&msg[offset], authType);
+    if (operation->pin != NULL) {
+        msg[offset++] = TAG(MESSAGE_FIELD_PIN_AUTH, LENGTH_DELIMITED);
+        offset += KineticEncoder_PutVarint(&msg[offset], authLen);
+        msg[offset++] = TAG(PINAUTH_FIELD_PIN, LENGTH_DELIMITED);
+        offset += KineticEncoder_PutVarint(&msg[offset], operation->pin->len);
+        if (operation->pin->len > 0) {
+            memcpy(&msg[offset], operation->pin->data, operation->pin->len);
+        }
+        offset += operation->pin->len;
+    } else {
+        msg[offset++] = TAG(MESSAGE_FIELD_HMAC_AUTH, LENGTH_DELIMITED);
+        offset += KineticEncoder_PutVarint(&msg[offset], authLen);
+        msg[offset++] = TAG(HMACAUTH_FIELD_IDENTITY, VARINT);
+        offset += KineticEncoder_PutVarint(&msg[offset], (uint64_t)session->config.identity);
+        msg[offset++] = TAG(HMACAUTH_FIELD_HMAC, LENGTH_DELIMITED);
+        offset += KineticEncoder_PutVarint(&msg[offset], KINETIC_HMAC_SHA1_LEN);
+        hmacOffset = offset;  // filled in once the command bytes are in place
+        offset += KINETIC_HMAC_SHA1_LEN;
+    }
+    msg[offset++] = TAG(MESSAGE_FIELD_COMMAND_BYTES, LENGTH_DELIMITED);
+    offset += KineticEncoder_PutVarint(&msg[offset], cmdLen);
+
+    // A requested value tag is computed while copying the value into place,
+    // so the value is read once; the command carrying the tag is packed after
+    if (operation->computeValueTag) {
+        KINETIC_ASSERT(operation->entry != NULL);
+        KineticStatus tagStatus = KineticAuth_CopyAndPopulateTag(&operation->entry->tag,
+            operation->entry->algorithm, &msg[PDU_HEADER_LEN + header.protobufLength],
+            &operation->value);
+        if (tagStatus != KINETIC_STATUS_SUCCESS) {
+            return tagStatus;
+        }
+    }
+
+    // Pack the command straight into its final position
+    size_t packedLen = specialized ?
+        KineticEncoder_PackCommand(&request->message.command, &sizes, &msg[offset]) :
+        com__seagate__kinetic__proto__command__pack(&request->message.command, &msg[offset]);
+    KINETIC_ASSERT(packedLen == cmdLen);
+    proto->commandbytes.data = &msg[offset];
+    proto->commandbytes.len = cmdLen;
+    proto->has_commandbytes = true;
+    offset += cmdLen;
+    KINETIC_ASSERT(offset == PDU_HEADER_LEN + header.protobufLength);
+
+    // Authenticate over the command bytes where they sit in the PDU
+    uint64_t traceStart = KINETIC_TRACE_START();
+    KineticStatus status = KineticRequest_PopulateAuthentication(&session->config,
+        &session->hmacKeySchedule, request, operation->pin);
+    KINETIC_TRACE_SPAN(KINETIC_TRACE_HMAC, session->socket, request->message.header.sequence,
+        request->message.header.messagetype, traceStart);
+    if (status != KINETIC_STATUS_SUCCESS) {
+        return status;
+    }
+    if (operation->pin == NULL) {
+        KINETIC_ASSERT(proto->hmacauth->hmac.len == KINETIC_HMAC_SHA1_LEN);
+        memcpy(&msg[hmacOffset], proto->hmacauth->hmac.data, KINETIC_HMAC_SHA1_LEN);
+    }
 
     #ifndef TEST
     // Log protobuf per configuration
     LOGF2("[PDU TX] pdu: %p, session: %p, bus: %p, "
         "fd: %6d, seq: %8lld, protoLen: %8u, valueLen: %8u, op: %p, msgType: %02x",
         (void*)operation->request,
-        (void*)operation->session, (void*)operation->session->messageBus,
-        operation->session->socket, (long long)request->message.header.sequence,
+        (void*)session, (void*)session->messageBus,
+        session->socket, (long long)request->message.header.sequence,
         header.protobufLength, header.valueLength,
         (void*)operation, request->message.header.messagetype);
-    KineticLogger_LogHeader(3, &header);
-    KineticLogger_LogProtobuf(3, proto);
+    LOG_HEADER(3, &header);
+    LOG_PROTOBUF(3, proto);
     #endif
-    
-    // Pack value payload, if supplied
+
+    // Pack value payload, if supplied and not already copied with its tag
     if (header.valueLength > 0) {
-        memcpy(&msg[offset], operation->value.data, operation->value.len);
+        if (!operation->computeValueTag) {
+            memcpy(&msg[offset], operation->value.data, operation->value.len);
+        }
         offset += operation->value.len;
     }
-    KINETIC_ASSERT((PDU_HEADER_LEN + header.protobufLength + header.valueLength) == offset);
+    KINETIC_ASSERT(total == offset);
 
     *out_msg = msg;
     *msgSize = offset;
@@ -147,14 +216,24 @@ bool KineticRequest_SendRequest(KineticOperation *operation,
     return Bus_SendRequest(operation->session->messageBus, &bus_msg);
 }
 
-bool KineticRequest_LockSend(KineticSession* session)
+void KineticRequest_AwaitSendTurn(KineticSession* session, int64_t seq_id)
 {
     KINETIC_ASSERT(session);
-    return 0 == pthread_mutex_lock(&session->sendMutex);
+    pthread_mutex_lock(&session->sendMutex);
+    while (session->sendTurn != seq_id) {
+        pthread_cond_wait(&session->sendTurnCond, &session->sendMutex);
+    }
+    // No other request can be sent until this one passes the turn on, so
+    // the mutex need not be held while sending
+    pthread_mutex_unlock(&session->sendMutex);
 }
 
-bool KineticRequest_UnlockSend(KineticSession* session)
+void KineticRequest_PassSendTurn(KineticSession* session, int64_t seq_id)
 {
     KINETIC_ASSERT(session);
-    return 0 == pthread_mutex_unlock(&session->sendMutex);
+    pthread_mutex_lock(&session->sendMutex);
+    KINETIC_ASSERT(session->sendTurn == seq_id);
+    session->sendTurn = seq_id + 1;
+    pthread_cond_broadcast(&session->sendTurnCond);
+    pthread_mutex_unlock(&session->sendMutex);
 }
@@ -22,24 +22,19 @@
 
 #include "kinetic_types_internal.h"
 
-/* Special 'failed to pack' sentinel. */
-#define KINETIC_REQUEST_PACK_FAILURE ((size_t)-1)
-
-/* Pack the command into request->message.message.commandBytes.data.
- * Returns the allocated size,
- * or KINETIC_REQUEST_PACK_FAILURE on malloc failure. */
-size_t KineticRequest_PackCommand(KineticRequest* request);
-
 /* Populate the request's authentication info. If PIN is non-NULL,
- * use PIN authentication, otherwise use HMAC. */
+ * use PIN authentication, otherwise use HMAC with the session's
+ * precomputed key schedule. */
 KineticStatus KineticRequest_PopulateAuthentication(KineticSessionConfig *config,
-    KineticRequest *request, ByteArray *pin);
-
-/* Pack the header, command, and value (if any), allocating a buffer and
- * returning the buffer and its size in *msg and *msgSize.
- * Returns KINETIC_STATUS_SUCCESS on success, or KINETIC_STATUS_MEMORY_ERROR
- * on allocation failure. */
-KineticStatus KineticRequest_PackMessage(KineticOperation *operation,
+    KineticHMACKey const *hmacKey, KineticRequest *request, ByteArray *pin);
+
+/* Pack the header, Message framing, command, and value (if any) in a single
+ * pass into a buffer allocated from the request's transmit arena, then
+ * authenticate the command bytes in place. Returns the buffer and its size
+ * in *msg and *msgSize; the buffer is valid until the arena is reset.
+ * Returns KINETIC_STATUS_SUCCESS on success, KINETIC_STATUS_MEMORY_ERROR
+ * on allocation failure, or the authentication error status. */
+KineticStatus KineticRequest_PackPDU(KineticOperation *operation,
     uint8_t **msg, size_t *msgSize);
 
 /* Send the request. Returns whether the request was successfully queued
@@ -49,7 +44,11 @@ KineticStatus KineticRequest_PackMessage(KineticOperation *operation,
 bool KineticRequest_SendRequest(KineticOperation *operation,
     uint8_t *msg, size_t msgSize);
 
-bool KineticRequest_LockSend(KineticSession* session);
-bool KineticRequest_UnlockSend(KineticSession* session);
+/* Wait until the request with sequence number seq_id is next to be sent on
+ * the session. Every reserved sequence number must pass its turn on with
+ * KineticRequest_PassSendTurn, whether or not the request was sent, or later
+ * requests will wait forever. */
+void KineticRequest_AwaitSendTurn(KineticSession* session, int64_t seq_id);
+void KineticRequest_PassSendTurn(KineticSession* session, int64_t seq_id);
 
 #endif
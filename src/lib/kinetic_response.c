@@ -32,6 +32,34 @@
 
 #include <time.h>
 
+bool KineticResponse_Unpack(KineticResponse * response)
+{
+    KINETIC_ASSERT(response);
+    if (response->proto != NULL) { return true; }
+
+    response->proto = KineticPDU_unpack_message(&response->arena.allocator,
+        response->header.protobufLength, response->pdu);
+    if (response->proto == NULL) {
+        LOG0("Failed unpacking response protobuf!");
+        return false;
+    }
+
+    if (response->proto->has_commandbytes &&
+        response->proto->commandbytes.data != NULL &&
+        response->proto->commandbytes.len > 0)
+    {
+        response->command = KineticPDU_unpack_command(&response->arena.allocator,
+            response->proto->commandbytes.len, response->proto->commandbytes.data);
+        if (response->command == NULL) {
+            LOG0("Failed unpacking response command!");
+            return false;
+        }
+    } else {
+        response->command = NULL;
+    }
+    return true;
+}
+
 uint32_t KineticResponse_GetProtobufLength(KineticResponse * response)
 {
     KINETIC_ASSERT(response);
@@ -48,13 +76,10 @@ KineticStatus KineticResponse_GetStatus(KineticResponse * response)
 {
     KineticStatus status = KINETIC_STATUS_INVALID;
 
-    if (response != NULL &&
-        response->command != NULL &&
-        response->command->status != NULL &&
-        response->command->status->has_code != false)
-    {
+    // The listener's scan has the status, so it is known without unpacking
+    if (response != NULL && response->scan.hasStatusCode) {
         status = KineticProtoStatusCode_to_KineticStatus(
-            response->command->status->code);
+            (Com__Seagate__Kinetic__Proto__Command__Status__StatusCode)response->scan.statusCode);
     }
 
     return status;
@@ -64,13 +89,11 @@ int64_t KineticResponse_GetConnectionID(KineticResponse * response)
 {
     int64_t id = 0;
     KINETIC_ASSERT(response);
-    KINETIC_ASSERT(response->proto);
-    if (response->proto->authtype == COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__UNSOLICITEDSTATUS &&
-        response->command != NULL &&
-        response->command->header != NULL &&
-        response->command->header->has_connectionid)
+    if (response->scan.hasAuthType &&
+        response->scan.authType == COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__UNSOLICITEDSTATUS &&
+        response->scan.hasConnectionID)
     {
-        id = response->command->header->connectionid;
+        id = response->scan.connectionID;
     }
     return id;
 }
@@ -23,6 +23,9 @@
 
 #include "kinetic_types_internal.h"
 
+/* Unpack the protobuf stashed by the listener into response->proto and
+ * response->command. Returns false if it could not be unpacked. */
+bool KineticResponse_Unpack(KineticResponse * response);
 uint32_t KineticResponse_GetProtobufLength(KineticResponse * response);
 uint32_t KineticResponse_GetValueLength(KineticResponse * response);
 KineticStatus KineticResponse_GetStatus(KineticResponse * response);
@@ -54,6 +54,14 @@ KineticStatus KineticSession_Create(KineticSession * const session, KineticClien
         LOG0("Failed initializing session send mutex!");
         return KINETIC_STATUS_MEMORY_ERROR;
     }
+    if (pthread_cond_init(&session->sendTurnCond, NULL) != 0) {
+        LOG0("Failed initializing session send condition!");
+        return KINETIC_STATUS_MEMORY_ERROR;
+    }
+    // Requests go onto the bus in the order their sequence numbers were reserved
+    session->sendTurn = session->sequence;
+    // Batch signing is per session, so sessions don't serialize on each other
+    session->hmacKeySchedule.signer = client->batchHmac ? &session->hmacSigner : NULL;
 
     session->outstandingOperations =
         KineticCountingSemaphore_Create(KINETIC_MAX_OUTSTANDING_OPERATIONS_PER_SESSION);
@@ -144,6 +152,7 @@ KineticStatus KineticSession_Disconnect(KineticSession * const session)
     session->si = NULL;
     session->socket = KINETIC_SOCKET_INVALID;
     session->connected = false;
+    pthread_cond_destroy(&session->sendTurnCond);
     pthread_mutex_destroy(&session->sendMutex);
 
     return KINETIC_STATUS_SUCCESS;
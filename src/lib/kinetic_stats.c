@@ -0,0 +1,122 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_stats.h"
+
+size_t KineticStats_LatencyBucket(uint64_t nanoseconds)
+{
+    if (nanoseconds < 8) {
+        return (size_t)nanoseconds;
+    }
+    // 8 linear sub-buckets for each power of two from 2^3
+    unsigned log2 = 63 - (unsigned)__builtin_clzll(nanoseconds);
+    size_t bucket = (size_t)(log2 - 2) * 8 + (size_t)((nanoseconds >> (log2 - 3)) & 7);
+    return (bucket < KINETIC_LATENCY_BUCKETS) ? bucket : KINETIC_LATENCY_BUCKETS - 1;
+}
+
+static void update_max(uint64_t* max, uint64_t value)
+{
+    uint64_t current = *max;
+    while (value > current) {
+        uint64_t seen = __sync_val_compare_and_swap(max, current, value);
+        if (seen == current) { break; }
+        current = seen;
+    }
+}
+
+void KineticStats_Record(KineticStats* stats, KineticMessageType type,
+    KineticStatus status, uint64_t nanoseconds,
+    uint64_t bytesSent, uint64_t bytesReceived)
+{
+    if ((int)type < 0 || type >= KINETIC_MESSAGE_TYPE_COUNT) {
+        type = KINETIC_MESSAGE_TYPE_INVALID;
+    }
+    KineticOperationStats* counters = &stats->byType[type];
+
+    __sync_fetch_and_add(&counters->bytesSent, bytesSent);
+    __sync_fetch_and_add(&counters->bytesReceived, bytesReceived);
+    if ((int)status >= 0 && status < KINETIC_STATUS_COUNT) {
+        __sync_fetch_and_add(&counters->statusCounts[status], 1);
+    } else {
+        __sync_fetch_and_add(&counters->invalidStatusCount, 1);
+    }
+    __sync_fetch_and_add(&counters->latency.buckets[KineticStats_LatencyBucket(nanoseconds)], 1);
+    __sync_fetch_and_add(&counters->latency.sumNanoseconds, nanoseconds);
+    update_max(&counters->latency.maxNanoseconds, nanoseconds);
+    __sync_fetch_and_add(&counters->latency.count, 1);
+}
+
+static uint64_t collect(uint64_t* counter, bool reset)
+{
+    return reset ? __sync_fetch_and_and(counter, 0) : __sync_fetch_and_add(counter, 0);
+}
+
+static void collect_operation_stats(KineticOperationStats* counters,
+    KineticOperationStats* snapshot, bool reset)
+{
+    snapshot->bytesSent += collect(&counters->bytesSent, reset);
+    snapshot->bytesReceived += collect(&counters->bytesReceived, reset);
+    for (int i = 0; i < KINETIC_STATUS_COUNT; i++) {
+        snapshot->statusCounts[i] += collect(&counters->statusCounts[i], reset);
+    }
+    snapshot->invalidStatusCount += collect(&counters->invalidStatusCount, reset);
+    for (int i = 0; i < KINETIC_LATENCY_BUCKETS; i++) {
+        snapshot->latency.buckets[i] += collect(&counters->latency.buckets[i], reset);
+    }
+    snapshot->latency.count += collect(&counters->latency.count, reset);
+    snapshot->latency.sumNanoseconds += collect(&counters->latency.sumNanoseconds, reset);
+    uint64_t max = collect(&counters->latency.maxNanoseconds, reset);
+    if (max > snapshot->latency.maxNanoseconds) {
+        snapshot->latency.maxNanoseconds = max;
+    }
+}
+
+void KineticStats_Collect(KineticStats* stats, KineticStats* snapshot, bool reset)
+{
+    for (int type = 0; type < KINETIC_MESSAGE_TYPE_COUNT; type++) {
+        KineticOperationStats* counters = &stats->byType[type];
+        // Most sessions only use a few message types
+        if (__sync_fetch_and_add(&counters->latency.count, 0) == 0) { continue; }
+        collect_operation_stats(counters, &snapshot->byType[type], reset);
+    }
+}
+
+void KineticStats_Total(KineticStats* snapshot)
+{
+    KineticOperationStats* total = &snapshot->total;
+    memset(total, 0, sizeof(*total));
+    for (int type = 0; type < KINETIC_MESSAGE_TYPE_COUNT; type++) {
+        KineticOperationStats* byType = &snapshot->byType[type];
+        total->bytesSent += byType->bytesSent;
+        total->bytesReceived += byType->bytesReceived;
+        for (int i = 0; i < KINETIC_STATUS_COUNT; i++) {
+            total->statusCounts[i] += byType->statusCounts[i];
+        }
+        total->invalidStatusCount += byType->invalidStatusCount;
+        for (int i = 0; i < KINETIC_LATENCY_BUCKETS; i++) {
+            total->latency.buckets[i] += byType->latency.buckets[i];
+        }
+        total->latency.count += byType->latency.count;
+        total->latency.sumNanoseconds += byType->latency.sumNanoseconds;
+        if (byType->latency.maxNanoseconds > total->latency.maxNanoseconds) {
+            total->latency.maxNanoseconds = byType->latency.maxNanoseconds;
+        }
+    }
+}
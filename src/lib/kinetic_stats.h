@@ -0,0 +1,47 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_STATS_H
+#define _KINETIC_STATS_H
+
+#include "kinetic_types.h"
+
+// Operation statistics: each session counts its completions in a KineticStats
+// of its own, per request message type, with atomic adds so that completions
+// on different worker threads never take a lock. Snapshots read (and
+// optionally zero) each counter atomically, so a snapshot taken while
+// operations complete may split one completion between itself and the next.
+
+/* Histogram bucket for a latency (see KINETIC_LATENCY_BUCKETS). */
+size_t KineticStats_LatencyBucket(uint64_t nanoseconds);
+
+/* Count a completed operation. */
+void KineticStats_Record(KineticStats* stats, KineticMessageType type,
+    KineticStatus status, uint64_t nanoseconds,
+    uint64_t bytesSent, uint64_t bytesReceived);
+
+/* Add the per-type counters of stats to snapshot, zeroing them if reset.
+ * snapshot's totals are not updated; see KineticStats_Total. */
+void KineticStats_Collect(KineticStats* stats, KineticStats* snapshot, bool reset);
+
+/* Fill in snapshot->total from its per-type counters. */
+void KineticStats_Total(KineticStats* snapshot);
+
+#endif // _KINETIC_STATS_H
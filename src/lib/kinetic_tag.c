@@ -0,0 +1,258 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_tag.h"
+#include "kinetic_logger.h"
+#include <string.h>
+#include <pthread.h>
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#define CRC32C_POLY (0x82F63B78u)                   // reflected
+#define CRC64_POLY (0xC96C5795D7870F42ull)          // ECMA-182, reflected
+#define COPY_CHUNK_LEN (16 * 1024)                  // stays in L1/L2 between copy and digest
+
+static uint32_t Crc32Table[8][256];
+static uint64_t Crc64Table[8][256];
+static pthread_once_t TablesOnce = PTHREAD_ONCE_INIT;
+
+typedef uint32_t (*crc32_fn)(uint32_t crc, const uint8_t* data, size_t len);
+static crc32_fn Crc32Update = NULL;
+
+static void init_tables(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c32 = i;
+        uint64_t c64 = i;
+        for (int k = 0; k < 8; k++) {
+            c32 = (c32 & 1) ? (c32 >> 1) ^ CRC32C_POLY : c32 >> 1;
+            c64 = (c64 & 1) ? (c64 >> 1) ^ CRC64_POLY : c64 >> 1;
+        }
+        Crc32Table[0][i] = c32;
+        Crc64Table[0][i] = c64;
+    }
+    for (int t = 1; t < 8; t++) {
+        for (int i = 0; i < 256; i++) {
+            uint32_t c32 = Crc32Table[t - 1][i];
+            uint64_t c64 = Crc64Table[t - 1][i];
+            Crc32Table[t][i] = (c32 >> 8) ^ Crc32Table[0][c32 & 0xFF];
+            Crc64Table[t][i] = (c64 >> 8) ^ Crc64Table[0][c64 & 0xFF];
+        }
+    }
+}
+
+static uint64_t load_le64(const uint8_t* p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) { v = (v << 8) | p[i]; }
+    return v;
+}
+
+// Slicing-by-8: eight table lookups per 8 bytes
+static uint32_t crc32c_sw(uint32_t crc, const uint8_t* data, size_t len)
+{
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t v = load_le64(data) ^ crc;
+        crc = Crc32Table[7][v & 0xFF] ^ Crc32Table[6][(v >> 8) & 0xFF]
+            ^ Crc32Table[5][(v >> 16) & 0xFF] ^ Crc32Table[4][(v >> 24) & 0xFF]
+            ^ Crc32Table[3][(v >> 32) & 0xFF] ^ Crc32Table[2][(v >> 40) & 0xFF]
+            ^ Crc32Table[1][(v >> 48) & 0xFF] ^ Crc32Table[0][v >> 56];
+    }
+    for (; len > 0; data++, len--) {
+        crc = (crc >> 8) ^ Crc32Table[0][(crc ^ *data) & 0xFF];
+    }
+    return crc;
+}
+
+static uint64_t crc64_sw(uint64_t crc, const uint8_t* data, size_t len)
+{
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t v = load_le64(data) ^ crc;
+        crc = Crc64Table[7][v & 0xFF] ^ Crc64Table[6][(v >> 8) & 0xFF]
+            ^ Crc64Table[5][(v >> 16) & 0xFF] ^ Crc64Table[4][(v >> 24) & 0xFF]
+            ^ Crc64Table[3][(v >> 32) & 0xFF] ^ Crc64Table[2][(v >> 40) & 0xFF]
+            ^ Crc64Table[1][(v >> 48) & 0xFF] ^ Crc64Table[0][v >> 56];
+    }
+    for (; len > 0; data++, len--) {
+        crc = (crc >> 8) ^ Crc64Table[0][(crc ^ *data) & 0xFF];
+    }
+    return crc;
+}
+
+// CRC-32C instructions (SSE4.2 on x86, the CRC extension on ARMv8)
+#if defined(__GNUC__) && defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, const uint8_t* data, size_t len)
+{
+    uint64_t c = crc;
+    for (; len > 0 && ((uintptr_t)data & 7) != 0; data++, len--) {
+        c = __builtin_ia32_crc32qi((uint32_t)c, *data);
+    }
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t v;
+        memcpy(&v, data, sizeof(v));
+        c = __builtin_ia32_crc32di(c, v);
+    }
+    for (; len > 0; data++, len--) {
+        c = __builtin_ia32_crc32qi((uint32_t)c, *data);
+    }
+    return (uint32_t)c;
+}
+static bool has_crc32c_hw(void) { return __builtin_cpu_supports("sse4.2"); }
+#elif defined(__ARM_FEATURE_CRC32)
+static uint32_t crc32c_hw(uint32_t crc, const uint8_t* data, size_t len)
+{
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t v;
+        memcpy(&v, data, sizeof(v));
+        crc = __crc32cd(crc, v);
+    }
+    for (; len > 0; data++, len--) {
+        crc = __crc32cb(crc, *data);
+    }
+    return crc;
+}
+static bool has_crc32c_hw(void) { return true; }
+#else
+#define crc32c_hw crc32c_sw
+static bool has_crc32c_hw(void) { return false; }
+#endif
+
+static void init_crc(void)
+{
+    init_tables();
+    Crc32Update = has_crc32c_hw() ? crc32c_hw : crc32c_sw;
+}
+
+static const EVP_MD* digest_for(KineticAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case KINETIC_ALGORITHM_SHA1: return EVP_sha1();
+    case KINETIC_ALGORITHM_SHA2: return EVP_sha256();
+    case KINETIC_ALGORITHM_SHA3: return EVP_sha3_256();
+    default: return NULL;
+    }
+}
+
+size_t KineticTag_Length(KineticAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case KINETIC_ALGORITHM_SHA1: return 20;
+    case KINETIC_ALGORITHM_SHA2: return 32;
+    case KINETIC_ALGORITHM_SHA3: return 32;
+    case KINETIC_ALGORITHM_CRC32: return 4;
+    case KINETIC_ALGORITHM_CRC64: return 8;
+    default: return 0;
+    }
+}
+
+bool KineticTag_Init(KineticTagContext* ctx, KineticAlgorithm algorithm)
+{
+    KINETIC_ASSERT(ctx != NULL);
+    *ctx = (KineticTagContext) {
+        .algorithm = algorithm,
+        .crc32 = 0xFFFFFFFF,
+        .crc64 = ~0ull,
+    };
+
+    switch (algorithm) {
+    case KINETIC_ALGORITHM_CRC32:
+    case KINETIC_ALGORITHM_CRC64:
+        pthread_once(&TablesOnce, init_crc);
+        return true;
+    case KINETIC_ALGORITHM_SHA1:
+    case KINETIC_ALGORITHM_SHA2:
+    case KINETIC_ALGORITHM_SHA3:
+        // OpenSSL picks the fastest implementation for the CPU (SHA-NI, AVX2...)
+        ctx->md = EVP_MD_CTX_create();
+        if (ctx->md == NULL || !EVP_DigestInit_ex(ctx->md, digest_for(algorithm), NULL)) {
+            LOGF0("Failed initializing digest for tag algorithm %d!", algorithm);
+            if (ctx->md != NULL) { EVP_MD_CTX_destroy(ctx->md); }
+            ctx->md = NULL;
+            return false;
+        }
+        return true;
+    default:
+        LOGF0("Unsupported tag algorithm %d!", algorithm);
+        return false;
+    }
+}
+
+bool KineticTag_Update(KineticTagContext* ctx, const uint8_t* data, size_t len)
+{
+    KINETIC_ASSERT(ctx != NULL);
+    KINETIC_ASSERT(data != NULL || len == 0);
+    switch (ctx->algorithm) {
+    case KINETIC_ALGORITHM_CRC32:
+        ctx->crc32 = Crc32Update(ctx->crc32, data, len);
+        return true;
+    case KINETIC_ALGORITHM_CRC64:
+        ctx->crc64 = crc64_sw(ctx->crc64, data, len);
+        return true;
+    default:
+        KINETIC_ASSERT(ctx->md != NULL);
+        return EVP_DigestUpdate(ctx->md, data, len);
+    }
+}
+
+bool KineticTag_CopyAndUpdate(KineticTagContext* ctx, uint8_t* dst, const uint8_t* src, size_t len)
+{
+    KINETIC_ASSERT(dst != NULL || len == 0);
+    for (size_t done = 0; done < len; done += COPY_CHUNK_LEN) {
+        size_t n = (len - done < COPY_CHUNK_LEN) ? len - done : COPY_CHUNK_LEN;
+        memcpy(&dst[done], &src[done], n);
+        if (!KineticTag_Update(ctx, &dst[done], n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool KineticTag_Final(KineticTagContext* ctx, uint8_t* tag)
+{
+    KINETIC_ASSERT(ctx != NULL);
+    bool success = true;
+    switch (ctx->algorithm) {
+    case KINETIC_ALGORITHM_CRC32: {
+        uint32_t crc = ~ctx->crc32;
+        for (int i = 0; tag != NULL && i < 4; i++) {
+            tag[i] = (uint8_t)(crc >> (24 - 8 * i));
+        }
+        break;
+    }
+    case KINETIC_ALGORITHM_CRC64: {
+        uint64_t crc = ~ctx->crc64;
+        for (int i = 0; tag != NULL && i < 8; i++) {
+            tag[i] = (uint8_t)(crc >> (56 - 8 * i));
+        }
+        break;
+    }
+    default:
+        if (ctx->md == NULL) { return false; }
+        if (tag != NULL) {
+            success = EVP_DigestFinal_ex(ctx->md, tag, NULL);
+        }
+        EVP_MD_CTX_destroy(ctx->md);
+        ctx->md = NULL;
+        break;
+    }
+    return success;
+}
@@ -0,0 +1,53 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_TAG_H
+#define _KINETIC_TAG_H
+
+#include "kinetic_types_internal.h"
+#include <openssl/evp.h>
+
+// Value integrity tags: CRC32 (CRC-32C), CRC64 (CRC-64/XZ), SHA1, SHA2
+// (SHA-256) and SHA3 (SHA3-256), stored big-endian.
+
+#define KINETIC_TAG_MAX_LEN (32)
+
+typedef struct _KineticTagContext {
+    KineticAlgorithm algorithm;
+    uint32_t crc32;
+    uint64_t crc64;
+    EVP_MD_CTX* md;         // SHA algorithms only
+} KineticTagContext;
+
+/* Length of the tag for algorithm, or 0 if it is not supported. */
+size_t KineticTag_Length(KineticAlgorithm algorithm);
+
+bool KineticTag_Init(KineticTagContext* ctx, KineticAlgorithm algorithm);
+bool KineticTag_Update(KineticTagContext* ctx, const uint8_t* data, size_t len);
+
+/* Copy len bytes from src to dst, digesting them while they are still in
+ * cache, so a value is only read from memory once. */
+bool KineticTag_CopyAndUpdate(KineticTagContext* ctx, uint8_t* dst, const uint8_t* src, size_t len);
+
+/* Write the tag (KineticTag_Length bytes) and release the context. Pass a
+ * NULL tag to discard it. */
+bool KineticTag_Final(KineticTagContext* ctx, uint8_t* tag);
+
+#endif // _KINETIC_TAG_H
@@ -0,0 +1,377 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_trace.h"
+#include "kinetic.pb-c.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Spans retained per thread (power of two); the oldest are overwritten
+#define RING_SLOTS 4096
+
+typedef struct {
+    uint64_t start;
+    int64_t seq;
+    uint32_t duration;
+    int32_t fd;
+    uint32_t tid;               // recording thread, which may since have exited
+    int8_t messageType;
+    uint8_t stage;
+} trace_record;
+
+// Rings outlive their threads, and a thread starting to record takes over a
+// retired ring if there is one, so there are never more rings than threads
+// ever ran at once, however often the threadpool retires and starts workers.
+typedef struct _trace_ring {
+    struct _trace_ring* next;
+    uint32_t tid;               // current owner
+    volatile uint64_t head;     // spans ever recorded; only advanced by the owner
+    uint64_t floor;             // spans before this were discarded by a reset
+    volatile bool retired;      // owning thread has exited
+    trace_record records[RING_SLOTS];
+} trace_ring;
+
+// A span copied out of a ring for export
+typedef struct {
+    trace_record record;
+} trace_span;
+
+volatile bool KineticTraceEnabled = false;
+
+static pthread_once_t RingKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t RingKey;
+static pthread_mutex_t RingsMutex = PTHREAD_MUTEX_INITIALIZER;
+static trace_ring* Rings = NULL;
+static uint32_t NextTid = 1;
+
+static const char* const StageNames[KINETIC_TRACE_STAGE_COUNT] = {
+    [KINETIC_TRACE_BUILD] = "build",
+    [KINETIC_TRACE_PACK] = "pack",
+    [KINETIC_TRACE_HMAC] = "hmac",
+    [KINETIC_TRACE_SEND_TURN] = "send_turn",
+    [KINETIC_TRACE_THROTTLE] = "throttle",
+    [KINETIC_TRACE_SOCKET_WRITE] = "socket_write",
+    [KINETIC_TRACE_LISTENER_MATCH] = "listener_match",
+    [KINETIC_TRACE_QUEUE_WAIT] = "queue_wait",
+    [KINETIC_TRACE_UNPACK] = "unpack",
+    [KINETIC_TRACE_CALLBACK] = "callback",
+};
+
+static void retire_ring(void* arg)
+{
+    trace_ring* ring = arg;
+    ring->retired = true;
+}
+
+static void create_ring_key(void)
+{
+    pthread_key_create(&RingKey, retire_ring);
+}
+
+// Take over a retired ring, keeping the spans its previous owner recorded
+static trace_ring* adopt_retired_ring(void)
+{
+    trace_ring* ring = NULL;
+    pthread_mutex_lock(&RingsMutex);
+    for (trace_ring* r = Rings; r != NULL; r = r->next) {
+        if (r->retired) {
+            ring = r;
+            ring->tid = NextTid++;
+            ring->retired = false;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&RingsMutex);
+    return ring;
+}
+
+static trace_ring* get_ring(void)
+{
+    pthread_once(&RingKeyOnce, create_ring_key);
+    trace_ring* ring = pthread_getspecific(RingKey);
+    if (ring == NULL) {
+        bool adopted = false;
+        ring = adopt_retired_ring();
+        if (ring != NULL) {
+            adopted = true;
+        } else {
+            ring = calloc(1, sizeof(*ring));
+            if (ring == NULL) {
+                return NULL;
+            }
+        }
+        if (pthread_setspecific(RingKey, ring) != 0) {
+            if (adopted) {
+                ring->retired = true;
+            } else {
+                free(ring);
+            }
+            return NULL;
+        }
+        if (!adopted) {
+            pthread_mutex_lock(&RingsMutex);
+            ring->tid = NextTid++;
+            ring->next = Rings;
+            Rings = ring;
+            pthread_mutex_unlock(&RingsMutex);
+        }
+    }
+    return ring;
+}
+
+void KineticTrace_Enable(bool enable)
+{
+    KineticTraceEnabled = enable;
+}
+
+void KineticTrace_Record(KineticTraceStage stage, int fd, int64_t seq,
+    int messageType, uint64_t start, uint64_t end)
+{
+    trace_ring* ring = get_ring();
+    if (ring == NULL) {
+        return;
+    }
+
+    uint64_t head = ring->head;
+    trace_record* record = &ring->records[head & (RING_SLOTS - 1)];
+    uint64_t duration = (end > start) ? end - start : 0;
+    *record = (trace_record) {
+        .start = start,
+        .seq = seq,
+        .duration = (duration > UINT32_MAX) ? UINT32_MAX : (uint32_t)duration,
+        .fd = fd,
+        .tid = ring->tid,
+        .messageType = (int8_t)messageType,
+        .stage = (uint8_t)stage,
+    };
+    __sync_synchronize();
+    ring->head = head + 1;
+}
+
+void KineticTrace_Reset(void)
+{
+    pthread_mutex_lock(&RingsMutex);
+    for (trace_ring** link = &Rings; *link != NULL;) {
+        trace_ring* ring = *link;
+        if (ring->retired) {
+            *link = ring->next;
+            free(ring);
+        }
+        else {
+            ring->floor = ring->head;
+            link = &ring->next;
+        }
+    }
+    pthread_mutex_unlock(&RingsMutex);
+}
+
+// Copy out every span still intact in the rings. Spans may be recorded while
+// this runs; any whose slot could have been reused meanwhile are skipped.
+static trace_span* collect_spans(size_t* count)
+{
+    pthread_mutex_lock(&RingsMutex);
+    size_t capacity = 0;
+    for (trace_ring* ring = Rings; ring != NULL; ring = ring->next) {
+        capacity += RING_SLOTS;
+    }
+    trace_span* spans = malloc((capacity > 0 ? capacity : 1) * sizeof(*spans));
+    size_t n = 0;
+    for (trace_ring* ring = Rings; spans != NULL && ring != NULL; ring = ring->next) {
+        uint64_t head = ring->head;
+        __sync_synchronize();
+        uint64_t first = (head > RING_SLOTS) ? head - RING_SLOTS : 0;
+        if (first < ring->floor) {
+            first = ring->floor;
+        }
+        size_t copied = n;
+        for (uint64_t i = first; i < head; i++) {
+            spans[n].record = ring->records[i & (RING_SLOTS - 1)];
+            n++;
+        }
+        __sync_synchronize();
+        uint64_t after = ring->head;
+        if (after - first >= RING_SLOTS) {
+            // The owner lapped the oldest spans while they were copied
+            size_t stale = (size_t)(after - first - RING_SLOTS + 1);
+            if (stale > n - copied) {
+                stale = n - copied;
+            }
+            memmove(&spans[copied], &spans[copied + stale], (n - copied - stale) * sizeof(*spans));
+            n -= stale;
+        }
+    }
+    pthread_mutex_unlock(&RingsMutex);
+    *count = n;
+    return spans;
+}
+
+static int compare_spans(const void* a, const void* b)
+{
+    const trace_record* ra = &((const trace_span*)a)->record;
+    const trace_record* rb = &((const trace_span*)b)->record;
+    return (ra->start > rb->start) - (ra->start < rb->start);
+}
+
+// Spans recorded in the bus don't know their message type; take it from a
+// span of the same request recorded by the client
+static void resolve_message_types(trace_span* spans, size_t count)
+{
+    size_t size = 16;
+    while (size < count * 2) {
+        size <<= 1;
+    }
+    trace_record** table = calloc(size, sizeof(*table));
+    if (table == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        trace_record* r = &spans[i].record;
+        if (r->messageType == KINETIC_TRACE_TYPE_UNKNOWN) { continue; }
+        size_t h = (size_t)((uint64_t)r->seq * 0x9E3779B97F4A7C15ull ^ (uint64_t)r->fd) & (size - 1);
+        while (table[h] != NULL && !(table[h]->fd == r->fd && table[h]->seq == r->seq)) {
+            h = (h + 1) & (size - 1);
+        }
+        table[h] = r;
+    }
+    for (size_t i = 0; i < count; i++) {
+        trace_record* r = &spans[i].record;
+        if (r->messageType != KINETIC_TRACE_TYPE_UNKNOWN) { continue; }
+        size_t h = (size_t)((uint64_t)r->seq * 0x9E3779B97F4A7C15ull ^ (uint64_t)r->fd) & (size - 1);
+        while (table[h] != NULL) {
+            if (table[h]->fd == r->fd && table[h]->seq == r->seq) {
+                r->messageType = table[h]->messageType;
+                break;
+            }
+            h = (h + 1) & (size - 1);
+        }
+    }
+    free(table);
+}
+
+static const char* message_type_name(int type)
+{
+    switch (type) {
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET: return "GET";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PUT: return "PUT";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__DELETE: return "DELETE";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETNEXT: return "GETNEXT";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETPREVIOUS: return "GETPREVIOUS";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETKEYRANGE: return "GETKEYRANGE";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETVERSION: return "GETVERSION";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__SETUP: return "SETUP";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETLOG: return "GETLOG";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__SECURITY: return "SECURITY";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PEER2PEERPUSH: return "PEER2PEERPUSH";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__NOOP: return "NOOP";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__FLUSHALLDATA: return "FLUSHALLDATA";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PINOP: return "PINOP";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__MEDIASCAN: return "MEDIASCAN";
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__MEDIAOPTIMIZE: return "MEDIAOPTIMIZE";
+    default: return "UNKNOWN";
+    }
+}
+
+bool KineticTrace_WriteChromeJSON(FILE* out)
+{
+    size_t count = 0;
+    trace_span* spans = collect_spans(&count);
+    if (spans == NULL) {
+        return false;
+    }
+    resolve_message_types(spans, count);
+    qsort(spans, count, sizeof(*spans), compare_spans);
+
+    uint64_t origin = (count > 0) ? spans[0].record.start : 0;
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    pthread_mutex_lock(&RingsMutex);
+    for (trace_ring* ring = Rings; ring != NULL; ring = ring->next) {
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+            "\"args\":{\"name\":\"kinetic-c thread %u\"}}",
+            first ? "" : ",\n", ring->tid, ring->tid);
+        first = false;
+    }
+    pthread_mutex_unlock(&RingsMutex);
+    for (size_t i = 0; i < count; i++) {
+        const trace_record* r = &spans[i].record;
+        fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+            "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"fd\":%d,\"seq\":%lld}}",
+            first ? "" : ",\n", StageNames[r->stage], message_type_name(r->messageType),
+            r->tid, (r->start - origin) / 1000.0, r->duration / 1000.0,
+            (int)r->fd, (long long)r->seq);
+        first = false;
+    }
+    fprintf(out, "\n]}\n");
+    free(spans);
+    return !ferror(out);
+}
+
+// Message types are indexed from -1 (unknown) to the largest request type
+#define TYPE_SLOTS (COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__MEDIAOPTIMIZE + 2)
+
+bool KineticTrace_WriteFolded(FILE* out)
+{
+    size_t count = 0;
+    trace_span* spans = collect_spans(&count);
+    if (spans == NULL) {
+        return false;
+    }
+    resolve_message_types(spans, count);
+
+    uint64_t (*totals)[KINETIC_TRACE_STAGE_COUNT] = calloc(TYPE_SLOTS, sizeof(*totals));
+    if (totals == NULL) {
+        free(spans);
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const trace_record* r = &spans[i].record;
+        int type = r->messageType + 1;
+        if (type < 0 || type >= TYPE_SLOTS) {
+            type = 0;
+        }
+        totals[type][r->stage] += r->duration;
+    }
+    free(spans);
+
+    // HMAC runs within packing, so packing's own frame excludes it
+    for (int type = 0; type < TYPE_SLOTS; type++) {
+        const char* name = message_type_name(type - 1);
+        uint64_t* t = totals[type];
+        for (int stage = 0; stage < KINETIC_TRACE_STAGE_COUNT; stage++) {
+            uint64_t ns = t[stage];
+            if (stage == KINETIC_TRACE_PACK) {
+                ns = (ns > t[KINETIC_TRACE_HMAC]) ? ns - t[KINETIC_TRACE_HMAC] : 0;
+            }
+            if (ns == 0) {
+                continue;
+            }
+            if (stage == KINETIC_TRACE_HMAC) {
+                fprintf(out, "kinetic-c;%s;%s;%s %llu\n", name,
+                    StageNames[KINETIC_TRACE_PACK], StageNames[stage], (unsigned long long)ns);
+            }
+            else {
+                fprintf(out, "kinetic-c;%s;%s %llu\n", name, StageNames[stage], (unsigned long long)ns);
+            }
+        }
+    }
+    free(totals);
+    return !ferror(out);
+}
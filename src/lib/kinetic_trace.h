@@ -0,0 +1,86 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_TRACE_H
+#define _KINETIC_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "kinetic_clock.h"
+
+// Per-operation tracing: each stage of an operation's life is recorded as a
+// span in a fixed-size binary ring owned by the thread that ran it, so that
+// recording takes no locks. The rings keep the most recent spans and can be
+// exported as Chrome trace-event JSON or as folded stacks for FlameGraph.
+// Spans are keyed by the connection's fd and the request's sequence ID, which
+// the client and the bus both know.
+
+typedef enum {
+    KINETIC_TRACE_BUILD = 0,        // operation allocated until it is sent
+    KINETIC_TRACE_PACK,             // PDU packing, including HMAC
+    KINETIC_TRACE_HMAC,             // request signing
+    KINETIC_TRACE_SEND_TURN,        // waiting for the session's send turn
+    KINETIC_TRACE_THROTTLE,         // waiting on outstandingOperations
+    KINETIC_TRACE_SOCKET_WRITE,     // handing the PDU to the bus and writing it
+    KINETIC_TRACE_LISTENER_MATCH,   // listener matching a response to its request
+    KINETIC_TRACE_QUEUE_WAIT,       // response waiting in the threadpool queue
+    KINETIC_TRACE_UNPACK,           // response unpack on the worker thread
+    KINETIC_TRACE_CALLBACK,         // operation and user callbacks
+    KINETIC_TRACE_STAGE_COUNT
+} KineticTraceStage;
+
+// Message type for spans recorded where it is not known (the bus); resolved
+// from the operation's other spans on export
+#define KINETIC_TRACE_TYPE_UNKNOWN (-1)
+
+extern volatile bool KineticTraceEnabled;
+
+void KineticTrace_Enable(bool enable);
+
+/* Record a span from start to end (KineticClock_Now() timestamps). */
+void KineticTrace_Record(KineticTraceStage stage, int fd, int64_t seq,
+    int messageType, uint64_t start, uint64_t end);
+
+/* Discard all recorded spans. */
+void KineticTrace_Reset(void);
+
+/* Export the recorded spans. Return false on a write error. */
+bool KineticTrace_WriteChromeJSON(FILE* out);
+bool KineticTrace_WriteFolded(FILE* out);
+
+#ifndef TEST
+// Start timestamp for a span, or 0 while tracing is disabled
+#define KINETIC_TRACE_START() (KineticTraceEnabled ? KineticClock_Now() : 0)
+// Record a span from a KINETIC_TRACE_START() timestamp until now
+#define KINETIC_TRACE_SPAN(STAGE, FD, SEQ, TYPE, START)                   \
+    do {                                                                \
+        uint64_t _start = (START);                                      \
+        if (_start != 0 && KineticTraceEnabled) {                       \
+            KineticTrace_Record(STAGE, FD, SEQ, TYPE, _start, KineticClock_Now()); \
+        }                                                               \
+    } while (0)
+#else
+#define KINETIC_TRACE_START() ((uint64_t)0)
+#define KINETIC_TRACE_SPAN(STAGE, FD, SEQ, TYPE, START) \
+    ((void)(FD), (void)(SEQ), (void)(TYPE), (void)(START))
+#endif
+
+#endif // _KINETIC_TRACE_H
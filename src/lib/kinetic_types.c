@@ -57,6 +57,7 @@ STATIC const char* KineticStatusDescriptor[] = {
     "INVALID_LOG_TYPE",
     "HMAC_FAILURE",
     "SESSION_TERMINATED",
+    "TAG_MISMATCH",
 };
 
 #ifdef TEST
@@ -74,7 +75,7 @@ const char* Kinetic_GetStatusDescription(KineticStatus status)
 
 const char* KineticMessageTypeNames[33] =
 {
-    "<UNKNOWN>"
+    "<UNKNOWN>",
     "GET_RESPONSE",
     "GET",
     "PUT_RESPONSE",
@@ -150,3 +151,36 @@ const char* KineticMessageType_GetName(KineticMessageType type)
       return KineticMessageTypeNames[0];
     };
 }
+
+// Largest latency counted by a histogram bucket (see KINETIC_LATENCY_BUCKETS)
+static uint64_t latency_bucket_upper_bound(size_t bucket)
+{
+    if (bucket < 8) {
+        return bucket;
+    }
+    unsigned shift = (unsigned)(bucket / 8) - 1;
+    uint64_t lower = (uint64_t)(8 + bucket % 8) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
+
+uint64_t KineticLatencyHistogram_Percentile(const KineticLatencyHistogram* histogram, double percentile)
+{
+    if (histogram == NULL || histogram->count == 0) {
+        return 0;
+    }
+    if (percentile < 0.0) { percentile = 0.0; }
+    if (percentile > 100.0) { percentile = 100.0; }
+
+    uint64_t rank = (uint64_t)((percentile / 100.0) * (double)histogram->count + 0.5);
+    if (rank == 0) { rank = 1; }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < KINETIC_LATENCY_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint64_t bound = latency_bucket_upper_bound(i);
+            return (bound < histogram->maxNanoseconds) ? bound : histogram->maxNanoseconds;
+        }
+    }
+    return histogram->maxNanoseconds;
+}
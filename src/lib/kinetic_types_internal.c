@@ -378,7 +378,79 @@ Com__Seagate__Kinetic__Proto__Command__GetLog__Type KineticLogInfo_Type_to_Com__
 
 KineticMessageType Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType(Com__Seagate__Kinetic__Proto__Command__MessageType type)
 {
-    return (KineticMessageType)type;
+    KineticMessageType kineticType;
+
+    // The protocol leaves gaps in its numbering, so the values differ from GETVERSION on
+    switch(type) {
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_GET_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET:
+        kineticType = KINETIC_MESSAGE_TYPE_GET; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PUT_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_PUT_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PUT:
+        kineticType = KINETIC_MESSAGE_TYPE_PUT; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__DELETE_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_DELETE_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__DELETE:
+        kineticType = KINETIC_MESSAGE_TYPE_DELETE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETNEXT_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_GETNEXT_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETNEXT:
+        kineticType = KINETIC_MESSAGE_TYPE_GETNEXT; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETPREVIOUS_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_GETPREVIOUS_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETPREVIOUS:
+        kineticType = KINETIC_MESSAGE_TYPE_GETPREVIOUS; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETKEYRANGE_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_GETKEYRANGE_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETKEYRANGE:
+        kineticType = KINETIC_MESSAGE_TYPE_GETKEYRANGE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETVERSION_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_GETVERSION_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETVERSION:
+        kineticType = KINETIC_MESSAGE_TYPE_GETVERSION; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__SETUP_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_SETUP_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__SETUP:
+        kineticType = KINETIC_MESSAGE_TYPE_SETUP; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETLOG_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_GETLOG_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETLOG:
+        kineticType = KINETIC_MESSAGE_TYPE_GETLOG; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__SECURITY_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_SECURITY_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__SECURITY:
+        kineticType = KINETIC_MESSAGE_TYPE_SECURITY; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PEER2PEERPUSH_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_PEER2PEERPUSH_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PEER2PEERPUSH:
+        kineticType = KINETIC_MESSAGE_TYPE_PEER2PEERPUSH; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__NOOP_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_NOOP_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__NOOP:
+        kineticType = KINETIC_MESSAGE_TYPE_NOOP; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__FLUSHALLDATA_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_FLUSHALLDATA_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__FLUSHALLDATA:
+        kineticType = KINETIC_MESSAGE_TYPE_FLUSHALLDATA; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PINOP_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_PINOP_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PINOP:
+        kineticType = KINETIC_MESSAGE_TYPE_PINOP; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__MEDIASCAN_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_MEDIASCAN_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__MEDIASCAN:
+        kineticType = KINETIC_MESSAGE_TYPE_MEDIASCAN; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__MEDIAOPTIMIZE_RESPONSE:
+        kineticType = KINETIC_MESSAGE_TYPE_MEDIAOPTIMIZE_RESPONSE; break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__MEDIAOPTIMIZE:
+        kineticType = KINETIC_MESSAGE_TYPE_MEDIAOPTIMIZE; break;
+    default:
+        kineticType = KINETIC_MESSAGE_TYPE_INVALID;
+    };
+
+    return kineticType;
 }
 
 void KineticSessionConfig_Copy(KineticSessionConfig* dest, KineticSessionConfig* src)
@@ -409,7 +481,9 @@ void KineticMessage_Init(KineticMessage* const message)
     com__seagate__kinetic__proto__command__get_log__init(&message->getLog);
     com__seagate__kinetic__proto__command__get_log__device__init(&message->getLogDevice);
     com__seagate__kinetic__proto__command__security__init(&message->security);
+    com__seagate__kinetic__proto__command__security__acl__init(&message->acl);
     com__seagate__kinetic__proto__command__pin_operation__init(&message->pinOp);
+    message->getLogType = 0;
 }
 
 static void KineticMessage_HeaderInit(Com__Seagate__Kinetic__Proto__Command__Header* hdr, KineticSession const * const session)
@@ -431,9 +505,11 @@ void KineticRequest_Init(KineticRequest* request, KineticSession const * const s
 {
     KINETIC_ASSERT(request != NULL);
     KINETIC_ASSERT(session != NULL);
-    memset(request, 0, sizeof(KineticRequest));
+    // Requests are recycled, so reset each protobuf element in place rather
+    // than zeroing the whole request first; hmacData is always overwritten.
     KineticMessage_Init(&(request->message));
     KineticMessage_HeaderInit(&(request->message.header), session);
     request->command = &request->message.command;
     request->command->header = &request->message.header;
+    request->pinAuth = false;
 }
@@ -27,9 +27,12 @@
 #include "kinetic_resourcewaiter_types.h"
 #include "kinetic_resourcewaiter.h"
 #include "kinetic_acl.h"
+#include "kinetic_arena.h"
+#include "kinetic_pdu_scan.h"
 #include <netinet/in.h>
 #include <ifaddrs.h>
 #include <openssl/sha.h>
+#include <openssl/evp.h>
 #include <time.h>
 #include <pthread.h>
 
@@ -37,6 +40,7 @@
 #define KINETIC_SOCKET_DESCRIPTOR_INVALID (-1)
 #define KINETIC_CONNECTION_TIMEOUT_SECS (30) /* Java simulator may take longer than 10 seconds to respond */
 #define KINETIC_OPERATION_TIMEOUT_SECS (20)
+#define KINETIC_OPERATION_POOL_MAX (2 * KINETIC_MAX_OUTSTANDING_OPERATIONS_PER_SESSION)
 
 // Ensure __func__ is defined (for debugging)
 #if !defined __func__
@@ -55,6 +59,10 @@
 
 struct _KineticClient {
     struct bus *bus;
+    bool batchHmac;     // sign requests through the batch HMAC signer
+    pthread_mutex_t sessionsMutex;      // guards sessions and retiredStats
+    struct _KineticSession *sessions;   // connected sessions, for KineticClient_GetStats
+    KineticStats retiredStats;          // counters of destroyed sessions
 };
 
 enum unpack_error {
@@ -62,6 +70,7 @@ enum unpack_error {
     UNPACK_ERROR_SUCCESS,
     UNPACK_ERROR_INVALID_HEADER,
     UNPACK_ERROR_PAYLOAD_MALLOC_FAIL,
+    UNPACK_ERROR_INVALID_PROTOBUF,
 };
 
 // #TODO remove packed attribute and replace uses of sizeof(KineticPDUHeader)
@@ -88,6 +97,34 @@ typedef struct {
     uint8_t buf[];
 } socket_info;
 
+struct _KineticOperationSlot;
+
+/**
+ * @brief Counters for the session's memory pools.
+ */
+typedef struct {
+    uint64_t operations;        ///< operations handed out by KineticAllocator_NewOperation
+    uint64_t operationAllocs;   ///< heap allocations needed to satisfy them
+} KineticAllocatorStats;
+
+// Combines messages signed concurrently into multi-buffer batches (see
+// KineticHMACBatch_Sign)
+typedef struct _KineticHMACBatchSigner {
+    pthread_mutex_t mutex;
+    pthread_cond_t signedCond;
+    bool busy;                              // a thread is signing a batch
+    struct _KineticHMACBatchJob* pending;   // submitted, not yet in a batch
+} KineticHMACBatchSigner;
+
+// HMAC-SHA1 key schedule: digest states after the padded key blocks
+typedef struct _KineticHMACKey {
+    EVP_MD_CTX* inner;      // after (key ^ ipad)
+    EVP_MD_CTX* outer;      // after (key ^ opad)
+    uint32_t innerState[5]; // the same states as raw SHA-1 words, for batch signing
+    uint32_t outerState[5];
+    KineticHMACBatchSigner* signer; // sign requests through this batch signer, if set
+} KineticHMACKey;
+
 /**
  * @brief An instance of a session with a Kinetic device.
  */
@@ -100,10 +137,23 @@ struct _KineticSession {
     int64_t         sequence;                           ///< increments for each request in a session
     struct bus *    messageBus;                         ///< pointer to message bus instance
     socket_info *   si;                                 ///< pointer to socket information
-    pthread_mutex_t sendMutex;                          ///< mutex for locking around seq count acquisision, PDU packing, and transfer to threadpool
+    pthread_mutex_t sendMutex;                          ///< mutex guarding the ordered hand-off of packed PDUs to the message bus
+    pthread_cond_t  sendTurnCond;                       ///< signalled when sendTurn advances
+    int64_t         sendTurn;                           ///< sequence number of the next request allowed onto the message bus
     KineticResourceWaiter connectionReady;              ///< connection ready status (set to true once connectionID recieved)
     KineticCountingSemaphore * outstandingOperations;   ///< counting semaphore to only allows the configured number of outstanding operation at a given time
     uint16_t timeoutSeconds;                            ///< Default response timeout
+    pthread_mutex_t operationPoolMutex;                 ///< mutex protecting the free operation list and allocator stats
+    struct _KineticOperationSlot * freeOperations;      ///< completed operations kept for reuse
+    size_t          freeOperationCount;                 ///< number of operations in freeOperations
+    KineticAllocatorStats allocatorStats;               ///< allocation counters, for checking pool effectiveness
+    KineticHMACKey  hmacKeySchedule;                    ///< HMAC state precomputed from config.hmacKey
+    KineticHMACBatchSigner hmacSigner;                  ///< combines this session's concurrent request signing, if batchHmac
+    KineticTagStats tagStats;                           ///< GET value verification counters, updated atomically
+    KineticResponseAuthStats responseAuthStats;         ///< response HMAC validation counters, updated atomically
+    KineticStats    stats;                              ///< operation completion counters, updated atomically (see kinetic_stats.h)
+    KineticClient * client;                             ///< client aggregating this session's stats, once connected
+    struct _KineticSession * nextSession;               ///< next session in client->sessions
 };
 
 // Kinetic Message HMAC
@@ -159,14 +209,21 @@ struct _KineticRequest {
     KineticMessage message;
     Com__Seagate__Kinetic__Proto__Command* command;
     bool pinAuth;
+    KineticArena txArena;   // backs the packed PDU; reset when the operation is freed
 };
 
+#define KINETIC_RESPONSE_UNPOOLED (0)
+
 typedef struct _KineticResponse
 {
     KineticPDUHeader header;
     Com__Seagate__Kinetic__Proto__Message* proto;
     Com__Seagate__Kinetic__Proto__Command* command;
-    uint8_t value[];
+    uint8_t sizeClass;                  // 1-based response pool index, or KINETIC_RESPONSE_UNPOOLED
+    struct _KineticResponse* next;      // free list link while pooled
+    KineticArena arena;                 // backs the unpacked proto and command
+    KineticPDUScan scan;                // routing fields read on the listener thread
+    uint8_t pdu[];                      // raw protobuf then value, as received
 } KineticResponse;
 
 typedef struct _KineticRequest KineticRequest;
@@ -189,8 +246,20 @@ struct _KineticOperation {
     KineticOperationCallback opCallback;
     KineticCompletionClosure closure;
     ByteArray value;
+    bool computeValueTag;   // fill entry->tag from the value as it is packed
+    uint64_t traceStart;    // allocation time, if tracing (see kinetic_trace.h)
+    KineticOperationTimestamps timestamps;  // stage times (see kinetic_clock.h), for session stats
+    uint64_t bytesSent;     // request PDU length, including the value
 };
 
+// Operation and its request, allocated together and recycled through the
+// owning session's free list
+typedef struct _KineticOperationSlot {
+    KineticOperation operation;
+    KineticRequest request;
+    struct _KineticOperationSlot* next;
+} KineticOperationSlot;
+
 
 Com__Seagate__Kinetic__Proto__Command__Algorithm Com__Seagate__Kinetic__Proto__Command__Algorithm_from_KineticAlgorithm(
     KineticAlgorithm kinteicAlgorithm);
@@ -34,9 +34,9 @@ static size_t fibs(size_t arg) {
 }
 
 static void dump_stats(const char *prefix, struct threadpool_info *stats) {
-    printf("%s(at %d, dt %d, bl %zd)\n",
+    printf("%s(at %d, dt %d, bl %zd, sp %zd, rt %zd)\n",
         prefix, stats->active_threads, stats->dormant_threads,
-        stats->backlog_size);
+        stats->backlog_size, stats->threads_spawned, stats->threads_retired);
 }
 
 #define ATOMIC_BOOL_COMPARE_AND_SWAP(PTR, OLD, NEW)     \
@@ -74,16 +74,24 @@ static void inf_loop_cb(void *env) {
 
 int main(int argc, char **argv) {
     uint8_t sz2 = 8;
-    uint8_t max_threads = 8;
+    uint16_t min_threads = 1;
+    uint16_t max_threads = 8;
+    size_t idle_msec = 500;
 
     char *sz2_env = getenv("SZ2");
+    char *min_threads_env = getenv("MIN_THREADS");
     char *max_threads_env = getenv("MAX_THREADS");
+    char *idle_msec_env = getenv("IDLE_MSEC");
     if (sz2_env) { sz2 = atoi(sz2_env); }
+    if (min_threads_env) { min_threads = atoi(min_threads_env); }
     if (max_threads_env) { max_threads = atoi(max_threads_env); }
+    if (idle_msec_env) { idle_msec = atoi(idle_msec_env); }
 
     struct threadpool_config cfg = {
         .task_ringbuf_size2 = sz2,
+        .min_threads = min_threads,
         .max_threads = max_threads,
+        .idle_timeout = idle_msec,
     };
     struct threadpool *t = Threadpool_Init(&cfg);
     assert(t);
@@ -119,6 +127,17 @@ int main(int argc, char **argv) {
         sleep(1);
     }
 
+    /* Once idle, the pool should shrink back down to min_threads. */
+    for (int i = 0; i < 100; i++) {
+        Threadpool_Stats(t, &stats);
+        if (stats.active_threads + stats.dormant_threads <= min_threads) { break; }
+        (void)poll(NULL, 0, idle_msec / 10 + 1);
+    }
+    Threadpool_Stats(t, &stats);
+    dump_stats("idle...", &stats);
+    assert(stats.active_threads + stats.dormant_threads == min_threads);
+    assert(stats.threads_spawned == stats.threads_retired + min_threads);
+
     task.task = inf_loop_cb;
     size_t counterpressure = 0;
     while (!Threadpool_Schedule(t, &task, &counterpressure)) {
@@ -0,0 +1,143 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <assert.h>
+#include <poll.h>
+
+#include "threadpool.h"
+
+/* Check that tasks in a serial queue run in order, one at a time,
+ * while separate queues still make progress in parallel. */
+
+#define QUEUES 16
+#define TASKS_PER_QUEUE 10000
+
+#define ATOMIC_BOOL_COMPARE_AND_SWAP(PTR, OLD, NEW)     \
+    (__sync_bool_compare_and_swap(PTR, OLD, NEW))
+
+/* Spin attempting to atomically adjust F by ADJ until successful */
+#define SPIN_ADJ(F, ADJ)                                                \
+    do {                                                                \
+        for (;;) {                                                      \
+            size_t v = F;                                               \
+            if (ATOMIC_BOOL_COMPARE_AND_SWAP(&F, v, v + ADJ)) {         \
+                break;                                                  \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+typedef struct {
+    size_t next;                /* next expected sequence number */
+    size_t in_task;             /* tasks currently running for this queue */
+} queue_env;
+
+typedef struct {
+    queue_env *q;
+    size_t seq;
+} task_env;
+
+static queue_env queues[QUEUES];
+static task_env task_envs[QUEUES][TASKS_PER_QUEUE];
+static size_t completed_count = 0;
+static size_t max_concurrent = 0;
+static size_t concurrent = 0;
+
+static void task_cb(void *udata) {
+    task_env *te = (task_env *)udata;
+    queue_env *q = te->q;
+
+    SPIN_ADJ(q->in_task, 1);
+    assert(q->in_task == 1);
+    assert(q->next == te->seq);
+
+    SPIN_ADJ(concurrent, 1);
+    for (;;) {
+        size_t c = concurrent;
+        size_t m = max_concurrent;
+        if (c <= m || ATOMIC_BOOL_COMPARE_AND_SWAP(&max_concurrent, m, c)) {
+            break;
+        }
+    }
+    if ((te->seq & 1023) == 0) { (void)poll(NULL, 0, 1); }
+    SPIN_ADJ(concurrent, -1);
+
+    q->next++;
+    SPIN_ADJ(q->in_task, -1);
+    SPIN_ADJ(completed_count, 1);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    uint16_t max_threads = 8;
+
+    char *max_threads_env = getenv("MAX_THREADS");
+    if (max_threads_env) { max_threads = atoi(max_threads_env); }
+
+    struct threadpool_config cfg = {
+        .task_ringbuf_size2 = 8,
+        .max_threads = max_threads,
+    };
+    struct threadpool *t = Threadpool_Init(&cfg);
+    assert(t);
+
+    struct threadpool_serial *serials[QUEUES];
+    for (int i = 0; i < QUEUES; i++) {
+        serials[i] = Threadpool_SerialInit(t);
+        assert(serials[i]);
+    }
+
+    for (size_t seq = 0; seq < TASKS_PER_QUEUE; seq++) {
+        for (int i = 0; i < QUEUES; i++) {
+            task_envs[i][seq] = (task_env){ .q = &queues[i], .seq = seq, };
+            struct threadpool_task task = {
+                .task = task_cb, .udata = &task_envs[i][seq],
+            };
+            size_t counterpressure = 0;
+            while (!Threadpool_ScheduleSerial(serials[i], &task, &counterpressure)) {
+                (void)poll(NULL, 0, 1);
+            }
+        }
+    }
+
+    /* Queues are freed once drained. */
+    for (int i = 0; i < QUEUES; i++) {
+        Threadpool_SerialRelease(serials[i]);
+    }
+
+    while (completed_count < QUEUES * TASKS_PER_QUEUE) {
+        (void)poll(NULL, 0, 10);
+    }
+
+    for (int i = 0; i < QUEUES; i++) {
+        assert(queues[i].next == TASKS_PER_QUEUE);
+    }
+    printf("completed %zd tasks in %d queues, max concurrency %zd\n",
+        completed_count, QUEUES, max_concurrent);
+    assert(max_threads == 1 || max_concurrent > 1);
+
+    while (!Threadpool_Shutdown(t, false)) {
+        (void)poll(NULL, 0, 10);
+    }
+    Threadpool_Free(t);
+    return 0;
+}
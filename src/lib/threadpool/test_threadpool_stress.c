@@ -69,7 +69,7 @@ static void task_cb(void *udata) {
 
 int main(int argc, char **argv) {
     uint8_t sz2 = 12;
-    uint8_t max_threads = 8;
+    uint16_t max_threads = 8;
 
     char *sz2_env = getenv("SZ2");
     char *max_threads_env = getenv("MAX_THREADS");
@@ -25,6 +25,7 @@
 #include <err.h>
 #include <poll.h>
 #include <errno.h>
+#include <limits.h>
 
 #include "threadpool_internals.h"
 
@@ -33,13 +34,22 @@
 #define INFINITE_DELAY -1 /* poll will only return upon an event */
 #define DEFAULT_TASK_RINGBUF_SIZE2 8
 #define DEFAULT_MAX_THREADS 8
+#define DEFAULT_IDLE_TIMEOUT 5000 /* msec */
+#define SERIAL_DEF_SIZE 16
+#define SERIAL_MAX_BATCH 16 /* tasks run before yielding to other work */
 
 static void notify_new_task(struct threadpool *t);
 static bool notify_shutdown(struct threadpool *t);
 static bool spawn(struct threadpool *t);
+static bool retire(struct threadpool *t, struct thread_info *ti);
+static void reap(struct thread_info *ti);
 static void *thread_task(void *thread_info);
 static void commit_current_task(struct threadpool *t, struct marked_task *task, size_t wh);
 static void release_current_task(struct threadpool *t, struct marked_task *task, size_t rh);
+static void serial_drain_cb(void *udata);
+static void serial_cleanup_cb(void *udata);
+static bool serial_grow(struct threadpool_serial *s);
+static void serial_free(struct threadpool_serial *s);
 
 static void set_defaults(struct threadpool_config *cfg) {
     if (cfg->task_ringbuf_size2 == 0) {
@@ -47,6 +57,7 @@ static void set_defaults(struct threadpool_config *cfg) {
     }
     
     if (cfg->max_threads == 0) { cfg->max_threads = DEFAULT_MAX_THREADS; }
+    if (cfg->idle_timeout == 0) { cfg->idle_timeout = DEFAULT_IDLE_TIMEOUT; }
 }
 
 struct threadpool *Threadpool_Init(struct threadpool_config *cfg) {
@@ -56,6 +67,7 @@ struct threadpool *Threadpool_Init(struct threadpool_config *cfg) {
         return NULL;
     }
     if (cfg->max_threads < 1) { return NULL; }
+    if (cfg->min_threads > cfg->max_threads) { return NULL; }
 
     struct threadpool *t = NULL;
     struct marked_task *tasks = NULL;
@@ -86,7 +98,16 @@ struct threadpool *Threadpool_Init(struct threadpool_config *cfg) {
     t->task_ringbuf_size = 1 << cfg->task_ringbuf_size2;
     t->task_ringbuf_size2 = cfg->task_ringbuf_size2;
     t->task_ringbuf_mask = t->task_ringbuf_size - 1;
+    t->min_threads = cfg->min_threads;
     t->max_threads = cfg->max_threads;
+    t->idle_timeout = (cfg->idle_timeout > INT_MAX
+        ? INT_MAX : (int)cfg->idle_timeout);
+
+    /* Start the floor of the pool up front; if any of these fail, they
+     * will be retried on demand as tasks arrive. */
+    for (int i = 0; i < t->min_threads; i++) {
+        if (!spawn(t)) { break; }
+    }
     return t;
 
 cleanup:
@@ -146,17 +167,107 @@ static void commit_current_task(struct threadpool *t, struct marked_task *task,
     }
 }
 
+struct threadpool_serial *Threadpool_SerialInit(struct threadpool *t) {
+    if (t == NULL) { return NULL; }
+
+    struct threadpool_serial *s = malloc(sizeof(*s));
+    if (s == NULL) { return NULL; }
+    struct threadpool_task *tasks = malloc(SERIAL_DEF_SIZE * sizeof(*tasks));
+    if (tasks == NULL) {
+        free(s);
+        return NULL;
+    }
+
+    memset(s, 0, sizeof(*s));
+    if (0 != pthread_mutex_init(&s->lock, NULL)) {
+        free(tasks);
+        free(s);
+        return NULL;
+    }
+    s->t = t;
+    s->tasks = tasks;
+    s->size = SERIAL_DEF_SIZE;
+    s->refs = 1;
+    return s;
+}
+
+bool Threadpool_ScheduleSerial(struct threadpool_serial *s,
+        struct threadpool_task *task, size_t *pushback) {
+    if (s == NULL) { return false; }
+    if (task == NULL || task->task == NULL) { return false; }
+    struct threadpool *t = s->t;
+    if (t->shutting_down) { return false; }
+
+    bool res = true;
+    if (0 != pthread_mutex_lock(&s->lock)) { assert(false); }
+
+    if (s->count == s->size && !serial_grow(s)) {
+        res = false;
+    } else {
+        s->tasks[(s->head + s->count) & (s->size - 1)] = *task;
+        s->count++;
+
+        if (s->running) {
+            /* The drain task will get to it, after everything ahead of it. */
+            if (pushback) {
+                *pushback = (t->task_commit_head - t->task_request_head)
+                  + s->count - 1;
+            }
+        } else {
+            struct threadpool_task drain = {
+                .task = serial_drain_cb,
+                .cleanup = serial_cleanup_cb,
+                .udata = s,
+            };
+            if (Threadpool_Schedule(t, &drain, pushback)) {
+                s->running = true;
+            } else {
+                s->count--;     /* withdraw it, caller will retry */
+                res = false;
+            }
+        }
+    }
+
+    if (0 != pthread_mutex_unlock(&s->lock)) { assert(false); }
+    return res;
+}
+
+void Threadpool_SerialRetain(struct threadpool_serial *s) {
+    if (0 != pthread_mutex_lock(&s->lock)) { assert(false); }
+    assert(s->refs > 0);
+    s->refs++;
+    if (0 != pthread_mutex_unlock(&s->lock)) { assert(false); }
+}
+
+void Threadpool_SerialRelease(struct threadpool_serial *s) {
+    if (s == NULL) { return; }
+    if (0 != pthread_mutex_lock(&s->lock)) { assert(false); }
+    assert(s->refs > 0);
+    s->refs--;
+    /* If the drain task is running, it will free the queue once empty. */
+    bool unused = (s->refs == 0 && !s->running);
+    if (0 != pthread_mutex_unlock(&s->lock)) { assert(false); }
+
+    if (unused) { serial_free(s); }
+}
+
 void Threadpool_Stats(struct threadpool *t, struct threadpool_info *info) {
     if (info) {
-        uint8_t at = 0;
-        for (int i = 0; i < t->live_threads; i++) {
+        uint16_t at = 0;
+        uint16_t dt = 0;
+        for (int i = 0; i < t->slot_limit; i++) {
             struct thread_info *ti = &t->threads[i];
-            if (ti->status == STATUS_AWAKE) { at++; }
+            if (ti->status == STATUS_AWAKE) {
+                at++;
+            } else if (ti->status == STATUS_ASLEEP) {
+                dt++;
+            }
         }
         info->active_threads = at;
-
-        info->dormant_threads = t->live_threads - at;
+        info->dormant_threads = dt;
         info->backlog_size = t->task_commit_head - t->task_request_head;
+        info->threads_spawned = t->threads_spawned;
+        info->threads_retired = t->threads_retired;
     }
 }
 
@@ -165,9 +276,9 @@ bool Threadpool_Shutdown(struct threadpool *t, bool kill_all) {
     size_t mask = t->task_ringbuf_mask;
 
     if (kill_all) {
-        for (int i = 0; i < t->live_threads; i++) {
+        for (int i = 0; i < t->slot_limit; i++) {
             struct thread_info *ti = &t->threads[i];
-            if (ti->status < STATUS_SHUTDOWN) {
+            if (ti->status == STATUS_ASLEEP || ti->status == STATUS_AWAKE) {
                 ti->status = STATUS_SHUTDOWN;
                 int pcres = pthread_cancel(ti->t);
                 if (pcres != 0) {
@@ -206,9 +317,13 @@ void Threadpool_Free(struct threadpool *t) {
 }
 
 static void notify_new_task(struct threadpool *t) {
-    for (int i = 0; i < t->live_threads; i++) {
+    for (int i = 0; i < t->slot_limit; i++) {
         struct thread_info *ti = &t->threads[i];
-        if (ti->status == STATUS_ASLEEP) {
+        /* Claim the wakeup, so the thread cannot concurrently retire
+         * and leave the new task without a worker. */
+        if (ti->status == STATUS_ASLEEP &&
+            ATOMIC_BOOL_COMPARE_AND_SWAP(&ti->status,
+                STATUS_ASLEEP, STATUS_AWAKE)) {
             ssize_t res = write(ti->parent_fd,
                 NOTIFY_MSG, NOTIFY_MSG_LEN);
             if (NOTIFY_MSG_LEN == res) {
@@ -222,51 +337,76 @@ static void notify_new_task(struct threadpool *t) {
     }
 
     if (t->live_threads < t->max_threads) { /* spawn */
-        if (spawn(t)) {
-            SPIN_ADJ(t->live_threads, 1);
-        }
+        (void)spawn(t);
     } else {
         /* all awake & busy, just keep out of the way & let them work */
     }
 }
 
 static bool notify_shutdown(struct threadpool *t) {
-    int done = 0;
+    int remaining = 0;
     
-    for (int i = 0; i < t->live_threads; i++) {
+    for (int i = 0; i < t->slot_limit; i++) {
         struct thread_info *ti = &t->threads[i];
-        if (ti->status == STATUS_JOINED) {
-            done++;
+        if (ti->status == STATUS_NONE || ti->status == STATUS_JOINED) {
+            continue;
+        } else if (ti->status == STATUS_RETIRED) {
+            reap(ti);
+            ti->status = STATUS_JOINED;
         } else if (ti->status == STATUS_SHUTDOWN) {
             void *v = NULL;
             int joinres = pthread_join(ti->t, &v);
             if (0 == joinres) {
                 ti->status = STATUS_JOINED;
-                done++;
             } else {
                 fprintf(stderr, "pthread_join: %d\n", joinres);
                 assert(joinres == ESRCH);
+                remaining++;
             }
         } else {
-            close(ti->parent_fd);
+            if (ti->parent_fd != -1) {
+                close(ti->parent_fd);
+                ti->parent_fd = -1;
+            }
+            remaining++;
         }
     }
     
-    return (done == t->live_threads);
+    return (remaining == 0);
 }
 
+/* Claim an unused or retired slot and start a thread in it. */
 static bool spawn(struct threadpool *t) {
-    int id = t->live_threads;
-    if (id >= t->max_threads) { return false; }
-    struct thread_info *ti = &t->threads[id];
+    struct thread_info *ti = NULL;
+    int id = 0;
+    for (id = 0; id < t->max_threads; id++) {
+        thread_status_t s = t->threads[id].status;
+        if ((s == STATUS_NONE || s == STATUS_RETIRED) &&
+            ATOMIC_BOOL_COMPARE_AND_SWAP(&t->threads[id].status, s, STATUS_AWAKE)) {
+            ti = &t->threads[id];
+            if (s == STATUS_RETIRED) { reap(ti); }
+            break;
+        }
+    }
+    if (ti == NULL) { return false; }
+
+    for (;;) {
+        uint16_t limit = t->slot_limit;
+        if (id < limit) { break; }
+        if (ATOMIC_BOOL_COMPARE_AND_SWAP(&t->slot_limit, limit, id + 1)) { break; }
+    }
 
     struct thread_context *tc = malloc(sizeof(*tc));
-    if (tc == NULL) { return false; }
+    if (tc == NULL) {
+        ti->status = STATUS_NONE;
+        return false;
+    }
 
     int pipe_fds[2];
     if (0 != pipe(pipe_fds)) {
         printf("pipe(2) failure\n");
         free(tc);
+        ti->status = STATUS_NONE;
         return false;
     }
 
@@ -275,20 +415,63 @@ static bool spawn(struct threadpool *t) {
 
     *tc = (struct thread_context){ .t = t, .ti = ti };
 
+    /* Count the thread as live before it starts, so it cannot see
+     * a stale count if it idles and considers retiring. */
+    SPIN_ADJ(t->live_threads, 1);
     int res = pthread_create(&ti->t, NULL, thread_task, tc);
     if (res == 0) {
-        ti->status = STATUS_AWAKE;
+        SPIN_ADJ(t->threads_spawned, 1);
         return true;
     } else if (res == EAGAIN) {
+        SPIN_ADJ(t->live_threads, -1);
         close(pipe_fds[0]);
         close(pipe_fds[1]);
         free(tc);
+        ti->status = STATUS_NONE;
         return false;
     } else {
         assert(false);
     }                    
 }
 
+/* Called by an idle thread when its poll times out. Returns true if the
+ * thread should exit, which it may only do while the pool is above
+ * min_threads and no wakeup has claimed it. */
+static bool retire(struct threadpool *t, struct thread_info *ti) {
+    if (t->task_request_head != t->task_commit_head) { return false; }
+
+    for (;;) {
+        uint16_t live = t->live_threads;
+        if (live <= t->min_threads) { return false; }
+        if (ATOMIC_BOOL_COMPARE_AND_SWAP(&t->live_threads, live, live - 1)) {
+            break;
+        }
+    }
+
+    if (ATOMIC_BOOL_COMPARE_AND_SWAP(&ti->status, STATUS_ASLEEP, STATUS_RETIRED)) {
+        SPIN_ADJ(t->threads_retired, 1);
+        return true;
+    } else {                    /* woken for a new task, or shutting down */
+        SPIN_ADJ(t->live_threads, 1);
+        return false;
+    }
+}
+
+/* Join a retired thread and release its alert pipe, so the slot
+ * can be reused. */
+static void reap(struct thread_info *ti) {
+    void *v = NULL;
+    int joinres = pthread_join(ti->t, &v);
+    if (joinres != 0) {
+        fprintf(stderr, "pthread_join: %d\n", joinres);
+        assert(joinres == ESRCH);
+    }
+    close(ti->parent_fd);
+    close(ti->child_fd);
+    ti->parent_fd = -1;
+    ti->child_fd = -1;
+}
+
 static void *thread_task(void *arg) {
     struct thread_context *tc = (struct thread_context *)arg;
     struct threadpool *t = tc->t;
@@ -297,14 +480,20 @@ static void *thread_task(void *arg) {
     size_t mask = t->task_ringbuf_mask;
     struct pollfd pfd[1] = { { .fd=ti->child_fd, .events=POLLIN }, };
     uint8_t read_buf[NOTIFY_MSG_LEN*32];
+    bool retired = false;
 
     while (ti->status < STATUS_SHUTDOWN) {
         if (t->task_request_head == t->task_commit_head) {
             if (ti->status == STATUS_AWAKE) {
                 ti->status = STATUS_ASLEEP;
             }
-            int res = poll(pfd, 1, -1);
-            if (res == 1) {
+            int res = poll(pfd, 1, t->idle_timeout);
+            if (res == 0) {
+                if (retire(t, ti)) {
+                    retired = true;
+                    break;
+                }
+            } else if (res == 1) {
                 if (pfd[0].revents & (POLLHUP | POLLERR | POLLNVAL)) {
                     /* TODO: HUP should be distinct from ERR -- hup is
                      * intentional shutdown, ERR probably isn't. */
@@ -345,7 +534,9 @@ static void *thread_task(void *arg) {
         }
     }
 
-    close(ti->child_fd);
+    /* A retired thread's slot may be claimed by spawn() as soon as its
+     * status changes, so leave its pipe for reap() to close. */
+    if (!retired) { close(ti->child_fd); }
     free(tc);
     return NULL;
 }
@@ -362,3 +553,84 @@ static void release_current_task(struct threadpool *t, struct marked_task *task,
         }
     }
 }
+
+/* Run a serial queue's tasks in order. After a batch, re-schedule to
+ * give other queues and tasks a turn, rather than hogging the thread. */
+static void serial_drain_cb(void *udata) {
+    struct threadpool_serial *s = (struct threadpool_serial *)udata;
+
+    for (;;) {
+        for (int i = 0; i < SERIAL_MAX_BATCH; i++) {
+            if (0 != pthread_mutex_lock(&s->lock)) { assert(false); }
+            if (s->count == 0) {
+                s->running = false;
+                bool unused = (s->refs == 0);
+                if (0 != pthread_mutex_unlock(&s->lock)) { assert(false); }
+                if (unused) { serial_free(s); }
+                return;
+            }
+
+            struct threadpool_task task = s->tasks[s->head];
+            s->head = (s->head + 1) & (s->size - 1);
+            s->count--;
+            if (0 != pthread_mutex_unlock(&s->lock)) { assert(false); }
+
+            task.task(task.udata);
+        }
+
+        struct threadpool_task drain = {
+            .task = serial_drain_cb,
+            .cleanup = serial_cleanup_cb,
+            .udata = s,
+        };
+        if (Threadpool_Schedule(s->t, &drain, NULL)) { return; }
+        /* Pool is full or shutting down, so keep draining here. */
+    }
+}
+
+/* The drain task was cancelled during shutdown, so cancel everything
+ * it would have run. */
+static void serial_cleanup_cb(void *udata) {
+    struct threadpool_serial *s = (struct threadpool_serial *)udata;
+
+    for (;;) {
+        if (0 != pthread_mutex_lock(&s->lock)) { assert(false); }
+        if (s->count == 0) {
+            s->running = false;
+            bool unused = (s->refs == 0);
+            if (0 != pthread_mutex_unlock(&s->lock)) { assert(false); }
+            if (unused) { serial_free(s); }
+            return;
+        }
+
+        struct threadpool_task task = s->tasks[s->head];
+        s->head = (s->head + 1) & (s->size - 1);
+        s->count--;
+        if (0 != pthread_mutex_unlock(&s->lock)) { assert(false); }
+
+        if (task.cleanup) { task.cleanup(task.udata); }
+    }
+}
+
+/* Double a full serial queue's ring buffer. Must hold s->lock. */
+static bool serial_grow(struct threadpool_serial *s) {
+    size_t nsize = 2 * s->size;
+    struct threadpool_task *ntasks = malloc(nsize * sizeof(*ntasks));
+    if (ntasks == NULL) { return false; }
+
+    for (size_t i = 0; i < s->count; i++) {
+        ntasks[i] = s->tasks[(s->head + i) & (s->size - 1)];
+    }
+    free(s->tasks);
+    s->tasks = ntasks;
+    s->size = nsize;
+    s->head = 0;
+    return true;
+}
+
+static void serial_free(struct threadpool_serial *s) {
+    assert(s->count == 0);
+    pthread_mutex_destroy(&s->lock);
+    free(s->tasks);
+    free(s);
+}
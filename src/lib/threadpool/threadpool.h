@@ -30,11 +30,18 @@
 /** Opaque handle to threadpool. */
 struct threadpool;
 
+/** Opaque handle to a serial queue, whose tasks run on the threadpool
+ * one at a time, in the order they were scheduled. */
+struct threadpool_serial;
+
 /** Configuration for thread pool. */
 struct threadpool_config {
     uint8_t task_ringbuf_size2; //> log2(size) of task ring buffer
     size_t max_delay;           //> max delay, in msec. 0 => default
-    uint8_t max_threads;        //> max threads to alloc on demand
+    uint16_t min_threads;       //> threads kept alive even while idle
+    uint16_t max_threads;       //> max threads to alloc on demand
+    size_t idle_timeout;        //> msec a thread above min_threads may
+                                //> sit idle before retiring. 0 => default
 };
 
 /** Callback for a task, with an arbitrary user-supplied pointer. */
@@ -53,12 +60,18 @@ struct threadpool_task {
 
 /** Statistics about the current state of the threadpool. */
 struct threadpool_info {
-    uint8_t active_threads;
-    uint8_t dormant_threads;
+    uint16_t active_threads;
+    uint16_t dormant_threads;
     size_t backlog_size;
+    size_t threads_spawned;     //> threads started since init
+    size_t threads_retired;     //> threads that exited after idling
 };
 
-/** Initialize a threadpool, according to a config. Returns NULL on error. */
+/** Initialize a threadpool, according to a config. Returns NULL on error.
+ *
+ * MIN_THREADS threads are started immediately. More are started on
+ * demand, up to MAX_THREADS, and any above MIN_THREADS exit after
+ * idling for IDLE_TIMEOUT msec. */
 struct threadpool *Threadpool_Init(struct threadpool_config *cfg);
 
 /** Schedule a task in the threadpool. Returns whether the task was successfully
@@ -72,6 +85,30 @@ struct threadpool *Threadpool_Init(struct threadpool_config *cfg);
 bool Threadpool_Schedule(struct threadpool *t, struct threadpool_task *task,
     size_t *pushback);
 
+/** Create a serial queue that runs its tasks on T. Tasks in different
+ * serial queues (and tasks scheduled directly on T) still run in
+ * parallel. Returns NULL on error.
+ *
+ * The queue starts with one reference, owned by the caller. */
+struct threadpool_serial *Threadpool_SerialInit(struct threadpool *t);
+
+/** Schedule a task in a serial queue. It will run after every task
+ * previously scheduled in the same queue has finished. Returns whether
+ * the task was successfully registered, and sets *pushback (if non-NULL)
+ * as in Threadpool_Schedule.
+ *
+ * TASK is copied into the queue by value. */
+bool Threadpool_ScheduleSerial(struct threadpool_serial *s,
+    struct threadpool_task *task, size_t *pushback);
+
+/** Add a reference to a serial queue, so it will outlive the creator's
+ * Threadpool_SerialRelease. */
+void Threadpool_SerialRetain(struct threadpool_serial *s);
+
+/** Drop a reference to a serial queue. Once the last reference is gone,
+ * it is freed as soon as any pending tasks have run. */
+void Threadpool_SerialRelease(struct threadpool_serial *s);
+
 /** If TI is non-NULL, fill out some statistics about the operating state
  * of the thread pool. */
 void Threadpool_Stats(struct threadpool *t, struct threadpool_info *ti);
@@ -28,6 +28,7 @@ typedef enum {
     STATUS_NONE,                //> undefined status
     STATUS_ASLEEP,              //> thread is poll-sleeping to reduce CPU
     STATUS_AWAKE,               //> thread is active
+    STATUS_RETIRED,             //> thread exited after idling, needs join
     STATUS_SHUTDOWN,            //> thread has been notified about shutdown
     STATUS_JOINED,              //> thread has been pthread_join'd
 } thread_status_t;
@@ -79,11 +80,29 @@ struct threadpool {
     uint8_t task_ringbuf_size2; //> log2 of size of ring buffer
 
     bool shutting_down;         //> shutdown has been called
-    uint8_t live_threads;       //> currently live threads
-    uint8_t max_threads;        //> max number of threads to start
+    uint16_t live_threads;      //> currently live threads
+    uint16_t min_threads;       //> number of threads exempt from retiring
+    uint16_t max_threads;       //> max number of threads to start
+    uint16_t slot_limit;        //> one past highest thread slot ever used
+    int idle_timeout;           //> msec before an idle thread retires
+    size_t threads_spawned;     //> total threads started
+    size_t threads_retired;     //> total threads retired for idleness
     struct thread_info *threads;
 };
 
+/** Tasks run one at a time, in FIFO order, by a drain task that is
+ * scheduled on the threadpool whenever the queue becomes non-empty. */
+struct threadpool_serial {
+    struct threadpool *t;       //> pool the drain task runs on
+    pthread_mutex_t lock;       //> protects all fields below
+    struct threadpool_task *tasks; //> ring buffer of pending tasks
+    size_t size;                //> ring buffer capacity, a power of 2
+    size_t head;                //> index of the next task to run
+    size_t count;               //> number of pending tasks
+    size_t refs;                //> outstanding references
+    bool running;               //> drain task is scheduled or running
+};
+
 /* Do an atomic compare-and-swap, changing *PTR from OLD to NEW. Returns
  * true if the swap succeeded, false if it failed (generally because
  * another thread updated the memory first). */
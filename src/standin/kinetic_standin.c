@@ -0,0 +1,915 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#define _GNU_SOURCE     // for pthread_rwlock_t and ppoll under -D_POSIX_C_SOURCE=199309L
+#include "kinetic_standin.h"
+#include "kinetic_standin_map.h"
+#include "kinetic_hmac.h"
+#include "kinetic_types_internal.h"
+#include "kinetic.pb-c.h"
+#include "socket99.h"
+#include "bench_util.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define DEFAULT_HOST "127.0.0.1"
+#define DEFAULT_HMAC_KEY "asdfasdf"
+#define READ_CHUNK (64 * 1024)
+#define REORDER_MAX_HOLD_NS (100 * 1000 * 1000)  // if no later response comes along
+#define MAX_KEY_RANGE_COUNT 200     // keys per GETKEYRANGE, as limits.maxKeyRangeCount on a drive
+
+#define LOG(STANDIN, VERBOSITY, ...)                                   \
+    do {                                                               \
+        if ((VERBOSITY) <= (STANDIN)->config.verbosity) {              \
+            printf(__VA_ARGS__);                                       \
+        }                                                              \
+    }                                                                  \
+    while(0)
+
+typedef Com__Seagate__Kinetic__Proto__Command__Status__StatusCode StatusCode;
+typedef Com__Seagate__Kinetic__Proto__Command__MessageType MessageType;
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+} buffer;
+
+// A response held back by fault injection
+typedef struct {
+    uint64_t ready;             // CLOCK_MONOTONIC nanoseconds when its delay is over
+    uint64_t due;               // when it goes out regardless: ready, or
+                                //   REORDER_MAX_HOLD_NS after it if held
+    bool held;                  // reordered: goes out once another response overtakes it
+    bool overtaken;             // another response went out after this one was held
+    uint8_t* pdu;
+    size_t len;
+} delayed_response;
+
+typedef struct connection {
+    KineticStandin* standin;
+    int fd;
+    int64_t connectionID;
+    pthread_t thread;
+    int done;                   // thread has exited and can be joined
+    buffer in;                  // received bytes not yet handled
+    buffer out;                 // responses not yet written
+    buffer command;             // packed response command, for signing
+
+    // Fault injection state
+    uint64_t rng;
+    uint64_t requests;          // handled so far
+    bool closing;               // terminated; close once the output is written
+    delayed_response* delayed;  // ordered by due time
+    size_t delayedCount;
+    size_t delayedCap;
+
+    struct connection* next;
+} connection;
+
+struct _KineticStandin {
+    KineticStandinConfig config;
+    KineticHMACKey key;
+    int listenFd;
+    int port;
+    pthread_t acceptThread;
+    int stopping;
+    bool injectFaults;          // any of config.faults are set
+
+    pthread_rwlock_t mapLock;   // writers exclude readers of the map
+    KineticStandinMap* map;
+
+    pthread_mutex_t connectionsMutex;
+    connection* connections;
+    int64_t nextConnectionID;
+    uint64_t accepted;          // connections so far, for seeding their faults
+};
+
+// Protobuf structs for one response, wired together by init_response
+typedef struct {
+    Com__Seagate__Kinetic__Proto__Command command;
+    Com__Seagate__Kinetic__Proto__Command__Header header;
+    Com__Seagate__Kinetic__Proto__Command__Status status;
+    Com__Seagate__Kinetic__Proto__Command__Body body;
+    Com__Seagate__Kinetic__Proto__Command__KeyValue keyValue;
+    Com__Seagate__Kinetic__Proto__Command__Range range;
+    ByteArray value;
+} response;
+
+static void* accept_main(void* arg);
+static void* connection_main(void* arg);
+static void reap_connections(KineticStandin* standin, bool all);
+
+/*******************************************************************************
+ * Lifecycle
+*******************************************************************************/
+
+KineticStandin* KineticStandin_Start(const KineticStandinConfig* config)
+{
+    KineticStandin* standin = calloc(1, sizeof(*standin));
+    if (standin == NULL) { return NULL; }
+    standin->config = *config;
+    if (standin->config.host == NULL) { standin->config.host = DEFAULT_HOST; }
+    if (standin->config.identity == 0) { standin->config.identity = 1; }
+    if (standin->config.hmacKey.len == 0) {
+        standin->config.hmacKey = ByteArray_CreateWithCString(DEFAULT_HMAC_KEY);
+    }
+    standin->listenFd = -1;
+    standin->nextConnectionID = (int64_t)time(NULL);
+    const KineticStandinFaults* faults = &standin->config.faults;
+    standin->injectFaults = faults->delay != KINETIC_STANDIN_DELAY_NONE || faults->dropRate > 0.0
+        || faults->reorderRate > 0.0 || faults->busyRate > 0.0 || faults->closeAfter > 0;
+
+    standin->map = KineticStandinMap_Create();
+    if (standin->map == NULL ||
+      !KineticHMAC_InitKey(&standin->key, standin->config.hmacKey)) {
+        fprintf(stderr, "Failed allocating stand-in server state\n");
+        KineticStandinMap_Destroy(standin->map);
+        free(standin);
+        return NULL;
+    }
+    // The key was only borrowed from the caller
+    standin->config.hmacKey = BYTE_ARRAY_NONE;
+    pthread_rwlock_init(&standin->mapLock, NULL);
+    pthread_mutex_init(&standin->connectionsMutex, NULL);
+
+    socket99_config cfg = {
+        .host = (char*)standin->config.host,
+        .port = standin->config.port,
+        .server = true,
+    };
+    socket99_result res;
+    struct sockaddr_storage addr;
+    socklen_t addrLen = sizeof(addr);
+    if (!socket99_open(&cfg, &res)) {
+        fprintf(stderr, "Failed listening on %s:%d: ", cfg.host, cfg.port);
+        socket99_fprintf(stderr, &res);
+        goto cleanup;
+    }
+    standin->listenFd = res.fd;
+
+    if (getsockname(standin->listenFd, (struct sockaddr*)&addr, &addrLen) != 0) {
+        fprintf(stderr, "Failed getting the listening port: %s\n", strerror(errno));
+        goto cleanup;
+    }
+    standin->port = ntohs((addr.ss_family == AF_INET6)
+        ? ((struct sockaddr_in6*)&addr)->sin6_port
+        : ((struct sockaddr_in*)&addr)->sin_port);
+
+    if (pthread_create(&standin->acceptThread, NULL, accept_main, standin) != 0) {
+        fprintf(stderr, "Failed starting the stand-in server thread\n");
+        goto cleanup;
+    }
+    LOG(standin, 1, "Stand-in server listening on %s:%d\n", standin->config.host, standin->port);
+    return standin;
+
+cleanup:
+    if (standin->listenFd != -1) { close(standin->listenFd); }
+    pthread_rwlock_destroy(&standin->mapLock);
+    pthread_mutex_destroy(&standin->connectionsMutex);
+    KineticHMAC_DestroyKey(&standin->key);
+    KineticStandinMap_Destroy(standin->map);
+    free(standin);
+    return NULL;
+}
+
+int KineticStandin_Port(const KineticStandin* standin)
+{
+    return standin->port;
+}
+
+void KineticStandin_Stop(KineticStandin* standin)
+{
+    if (standin == NULL) { return; }
+
+    // Shutting down the sockets wakes their threads out of accept and read
+    (void)__sync_lock_test_and_set(&standin->stopping, 1);
+    shutdown(standin->listenFd, SHUT_RDWR);
+    pthread_join(standin->acceptThread, NULL);
+    close(standin->listenFd);
+
+    pthread_mutex_lock(&standin->connectionsMutex);
+    for (connection* c = standin->connections; c != NULL; c = c->next) {
+        shutdown(c->fd, SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&standin->connectionsMutex);
+    reap_connections(standin, true);
+
+    pthread_rwlock_destroy(&standin->mapLock);
+    pthread_mutex_destroy(&standin->connectionsMutex);
+    KineticHMAC_DestroyKey(&standin->key);
+    KineticStandinMap_Destroy(standin->map);
+    free(standin);
+}
+
+/*******************************************************************************
+ * Connections
+*******************************************************************************/
+
+static void free_connection(connection* c)
+{
+    close(c->fd);
+    for (size_t i = 0; i < c->delayedCount; i++) {
+        free(c->delayed[i].pdu);
+    }
+    free(c->delayed);
+    free(c->in.data);
+    free(c->out.data);
+    free(c->command.data);
+    free(c);
+}
+
+/* Join and free the threads of closed connections, or of all of them. A
+ * connection's socket is only closed here, once its thread is done with it,
+ * so that Stop never shuts down a descriptor that has been reused. */
+static void reap_connections(KineticStandin* standin, bool all)
+{
+    pthread_mutex_lock(&standin->connectionsMutex);
+    connection** link = &standin->connections;
+    while (*link != NULL) {
+        connection* c = *link;
+        if (all || __sync_fetch_and_or(&c->done, 0)) {
+            *link = c->next;
+            pthread_join(c->thread, NULL);
+            free_connection(c);
+        } else {
+            link = &c->next;
+        }
+    }
+    pthread_mutex_unlock(&standin->connectionsMutex);
+}
+
+static void* accept_main(void* arg)
+{
+    KineticStandin* standin = arg;
+    for (;;) {
+        int fd = accept(standin->listenFd, NULL, NULL);
+        if (__sync_fetch_and_or(&standin->stopping, 0)) {
+            if (fd != -1) { close(fd); }
+            break;
+        }
+        if (fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) { continue; }
+            fprintf(stderr, "Stand-in server failed accepting a connection: %s\n", strerror(errno));
+            break;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        reap_connections(standin, false);
+
+        connection* c = calloc(1, sizeof(*c));
+        if (c == NULL) {
+            close(fd);
+            continue;
+        }
+        c->standin = standin;
+        c->fd = fd;
+        c->connectionID = __sync_fetch_and_add(&standin->nextConnectionID, 1);
+        c->rng = (standin->config.faults.seed ^ standin->accepted++) * 0x9E3779B97F4A7C15ull;
+        if (c->rng == 0) { c->rng = 1; }
+
+        pthread_mutex_lock(&standin->connectionsMutex);
+        if (pthread_create(&c->thread, NULL, connection_main, c) != 0) {
+            pthread_mutex_unlock(&standin->connectionsMutex);
+            fprintf(stderr, "Failed starting a stand-in connection thread\n");
+            free_connection(c);
+            continue;
+        }
+        c->next = standin->connections;
+        standin->connections = c;
+        pthread_mutex_unlock(&standin->connectionsMutex);
+        LOG(standin, 1, "Accepted connection %lld on fd %d\n", (long long)c->connectionID, fd);
+    }
+    return NULL;
+}
+
+static bool reserve(buffer* b, size_t cap)
+{
+    if (cap <= b->cap) { return true; }
+    size_t newCap = (b->cap > 0) ? b->cap : READ_CHUNK;
+    while (newCap < cap) { newCap *= 2; }
+    uint8_t* data = realloc(b->data, newCap);
+    if (data == NULL) { return false; }
+    b->data = data;
+    b->cap = newCap;
+    return true;
+}
+
+static bool flush(connection* c)
+{
+    size_t written = 0;
+    while (written < c->out.len) {
+        ssize_t n = send(c->fd, &c->out.data[written], c->out.len - written, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+        written += n;
+    }
+    c->out.len = 0;
+    return true;
+}
+
+/*******************************************************************************
+ * PDU framing
+*******************************************************************************/
+
+static void put_be32(uint8_t* p, uint32_t x)
+{
+    p[0] = (uint8_t)(x >> 24);
+    p[1] = (uint8_t)(x >> 16);
+    p[2] = (uint8_t)(x >> 8);
+    p[3] = (uint8_t)x;
+}
+
+static uint32_t get_be32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/* Append a PDU carrying command and value to the output, signed with the
+ * HMAC key unless it is an unsolicited status. */
+static bool append_pdu(connection* c, Com__Seagate__Kinetic__Proto__Command* command,
+    Com__Seagate__Kinetic__Proto__Message__AuthType authType, ByteArray value)
+{
+    size_t commandLen = com__seagate__kinetic__proto__command__get_packed_size(command);
+    if (!reserve(&c->command, commandLen)) { return false; }
+    com__seagate__kinetic__proto__command__pack(command, c->command.data);
+
+    Com__Seagate__Kinetic__Proto__Message msg = COM__SEAGATE__KINETIC__PROTO__MESSAGE__INIT;
+    msg.has_authtype = true;
+    msg.authtype = authType;
+    msg.has_commandbytes = true;
+    msg.commandbytes = (ProtobufCBinaryData){.len = commandLen, .data = c->command.data};
+
+    Com__Seagate__Kinetic__Proto__Message__HMACauth auth = COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
+    uint8_t tag[KINETIC_HMAC_SHA1_LEN];
+    if (authType == COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__HMACAUTH) {
+        if (!KineticHMAC_ComputeTag(&c->standin->key, c->command.data, commandLen, tag)) {
+            return false;
+        }
+        auth.has_identity = true;
+        auth.identity = c->standin->config.identity;
+        auth.has_hmac = true;
+        auth.hmac = (ProtobufCBinaryData){.len = sizeof(tag), .data = tag};
+        msg.hmacauth = &auth;
+    }
+
+    size_t protoLen = com__seagate__kinetic__proto__message__get_packed_size(&msg);
+    if (!reserve(&c->out, c->out.len + PDU_HEADER_LEN + protoLen + value.len)) { return false; }
+    uint8_t* pdu = &c->out.data[c->out.len];
+    pdu[0] = 'F';
+    put_be32(&pdu[1], (uint32_t)protoLen);
+    put_be32(&pdu[5], (uint32_t)value.len);
+    com__seagate__kinetic__proto__message__pack(&msg, &pdu[PDU_HEADER_LEN]);
+    if (value.len > 0) {
+        memcpy(&pdu[PDU_HEADER_LEN + protoLen], value.data, value.len);
+    }
+    c->out.len += PDU_HEADER_LEN + protoLen + value.len;
+    return true;
+}
+
+/* The status a drive sends when a connection opens, assigning its ID, or
+ * without an ID when it is terminating the connection. */
+static bool append_unsolicited_status(connection* c, StatusCode code, bool assignID)
+{
+    Com__Seagate__Kinetic__Proto__Command command = COM__SEAGATE__KINETIC__PROTO__COMMAND__INIT;
+    Com__Seagate__Kinetic__Proto__Command__Header header = COM__SEAGATE__KINETIC__PROTO__COMMAND__HEADER__INIT;
+    Com__Seagate__Kinetic__Proto__Command__Status status = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__INIT;
+    header.has_connectionid = assignID;
+    header.connectionid = assignID ? c->connectionID : 0;
+    status.has_code = true;
+    status.code = code;
+    command.header = &header;
+    command.status = &status;
+    return append_pdu(c, &command,
+        COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__UNSOLICITEDSTATUS, BYTE_ARRAY_NONE);
+}
+
+/*******************************************************************************
+ * Fault injection
+*******************************************************************************/
+
+// Random numbers come from a generator per connection, so no locking is needed
+static bool chance(connection* c, double rate)
+{
+    return rate > 0.0 && BenchUtil_NextUnit(&c->rng) < rate;
+}
+
+static uint64_t response_delay_ns(connection* c)
+{
+    const KineticStandinFaults* f = &c->standin->config.faults;
+    switch (f->delay) {
+    case KINETIC_STANDIN_DELAY_FIXED:
+        return (uint64_t)f->delayMicros * 1000;
+    case KINETIC_STANDIN_DELAY_EXPONENTIAL:
+        return (uint64_t)(-log(1.0 - BenchUtil_NextUnit(&c->rng)) * f->delayMicros * 1000.0);
+    case KINETIC_STANDIN_DELAY_BIMODAL:
+        return (uint64_t)(chance(c, f->slowFraction) ? f->slowDelayMicros : f->delayMicros) * 1000;
+    case KINETIC_STANDIN_DELAY_NONE:
+    default:
+        return 0;
+    }
+}
+
+/* A response is going out ahead of every held one. */
+static void overtake_held(connection* c)
+{
+    for (size_t i = 0; i < c->delayedCount; i++) {
+        c->delayed[i].overtaken |= c->delayed[i].held;
+    }
+}
+
+/* Decide the fate of the response just appended to the output at start:
+ * drop it, hold it back, or leave it to go out with this batch. */
+static bool schedule_response(connection* c, size_t start)
+{
+    const KineticStandinFaults* f = &c->standin->config.faults;
+    if (chance(c, f->dropRate)) {
+        LOG(c->standin, 2, "Connection %lld: dropping response\n", (long long)c->connectionID);
+        c->out.len = start;
+        return true;
+    }
+    uint64_t delay = response_delay_ns(c);
+    bool held = chance(c, f->reorderRate);
+    if (delay == 0 && !held) {
+        overtake_held(c);
+        return true;
+    }
+
+    if (c->delayedCount == c->delayedCap) {
+        size_t cap = (c->delayedCap > 0) ? 2 * c->delayedCap : 16;
+        delayed_response* delayed = realloc(c->delayed, cap * sizeof(*delayed));
+        if (delayed == NULL) { return false; }
+        c->delayed = delayed;
+        c->delayedCap = cap;
+    }
+    uint64_t ready = BenchUtil_Now() + delay;
+    delayed_response d = {
+        .ready = ready,
+        .due = ready + (held ? REORDER_MAX_HOLD_NS : 0),
+        .held = held,
+        .len = c->out.len - start,
+    };
+    d.pdu = malloc(d.len);
+    if (d.pdu == NULL) { return false; }
+    memcpy(d.pdu, &c->out.data[start], d.len);
+    c->out.len = start;
+
+    // Keep the list ordered by due time
+    size_t i = c->delayedCount++;
+    while (i > 0 && c->delayed[i - 1].due > d.due) {
+        c->delayed[i] = c->delayed[i - 1];
+        i--;
+    }
+    c->delayed[i] = d;
+    return true;
+}
+
+/* When a delayed response can go out: once its delay is over, and if it is
+ * held, once another response has overtaken it or it has been held too long. */
+static uint64_t release_time(const delayed_response* d)
+{
+    return (d->held && !d->overtaken) ? d->due : d->ready;
+}
+
+/* Move responses which have come due to the output, followed by any held
+ * back for reordering which they, or earlier responses, have overtaken. */
+static bool release_delayed(connection* c)
+{
+    uint64_t now = BenchUtil_Now();
+    for (int pass = 0; pass < 2; pass++) {
+        size_t kept = 0;
+        bool released = false;
+        for (size_t i = 0; i < c->delayedCount; i++) {
+            delayed_response* d = &c->delayed[i];
+            bool release = ((pass == 0) ? !d->held : d->held) && release_time(d) <= now;
+            if (!release) {
+                c->delayed[kept++] = *d;
+                continue;
+            }
+            if (!reserve(&c->out, c->out.len + d->len)) { return false; }
+            memcpy(&c->out.data[c->out.len], d->pdu, d->len);
+            c->out.len += d->len;
+            free(d->pdu);
+            released = true;
+        }
+        c->delayedCount = kept;
+        if (pass == 0 && released) { overtake_held(c); }
+    }
+    return true;
+}
+
+/* How long until the next delayed response can go out, or NULL to wait for
+ * input indefinitely. */
+static struct timespec* next_due(connection* c, struct timespec* ts)
+{
+    if (c->delayedCount == 0) { return NULL; }
+    uint64_t next = release_time(&c->delayed[0]);
+    for (size_t i = 1; i < c->delayedCount; i++) {
+        uint64_t t = release_time(&c->delayed[i]);
+        if (t < next) { next = t; }
+    }
+    uint64_t now = BenchUtil_Now();
+    uint64_t wait = (next > now) ? next - now : 0;
+    ts->tv_sec = wait / 1000000000ull;
+    ts->tv_nsec = wait % 1000000000ull;
+    return ts;
+}
+
+/*******************************************************************************
+ * Request handling
+*******************************************************************************/
+
+static ByteArray array(ProtobufCBinaryData data)
+{
+    return (ByteArray){.len = data.len, .data = data.data};
+}
+
+static ProtobufCBinaryData binary(ByteArray array)
+{
+    return (ProtobufCBinaryData){.len = array.len, .data = array.data};
+}
+
+static bool same_bytes(ByteArray a, ByteArray b)
+{
+    return a.len == b.len && (a.len == 0 || memcmp(a.data, b.data, a.len) == 0);
+}
+
+static void init_response(response* r, const Com__Seagate__Kinetic__Proto__Command__Header* request,
+    int64_t connectionID)
+{
+    *r = (response) {
+        .command = COM__SEAGATE__KINETIC__PROTO__COMMAND__INIT,
+        .header = COM__SEAGATE__KINETIC__PROTO__COMMAND__HEADER__INIT,
+        .status = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__INIT,
+        .body = COM__SEAGATE__KINETIC__PROTO__COMMAND__BODY__INIT,
+        .keyValue = COM__SEAGATE__KINETIC__PROTO__COMMAND__KEY_VALUE__INIT,
+        .range = COM__SEAGATE__KINETIC__PROTO__COMMAND__RANGE__INIT,
+    };
+    r->header.has_connectionid = true;
+    r->header.connectionid = connectionID;
+    r->header.has_acksequence = request->has_sequence;
+    r->header.acksequence = request->sequence;
+    // Each response type precedes its request type
+    if (request->has_messagetype) {
+        r->header.has_messagetype = true;
+        r->header.messagetype = request->messagetype - 1;
+    }
+    r->status.has_code = true;
+    r->command.header = &r->header;
+    r->command.status = &r->status;
+}
+
+static void respond_with_entry(response* r, const KineticStandinEntry* entry, bool metadataOnly)
+{
+    r->keyValue.has_key = true;
+    r->keyValue.key = binary(entry->key);
+    r->keyValue.has_dbversion = (entry->version.len > 0);
+    r->keyValue.dbversion = binary(entry->version);
+    r->keyValue.has_tag = (entry->tag.len > 0);
+    r->keyValue.tag = binary(entry->tag);
+    r->keyValue.has_algorithm = (entry->algorithm != 0);
+    r->keyValue.algorithm = entry->algorithm;
+    r->body.keyvalue = &r->keyValue;
+    r->command.body = &r->body;
+    if (!metadataOnly) {
+        r->value = entry->value;
+    }
+}
+
+static StatusCode handle_put(KineticStandin* standin,
+    const Com__Seagate__Kinetic__Proto__Command__KeyValue* kv, ByteArray value)
+{
+    if (kv == NULL || !kv->has_key) {
+        return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__INVALID_REQUEST;
+    }
+    if (!(kv->has_force && kv->force)) {
+        const KineticStandinEntry* existing = KineticStandinMap_Find(standin->map, array(kv->key));
+        ByteArray current = (existing != NULL) ? existing->version : BYTE_ARRAY_NONE;
+        ByteArray expected = kv->has_dbversion ? array(kv->dbversion) : BYTE_ARRAY_NONE;
+        if (!same_bytes(current, expected)) {
+            return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__VERSION_MISMATCH;
+        }
+    }
+    KineticStandinEntry entry = {
+        .key = array(kv->key),
+        .value = value,
+        .version = kv->has_newversion ? array(kv->newversion) : BYTE_ARRAY_NONE,
+        .tag = kv->has_tag ? array(kv->tag) : BYTE_ARRAY_NONE,
+        .algorithm = kv->has_algorithm ? kv->algorithm : 0,
+    };
+    if (!KineticStandinMap_Put(standin->map, &entry)) {
+        return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__NO_SPACE;
+    }
+    return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__SUCCESS;
+}
+
+static StatusCode handle_delete(KineticStandin* standin,
+    const Com__Seagate__Kinetic__Proto__Command__KeyValue* kv)
+{
+    if (kv == NULL || !kv->has_key) {
+        return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__INVALID_REQUEST;
+    }
+    const KineticStandinEntry* existing = KineticStandinMap_Find(standin->map, array(kv->key));
+    if (existing == NULL) {
+        return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__NOT_FOUND;
+    }
+    ByteArray expected = kv->has_dbversion ? array(kv->dbversion) : BYTE_ARRAY_NONE;
+    if (!(kv->has_force && kv->force) && !same_bytes(existing->version, expected)) {
+        return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__VERSION_MISMATCH;
+    }
+    KineticStandinMap_Delete(standin->map, array(kv->key));
+    return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__SUCCESS;
+}
+
+// GET, GETNEXT and GETPREVIOUS
+static StatusCode handle_get(KineticStandin* standin, MessageType type,
+    const Com__Seagate__Kinetic__Proto__Command__KeyValue* kv, response* r)
+{
+    if (kv == NULL || !kv->has_key) {
+        return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__INVALID_REQUEST;
+    }
+    const KineticStandinEntry* entry = NULL;
+    switch (type) {
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETNEXT:
+        entry = KineticStandinMap_Ceiling(standin->map, array(kv->key), false);
+        break;
+    case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETPREVIOUS:
+        entry = KineticStandinMap_Floor(standin->map, array(kv->key), false);
+        break;
+    default:
+        entry = KineticStandinMap_Find(standin->map, array(kv->key));
+        break;
+    }
+    if (entry == NULL) {
+        return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__NOT_FOUND;
+    }
+    respond_with_entry(r, entry, kv->has_metadataonly && kv->metadataonly);
+    return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__SUCCESS;
+}
+
+static bool in_range(ByteArray key, bool hasBound, ByteArray bound, bool inclusive, int direction)
+{
+    if (!hasBound) { return true; }
+    int c = KineticStandinMap_CompareKeys(key, bound) * direction;
+    return c < 0 || (inclusive && c == 0);
+}
+
+/* Collect the keys of a GETKEYRANGE into keys, which must have room for
+ * range->maxreturned of them. */
+static StatusCode handle_get_key_range(KineticStandin* standin,
+    const Com__Seagate__Kinetic__Proto__Command__Range* range, ProtobufCBinaryData* keys, response* r)
+{
+    bool reverse = range->has_reverse && range->reverse;
+    bool startInclusive = range->has_startkeyinclusive && range->startkeyinclusive;
+    bool endInclusive = range->has_endkeyinclusive && range->endkeyinclusive;
+    ByteArray start = array(range->startkey);
+    ByteArray end = array(range->endkey);
+
+    const KineticStandinEntry* entry = NULL;
+    if (reverse) {
+        entry = range->has_endkey
+            ? KineticStandinMap_Floor(standin->map, end, endInclusive)
+            : KineticStandinMap_Last(standin->map);
+    } else {
+        entry = range->has_startkey
+            ? KineticStandinMap_Ceiling(standin->map, start, startInclusive)
+            : KineticStandinMap_First(standin->map);
+    }
+
+    size_t count = 0;
+    while (entry != NULL && count < (size_t)range->maxreturned) {
+        if (reverse) {
+            if (!in_range(entry->key, range->has_startkey, start, startInclusive, -1)) { break; }
+        } else {
+            if (!in_range(entry->key, range->has_endkey, end, endInclusive, 1)) { break; }
+        }
+        keys[count++] = binary(entry->key);
+        entry = reverse ? KineticStandinMap_Previous(entry) : KineticStandinMap_Next(entry);
+    }
+
+    r->range.n_keys = count;
+    r->range.keys = keys;
+    r->body.range = &r->range;
+    r->command.body = &r->body;
+    return COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__SUCCESS;
+}
+
+static bool request_is_signed(KineticStandin* standin, const Com__Seagate__Kinetic__Proto__Message* msg)
+{
+    return msg->hmacauth != NULL
+        && msg->hmacauth->has_identity
+        && msg->hmacauth->identity == standin->config.identity
+        && KineticHMAC_Validate(msg, &standin->key);
+}
+
+/* Carry out one request and queue its response. The map lock is held
+ * until the response is packed, since it refers to the stored entries.
+ * Returns false if the request is not well formed. */
+static bool handle_request(connection* c, const uint8_t* proto, size_t protoLen, ByteArray value)
+{
+    KineticStandin* standin = c->standin;
+    Com__Seagate__Kinetic__Proto__Message* msg =
+        com__seagate__kinetic__proto__message__unpack(NULL, protoLen, proto);
+    if (msg == NULL || !msg->has_commandbytes) {
+        LOG(standin, 1, "Connection %lld sent a malformed message\n", (long long)c->connectionID);
+        if (msg != NULL) { com__seagate__kinetic__proto__message__free_unpacked(msg, NULL); }
+        return false;
+    }
+    Com__Seagate__Kinetic__Proto__Command* cmd = com__seagate__kinetic__proto__command__unpack(
+        NULL, msg->commandbytes.len, msg->commandbytes.data);
+    if (cmd == NULL || cmd->header == NULL) {
+        LOG(standin, 1, "Connection %lld sent a malformed command\n", (long long)c->connectionID);
+        if (cmd != NULL) { com__seagate__kinetic__proto__command__free_unpacked(cmd, NULL); }
+        com__seagate__kinetic__proto__message__free_unpacked(msg, NULL);
+        return false;
+    }
+
+    MessageType type = cmd->header->messagetype;
+    LOG(standin, 2, "Connection %lld: request type %d seq %lld\n",
+        (long long)c->connectionID, type, (long long)cmd->header->sequence);
+    const Com__Seagate__Kinetic__Proto__Command__KeyValue* kv =
+        (cmd->body != NULL) ? cmd->body->keyvalue : NULL;
+    const Com__Seagate__Kinetic__Proto__Command__Range* range =
+        (cmd->body != NULL) ? cmd->body->range : NULL;
+
+    const KineticStandinFaults* faults = &standin->config.faults;
+    c->requests++;
+    if (faults->closeAfter > 0 && c->requests > faults->closeAfter) {
+        LOG(standin, 1, "Connection %lld: terminating after %llu requests\n",
+            (long long)c->connectionID, (unsigned long long)faults->closeAfter);
+        c->closing = true;
+        com__seagate__kinetic__proto__command__free_unpacked(cmd, NULL);
+        com__seagate__kinetic__proto__message__free_unpacked(msg, NULL);
+        return append_unsolicited_status(c,
+            COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__CONNECTION_TERMINATED, false);
+    }
+
+    response r;
+    init_response(&r, cmd->header, c->connectionID);
+    ProtobufCBinaryData* keys = NULL;
+    pthread_rwlock_t* lock = NULL;
+
+    if (standin->config.verifyRequests && !request_is_signed(standin, msg)) {
+        r.status.code = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__HMAC_FAILURE;
+    } else if (chance(c, faults->busyRate)) {
+        r.status.code = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__SERVICE_BUSY;
+    } else {
+        switch (type) {
+        case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__NOOP:
+        case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__FLUSHALLDATA:
+            // Entries are never cached anywhere they would need flushing from
+            r.status.code = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__SUCCESS;
+            break;
+        case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PUT:
+            lock = &standin->mapLock;
+            pthread_rwlock_wrlock(lock);
+            r.status.code = handle_put(standin, kv, value);
+            break;
+        case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__DELETE:
+            lock = &standin->mapLock;
+            pthread_rwlock_wrlock(lock);
+            r.status.code = handle_delete(standin, kv);
+            break;
+        case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET:
+        case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETNEXT:
+        case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETPREVIOUS:
+            lock = &standin->mapLock;
+            pthread_rwlock_rdlock(lock);
+            r.status.code = handle_get(standin, type, kv, &r);
+            break;
+        case COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETKEYRANGE:
+            if (range == NULL || !range->has_maxreturned || range->maxreturned <= 0) {
+                r.status.code = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__INVALID_REQUEST;
+                break;
+            }
+            if (range->maxreturned > MAX_KEY_RANGE_COUNT) {
+                r.status.code = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__INVALID_REQUEST;
+                r.status.statusmessage = "maxReturned exceeds the maximum key range count";
+                break;
+            }
+            keys = malloc(range->maxreturned * sizeof(*keys));
+            if (keys == NULL) {
+                r.status.code = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__INTERNAL_ERROR;
+                break;
+            }
+            lock = &standin->mapLock;
+            pthread_rwlock_rdlock(lock);
+            r.status.code = handle_get_key_range(standin, range, keys, &r);
+            break;
+        default:
+            r.status.code = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__INVALID_REQUEST;
+            r.status.statusmessage = "Not supported by the stand-in server";
+            break;
+        }
+    }
+
+    size_t start = c->out.len;
+    bool ok = append_pdu(c, &r.command, COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__HMACAUTH, r.value);
+    if (lock != NULL) { pthread_rwlock_unlock(lock); }
+    if (ok && standin->injectFaults) {
+        ok = schedule_response(c, start);
+    }
+    free(keys);
+    com__seagate__kinetic__proto__command__free_unpacked(cmd, NULL);
+    com__seagate__kinetic__proto__message__free_unpacked(msg, NULL);
+    return ok;
+}
+
+/* Handle every complete PDU received so far, dropping them from the input.
+ * Returns false if the connection should be closed. */
+static bool handle_input(connection* c)
+{
+    size_t offset = 0;
+    size_t needed = 0;
+    bool ok = true;
+    while (ok && !c->closing && c->in.len - offset >= PDU_HEADER_LEN) {
+        const uint8_t* pdu = &c->in.data[offset];
+        uint32_t protoLen = get_be32(&pdu[1]);
+        uint32_t valueLen = get_be32(&pdu[5]);
+        if (pdu[0] != 'F' || protoLen > PDU_PROTO_MAX_LEN || valueLen > KINETIC_OBJ_SIZE) {
+            LOG(c->standin, 1, "Connection %lld sent a bad PDU header\n", (long long)c->connectionID);
+            return false;
+        }
+        size_t pduLen = PDU_HEADER_LEN + protoLen + valueLen;
+        if (c->in.len - offset < pduLen) {
+            needed = pduLen;
+            break;
+        }
+        ByteArray value = {.len = valueLen, .data = (uint8_t*)&pdu[PDU_HEADER_LEN + protoLen]};
+        ok = handle_request(c, &pdu[PDU_HEADER_LEN], protoLen, value);
+        offset += pduLen;
+    }
+
+    c->in.len -= offset;
+    if (c->in.len > 0) {
+        memmove(c->in.data, &c->in.data[offset], c->in.len);
+    }
+    // Make room for the rest of a partial PDU, and for more after it
+    return ok && reserve(&c->in, ((needed > c->in.len) ? needed : c->in.len) + READ_CHUNK);
+}
+
+static void* connection_main(void* arg)
+{
+    connection* c = arg;
+    KineticStandin* standin = c->standin;
+
+    bool ok = reserve(&c->in, READ_CHUNK)
+        && append_unsolicited_status(c, COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__SUCCESS, true)
+        && flush(c);
+    while (ok && !c->closing) {
+        // Wake for delayed responses as they come due
+        struct timespec wait;
+        struct timespec* timeout = next_due(c, &wait);
+        if (timeout != NULL) {
+            struct pollfd pfd = {.fd = c->fd, .events = POLLIN};
+            int ready = ppoll(&pfd, 1, timeout, NULL);
+            if (ready < 0 && errno != EINTR) { break; }
+            if (ready <= 0) {
+                ok = release_delayed(c) && flush(c);
+                continue;
+            }
+        }
+
+        ssize_t n = read(c->fd, &c->in.data[c->in.len], c->in.cap - c->in.len);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { break; }
+        c->in.len += n;
+        // Respond to everything pipelined so far with as few writes as possible
+        ok = handle_input(c) && (c->delayedCount == 0 || release_delayed(c)) && flush(c);
+    }
+
+    LOG(standin, 1, "Closing connection %lld\n", (long long)c->connectionID);
+    shutdown(c->fd, SHUT_RDWR);
+    (void)__sync_lock_test_and_set(&c->done, 1);
+    return NULL;
+}
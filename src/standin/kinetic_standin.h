@@ -0,0 +1,82 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_STANDIN_H
+#define _KINETIC_STANDIN_H
+
+#include "byte_array.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// A native stand-in for a Kinetic drive, for exercising and benchmarking the
+// client without the Java simulator. It speaks the real PDU framing and
+// protobuf messages, keeps entries in memory, and serves each connection on
+// its own thread.
+//
+// Supported: NOOP, PUT, GET, DELETE, GETNEXT, GETPREVIOUS, GETKEYRANGE (of up
+// to 200 keys) and FLUSHALLDATA. Every other request fails with INVALID_REQUEST.
+
+// How responses are delayed, from when their request is handled
+typedef enum {
+    KINETIC_STANDIN_DELAY_NONE = 0,
+    KINETIC_STANDIN_DELAY_FIXED,        // by delayMicros
+    KINETIC_STANDIN_DELAY_EXPONENTIAL,  // exponentially distributed, averaging delayMicros
+    KINETIC_STANDIN_DELAY_BIMODAL,      // by slowDelayMicros for slowFraction of them, else delayMicros
+} KineticStandinDelay;
+
+// Faults to inject, for exercising the client's timeout and failure handling.
+// Rates are probabilities per request. Delayed responses are sent as they
+// come due, so varying delays also reorder responses across sequence IDs.
+typedef struct _KineticStandinFaults {
+    KineticStandinDelay delay;
+    uint32_t delayMicros;
+    uint32_t slowDelayMicros;
+    double slowFraction;
+    double dropRate;        // Responses never sent
+    double reorderRate;     // Responses held back, once delayed, until after the next one
+    double busyRate;        // Requests refused with SERVICE_BUSY without being carried out
+    uint64_t closeAfter;    // Requests per connection before closing it with an
+                            //   unsolicited CONNECTION_TERMINATED status (0 for never)
+    uint64_t seed;          // Random seed, combined with each connection's number (0 for
+                            //   the first accepted), so a seed reproduces the same faults
+} KineticStandinFaults;
+
+typedef struct _KineticStandinConfig {
+    const char* host;       // Address to listen on (127.0.0.1 if NULL)
+    int port;               // Port to listen on, or 0 for any free port
+    int64_t identity;       // HMAC identity (1 if 0)
+    ByteArray hmacKey;      // HMAC key for the identity ("asdfasdf" if empty)
+    bool verifyRequests;    // Fail requests not signed with the key with HMAC_FAILURE
+    int verbosity;          // Print connections at 1, and every request at 2
+    KineticStandinFaults faults;    // Faults to inject (none if zeroed)
+} KineticStandinConfig;
+
+typedef struct _KineticStandin KineticStandin;
+
+// Start serving on a background thread. Returns NULL on failure.
+KineticStandin* KineticStandin_Start(const KineticStandinConfig* config);
+
+// The port being served, which is useful when config->port was 0
+int KineticStandin_Port(const KineticStandin* standin);
+
+// Disconnect all clients, stop serving and free the stored entries
+void KineticStandin_Stop(KineticStandin* standin);
+
+#endif // _KINETIC_STANDIN_H
@@ -0,0 +1,152 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_standin.h"
+#include "kinetic_types.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t Stopping = 0;
+
+static void handle_stop_signal(int sig)
+{
+    (void)sig;
+    Stopping = 1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: kinetic-c-standin [-h HOST] [-p PORT] [-i IDENTITY] [-k HMAC_KEY] [-V] [-v]\n"
+        "                         [-d DELAY] [-D RATE] [-R RATE] [-B RATE] [-C COUNT] [-S SEED]\n"
+        "    Serves an in-memory Kinetic drive on HOST:PORT (default 127.0.0.1:%d)\n"
+        "    until interrupted. Responses are signed with HMAC_KEY (default asdfasdf)\n"
+        "    for IDENTITY (default 1).\n"
+        "    -V  fail requests that are not signed with HMAC_KEY\n"
+        "    -v  print connections; repeat to print every request\n"
+        "  Fault injection:\n"
+        "    -d  delay responses: fixed:US, exp:MEAN_US or bimodal:US,SLOW_US,SLOW_FRACTION\n"
+        "    -D  fraction of responses to drop\n"
+        "    -R  fraction of responses to hold back until after the next one\n"
+        "    -B  fraction of requests to refuse with SERVICE_BUSY\n"
+        "    -C  terminate each connection with an unsolicited status after COUNT requests\n"
+        "    -S  random seed for the injected faults\n",
+        KINETIC_PORT);
+    exit(1);
+}
+
+static bool parse_delay(const char* spec, KineticStandinFaults* faults)
+{
+    unsigned long fast = 0, slow = 0;
+    double fraction = 0.0;
+    if (sscanf(spec, "fixed:%lu", &fast) == 1) {
+        faults->delay = KINETIC_STANDIN_DELAY_FIXED;
+    } else if (sscanf(spec, "exp:%lu", &fast) == 1) {
+        faults->delay = KINETIC_STANDIN_DELAY_EXPONENTIAL;
+    } else if (sscanf(spec, "bimodal:%lu,%lu,%lf", &fast, &slow, &fraction) == 3
+      && fraction >= 0.0 && fraction <= 1.0) {
+        faults->delay = KINETIC_STANDIN_DELAY_BIMODAL;
+    } else {
+        return false;
+    }
+    faults->delayMicros = (uint32_t)fast;
+    faults->slowDelayMicros = (uint32_t)slow;
+    faults->slowFraction = fraction;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    KineticStandinConfig config = {.port = KINETIC_PORT};
+    int opt = 0;
+    while ((opt = getopt(argc, argv, "h:p:i:k:Vvd:D:R:B:C:S:?")) != -1) {
+        switch (opt) {
+        case 'h':
+            config.host = optarg;
+            break;
+        case 'p':
+            config.port = atoi(optarg);
+            break;
+        case 'i':
+            config.identity = strtoll(optarg, NULL, 0);
+            break;
+        case 'k':
+            config.hmacKey = ByteArray_CreateWithCString(optarg);
+            break;
+        case 'V':
+            config.verifyRequests = true;
+            break;
+        case 'v':
+            config.verbosity++;
+            break;
+        case 'd':
+            if (!parse_delay(optarg, &config.faults)) { usage(); }
+            break;
+        case 'D':
+            config.faults.dropRate = atof(optarg);
+            break;
+        case 'R':
+            config.faults.reorderRate = atof(optarg);
+            break;
+        case 'B':
+            config.faults.busyRate = atof(optarg);
+            break;
+        case 'C':
+            config.faults.closeAfter = strtoull(optarg, NULL, 0);
+            break;
+        case 'S':
+            config.faults.seed = strtoull(optarg, NULL, 0);
+            break;
+        default:
+            usage();
+        }
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // Block the signals while starting, so the server threads inherit the
+    // mask and only sigsuspend below takes them
+    sigset_t stopSignals, waitMask;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &stopSignals, &waitMask);
+
+    KineticStandin* standin = KineticStandin_Start(&config);
+    if (standin == NULL) {
+        return 1;
+    }
+    printf("Serving on %s:%d\n", (config.host != NULL) ? config.host : "127.0.0.1",
+        KineticStandin_Port(standin));
+    fflush(stdout);
+
+    while (!Stopping) {
+        sigsuspend(&waitMask);
+    }
+    KineticStandin_Stop(standin);
+    return 0;
+}
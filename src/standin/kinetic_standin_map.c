@@ -0,0 +1,244 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_standin_map.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Each level links about a quarter of the entries of the level below, so 24
+// levels keep lookups logarithmic well past the 2^40 keys a drive could hold
+#define MAX_HEIGHT 24
+
+typedef struct node {
+    KineticStandinEntry entry;  // first, so entries handed out convert back
+    struct node* prev;          // NULL for the first entry
+    uint8_t height;
+    struct node* next[];
+} node;
+
+struct _KineticStandinMap {
+    node* head;         // sentinel before the first entry, at every level
+    uint8_t height;     // levels in use
+    size_t count;
+    uint64_t rng;
+};
+
+int KineticStandinMap_CompareKeys(ByteArray a, ByteArray b)
+{
+    size_t len = (a.len < b.len) ? a.len : b.len;
+    int c = (len > 0) ? memcmp(a.data, b.data, len) : 0;
+    if (c != 0) { return c; }
+    return (a.len > b.len) - (a.len < b.len);
+}
+
+static node* node_alloc(uint8_t height, size_t payload)
+{
+    node* n = calloc(1, sizeof(node) + height * sizeof(node*) + payload);
+    if (n != NULL) { n->height = height; }
+    return n;
+}
+
+KineticStandinMap* KineticStandinMap_Create(void)
+{
+    KineticStandinMap* map = calloc(1, sizeof(*map));
+    if (map == NULL) { return NULL; }
+    map->head = node_alloc(MAX_HEIGHT, 0);
+    if (map->head == NULL) {
+        free(map);
+        return NULL;
+    }
+    map->height = 1;
+    map->rng = 0x9E3779B97F4A7C15ull;
+    return map;
+}
+
+void KineticStandinMap_Destroy(KineticStandinMap* map)
+{
+    if (map == NULL) { return; }
+    node* n = map->head;
+    while (n != NULL) {
+        node* next = n->next[0];
+        free(n);
+        n = next;
+    }
+    free(map);
+}
+
+size_t KineticStandinMap_Count(const KineticStandinMap* map)
+{
+    return map->count;
+}
+
+static uint8_t random_height(KineticStandinMap* map)
+{
+    // xorshift64*
+    map->rng ^= map->rng >> 12;
+    map->rng ^= map->rng << 25;
+    map->rng ^= map->rng >> 27;
+    uint64_t r = map->rng * 0x2545F4914F6CDD1Dull;
+
+    uint8_t height = 1;
+    while (height < MAX_HEIGHT && (r & 3) == 0) {
+        height++;
+        r >>= 2;
+    }
+    return height;
+}
+
+/* Find the last node ordered before key (or at it, if inclusive), or the
+ * head if there is none. If update is not NULL, it receives that node's
+ * counterpart at every level, for linking at key. */
+static node* find_before(const KineticStandinMap* map, ByteArray key,
+    bool inclusive, node* update[MAX_HEIGHT])
+{
+    node* x = map->head;
+    for (int level = map->height - 1; level >= 0; level--) {
+        while (x->next[level] != NULL) {
+            int c = KineticStandinMap_CompareKeys(x->next[level]->entry.key, key);
+            if (c < 0 || (inclusive && c == 0)) {
+                x = x->next[level];
+            } else {
+                break;
+            }
+        }
+        if (update != NULL) { update[level] = x; }
+    }
+    return x;
+}
+
+static uint8_t* copy_array(ByteArray* dst, uint8_t* p, ByteArray src)
+{
+    dst->len = src.len;
+    dst->data = p;
+    if (src.len > 0) { memcpy(p, src.data, src.len); }
+    return p + src.len;
+}
+
+bool KineticStandinMap_Put(KineticStandinMap* map, const KineticStandinEntry* entry)
+{
+    node* update[MAX_HEIGHT];
+    for (int level = map->height; level < MAX_HEIGHT; level++) {
+        update[level] = map->head;
+    }
+    node* prev = find_before(map, entry->key, false, update);
+    node* existing = prev->next[0];
+    if (existing != NULL && KineticStandinMap_CompareKeys(existing->entry.key, entry->key) != 0) {
+        existing = NULL;
+    }
+
+    uint8_t height = random_height(map);
+    node* n = node_alloc(height, entry->key.len + entry->value.len
+        + entry->version.len + entry->tag.len);
+    if (n == NULL) { return false; }
+    uint8_t* p = (uint8_t*)&n->next[height];
+    p = copy_array(&n->entry.key, p, entry->key);
+    p = copy_array(&n->entry.value, p, entry->value);
+    p = copy_array(&n->entry.version, p, entry->version);
+    copy_array(&n->entry.tag, p, entry->tag);
+    n->entry.algorithm = entry->algorithm;
+
+    if (existing != NULL) {
+        for (int level = 0; level < existing->height; level++) {
+            update[level]->next[level] = existing->next[level];
+        }
+        free(existing);
+        map->count--;
+    }
+    for (int level = 0; level < height; level++) {
+        n->next[level] = update[level]->next[level];
+        update[level]->next[level] = n;
+    }
+    n->prev = (prev == map->head) ? NULL : prev;
+    if (n->next[0] != NULL) { n->next[0]->prev = n; }
+    if (height > map->height) { map->height = height; }
+    map->count++;
+    return true;
+}
+
+bool KineticStandinMap_Delete(KineticStandinMap* map, ByteArray key)
+{
+    node* update[MAX_HEIGHT];
+    node* n = find_before(map, key, false, update)->next[0];
+    if (n == NULL || KineticStandinMap_CompareKeys(n->entry.key, key) != 0) {
+        return false;
+    }
+    for (int level = 0; level < n->height; level++) {
+        update[level]->next[level] = n->next[level];
+    }
+    if (n->next[0] != NULL) { n->next[0]->prev = n->prev; }
+    free(n);
+    while (map->height > 1 && map->head->next[map->height - 1] == NULL) {
+        map->height--;
+    }
+    map->count--;
+    return true;
+}
+
+const KineticStandinEntry* KineticStandinMap_Find(const KineticStandinMap* map, ByteArray key)
+{
+    node* n = find_before(map, key, false, NULL)->next[0];
+    if (n == NULL || KineticStandinMap_CompareKeys(n->entry.key, key) != 0) {
+        return NULL;
+    }
+    return &n->entry;
+}
+
+const KineticStandinEntry* KineticStandinMap_First(const KineticStandinMap* map)
+{
+    node* n = map->head->next[0];
+    return (n == NULL) ? NULL : &n->entry;
+}
+
+const KineticStandinEntry* KineticStandinMap_Last(const KineticStandinMap* map)
+{
+    node* x = map->head;
+    for (int level = map->height - 1; level >= 0; level--) {
+        while (x->next[level] != NULL) {
+            x = x->next[level];
+        }
+    }
+    return (x == map->head) ? NULL : &x->entry;
+}
+
+const KineticStandinEntry* KineticStandinMap_Ceiling(const KineticStandinMap* map,
+    ByteArray key, bool inclusive)
+{
+    node* n = find_before(map, key, !inclusive, NULL)->next[0];
+    return (n == NULL) ? NULL : &n->entry;
+}
+
+const KineticStandinEntry* KineticStandinMap_Floor(const KineticStandinMap* map,
+    ByteArray key, bool inclusive)
+{
+    node* n = find_before(map, key, inclusive, NULL);
+    return (n == map->head) ? NULL : &n->entry;
+}
+
+const KineticStandinEntry* KineticStandinMap_Next(const KineticStandinEntry* entry)
+{
+    node* n = ((const node*)entry)->next[0];
+    return (n == NULL) ? NULL : &n->entry;
+}
+
+const KineticStandinEntry* KineticStandinMap_Previous(const KineticStandinEntry* entry)
+{
+    node* n = ((const node*)entry)->prev;
+    return (n == NULL) ? NULL : &n->entry;
+}
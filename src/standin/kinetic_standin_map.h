@@ -0,0 +1,76 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef _KINETIC_STANDIN_MAP_H
+#define _KINETIC_STANDIN_MAP_H
+
+#include "byte_array.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// In-memory ordered key/value map backing the stand-in server: a skip list
+// ordered by unsigned lexicographic key comparison, as on a Kinetic drive.
+// It is not synchronized; the server serializes writers against readers.
+
+typedef struct _KineticStandinEntry {
+    ByteArray key;
+    ByteArray value;
+    ByteArray version;
+    ByteArray tag;
+    int32_t algorithm;
+} KineticStandinEntry;
+
+typedef struct _KineticStandinMap KineticStandinMap;
+
+KineticStandinMap* KineticStandinMap_Create(void);
+void KineticStandinMap_Destroy(KineticStandinMap* map);
+size_t KineticStandinMap_Count(const KineticStandinMap* map);
+
+// Store a copy of entry, replacing any entry with the same key.
+// Returns false if out of memory, leaving the map unchanged.
+bool KineticStandinMap_Put(KineticStandinMap* map, const KineticStandinEntry* entry);
+
+// Remove the entry for key. Returns false if there was none.
+bool KineticStandinMap_Delete(KineticStandinMap* map, ByteArray key);
+
+// Lookups return entries owned by the map, valid until it is next modified.
+const KineticStandinEntry* KineticStandinMap_Find(const KineticStandinMap* map, ByteArray key);
+
+// The entries with the lowest and highest keys, or NULL if the map is empty
+const KineticStandinEntry* KineticStandinMap_First(const KineticStandinMap* map);
+const KineticStandinEntry* KineticStandinMap_Last(const KineticStandinMap* map);
+
+// The first entry after key (or at it, if inclusive), or NULL
+const KineticStandinEntry* KineticStandinMap_Ceiling(const KineticStandinMap* map,
+    ByteArray key, bool inclusive);
+
+// The last entry before key (or at it, if inclusive), or NULL
+const KineticStandinEntry* KineticStandinMap_Floor(const KineticStandinMap* map,
+    ByteArray key, bool inclusive);
+
+// Step from an entry returned by a lookup to its neighbors in key order
+const KineticStandinEntry* KineticStandinMap_Next(const KineticStandinEntry* entry);
+const KineticStandinEntry* KineticStandinMap_Previous(const KineticStandinEntry* entry);
+
+// Compare keys as a Kinetic drive orders them
+int KineticStandinMap_CompareKeys(ByteArray a, ByteArray b);
+
+#endif // _KINETIC_STANDIN_MAP_H
@@ -0,0 +1,921 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+// kinetic-c-bench: load generator for Kinetic devices, built on the public
+// client API. Runs sessions x threads x queue depth outstanding operations
+// with a configurable key distribution, value sizes and operation mix,
+// either closed-loop (as fast as completions allow) or open-loop at a fixed
+// rate, and reports throughput and latency percentiles as text and JSON.
+//
+// In open-loop mode latency is measured from when each operation was due to
+// start, not from when it was issued, so stalls are not hidden by the load
+// generator backing off (coordinated omission).
+
+#include "kinetic_client.h"
+#include "kinetic_types.h"
+#include "kinetic_standin.h"
+#include "bench_util.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#define MAX_VALUE_SIZES 16
+#define VERSION_BUF_LEN 64
+
+typedef enum {
+    OP_READ = 0,
+    OP_WRITE,
+    OP_DELETE,
+    OP_RANGE,
+    OP_COUNT
+} OpType;
+
+static const char* const OpNames[OP_COUNT] = {"read", "write", "delete", "range"};
+
+typedef enum {
+    KEYS_SEQUENTIAL = 0,
+    KEYS_UNIFORM,
+    KEYS_ZIPFIAN,
+} KeyDistribution;
+
+static const char* const KeyDistributionNames[] = {"sequential", "uniform", "zipfian"};
+
+typedef struct {
+    char host[256];
+    int port;
+    int64_t identity;
+    char hmacKey[64];
+    bool standin;               // serve from an in-process stand-in server
+    int logLevel;
+
+    int sessions;
+    int threads;                // per session
+    int depth;                  // outstanding operations per thread
+    double seconds;
+    double warmupSeconds;
+    uint64_t ops;               // if set, run this many operations instead of for a time
+    double rate;                // open-loop operations per second in total, or 0 for closed-loop
+
+    uint64_t keyCount;
+    size_t keySize;
+    KeyDistribution keyDistribution;
+    double zipfTheta;
+
+    const char* valueSpec;
+    size_t valueSizes[MAX_VALUE_SIZES];
+    size_t valueSizeCount;
+    bool valueSizeUniform;      // uniform between valueSizes[0] and [1]
+    size_t maxValueSize;
+
+    const char* mixSpec;
+    unsigned mix[OP_COUNT];
+    int rangeCount;             // keys requested per range operation
+    bool prefill;
+    const char* jsonPath;
+} BenchConfig;
+
+typedef struct {
+    uint64_t count;
+    uint64_t notFound;
+    uint64_t errors;
+    uint64_t bytes;
+    KineticLatencyHistogram latency;
+} OpResults;
+
+struct Worker;
+
+// One outstanding operation and its buffers
+typedef struct Slot {
+    struct Worker* worker;
+    OpType type;
+    KineticEntry entry;
+    KineticKeyRange range;
+    ByteBufferArray rangeKeys;
+    uint8_t* keyData;
+    uint8_t* endKeyData;
+    uint8_t* valueData;
+    uint8_t version[VERSION_BUF_LEN];
+    uint8_t tag[VERSION_BUF_LEN];
+    uint64_t intendedNs;        // when the operation was due to start
+    uint64_t doneNs;
+    KineticStatus status;
+    bool hasResult;             // completed, but not yet recorded
+    struct Slot* nextFree;
+} Slot;
+
+typedef struct Worker {
+    struct Bench* bench;
+    KineticSession* session;
+    pthread_t thread;
+    uint64_t rng;
+    uint64_t opsLimit;          // for this phase, or 0 for no limit
+
+    pthread_mutex_t mutex;      // guards the free list
+    pthread_cond_t slotFreed;
+    Slot* freeSlots;
+    int freeCount;
+    Slot* slots;
+
+    OpResults results[OP_COUNT];
+} Worker;
+
+typedef struct Bench {
+    BenchConfig cfg;
+    KineticClient* client;
+    KineticSession** sessions;
+    Worker* workers;
+    size_t workerCount;
+    KineticStandin* standin;
+
+    // Zipfian generator constants (Gray et al., "Quickly Generating
+    // Billion-Record Synthetic Databases")
+    double zipfZetaN;
+    double zipfAlpha;
+    double zipfEta;
+
+    // Current phase
+    unsigned mix[OP_COUNT];
+    unsigned mixTotal;
+    KeyDistribution keyDistribution;
+    bool record;
+    uint64_t sequence;          // next key for sequential access
+    uint64_t startNs;
+    uint64_t warmupEndNs;
+    uint64_t endNs;
+    double intervalNs;          // between operations per worker when open-loop
+} Bench;
+
+/*******************************************************************************
+ * Helpers
+*******************************************************************************/
+
+static void sleep_until(uint64_t ns)
+{
+    uint64_t now = BenchUtil_Now();
+    if (ns <= now) { return; }
+    uint64_t delta = ns - now;
+    struct timespec ts = {.tv_sec = delta / 1000000000ull, .tv_nsec = delta % 1000000000ull};
+    nanosleep(&ts, NULL);
+}
+
+static void merge_results(OpResults* dst, const OpResults* src)
+{
+    dst->count += src->count;
+    dst->notFound += src->notFound;
+    dst->errors += src->errors;
+    dst->bytes += src->bytes;
+    dst->latency.count += src->latency.count;
+    dst->latency.sumNanoseconds += src->latency.sumNanoseconds;
+    if (src->latency.maxNanoseconds > dst->latency.maxNanoseconds) {
+        dst->latency.maxNanoseconds = src->latency.maxNanoseconds;
+    }
+    for (size_t i = 0; i < KINETIC_LATENCY_BUCKETS; i++) {
+        dst->latency.buckets[i] += src->latency.buckets[i];
+    }
+}
+
+/*******************************************************************************
+ * Workload generation
+*******************************************************************************/
+
+static void init_zipfian(Bench* b)
+{
+    double theta = b->cfg.zipfTheta;
+    double n = (double)b->cfg.keyCount;
+    double zeta2 = 1.0 + pow(0.5, theta);
+    double zetaN = 0.0;
+    for (uint64_t i = 1; i <= b->cfg.keyCount; i++) {
+        zetaN += 1.0 / pow((double)i, theta);
+    }
+    b->zipfZetaN = zetaN;
+    b->zipfAlpha = 1.0 / (1.0 - theta);
+    b->zipfEta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetaN);
+}
+
+static uint64_t next_zipfian(Bench* b, uint64_t* rng)
+{
+    double u = BenchUtil_NextUnit(rng);
+    double uz = u * b->zipfZetaN;
+    uint64_t rank;
+    if (uz < 1.0) {
+        rank = 0;
+    } else if (uz < 1.0 + pow(0.5, b->cfg.zipfTheta)) {
+        rank = 1;
+    } else {
+        rank = (uint64_t)((double)b->cfg.keyCount * pow(b->zipfEta * u - b->zipfEta + 1.0, b->zipfAlpha));
+    }
+    if (rank >= b->cfg.keyCount) { rank = b->cfg.keyCount - 1; }
+
+    // Scatter the popular keys over the key space (FNV-1a of the rank)
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (int i = 0; i < 8; i++) {
+        hash = (hash ^ ((rank >> (i * 8)) & 0xff)) * 0x100000001b3ull;
+    }
+    return hash % b->cfg.keyCount;
+}
+
+static uint64_t next_key(Worker* w)
+{
+    Bench* b = w->bench;
+    switch (b->keyDistribution) {
+    case KEYS_SEQUENTIAL:
+        return __sync_fetch_and_add(&b->sequence, 1) % b->cfg.keyCount;
+    case KEYS_ZIPFIAN:
+        return next_zipfian(b, &w->rng);
+    case KEYS_UNIFORM:
+    default:
+        return BenchUtil_NextRandom(&w->rng) % b->cfg.keyCount;
+    }
+}
+
+// Keys are 'k' followed by the zero-padded key number
+static void format_key(const BenchConfig* cfg, uint8_t* out, uint64_t key)
+{
+    out[0] = 'k';
+    for (size_t i = cfg->keySize - 1; i > 0; i--) {
+        out[i] = (uint8_t)('0' + key % 10);
+        key /= 10;
+    }
+}
+
+static size_t next_value_size(Worker* w)
+{
+    const BenchConfig* cfg = &w->bench->cfg;
+    if (cfg->valueSizeUniform) {
+        size_t span = cfg->valueSizes[1] - cfg->valueSizes[0] + 1;
+        return cfg->valueSizes[0] + BenchUtil_NextRandom(&w->rng) % span;
+    }
+    return cfg->valueSizes[BenchUtil_NextRandom(&w->rng) % cfg->valueSizeCount];
+}
+
+static OpType next_op(Worker* w)
+{
+    Bench* b = w->bench;
+    unsigned pick = (unsigned)(BenchUtil_NextRandom(&w->rng) % b->mixTotal);
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (pick < b->mix[op]) { return (OpType)op; }
+        pick -= b->mix[op];
+    }
+    return OP_READ;
+}
+
+/*******************************************************************************
+ * Operations
+*******************************************************************************/
+
+static void release_slot(Slot* s)
+{
+    Worker* w = s->worker;
+    pthread_mutex_lock(&w->mutex);
+    s->nextFree = w->freeSlots;
+    w->freeSlots = s;
+    w->freeCount++;
+    pthread_cond_signal(&w->slotFreed);
+    pthread_mutex_unlock(&w->mutex);
+}
+
+static void operation_done(KineticCompletionData* data, void* clientData)
+{
+    Slot* s = clientData;
+    s->doneNs = BenchUtil_Now();
+    s->status = data->status;
+    s->hasResult = true;
+    release_slot(s);
+}
+
+static void record_result(Worker* w, Slot* s)
+{
+    Bench* b = w->bench;
+    s->hasResult = false;
+    if (!b->record || s->intendedNs < b->warmupEndNs) { return; }
+
+    OpResults* r = &w->results[s->type];
+    r->count++;
+    BenchUtil_RecordLatency(&r->latency, (s->doneNs > s->intendedNs) ? s->doneNs - s->intendedNs : 0);
+    if (s->status == KINETIC_STATUS_SUCCESS) {
+        if (s->type == OP_READ || s->type == OP_WRITE) {
+            r->bytes += s->entry.value.bytesUsed;
+        }
+    } else if (s->status == KINETIC_STATUS_NOT_FOUND) {
+        r->notFound++;
+    } else {
+        r->errors++;
+    }
+}
+
+// Wait for a free slot, recording the result of its last operation
+static Slot* acquire_slot(Worker* w)
+{
+    pthread_mutex_lock(&w->mutex);
+    while (w->freeSlots == NULL) {
+        pthread_cond_wait(&w->slotFreed, &w->mutex);
+    }
+    Slot* s = w->freeSlots;
+    w->freeSlots = s->nextFree;
+    w->freeCount--;
+    pthread_mutex_unlock(&w->mutex);
+
+    if (s->hasResult) { record_result(w, s); }
+    return s;
+}
+
+static void issue(Worker* w, Slot* s, uint64_t intendedNs)
+{
+    const BenchConfig* cfg = &w->bench->cfg;
+    s->type = next_op(w);
+    format_key(cfg, s->keyData, next_key(w));
+    s->entry = (KineticEntry) {
+        .key = ByteBuffer_Create(s->keyData, cfg->keySize, cfg->keySize),
+        .force = true,
+    };
+    s->intendedNs = intendedNs;
+
+    KineticCompletionClosure closure = {.callback = operation_done, .clientData = s};
+    KineticStatus status = KINETIC_STATUS_INVALID;
+    switch (s->type) {
+    case OP_READ:
+        s->entry.value = ByteBuffer_Create(s->valueData, cfg->maxValueSize, 0);
+        s->entry.dbVersion = ByteBuffer_Create(s->version, sizeof(s->version), 0);
+        s->entry.tag = ByteBuffer_Create(s->tag, sizeof(s->tag), 0);
+        status = KineticClient_Get(w->session, &s->entry, &closure);
+        break;
+    case OP_WRITE:
+        s->entry.value = ByteBuffer_Create(s->valueData, cfg->maxValueSize, next_value_size(w));
+        s->entry.synchronization = KINETIC_SYNCHRONIZATION_WRITEBACK;
+        status = KineticClient_Put(w->session, &s->entry, &closure);
+        break;
+    case OP_DELETE:
+        s->entry.synchronization = KINETIC_SYNCHRONIZATION_WRITEBACK;
+        status = KineticClient_Delete(w->session, &s->entry, &closure);
+        break;
+    case OP_RANGE:
+        s->range = (KineticKeyRange) {
+            .startKey = s->entry.key,
+            .endKey = ByteBuffer_Create(s->endKeyData, cfg->keySize, cfg->keySize),
+            .startKeyInclusive = true,
+            .endKeyInclusive = true,
+            .maxReturned = cfg->rangeCount,
+        };
+        for (size_t i = 0; i < s->rangeKeys.count; i++) {
+            ByteBuffer_Reset(&s->rangeKeys.buffers[i]);
+        }
+        s->rangeKeys.used = 0;
+        status = KineticClient_GetKeyRange(w->session, &s->range, &s->rangeKeys, &closure);
+        break;
+    default:
+        break;
+    }
+
+    // A request rejected outright never calls back
+    if (status != KINETIC_STATUS_SUCCESS) {
+        s->doneNs = BenchUtil_Now();
+        s->status = status;
+        s->hasResult = true;
+        release_slot(s);
+    }
+}
+
+static void* worker_main(void* arg)
+{
+    Worker* w = arg;
+    Bench* b = w->bench;
+    bool openLoop = (b->intervalNs > 0.0);
+
+    for (uint64_t i = 0; w->opsLimit == 0 || i < w->opsLimit; i++) {
+        uint64_t intendedNs = 0;
+        if (openLoop) {
+            intendedNs = b->startNs + (uint64_t)((double)i * b->intervalNs);
+            if (intendedNs >= b->endNs) { break; }
+            sleep_until(intendedNs);
+        }
+        Slot* s = acquire_slot(w);
+        if (!openLoop) {
+            intendedNs = BenchUtil_Now();
+            if (intendedNs >= b->endNs) {
+                release_slot(s);
+                break;
+            }
+        }
+        issue(w, s, intendedNs);
+    }
+
+    // Wait for everything outstanding
+    pthread_mutex_lock(&w->mutex);
+    while (w->freeCount < b->cfg.depth) {
+        pthread_cond_wait(&w->slotFreed, &w->mutex);
+    }
+    pthread_mutex_unlock(&w->mutex);
+    for (Slot* s = w->freeSlots; s != NULL; s = s->nextFree) {
+        if (s->hasResult) { record_result(w, s); }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ * Phases
+*******************************************************************************/
+
+static bool init_workers(Bench* b)
+{
+    const BenchConfig* cfg = &b->cfg;
+    b->workerCount = (size_t)cfg->sessions * cfg->threads;
+    b->workers = calloc(b->workerCount, sizeof(Worker));
+    if (b->workers == NULL) { return false; }
+
+    for (size_t i = 0; i < b->workerCount; i++) {
+        Worker* w = &b->workers[i];
+        w->bench = b;
+        w->session = b->sessions[i / cfg->threads];
+        w->rng = 0x9E3779B97F4A7C15ull * (i + 1);
+        pthread_mutex_init(&w->mutex, NULL);
+        pthread_cond_init(&w->slotFreed, NULL);
+        w->slots = calloc(cfg->depth, sizeof(Slot));
+        if (w->slots == NULL) { return false; }
+
+        for (int d = 0; d < cfg->depth; d++) {
+            Slot* s = &w->slots[d];
+            s->worker = w;
+            s->keyData = malloc(cfg->keySize);
+            s->endKeyData = malloc(cfg->keySize);
+            s->valueData = malloc(cfg->maxValueSize > 0 ? cfg->maxValueSize : 1);
+            s->rangeKeys.buffers = calloc(cfg->rangeCount, sizeof(ByteBuffer));
+            s->rangeKeys.count = cfg->rangeCount;
+            if (s->keyData == NULL || s->endKeyData == NULL || s->valueData == NULL ||
+              s->rangeKeys.buffers == NULL) {
+                return false;
+            }
+            for (int k = 0; k < cfg->rangeCount; k++) {
+                s->rangeKeys.buffers[k] = ByteBuffer_Malloc(cfg->keySize);
+            }
+            // The highest key, ending every range
+            s->endKeyData[0] = 'k';
+            memset(&s->endKeyData[1], '9', cfg->keySize - 1);
+            for (size_t v = 0; v < cfg->maxValueSize; v++) {
+                s->valueData[v] = (uint8_t)BenchUtil_NextRandom(&w->rng);
+            }
+            s->nextFree = w->freeSlots;
+            w->freeSlots = s;
+            w->freeCount++;
+        }
+    }
+    return true;
+}
+
+static void free_workers(Bench* b)
+{
+    for (size_t i = 0; b->workers != NULL && i < b->workerCount; i++) {
+        Worker* w = &b->workers[i];
+        for (int d = 0; w->slots != NULL && d < b->cfg.depth; d++) {
+            Slot* s = &w->slots[d];
+            for (size_t k = 0; s->rangeKeys.buffers != NULL && k < s->rangeKeys.count; k++) {
+                ByteBuffer_Free(s->rangeKeys.buffers[k]);
+            }
+            free(s->rangeKeys.buffers);
+            free(s->keyData);
+            free(s->endKeyData);
+            free(s->valueData);
+        }
+        free(w->slots);
+        pthread_mutex_destroy(&w->mutex);
+        pthread_cond_destroy(&w->slotFreed);
+    }
+    free(b->workers);
+}
+
+/* Run every worker through one phase. Returns the nanoseconds from the end
+ * of the warmup until all operations completed. */
+static uint64_t run_phase(Bench* b, const unsigned mix[OP_COUNT], KeyDistribution keys,
+    uint64_t ops, double seconds, double warmupSeconds, double rate, bool record)
+{
+    memcpy(b->mix, mix, sizeof(b->mix));
+    b->mixTotal = 0;
+    for (int op = 0; op < OP_COUNT; op++) { b->mixTotal += mix[op]; }
+    b->keyDistribution = keys;
+    b->record = record;
+    b->sequence = 0;
+    b->intervalNs = (rate > 0.0) ? 1e9 * (double)b->workerCount / rate : 0.0;
+
+    b->startNs = BenchUtil_Now();
+    b->warmupEndNs = b->startNs + (uint64_t)(warmupSeconds * 1e9);
+    b->endNs = (ops > 0) ? UINT64_MAX : b->warmupEndNs + (uint64_t)(seconds * 1e9);
+    for (size_t i = 0; i < b->workerCount; i++) {
+        Worker* w = &b->workers[i];
+        w->opsLimit = 0;
+        if (ops > 0) {
+            w->opsLimit = ops / b->workerCount + ((i < ops % b->workerCount) ? 1 : 0);
+            if (w->opsLimit == 0) { continue; }
+        }
+        pthread_create(&w->thread, NULL, worker_main, w);
+    }
+    for (size_t i = 0; i < b->workerCount; i++) {
+        if (ops == 0 || b->workers[i].opsLimit > 0) {
+            pthread_join(b->workers[i].thread, NULL);
+        }
+    }
+    uint64_t finishNs = BenchUtil_Now();
+    return (finishNs > b->warmupEndNs) ? finishNs - b->warmupEndNs : 1;
+}
+
+/*******************************************************************************
+ * Reporting
+*******************************************************************************/
+
+static double us(uint64_t ns)
+{
+    return (double)ns / 1000.0;
+}
+
+static void print_text(FILE* f, const Bench* b, const OpResults results[OP_COUNT + 1], double seconds)
+{
+    const BenchConfig* cfg = &b->cfg;
+    fprintf(f, "kinetic-c-bench: %d sessions x %d threads x depth %d against %s:%d\n",
+        cfg->sessions, cfg->threads, cfg->depth, cfg->host, cfg->port);
+    fprintf(f, "  keys: %llu x %zu bytes, %s; values: %s bytes; mix: %s\n",
+        (unsigned long long)cfg->keyCount, cfg->keySize,
+        KeyDistributionNames[cfg->keyDistribution], cfg->valueSpec, cfg->mixSpec);
+    if (cfg->rate > 0.0) {
+        fprintf(f, "  open loop at %.0f ops/s; measured %.2f s\n", cfg->rate, seconds);
+    } else {
+        fprintf(f, "  closed loop; measured %.2f s\n", seconds);
+    }
+    fprintf(f, "\n%-7s %10s %11s %9s %9s %9s %9s %9s %10s %9s %7s\n", "op", "ops", "ops/s", "MB/s",
+        "mean(us)", "p50(us)", "p99(us)", "p999(us)", "max(us)", "notfound", "errors");
+    for (int op = 0; op <= OP_COUNT; op++) {
+        const OpResults* r = &results[op];
+        if (r->count == 0 && op != OP_COUNT) { continue; }
+        const KineticLatencyHistogram* h = &r->latency;
+        fprintf(f, "%-7s %10llu %11.1f %9.2f %9.1f %9.1f %9.1f %9.1f %10.1f %9llu %7llu\n",
+            (op == OP_COUNT) ? "all" : OpNames[op],
+            (unsigned long long)r->count, r->count / seconds, r->bytes / seconds / 1e6,
+            (h->count > 0) ? us(h->sumNanoseconds) / h->count : 0.0,
+            us(KineticLatencyHistogram_Percentile(h, 50.0)),
+            us(KineticLatencyHistogram_Percentile(h, 99.0)),
+            us(KineticLatencyHistogram_Percentile(h, 99.9)),
+            us(h->maxNanoseconds),
+            (unsigned long long)r->notFound, (unsigned long long)r->errors);
+    }
+}
+
+static bool write_json(const Bench* b, const OpResults results[OP_COUNT + 1], double seconds)
+{
+    const BenchConfig* cfg = &b->cfg;
+    bool toStdout = (strcmp(cfg->jsonPath, "-") == 0);
+    FILE* f = toStdout ? stdout : fopen(cfg->jsonPath, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Failed opening '%s' for writing\n", cfg->jsonPath);
+        return false;
+    }
+    fprintf(f, "{\n  \"config\": {\"host\": \"%s\", \"port\": %d, \"sessions\": %d, \"threads\": %d, "
+        "\"depth\": %d, \"keys\": %llu, \"key_size\": %zu, \"key_distribution\": \"%s\", "
+        "\"value_sizes\": \"%s\", \"mix\": \"%s\", \"range_count\": %d, \"mode\": \"%s\", \"rate\": %.1f},\n",
+        cfg->host, cfg->port, cfg->sessions, cfg->threads, cfg->depth,
+        (unsigned long long)cfg->keyCount, cfg->keySize, KeyDistributionNames[cfg->keyDistribution],
+        cfg->valueSpec, cfg->mixSpec, cfg->rangeCount, (cfg->rate > 0.0) ? "open" : "closed", cfg->rate);
+    fprintf(f, "  \"seconds\": %.3f,\n  \"ops\": {", seconds);
+    bool first = true;
+    for (int op = 0; op <= OP_COUNT; op++) {
+        const OpResults* r = &results[op];
+        if (r->count == 0 && op != OP_COUNT) { continue; }
+        const KineticLatencyHistogram* h = &r->latency;
+        fprintf(f, "%s\n    \"%s\": {\"count\": %llu, \"ops_per_sec\": %.1f, \"bytes\": %llu, "
+            "\"mean_us\": %.1f, \"p50_us\": %.1f, \"p99_us\": %.1f, \"p999_us\": %.1f, \"max_us\": %.1f, "
+            "\"not_found\": %llu, \"errors\": %llu}",
+            first ? "" : ",", (op == OP_COUNT) ? "all" : OpNames[op],
+            (unsigned long long)r->count, r->count / seconds, (unsigned long long)r->bytes,
+            (h->count > 0) ? us(h->sumNanoseconds) / h->count : 0.0,
+            us(KineticLatencyHistogram_Percentile(h, 50.0)),
+            us(KineticLatencyHistogram_Percentile(h, 99.0)),
+            us(KineticLatencyHistogram_Percentile(h, 99.9)),
+            us(h->maxNanoseconds),
+            (unsigned long long)r->notFound, (unsigned long long)r->errors);
+        first = false;
+    }
+    fprintf(f, "\n  }\n}\n");
+    if (!toStdout) { fclose(f); }
+    return true;
+}
+
+/*******************************************************************************
+ * Configuration
+*******************************************************************************/
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: kinetic-c-bench [options]\n"
+        "  Target:\n"
+        "    --host <host>            device address (default 127.0.0.1)\n"
+        "    --port <port>            device port (default %d)\n"
+        "    --identity <id>          HMAC identity (default 1)\n"
+        "    --hmackey <key>          HMAC key (default asdfasdf)\n"
+        "    --standin                serve from an in-process stand-in server instead\n"
+        "    --loglevel <n>           client log level (default -1, none)\n"
+        "  Load:\n"
+        "    --sessions <n>           sessions (default 1)\n"
+        "    --threads <n>            threads per session (default 1)\n"
+        "    --depth <n>              outstanding operations per thread (default 1)\n"
+        "    --seconds <s>            measured run time (default 10)\n"
+        "    --warmup <s>             unmeasured time before it (default 0)\n"
+        "    --ops <n>                run n operations instead of for a time\n"
+        "    --rate <ops/s>           open loop at this total rate (default: closed loop)\n"
+        "  Workload:\n"
+        "    --keys <n>               key space (default 100000)\n"
+        "    --keysize <bytes>        key length (default 16)\n"
+        "    --distribution <d>       sequential, uniform or zipfian (default uniform)\n"
+        "    --theta <t>              zipfian skew (default 0.99)\n"
+        "    --valuesize <spec>       N, MIN-MAX (uniform) or N1,N2,... (default 4096)\n"
+        "    --mix <spec>             weights, e.g. read=70,write=20,delete=5,range=5\n"
+        "                             (default read=50,write=50)\n"
+        "    --rangecount <n>         keys per range operation (default 16)\n"
+        "    --prefill                write every key before the run\n"
+        "    --json <file>            also write results as JSON ('-' for stdout)\n",
+        KINETIC_PORT);
+    exit(1);
+}
+
+static bool parse_value_sizes(BenchConfig* cfg, const char* spec)
+{
+    cfg->valueSpec = spec;
+    cfg->valueSizeCount = 0;
+    cfg->valueSizeUniform = false;
+    const char* p = spec;
+    while (*p != '\0') {
+        char* end = NULL;
+        unsigned long long size = strtoull(p, &end, 10);
+        if (end == p || size > KINETIC_OBJ_SIZE || cfg->valueSizeCount == MAX_VALUE_SIZES) {
+            return false;
+        }
+        cfg->valueSizes[cfg->valueSizeCount++] = (size_t)size;
+        if (*end == '-' && cfg->valueSizeCount == 1) {
+            cfg->valueSizeUniform = true;
+        } else if (*end != ',' && *end != '\0') {
+            return false;
+        }
+        p = (*end == '\0') ? end : end + 1;
+    }
+    if (cfg->valueSizeCount == 0 || (cfg->valueSizeUniform &&
+      (cfg->valueSizeCount != 2 || cfg->valueSizes[1] < cfg->valueSizes[0]))) {
+        return false;
+    }
+    cfg->maxValueSize = 0;
+    for (size_t i = 0; i < cfg->valueSizeCount; i++) {
+        if (cfg->valueSizes[i] > cfg->maxValueSize) { cfg->maxValueSize = cfg->valueSizes[i]; }
+    }
+    return true;
+}
+
+static bool parse_mix(BenchConfig* cfg, const char* spec)
+{
+    cfg->mixSpec = spec;
+    memset(cfg->mix, 0, sizeof(cfg->mix));
+    unsigned total = 0;
+    const char* p = spec;
+    while (*p != '\0') {
+        const char* eq = strchr(p, '=');
+        if (eq == NULL) { return false; }
+        int op = 0;
+        while (op < OP_COUNT && (strlen(OpNames[op]) != (size_t)(eq - p) ||
+          strncmp(p, OpNames[op], eq - p) != 0)) {
+            op++;
+        }
+        char* end = NULL;
+        unsigned long weight = strtoul(eq + 1, &end, 10);
+        if (op == OP_COUNT || end == eq + 1 || (*end != ',' && *end != '\0')) { return false; }
+        cfg->mix[op] = (unsigned)weight;
+        total += (unsigned)weight;
+        p = (*end == '\0') ? end : end + 1;
+    }
+    return total > 0;
+}
+
+typedef enum {
+    OPT_HELP = '?',
+    OPT_HOST = 200,
+    OPT_PORT,
+    OPT_IDENTITY,
+    OPT_HMACKEY,
+    OPT_STANDIN,
+    OPT_LOGLEVEL,
+    OPT_SESSIONS,
+    OPT_THREADS,
+    OPT_DEPTH,
+    OPT_SECONDS,
+    OPT_WARMUP,
+    OPT_OPS,
+    OPT_RATE,
+    OPT_KEYS,
+    OPT_KEYSIZE,
+    OPT_DISTRIBUTION,
+    OPT_THETA,
+    OPT_VALUESIZE,
+    OPT_MIX,
+    OPT_RANGECOUNT,
+    OPT_PREFILL,
+    OPT_JSON,
+} OptionID;
+
+static void parse_args(int argc, char** argv, BenchConfig* cfg)
+{
+    struct option long_options[] = {
+        {"help",            no_argument,        0, OPT_HELP},
+        {"host",            required_argument,  0, OPT_HOST},
+        {"port",            required_argument,  0, OPT_PORT},
+        {"identity",        required_argument,  0, OPT_IDENTITY},
+        {"hmackey",         required_argument,  0, OPT_HMACKEY},
+        {"standin",         no_argument,        0, OPT_STANDIN},
+        {"loglevel",        required_argument,  0, OPT_LOGLEVEL},
+        {"sessions",        required_argument,  0, OPT_SESSIONS},
+        {"threads",         required_argument,  0, OPT_THREADS},
+        {"depth",           required_argument,  0, OPT_DEPTH},
+        {"seconds",         required_argument,  0, OPT_SECONDS},
+        {"warmup",          required_argument,  0, OPT_WARMUP},
+        {"ops",             required_argument,  0, OPT_OPS},
+        {"rate",            required_argument,  0, OPT_RATE},
+        {"keys",            required_argument,  0, OPT_KEYS},
+        {"keysize",         required_argument,  0, OPT_KEYSIZE},
+        {"distribution",    required_argument,  0, OPT_DISTRIBUTION},
+        {"theta",           required_argument,  0, OPT_THETA},
+        {"valuesize",       required_argument,  0, OPT_VALUESIZE},
+        {"mix",             required_argument,  0, OPT_MIX},
+        {"rangecount",      required_argument,  0, OPT_RANGECOUNT},
+        {"prefill",         no_argument,        0, OPT_PREFILL},
+        {"json",            required_argument,  0, OPT_JSON},
+        {0,                 0,                  0, 0},
+    };
+
+    int option, optionIndex = 0;
+    while ((option = getopt_long(argc, argv, "?", long_options, &optionIndex)) != -1) {
+        switch (option) {
+        case OPT_HOST: strncpy(cfg->host, optarg, sizeof(cfg->host) - 1); break;
+        case OPT_PORT: cfg->port = atoi(optarg); break;
+        case OPT_IDENTITY: cfg->identity = strtoll(optarg, NULL, 0); break;
+        case OPT_HMACKEY: strncpy(cfg->hmacKey, optarg, sizeof(cfg->hmacKey) - 1); break;
+        case OPT_STANDIN: cfg->standin = true; break;
+        case OPT_LOGLEVEL: cfg->logLevel = atoi(optarg); break;
+        case OPT_SESSIONS: cfg->sessions = atoi(optarg); break;
+        case OPT_THREADS: cfg->threads = atoi(optarg); break;
+        case OPT_DEPTH: cfg->depth = atoi(optarg); break;
+        case OPT_SECONDS: cfg->seconds = atof(optarg); break;
+        case OPT_WARMUP: cfg->warmupSeconds = atof(optarg); break;
+        case OPT_OPS: cfg->ops = strtoull(optarg, NULL, 0); break;
+        case OPT_RATE: cfg->rate = atof(optarg); break;
+        case OPT_KEYS: cfg->keyCount = strtoull(optarg, NULL, 0); break;
+        case OPT_KEYSIZE: cfg->keySize = (size_t)atoi(optarg); break;
+        case OPT_DISTRIBUTION: {
+            int d = 0;
+            while (d <= KEYS_ZIPFIAN && strcmp(optarg, KeyDistributionNames[d]) != 0) { d++; }
+            if (d > KEYS_ZIPFIAN) { usage(); }
+            cfg->keyDistribution = (KeyDistribution)d;
+            break;
+        }
+        case OPT_THETA: cfg->zipfTheta = atof(optarg); break;
+        case OPT_VALUESIZE:
+            if (!parse_value_sizes(cfg, optarg)) {
+                fprintf(stderr, "Bad value size '%s'\n", optarg);
+                usage();
+            }
+            break;
+        case OPT_MIX:
+            if (!parse_mix(cfg, optarg)) {
+                fprintf(stderr, "Bad mix '%s'\n", optarg);
+                usage();
+            }
+            break;
+        case OPT_RANGECOUNT: cfg->rangeCount = atoi(optarg); break;
+        case OPT_PREFILL: cfg->prefill = true; break;
+        case OPT_JSON: cfg->jsonPath = optarg; break;
+        default: usage();
+        }
+    }
+
+    // Room for the 'k' and every digit of the highest key number
+    size_t digits = 1;
+    for (uint64_t n = (cfg->keyCount > 0) ? cfg->keyCount - 1 : 0; n >= 10; n /= 10) { digits++; }
+    if (cfg->sessions < 1 || cfg->threads < 1 || cfg->depth < 1 || cfg->keyCount < 1 ||
+      cfg->keySize < digits + 1 || cfg->keySize > KINETIC_DEFAULT_KEY_LEN ||
+      cfg->rangeCount < 1 || cfg->zipfTheta <= 0.0 || cfg->zipfTheta >= 1.0 ||
+      (cfg->ops == 0 && cfg->seconds <= 0.0)) {
+        fprintf(stderr, "Invalid configuration (keys need at least %zu bytes)\n", digits + 1);
+        usage();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Bench bench;
+    memset(&bench, 0, sizeof(bench));
+    BenchConfig* cfg = &bench.cfg;
+    *cfg = (BenchConfig) {
+        .host = "127.0.0.1",
+        .port = KINETIC_PORT,
+        .identity = 1,
+        .hmacKey = "asdfasdf",
+        .logLevel = -1,
+        .sessions = 1,
+        .threads = 1,
+        .depth = 1,
+        .seconds = 10.0,
+        .keyCount = 100000,
+        .keySize = 16,
+        .keyDistribution = KEYS_UNIFORM,
+        .zipfTheta = 0.99,
+        .rangeCount = 16,
+    };
+    parse_value_sizes(cfg, "4096");
+    parse_mix(cfg, "read=50,write=50");
+    parse_args(argc, argv, cfg);
+
+    if (cfg->keyDistribution == KEYS_ZIPFIAN) { init_zipfian(&bench); }
+
+    if (cfg->standin) {
+        KineticStandinConfig standinConfig = {
+            .identity = cfg->identity,
+            .hmacKey = ByteArray_CreateWithCString(cfg->hmacKey),
+        };
+        bench.standin = KineticStandin_Start(&standinConfig);
+        if (bench.standin == NULL) { return 1; }
+        strncpy(cfg->host, "127.0.0.1", sizeof(cfg->host) - 1);
+        cfg->port = KineticStandin_Port(bench.standin);
+    }
+
+    KineticClientConfig clientConfig = {
+        .logFile = "stdout",
+        .logLevel = cfg->logLevel,
+    };
+    bench.client = KineticClient_Init(&clientConfig);
+    if (bench.client == NULL) { return 1; }
+
+    int rc = 1;
+    bench.sessions = calloc(cfg->sessions, sizeof(KineticSession*));
+    if (bench.sessions == NULL) { goto cleanup; }
+    for (int i = 0; i < cfg->sessions; i++) {
+        KineticSessionConfig sessionConfig = {
+            .port = cfg->port,
+            .identity = cfg->identity,
+            .hmacKey = ByteArray_CreateWithCString(cfg->hmacKey),
+        };
+        strncpy(sessionConfig.host, cfg->host, sizeof(sessionConfig.host) - 1);
+        KineticStatus status = KineticClient_CreateSession(&sessionConfig, bench.client, &bench.sessions[i]);
+        if (status != KINETIC_STATUS_SUCCESS) {
+            fprintf(stderr, "Failed connecting to %s:%d: %s\n",
+                cfg->host, cfg->port, Kinetic_GetStatusDescription(status));
+            goto cleanup;
+        }
+    }
+    if (!init_workers(&bench)) {
+        fprintf(stderr, "Failed allocating buffers\n");
+        goto cleanup;
+    }
+
+    if (cfg->prefill) {
+        const unsigned writeOnly[OP_COUNT] = {[OP_WRITE] = 1};
+        run_phase(&bench, writeOnly, KEYS_SEQUENTIAL, cfg->keyCount, 0.0, 0.0, 0.0, false);
+    }
+    uint64_t measuredNs = run_phase(&bench, cfg->mix, cfg->keyDistribution, cfg->ops,
+        cfg->seconds, cfg->warmupSeconds, cfg->rate, true);
+    double seconds = (double)measuredNs / 1e9;
+
+    OpResults results[OP_COUNT + 1];
+    memset(results, 0, sizeof(results));
+    for (size_t i = 0; i < bench.workerCount; i++) {
+        for (int op = 0; op < OP_COUNT; op++) {
+            merge_results(&results[op], &bench.workers[i].results[op]);
+            merge_results(&results[OP_COUNT], &bench.workers[i].results[op]);
+        }
+    }
+    // Keep stdout clean for JSON when it goes there
+    bool jsonToStdout = (cfg->jsonPath != NULL && strcmp(cfg->jsonPath, "-") == 0);
+    print_text(jsonToStdout ? stderr : stdout, &bench, results, seconds);
+    rc = (cfg->jsonPath == NULL || write_json(&bench, results, seconds)) ? 0 : 1;
+
+cleanup:
+    for (int i = 0; bench.sessions != NULL && i < cfg->sessions; i++) {
+        if (bench.sessions[i] != NULL) { KineticClient_DestroySession(bench.sessions[i]); }
+    }
+    free(bench.sessions);
+    free_workers(&bench);
+    KineticClient_Shutdown(bench.client);
+    KineticStandin_Stop(bench.standin);
+    return rc;
+}
@@ -24,6 +24,8 @@
 #include "kinetic_types_internal.h"
 #include "protobuf-c/protobuf-c.h"
 #include "byte_array.h"
+#include <stdio.h>
+#include <string.h>
 
 extern int KineticLogLevel;
 
@@ -74,6 +76,23 @@ void test_KineticLogger_Log_should_write_log_message_to_file(void)
     TEST_ASSERT_FILE_EXISTS(TEST_LOG_FILE);
 }
 
+void test_KineticLogger_Flush_should_write_pending_messages_to_the_log_file(void)
+{
+    const char* msg = "Some message which must reach the file";
+    KineticLogger_Init(TEST_LOG_FILE, 3);
+    KineticLogger_Log(0, msg);
+    KineticLogger_Flush();
+
+    char content[4096] = {0};
+    FILE* file = fopen(TEST_LOG_FILE, "r");
+    TEST_ASSERT_NOT_NULL(file);
+    size_t len = fread(content, 1, sizeof(content) - 1, file);
+    fclose(file);
+    content[len] = '\0';
+    TEST_ASSERT_NOT_NULL(strstr(content, msg));
+    TEST_ASSERT_EQUAL(0, KineticLogger_GetDroppedCount());
+}
+
 void test_LOG_LOCATION_should_log_location(void)
 {
     KineticLogger_Init(TEST_LOG_FILE, 2);
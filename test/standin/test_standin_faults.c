@@ -0,0 +1,220 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+#include "unity.h"
+#include "unity_helper.h"
+#include "kinetic_client.h"
+#include "kinetic_standin.h"
+#include "bench_util.h"
+#include <pthread.h>
+
+#define SEED 42
+#define OPERATIONS 32
+#define BUF_LEN 32
+#define MS (1000 * 1000ull)
+
+static KineticStandin* Standin;
+static KineticClient* Client;
+static KineticSession* Session;
+
+static void start_standin(const KineticStandinFaults* faults, uint16_t timeoutSeconds)
+{
+    KineticStandinConfig config = {.faults = *faults};
+    Standin = KineticStandin_Start(&config);
+    TEST_ASSERT_NOT_NULL(Standin);
+    KineticClientConfig clientConfig = {.logFile = "stdout", .logLevel = 0};
+    Client = KineticClient_Init(&clientConfig);
+    TEST_ASSERT_NOT_NULL(Client);
+    KineticSessionConfig sessionConfig = {
+        .host = "127.0.0.1",
+        .port = KineticStandin_Port(Standin),
+        .identity = 1,
+        .hmacKey = ByteArray_CreateWithCString("asdfasdf"),
+        .timeoutSeconds = timeoutSeconds,
+    };
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS,
+        KineticClient_CreateSession(&sessionConfig, Client, &Session));
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+    if (Session != NULL) { KineticClient_DestroySession(Session); }
+    if (Client != NULL) { KineticClient_Shutdown(Client); }
+    if (Standin != NULL) { KineticStandin_Stop(Standin); }
+    Session = NULL;
+    Client = NULL;
+    Standin = NULL;
+}
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t done;
+    int completed;
+    uint64_t startNs[OPERATIONS];
+    uint64_t latencyNs[OPERATIONS];
+    KineticStatus status[OPERATIONS];
+} Pipeline;
+
+typedef struct {
+    Pipeline* pipeline;
+    int index;
+    uint8_t keyBuf[BUF_LEN];
+    uint8_t valueBuf[BUF_LEN];
+    KineticEntry entry;
+} PipelineOp;
+
+static void operation_done(KineticCompletionData* data, void* clientData)
+{
+    PipelineOp* op = clientData;
+    Pipeline* p = op->pipeline;
+    pthread_mutex_lock(&p->mutex);
+    p->latencyNs[op->index] = BenchUtil_Now() - p->startNs[op->index];
+    p->status[op->index] = data->status;
+    p->completed++;
+    pthread_cond_signal(&p->done);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+/* Send OPERATIONS PUTs without waiting, so the stand-in handles them
+ * together, in order, and wait for them all to complete. */
+static void run_pipeline(Pipeline* p)
+{
+    PipelineOp ops[OPERATIONS];
+    memset(p, 0, sizeof(*p));
+    pthread_mutex_init(&p->mutex, NULL);
+    pthread_cond_init(&p->done, NULL);
+    for (int i = 0; i < OPERATIONS; i++) {
+        PipelineOp* op = &ops[i];
+        op->pipeline = p;
+        op->index = i;
+        op->entry = (KineticEntry) {
+            .key = ByteBuffer_CreateAndAppendFormattedCString(op->keyBuf, sizeof(op->keyBuf), "key_%d", i),
+            .value = ByteBuffer_CreateAndAppendFormattedCString(op->valueBuf, sizeof(op->valueBuf), "value_%d", i),
+            .algorithm = KINETIC_ALGORITHM_SHA1,
+            .force = true,
+            .synchronization = KINETIC_SYNCHRONIZATION_WRITETHROUGH,
+        };
+        KineticCompletionClosure closure = {.callback = operation_done, .clientData = op};
+        p->startNs[i] = BenchUtil_Now();
+        TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, KineticClient_Put(Session, &op->entry, &closure));
+    }
+    pthread_mutex_lock(&p->mutex);
+    while (p->completed < OPERATIONS) {
+        pthread_cond_wait(&p->done, &p->mutex);
+    }
+    pthread_mutex_unlock(&p->mutex);
+    pthread_cond_destroy(&p->done);
+    pthread_mutex_destroy(&p->mutex);
+}
+
+void test_delayed_and_reordered_responses_should_go_out_after_their_delay(void)
+{
+    KineticStandinFaults faults = {
+        .delay = KINETIC_STANDIN_DELAY_FIXED,
+        .delayMicros = 20 * 1000,
+        .reorderRate = 0.5,
+        .seed = SEED,
+    };
+    start_standin(&faults, 5);
+    Pipeline p;
+    run_pipeline(&p);
+
+    for (int i = 0; i < OPERATIONS; i++) {
+        TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, p.status[i]);
+        TEST_ASSERT_TRUE(p.latencyNs[i] >= 20 * MS);
+    }
+}
+
+void test_held_responses_should_keep_their_delay_when_overtaken(void)
+{
+    KineticStandinFaults faults = {
+        .delay = KINETIC_STANDIN_DELAY_BIMODAL,
+        .delayMicros = 0,
+        .slowDelayMicros = 300 * 1000,
+        .slowFraction = 0.5,
+        .reorderRate = 0.5,
+        .seed = SEED,
+    };
+    start_standin(&faults, 5);
+    Pipeline p;
+    run_pipeline(&p);
+
+    // Replay the stand-in's draws for the first connection: whether each
+    // response is slow, then whether it is held
+    uint64_t rng = (uint64_t)SEED * 0x9E3779B97F4A7C15ull;
+    bool slowHeldOvertaken = false, slowHeldPending = false;
+    for (int i = 0; i < OPERATIONS; i++) {
+        bool slow = BenchUtil_NextUnit(&rng) < faults.slowFraction;
+        bool held = BenchUtil_NextUnit(&rng) < faults.reorderRate;
+        if (slow && held) {
+            slowHeldPending = true;
+        } else if (!slow && !held && slowHeldPending) {
+            slowHeldOvertaken = true;
+        }
+
+        TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, p.status[i]);
+        if (slow) {
+            TEST_ASSERT_TRUE(p.latencyNs[i] >= 300 * MS);
+        } else {
+            // Held fast responses wait at most 100ms for one to overtake them
+            TEST_ASSERT_TRUE(p.latencyNs[i] < 300 * MS);
+        }
+    }
+    // The seed must give a slow held response that a fast one overtakes
+    TEST_ASSERT_TRUE(slowHeldOvertaken);
+}
+
+void test_busy_requests_should_fail_with_DEVICE_BUSY(void)
+{
+    KineticStandinFaults faults = {.busyRate = 1.0, .seed = SEED};
+    start_standin(&faults, 5);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_DEVICE_BUSY, KineticClient_NoOp(Session));
+}
+
+void test_dropped_responses_should_time_out(void)
+{
+    KineticStandinFaults faults = {.dropRate = 1.0, .seed = SEED};
+    start_standin(&faults, 1);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_OPERATION_TIMEDOUT, KineticClient_NoOp(Session));
+}
+
+void test_closeAfter_should_terminate_the_connection_with_an_unsolicited_status(void)
+{
+    KineticStandinFaults faults = {.closeAfter = 3, .seed = SEED};
+    start_standin(&faults, 5);
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, KineticClient_NoOp(Session));
+    }
+    TEST_ASSERT_TRUE(KineticClient_NoOp(Session) != KINETIC_STATUS_SUCCESS);
+
+    // The status is handled on a worker thread, which may still be running
+    for (int i = 0; i < 100 && KineticClient_GetTerminationStatus(Session) == KINETIC_STATUS_SUCCESS; i++) {
+        struct timespec pause = {.tv_sec = 0, .tv_nsec = 10 * MS};
+        nanosleep(&pause, NULL);
+    }
+    TEST_ASSERT_TRUE(KineticClient_GetTerminationStatus(Session) != KINETIC_STATUS_SUCCESS);
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SESSION_TERMINATED, KineticClient_NoOp(Session));
+}
@@ -0,0 +1,257 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+#include "unity.h"
+#include "unity_helper.h"
+#include "kinetic_client.h"
+#include "kinetic_standin.h"
+
+#define HMAC_KEY "asdfasdf"
+#define BUF_LEN 32
+
+static KineticStandin* Standin;
+static KineticClient* Client;
+static KineticSession* Session;
+
+static KineticSession* connect_session(const char* hmacKey)
+{
+    KineticSessionConfig config = {
+        .host = "127.0.0.1",
+        .port = KineticStandin_Port(Standin),
+        .identity = 1,
+        .hmacKey = ByteArray_CreateWithCString(hmacKey),
+        .timeoutSeconds = 5,
+    };
+    KineticSession* session = NULL;
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS,
+        KineticClient_CreateSession(&config, Client, &session));
+    return session;
+}
+
+static void start_standin(const KineticStandinConfig* config)
+{
+    Standin = KineticStandin_Start(config);
+    TEST_ASSERT_NOT_NULL(Standin);
+    KineticClientConfig clientConfig = {.logFile = "stdout", .logLevel = 0};
+    Client = KineticClient_Init(&clientConfig);
+    TEST_ASSERT_NOT_NULL(Client);
+    Session = connect_session(HMAC_KEY);
+}
+
+void setUp(void)
+{
+    KineticStandinConfig config = {.port = 0};
+    start_standin(&config);
+}
+
+void tearDown(void)
+{
+    if (Session != NULL) { KineticClient_DestroySession(Session); }
+    if (Client != NULL) { KineticClient_Shutdown(Client); }
+    if (Standin != NULL) { KineticStandin_Stop(Standin); }
+    Session = NULL;
+    Client = NULL;
+    Standin = NULL;
+}
+
+static KineticStatus put(const char* key, const char* dbVersion, const char* newVersion, bool force)
+{
+    uint8_t keyBuf[BUF_LEN], valueBuf[BUF_LEN], dbVersionBuf[BUF_LEN], newVersionBuf[BUF_LEN];
+    KineticEntry entry = {
+        .key = ByteBuffer_CreateAndAppendCString(keyBuf, sizeof(keyBuf), key),
+        .value = ByteBuffer_CreateAndAppendFormattedCString(valueBuf, sizeof(valueBuf), "value_%s", key),
+        .dbVersion = (dbVersion != NULL)
+            ? ByteBuffer_CreateAndAppendCString(dbVersionBuf, sizeof(dbVersionBuf), dbVersion)
+            : BYTE_BUFFER_NONE,
+        .newVersion = (newVersion != NULL)
+            ? ByteBuffer_CreateAndAppendCString(newVersionBuf, sizeof(newVersionBuf), newVersion)
+            : BYTE_BUFFER_NONE,
+        .algorithm = KINETIC_ALGORITHM_SHA1,
+        .force = force,
+        .synchronization = KINETIC_SYNCHRONIZATION_WRITETHROUGH,
+    };
+    return KineticClient_Put(Session, &entry, NULL);
+}
+
+static void put_keys(int count)
+{
+    char key[BUF_LEN];
+    for (int i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, put(key, NULL, NULL, true));
+    }
+}
+
+void test_Put_should_require_the_stored_version_unless_forced(void)
+{
+    uint8_t keyBuf[BUF_LEN], valueBuf[BUF_LEN], versionBuf[BUF_LEN];
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, put("key", NULL, "v1", false));
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_VERSION_MISMATCH, put("key", NULL, "v2", false));
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_VERSION_MISMATCH, put("key", "v0", "v2", false));
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, put("key", "v1", "v2", false));
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, put("key", "v0", "v3", true));
+
+    KineticEntry entry = {
+        .key = ByteBuffer_CreateAndAppendCString(keyBuf, sizeof(keyBuf), "key"),
+        .value = ByteBuffer_Create(valueBuf, sizeof(valueBuf), 0),
+        .dbVersion = ByteBuffer_Create(versionBuf, sizeof(versionBuf), 0),
+    };
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, KineticClient_Get(Session, &entry, NULL));
+    TEST_ASSERT_EQUAL_SIZET(2, entry.dbVersion.bytesUsed);
+    TEST_ASSERT_EQUAL_MEMORY("v3", versionBuf, 2);
+}
+
+static KineticStatus get_adjacent(bool next, const char* key, char* found)
+{
+    uint8_t keyBuf[BUF_LEN], valueBuf[BUF_LEN];
+    KineticEntry entry = {
+        .key = ByteBuffer_CreateAndAppendCString(keyBuf, sizeof(keyBuf), key),
+        .value = ByteBuffer_Create(valueBuf, sizeof(valueBuf), 0),
+    };
+    KineticStatus status = next
+        ? KineticClient_GetNext(Session, &entry, NULL)
+        : KineticClient_GetPrevious(Session, &entry, NULL);
+    found[0] = '\0';
+    if (status == KINETIC_STATUS_SUCCESS) {
+        memcpy(found, keyBuf, entry.key.bytesUsed);
+        found[entry.key.bytesUsed] = '\0';
+    }
+    return status;
+}
+
+void test_GetNext_and_GetPrevious_should_fail_with_NOT_FOUND_past_the_ends_of_the_key_space(void)
+{
+    char found[BUF_LEN];
+    put_keys(3);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, get_adjacent(true, "key", found));
+    TEST_ASSERT_EQUAL_STRING("key_0", found);
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, get_adjacent(true, "key_1", found));
+    TEST_ASSERT_EQUAL_STRING("key_2", found);
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_NOT_FOUND, get_adjacent(true, "key_2", found));
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, get_adjacent(false, "key_9", found));
+    TEST_ASSERT_EQUAL_STRING("key_2", found);
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, get_adjacent(false, "key_1", found));
+    TEST_ASSERT_EQUAL_STRING("key_0", found);
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_NOT_FOUND, get_adjacent(false, "key_0", found));
+}
+
+#define RANGE_KEYS 5
+
+static KineticStatus get_range(const char* start, bool startInclusive, const char* end,
+    bool endInclusive, int32_t maxReturned, bool reverse, ByteBufferArray* keys)
+{
+    static uint8_t keysData[RANGE_KEYS][BUF_LEN];
+    static ByteBuffer buffers[RANGE_KEYS];
+    uint8_t startBuf[BUF_LEN], endBuf[BUF_LEN];
+    for (int i = 0; i < RANGE_KEYS; i++) {
+        buffers[i] = ByteBuffer_Create(keysData[i], BUF_LEN, 0);
+    }
+    *keys = (ByteBufferArray) {.buffers = buffers, .count = RANGE_KEYS};
+    KineticKeyRange range = {
+        .startKey = ByteBuffer_CreateAndAppendCString(startBuf, sizeof(startBuf), start),
+        .endKey = ByteBuffer_CreateAndAppendCString(endBuf, sizeof(endBuf), end),
+        .startKeyInclusive = startInclusive,
+        .endKeyInclusive = endInclusive,
+        .maxReturned = maxReturned,
+        .reverse = reverse,
+    };
+    return KineticClient_GetKeyRange(Session, &range, keys, NULL);
+}
+
+static void assert_keys(const ByteBufferArray* keys, size_t count, const char* const expected[])
+{
+    TEST_ASSERT_EQUAL_SIZET(count, keys->used);
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_SIZET(strlen(expected[i]), keys->buffers[i].bytesUsed);
+        TEST_ASSERT_EQUAL_MEMORY(expected[i], keys->buffers[i].array.data, strlen(expected[i]));
+    }
+}
+
+void test_GetKeyRange_should_honor_inclusive_and_exclusive_bounds(void)
+{
+    ByteBufferArray keys;
+    put_keys(5);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS,
+        get_range("key_1", true, "key_3", true, RANGE_KEYS, false, &keys));
+    assert_keys(&keys, 3, (const char* const[]){"key_1", "key_2", "key_3"});
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS,
+        get_range("key_1", false, "key_3", false, RANGE_KEYS, false, &keys));
+    assert_keys(&keys, 1, (const char* const[]){"key_2"});
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS,
+        get_range("key_1", false, "key_3", true, RANGE_KEYS, true, &keys));
+    assert_keys(&keys, 2, (const char* const[]){"key_3", "key_2"});
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS,
+        get_range("key_5", true, "key_9", true, RANGE_KEYS, false, &keys));
+    assert_keys(&keys, 0, NULL);
+}
+
+void test_GetKeyRange_should_return_at_most_maxReturned_keys(void)
+{
+    ByteBufferArray keys;
+    put_keys(5);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS,
+        get_range("key_0", true, "key_4", true, 2, false, &keys));
+    assert_keys(&keys, 2, (const char* const[]){"key_0", "key_1"});
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS,
+        get_range("key_0", true, "key_4", true, 2, true, &keys));
+    assert_keys(&keys, 2, (const char* const[]){"key_4", "key_3"});
+}
+
+void test_GetKeyRange_should_reject_maxReturned_over_the_key_range_limit(void)
+{
+    ByteBufferArray keys;
+    put_keys(5);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_INVALID_REQUEST,
+        get_range("key_0", true, "key_4", true, 201, false, &keys));
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_INVALID_REQUEST,
+        get_range("key_0", true, "key_4", true, INT32_MAX, false, &keys));
+}
+
+void test_CreateSession_should_take_the_connection_ID_from_the_unsolicited_status(void)
+{
+    KineticSession* second = connect_session(HMAC_KEY);
+
+    // The stand-in numbers connections consecutively
+    TEST_ASSERT_EQUAL_INT64(Session->connectionID + 1, second->connectionID);
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, KineticClient_NoOp(second));
+    KineticClient_DestroySession(second);
+}
+
+void test_requests_should_fail_with_HMAC_FAILURE_when_not_signed_with_the_key(void)
+{
+    tearDown();
+    KineticStandinConfig config = {.verifyRequests = true};
+    start_standin(&config);
+    KineticSession* badKey = connect_session("not the key");
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, KineticClient_NoOp(Session));
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_HMAC_FAILURE, KineticClient_NoOp(badKey));
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, put("key", NULL, NULL, true));
+    KineticClient_DestroySession(badKey);
+}
@@ -23,6 +23,7 @@
 #include "atomic.h"
 
 #include <pthread.h>
+#include <string.h>
 
 #include "mock_bus_poll.h"
 #include "mock_syscall.h"
@@ -346,6 +347,36 @@ void test_Bus_RegisterSocket_should_successfully_add_plain_socket(void)
     TEST_ASSERT_EQUAL(35, test_ci->fd);
 }
 
+void test_Bus_RegisterSocket_should_create_completion_queue_if_serial(void)
+{
+    struct listener fake_listener;
+    struct listener *listeners[] = {
+        &fake_listener,
+    };
+    struct threadpool fake_threadpool;
+    struct threadpool_serial fake_serial;
+    struct bus b = {
+        .listener_count = 1,
+        .listeners = listeners,
+        .threadpool = &fake_threadpool,
+        .serial_completions = true,
+    };
+    TEST_ASSERT_EQUAL(0, pthread_mutex_init(&b.fd_set_lock, NULL));
+    fake_listener.bus = &b;
+    test_ci = calloc(1, sizeof(*test_ci));
+
+    Threadpool_SerialInit_ExpectAndReturn(&fake_threadpool, &fake_serial);
+    struct yacht fake_yacht = { .size = 0, };
+    b.fd_set = &fake_yacht;
+    Yacht_Set_ExpectAndReturn(b.fd_set, 35, test_ci, &old_value, true);
+    Listener_AddSocket_ExpectAndReturn(&fake_listener, test_ci, &completion_pipe, true);
+    completion_pipe = 123;
+    BusPoll_OnCompletion_ExpectAndReturn(&b, 123, true);
+
+    TEST_ASSERT_TRUE(Bus_RegisterSocket(&b, BUS_SOCKET_PLAIN, 35, NULL));
+    TEST_ASSERT_EQUAL_PTR(&fake_serial, test_ci->serial);
+}
+
 void test_Bus_RegisterSocket_should_successfully_add_SSL_socket(void)
 {
     struct listener fake_listener;
@@ -505,6 +536,39 @@ void test_Bus_ReleaseSocket_should_return_true_on_successful_socket_disconnectio
     TEST_ASSERT_TRUE(Bus_ReleaseSocket(&b, fd, &old_udata));
 }
 
+void test_Bus_ReleaseSocket_should_release_completion_queue(void)
+{
+    struct listener fake_listener;
+    struct listener *listeners[] = {
+        &fake_listener,
+    };
+    struct threadpool_serial fake_serial;
+    struct bus b = {
+        .listener_count = 1,
+        .listeners = listeners,
+    };
+    TEST_ASSERT_EQUAL(0, pthread_mutex_init(&b.fd_set_lock, NULL));
+    fake_listener.bus = &b;
+
+    int fd = 3;
+    completion_pipe = 155;
+    Listener_RemoveSocket_ExpectAndReturn(&fake_listener, fd, &completion_pipe, true);
+    BusPoll_OnCompletion_ExpectAndReturn(&b, completion_pipe, true);
+
+    test_ci = calloc(1, sizeof(connection_info));
+    old_value = test_ci;
+    test_ci->ssl = BUS_NO_SSL;
+    test_ci->serial = &fake_serial;
+
+    struct yacht fake_yacht = { .size = 0, };
+    b.fd_set = &fake_yacht;
+    Yacht_Remove_ExpectAndReturn(b.fd_set, fd, &old_value, true);
+    Threadpool_SerialRelease_Expect(&fake_serial);
+
+    void *old_udata = NULL;
+    TEST_ASSERT_TRUE(Bus_ReleaseSocket(&b, fd, &old_udata));
+}
+
 void test_Bus_ReleaseSocket_should_return_true_on_successful_SSL_socket_disconnection(void)
 {
     struct listener fake_listener;
@@ -747,3 +811,88 @@ void test_Bus_Free_should_free_bus(void)
     BusSSL_CtxFree_Expect(b);
     Bus_Free(b);
 }
+
+void test_Bus_ProcessBoxedMessage_should_schedule_on_threadpool(void)
+{
+    struct threadpool fake_threadpool;
+    struct bus b = {
+        .threadpool = &fake_threadpool,
+    };
+    boxed_msg *box = calloc(1, sizeof(*box));
+    box->result.status = BUS_SEND_SUCCESS;
+
+    Threadpool_Schedule_IgnoreAndReturn(true);
+    size_t backpressure = 0;
+    TEST_ASSERT_TRUE(Bus_ProcessBoxedMessage(&b, box, &backpressure));
+    free(box);
+}
+
+void test_Bus_ProcessBoxedMessage_should_schedule_on_socket_completion_queue(void)
+{
+    struct threadpool fake_threadpool;
+    struct threadpool_serial fake_serial;
+    struct bus b = {
+        .threadpool = &fake_threadpool,
+        .serial_completions = true,
+    };
+    boxed_msg *box = calloc(1, sizeof(*box));
+    box->result.status = BUS_SEND_SUCCESS;
+    box->serial = &fake_serial;
+
+    Threadpool_ScheduleSerial_IgnoreAndReturn(true);
+    size_t backpressure = 0;
+    TEST_ASSERT_TRUE(Bus_ProcessBoxedMessage(&b, box, &backpressure));
+    free(box);
+}
+
+void test_Bus_GetStats_should_reject_NULL_arguments(void)
+{
+    struct bus b = { .listener_count = 0, };
+    bus_stats stats;
+    TEST_ASSERT_FALSE(Bus_GetStats(NULL, &stats, NULL, 0));
+    TEST_ASSERT_FALSE(Bus_GetStats(&b, NULL, NULL, 0));
+}
+
+void test_Bus_GetStats_should_report_counters_threadpool_and_listener_stats(void)
+{
+    struct threadpool fake_threadpool;
+    struct listener fake_listeners[2];
+    struct listener *listeners[] = {
+        &fake_listeners[0],
+        &fake_listeners[1],
+    };
+    struct bus b = {
+        .listener_count = 2,
+        .listeners = listeners,
+        .threadpool = &fake_threadpool,
+        .send_failures = 5,
+        .tx_timeouts = 2,
+        .failure_retries = 7,
+        .listener_retries = 11,
+    };
+
+    struct threadpool_info zero_info;
+    memset(&zero_info, 0, sizeof(zero_info));
+    struct threadpool_info info = { .active_threads = 3, .backlog_size = 40, };
+    Threadpool_Stats_Expect(&fake_threadpool, &zero_info);
+    Threadpool_Stats_ReturnThruPtr_ti(&info);
+
+    bus_listener_stats out[1];
+    memset(out, 0, sizeof(out));
+    bus_listener_stats listener_stats = { .rx_info_in_use = 12, .rx_timeouts = 1, };
+    Listener_GetStats_Expect(&fake_listeners[0], &out[0]);
+    Listener_GetStats_ReturnThruPtr_stats(&listener_stats);
+
+    bus_stats stats;
+    TEST_ASSERT_TRUE(Bus_GetStats(&b, &stats, out, 1));
+
+    TEST_ASSERT_EQUAL(2, stats.listener_count);
+    TEST_ASSERT_EQUAL(5, stats.send_failures);
+    TEST_ASSERT_EQUAL(2, stats.tx_timeouts);
+    TEST_ASSERT_EQUAL(7, stats.failure_retries);
+    TEST_ASSERT_EQUAL(11, stats.listener_retries);
+    TEST_ASSERT_EQUAL(3, stats.threadpool.active_threads);
+    TEST_ASSERT_EQUAL(40, stats.threadpool.backlog_size);
+    TEST_ASSERT_EQUAL(12, out[0].rx_info_in_use);
+    TEST_ASSERT_EQUAL(1, out[0].rx_timeouts);
+}
@@ -119,6 +119,31 @@ void test_Listener_RemoveSocket_should_add_ADD_SOCKET_msg_to_queue(void) {
     TEST_ASSERT_EQUAL(msg.pipes[1], msg.u.remove_socket.notify_fd);
 }
 
+void test_Listener_GetStats_should_report_counters_and_current_gauges(void) {
+    l->stats.holds = 10;
+    l->stats.rx_timeouts = 2;
+    l->rx_info_in_use = 7;
+    l->rx_info_max_used = 9;
+    l->msgs_in_use = 3;
+    l->tracked_fds = 4;
+    l->read_buf_size = 4096;
+    l->upstream_backpressure = 6;
+    ListenerTask_GetBackpressure_ExpectAndReturn(l, 123);
+
+    bus_listener_stats stats;
+    Listener_GetStats(l, &stats);
+
+    TEST_ASSERT_EQUAL(10, stats.holds);
+    TEST_ASSERT_EQUAL(2, stats.rx_timeouts);
+    TEST_ASSERT_EQUAL(7, stats.rx_info_in_use);
+    TEST_ASSERT_EQUAL(9, stats.rx_info_max_used);
+    TEST_ASSERT_EQUAL(3, stats.msgs_in_use);
+    TEST_ASSERT_EQUAL(4, stats.tracked_fds);
+    TEST_ASSERT_EQUAL(4096, stats.read_buf_size);
+    TEST_ASSERT_EQUAL(6, stats.upstream_backpressure);
+    TEST_ASSERT_EQUAL(123, stats.backpressure);
+}
+
 void test_Listener_Shutdown_should_handle_msg_exhaustion(void) {
     l->msg_freelist = NULL;
     int fd = -1;
@@ -222,3 +247,38 @@ void test_Listener_Free_should_unblock_pending_callers_and_close_file_handles(vo
     Listener_Free(nl);
 }
 
+void test_Listener_Free_should_release_boxes_still_awaiting_responses(void) {
+    /* setup */
+    struct listener *nl = calloc(1, sizeof(*nl));
+    nl->commit_pipe = 37;
+    nl->incoming_msg_pipe = 149;
+    nl->shutdown_notify_fd = LISTENER_SHUTDOWN_COMPLETE_FD;
+
+    boxed_msg expected_box;
+    boxed_msg queued_box;
+    for (int i = 0; i < MAX_PENDING_MESSAGES; i++) {
+        nl->rx_info[i].state = RIS_INACTIVE;
+    }
+    nl->rx_info[3].state = RIS_EXPECT;
+    nl->rx_info[3].u.expect.box = &expected_box;
+    for (int i = 0; i < MAX_QUEUE_MESSAGES; i++) {
+        nl->msgs[i].pipes[0] = i;
+        nl->msgs[i].pipes[1] = 2*i;
+    }
+    nl->msgs[5].type = MSG_EXPECT_RESPONSE;
+    nl->msgs[5].u.expect.box = &queued_box;
+
+    /* Boxes go back through the bus, so their serial queue references
+     * are released too. */
+    Bus_FreeBoxedMessage_Expect(&expected_box);
+    Bus_FreeBoxedMessage_Expect(&queued_box);
+    for (int i = 0; i < MAX_QUEUE_MESSAGES; i++) {
+        syscall_close_ExpectAndReturn(i, 0);
+        syscall_close_ExpectAndReturn(2*i, 0);
+    }
+    syscall_close_ExpectAndReturn(37, 0);
+    syscall_close_ExpectAndReturn(149, 0);
+
+    Listener_Free(nl);
+}
+
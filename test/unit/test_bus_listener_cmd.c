@@ -488,6 +488,7 @@ void test_ListenerCmd_CheckIncomingMessages_should_handle_incoming_HOLD_RESPONSE
     TEST_ASSERT_EQUAL(9, info.timeout_sec);
     TEST_ASSERT_EQUAL(23, info.u.hold.fd);
     TEST_ASSERT_EQUAL(false, info.u.hold.has_result);
+    TEST_ASSERT_EQUAL(1, l->stats.holds);
 }
 
 void test_ListenerCmd_CheckIncomingMessages_should_handle_incoming_EXPECT_command_when_result_is_saved(void) {
@@ -532,6 +533,8 @@ void test_ListenerCmd_CheckIncomingMessages_should_handle_incoming_EXPECT_comman
     TEST_ASSERT_EQUAL(true, hold_info.u.expect.has_result);
     TEST_ASSERT_EQUAL(opaque_result, hold_info.u.expect.result.u.success.msg);
     TEST_ASSERT_EQUAL(12345, hold_info.u.expect.result.u.success.seq_id);
+    TEST_ASSERT_EQUAL(1, l->stats.hold_to_expect);
+    TEST_ASSERT_EQUAL(1, l->stats.early_responses);
 }
 
 void test_ListenerCmd_CheckIncomingMessages_should_immediately_fail_incoming_EXPECT_command_when_corresponding_HOLD_has_an_error(void) {
@@ -344,6 +344,7 @@ void test_ListenerTask_GrowReadBuf_should_grow_the_listeners_read_buffer(void)
 
     TEST_ASSERT_TRUE(ListenerTask_GrowReadBuf(l, 200));
     TEST_ASSERT_EQUAL(200, l->read_buf_size);
+    TEST_ASSERT_EQUAL(1, l->stats.read_buf_grows);
     TEST_ASSERT(l->read_buf);
     memset(&l->read_buf[0], 0xFF, 200);  // write to notify valgrind
     
@@ -361,6 +362,7 @@ void test_ListenerTask_GrowReadBuf_should_expose_failures(void)
     TEST_ASSERT_FALSE(ListenerTask_GrowReadBuf(l, (size_t)-1));
     TEST_ASSERT_EQUAL(100, l->read_buf_size);
     TEST_ASSERT_EQUAL(orig_read_buf, l->read_buf);
+    TEST_ASSERT_EQUAL(0, l->stats.read_buf_grows);
     free(l->read_buf);
 }
 
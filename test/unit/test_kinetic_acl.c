@@ -30,6 +30,9 @@
 
 #define TEST_DIR(F) ("test/unit/acl/" F)
 
+// Read inline by the LOG macros; defined here since the logger is mocked
+int KineticLogLevel = -1;
+
 void test_acl_of_empty_JSON_object_should_fail(void)
 {
     struct ACL *acl = NULL;
@@ -29,6 +29,9 @@
 #include "byte_array.h"
 #include "mock_protobuf-c.h"
 #include "mock_kinetic_memory.h"
+#include "kinetic_arena.h"
+#include "mock_kinetic_hmac.h"
+#include "mock_kinetic_hmac_batch.h"
 #include <stdlib.h>
 #include <pthread.h>
 
@@ -40,6 +43,7 @@ void setUp(void)
 {
     KineticLogger_Init("stdout", 3);
     Session = (KineticSession) {.connected = false};
+    pthread_mutex_init(&Session.operationPoolMutex, NULL);
 }
 
 void tearDown(void)
@@ -54,9 +58,34 @@ void test_KineticAllocator_NewSession_should_return_null_if_calloc_returns_null(
     TEST_ASSERT_NULL(session);
 }
 
+void test_KineticAllocator_NewSession_should_return_null_if_the_HMAC_key_cannot_be_prepared(void)
+{
+    KineticCalloc_ExpectAndReturn(1, sizeof(KineticSession), &Session);
+    KineticHMAC_InitKey_ExpectAndReturn(&Session.hmacKeySchedule,
+        ByteArray_Create(Session.config.keyData, 0), false);
+    KineticFree_Expect(&Session);
+    KineticSession * session =  KineticAllocator_NewSession(&MessageBus, &Config);
+    TEST_ASSERT_NULL(session);
+}
+
+void test_KineticAllocator_NewSession_should_return_null_if_the_HMAC_signer_cannot_be_initialized(void)
+{
+    KineticCalloc_ExpectAndReturn(1, sizeof(KineticSession), &Session);
+    KineticHMAC_InitKey_ExpectAndReturn(&Session.hmacKeySchedule,
+        ByteArray_Create(Session.config.keyData, 0), true);
+    KineticHMACBatch_InitSigner_ExpectAndReturn(&Session.hmacSigner, false);
+    KineticHMAC_DestroyKey_Expect(&Session.hmacKeySchedule);
+    KineticFree_Expect(&Session);
+    KineticSession * session =  KineticAllocator_NewSession(&MessageBus, &Config);
+    TEST_ASSERT_NULL(session);
+}
+
 void test_KineticAllocator_NewSession_should_return_a_session_with_connected_flag_set_to_false(void)
 {
     KineticCalloc_ExpectAndReturn(1, sizeof(KineticSession), &Session);
+    KineticHMAC_InitKey_ExpectAndReturn(&Session.hmacKeySchedule,
+        ByteArray_Create(Session.config.keyData, 0), true);
+    KineticHMACBatch_InitSigner_ExpectAndReturn(&Session.hmacSigner, true);
     KineticResourceWaiter_Init_Expect(&Session.connectionReady);
     KineticSession* session =  KineticAllocator_NewSession(&MessageBus, &Config);
     TEST_ASSERT_FALSE(session->connected);
@@ -65,6 +94,9 @@ void test_KineticAllocator_NewSession_should_return_a_session_with_connected_fla
 void test_KineticAllocator_NewSession_should_return_a_session_with_a_minus1_fd(void)
 {
     KineticCalloc_ExpectAndReturn(1, sizeof(KineticSession), &Session);
+    KineticHMAC_InitKey_ExpectAndReturn(&Session.hmacKeySchedule,
+        ByteArray_Create(Session.config.keyData, 0), true);
+    KineticHMACBatch_InitSigner_ExpectAndReturn(&Session.hmacSigner, true);
     KineticResourceWaiter_Init_Expect(&Session.connectionReady);
     KineticSession* session =  KineticAllocator_NewSession(&MessageBus, &Config);
     TEST_ASSERT_NOT_NULL(session);
@@ -74,6 +106,9 @@ void test_KineticAllocator_NewSession_should_return_a_session_with_a_minus1_fd(v
 void test_KineticAllocator_NewSession_should_return_a_session_pointing_to_passed_bus(void)
 {
     KineticCalloc_ExpectAndReturn(1, sizeof(KineticSession), &Session);
+    KineticHMAC_InitKey_ExpectAndReturn(&Session.hmacKeySchedule,
+        ByteArray_Create(Session.config.keyData, 0), true);
+    KineticHMACBatch_InitSigner_ExpectAndReturn(&Session.hmacSigner, true);
     KineticResourceWaiter_Init_Expect(&Session.connectionReady);
     KineticSession* session = KineticAllocator_NewSession(&MessageBus, &Config);
     TEST_ASSERT_NOT_NULL(session);
@@ -83,51 +118,104 @@ void test_KineticAllocator_NewSession_should_return_a_session_pointing_to_passed
 void test_KineticAllocator_NewSession_should_return_a_session_with_termination_status_set_to_SUCCESS(void)
 {
     KineticCalloc_ExpectAndReturn(1, sizeof(KineticSession), &Session);
+    KineticHMAC_InitKey_ExpectAndReturn(&Session.hmacKeySchedule,
+        ByteArray_Create(Session.config.keyData, 0), true);
+    KineticHMACBatch_InitSigner_ExpectAndReturn(&Session.hmacSigner, true);
     KineticResourceWaiter_Init_Expect(&Session.connectionReady);
     KineticSession* session = KineticAllocator_NewSession(&MessageBus, &Config);
     TEST_ASSERT_EQUAL(KINETIC_STATUS_SUCCESS, session->terminationStatus);
     TEST_ASSERT_FALSE(session->connected);
 }
 
+void test_KineticAllocator_FreeSession_should_free_pooled_operations(void)
+{
+    KineticOperationSlot slot1, slot2;
+    KineticArena_Init(&slot1.request.txArena);
+    KineticArena_Init(&slot2.request.txArena);
+    slot2.next = NULL;
+    slot1.next = &slot2;
+    Session.freeOperations = &slot1;
+    Session.freeOperationCount = 2;
+
+    KineticFree_Expect(&slot1);
+    KineticFree_Expect(&slot2);
+    KineticHMAC_DestroyKey_Expect(&Session.hmacKeySchedule);
+    KineticHMACBatch_DestroySigner_Expect(&Session.hmacSigner);
+    KineticResourceWaiter_Destroy_Expect(&Session.connectionReady);
+    KineticFree_Expect(&Session);
+    KineticAllocator_FreeSession(&Session);
+}
+
 void test_KineticAllocator_FreeSession_should_destroy_waiter_and_free_session(void)
 {
+    KineticHMAC_DestroyKey_Expect(&Session.hmacKeySchedule);
+    KineticHMACBatch_DestroySigner_Expect(&Session.hmacSigner);
     KineticResourceWaiter_Destroy_Expect(&Session.connectionReady);
     KineticFree_Expect(&Session);
     KineticAllocator_FreeSession(&Session);
 }
 
-void test_KineticAllocator_NewKineticResponse_should_return_null_if_calloc_return_null(void)
+void test_KineticAllocator_NewKineticResponse_should_return_null_if_malloc_return_null(void)
 {
-    KineticCalloc_ExpectAndReturn(1, sizeof(KineticResponse) + 1234, NULL);
+    KineticMalloc_ExpectAndReturn(sizeof(KineticResponse) + 4096 + 2 * KINETIC_MAX_KEY_LEN, NULL);
     KineticResponse * response = KineticAllocator_NewKineticResponse(1234);
     TEST_ASSERT_NULL(response);
 }
 
-void test_KineticAllocator_FreeKineticResponse_should_free_the_command_if_its_not_null(void)
+void test_KineticAllocator_NewKineticResponse_should_reuse_a_freed_response_of_the_same_size_class(void)
 {
-    Com__Seagate__Kinetic__Proto__Command command;
+    size_t capacity = 64 * 1024 + 2 * KINETIC_MAX_KEY_LEN;
+    KineticResponse * buf = malloc(sizeof(KineticResponse) + capacity);
+    KineticMalloc_ExpectAndReturn(sizeof(KineticResponse) + capacity, buf);
 
-    KineticResponse rsp = { .command = &command};
-    protobuf_c_message_free_unpacked_Expect(&command.base, NULL);
+    KineticResponse * response = KineticAllocator_NewKineticResponse(10000);
+    TEST_ASSERT_EQUAL_PTR(buf, response);
+    TEST_ASSERT_NULL(response->proto);
+    TEST_ASSERT_NULL(response->command);
 
-    KineticFree_Expect(&rsp);
+    // returned to the pool rather than freed, and the arena-backed proto
+    // is not walked by protobuf-c
+    Com__Seagate__Kinetic__Proto__Message proto;
+    response->proto = &proto;
+    KineticAllocator_FreeKineticResponse(response);
 
-    KineticAllocator_FreeKineticResponse(&rsp);
+    response = KineticAllocator_NewKineticResponse(capacity);
+    TEST_ASSERT_EQUAL_PTR(buf, response);
+    TEST_ASSERT_NULL(response->proto);
+    TEST_ASSERT_NULL(response->next);
+
+    KineticAllocator_FreeKineticResponse(response);
 }
 
-void test_KineticAllocator_FreeKineticResponse_should_free_the_proto_if_its_not_null(void)
+void test_KineticAllocator_NewKineticResponse_should_pool_a_full_size_value_with_its_protobuf(void)
 {
-    Com__Seagate__Kinetic__Proto__Message proto;
+    size_t capacity = KINETIC_OBJ_SIZE + PDU_PROTO_MAX_LEN;
+    KineticResponse * buf = malloc(sizeof(KineticResponse) + capacity);
+    KineticMalloc_ExpectAndReturn(sizeof(KineticResponse) + capacity, buf);
 
-    KineticResponse rsp = { .proto = &proto};
-    protobuf_c_message_free_unpacked_Expect(&proto.base, NULL);
+    KineticResponse * response = KineticAllocator_NewKineticResponse(KINETIC_OBJ_SIZE + 256);
+    TEST_ASSERT_EQUAL_PTR(buf, response);
+    KineticAllocator_FreeKineticResponse(response);
 
-    KineticFree_Expect(&rsp);
+    response = KineticAllocator_NewKineticResponse(KINETIC_OBJ_SIZE + 256);
+    TEST_ASSERT_EQUAL_PTR(buf, response);
+    KineticAllocator_FreeKineticResponse(response);
+}
 
-    KineticAllocator_FreeKineticResponse(&rsp);
+void test_KineticAllocator_FreeKineticResponse_should_free_responses_too_large_to_pool(void)
+{
+    KineticResponse rsp;
+    size_t tooLarge = KINETIC_OBJ_SIZE + PDU_PROTO_MAX_LEN + 1;
+    KineticMalloc_ExpectAndReturn(sizeof(KineticResponse) + tooLarge, &rsp);
+
+    KineticResponse * response = KineticAllocator_NewKineticResponse(tooLarge);
+    TEST_ASSERT_EQUAL_PTR(&rsp, response);
+
+    KineticFree_Expect(&rsp);
+    KineticAllocator_FreeKineticResponse(response);
 }
 
-void test_KineticAllocator_FreeKineticResponse_should_free_the_proto_and_command_if_they_are_not_null(void)
+void test_KineticAllocator_FreeKineticResponse_should_leave_the_unpacked_messages_to_the_arena(void)
 {
     Com__Seagate__Kinetic__Proto__Message proto;
     Com__Seagate__Kinetic__Proto__Command command;
@@ -136,8 +224,6 @@ void test_KineticAllocator_FreeKineticResponse_should_free_the_proto_and_command
         .proto = &proto,
         .command = &command
     };
-    protobuf_c_message_free_unpacked_Expect(&command.base, NULL);
-    protobuf_c_message_free_unpacked_Expect(&proto.base, NULL);
 
     KineticFree_Expect(&rsp);
 
@@ -146,56 +232,87 @@ void test_KineticAllocator_FreeKineticResponse_should_free_the_proto_and_command
 
 void test_KineticAllocator_NewOperation_should_return_null_if_calloc_returns_null_for_operation(void)
 {
-    KineticCalloc_ExpectAndReturn(1, sizeof(KineticOperation), NULL);
+    KineticCalloc_ExpectAndReturn(1, sizeof(KineticOperationSlot), NULL);
     KineticOperation * operation = KineticAllocator_NewOperation(&Session);
     TEST_ASSERT_NULL(operation);
 }
 
-
-void test_KineticAllocator_NewOperation_should_return_null_and_free_operation_if_calloc_returns_null_for_request(void)
+void test_KineticAllocator_NewOperation_should_initialize_operation_and_request(void)
 {
-    KineticOperation op;
-    op.session = &Session;
+    Session.timeoutSeconds = 423;
+    KineticOperationSlot slot;
+    memset(&slot, 0xAA, sizeof(slot));
 
-    KineticCalloc_ExpectAndReturn(1, sizeof(KineticOperation), &op);
-    KineticCalloc_ExpectAndReturn(1, sizeof(KineticRequest), NULL);
-    KineticFree_Expect(&op);
+    KineticCalloc_ExpectAndReturn(1, sizeof(KineticOperationSlot), &slot);
 
+    KineticRequest_Init_Expect(&slot.request, &Session);
     KineticOperation * operation = KineticAllocator_NewOperation(&Session);
 
-    TEST_ASSERT_NULL(operation);
+    TEST_ASSERT_EQUAL_PTR(&slot.operation, operation);
+    TEST_ASSERT_EQUAL_PTR(&Session, operation->session);
+    TEST_ASSERT_EQUAL_PTR(&slot.request, operation->request);
+    TEST_ASSERT_NULL(operation->response);
+    TEST_ASSERT_NULL(operation->entry);
+    TEST_ASSERT_NULL(operation->closure.callback);
+    TEST_ASSERT_EQUAL(423, operation->timeoutSeconds);
+    TEST_ASSERT_NULL(slot.request.txArena.chunks);
+    TEST_ASSERT_EQUAL(KINETIC_ARENA_DEFAULT_RETAIN, slot.request.txArena.retainLimit);
 }
 
-void test_KineticAllocator_NewOperation_should_initialize_operation_and_request(void)
+void test_KineticAllocator_NewOperation_should_reuse_a_pooled_operation(void)
 {
-    Session.timeoutSeconds = 423;
-    KineticOperation op = {.session = NULL};
-    KineticRequest request;
-
-    KineticCalloc_ExpectAndReturn(1, sizeof(KineticOperation), &op);
-    KineticCalloc_ExpectAndReturn(1, sizeof(KineticRequest), &request);
+    KineticOperationSlot slot;
+    memset(&slot, 0xAA, sizeof(slot));
+    slot.next = NULL;
+    Session.freeOperations = &slot;
+    Session.freeOperationCount = 1;
 
-    KineticRequest_Init_Expect(&request, &Session);
+    KineticRequest_Init_Expect(&slot.request, &Session);
     KineticOperation * operation = KineticAllocator_NewOperation(&Session);
 
-    TEST_ASSERT_EQUAL_PTR(operation, &op);
-    TEST_ASSERT_EQUAL_PTR(&Session, operation->session);
-    TEST_ASSERT_EQUAL_PTR(&request, operation->request);
+    TEST_ASSERT_EQUAL_PTR(&slot.operation, operation);
+    TEST_ASSERT_EQUAL_PTR(&slot.request, operation->request);
     TEST_ASSERT_NULL(operation->response);
-    TEST_ASSERT_EQUAL(423, operation->timeoutSeconds);
+    TEST_ASSERT_NULL(Session.freeOperations);
+    TEST_ASSERT_EQUAL(0, Session.freeOperationCount);
+}
+
+void test_KineticAllocator_FreeOperation_should_return_operation_to_session_pool(void)
+{
+    KineticOperationSlot slot = { .operation = { .session = &Session } };
+
+    KineticAllocator_FreeOperation(&slot.operation);
+
+    TEST_ASSERT_EQUAL_PTR(&slot, Session.freeOperations);
+    TEST_ASSERT_EQUAL(1, Session.freeOperationCount);
+}
+
+void test_KineticAllocator_FreeOperation_should_reset_the_transmit_arena(void)
+{
+    static uint64_t chunk[(4096 + 64) / sizeof(uint64_t)];
+    KineticOperationSlot slot = { .operation = { .session = &Session } };
+    KineticArena_Init(&slot.request.txArena);
+    KineticMalloc_IgnoreAndReturn(chunk);
+    void* pdu = KineticArena_Alloc(&slot.request.txArena, 48);
+    TEST_ASSERT_NOT_NULL(pdu);
+
+    KineticAllocator_FreeOperation(&slot.operation);
+
+    // The retained chunk is reused from the start
+    TEST_ASSERT_EQUAL_PTR(&slot, Session.freeOperations);
+    TEST_ASSERT_EQUAL_PTR(pdu, KineticArena_Alloc(&slot.request.txArena, 48));
 }
 
-void test_KineticAllocator_FreeOperation_should_free_request_if_it_is_not_NULL(void)
+void test_KineticAllocator_FreeOperation_should_free_operation_if_session_pool_is_full(void)
 {
-    KineticRequest request;
-    memset(&request, 0x00, sizeof(request));
+    KineticOperationSlot slot = { .operation = { .session = &Session } };
+    Session.freeOperationCount = KINETIC_OPERATION_POOL_MAX;
 
-    KineticOperation op = { .request = &request };
+    KineticFree_Expect(&slot);
 
-    KineticFree_Expect(&request);
-    KineticFree_Expect(&op);
+    KineticAllocator_FreeOperation(&slot.operation);
 
-    KineticAllocator_FreeOperation(&op);
+    TEST_ASSERT_NULL(Session.freeOperations);
 }
 
 void test_KineticAllocator_FreeOperation_should_free_response_if_its_not_null(void)
@@ -203,12 +320,34 @@ void test_KineticAllocator_FreeOperation_should_free_response_if_its_not_null(vo
     KineticResponse response;
     memset(&response, 0x00, sizeof(response));
 
-    KineticOperation op = { .response = &response };
+    KineticOperationSlot slot = { .operation = { .response = &response } };
 
     KineticFree_Expect(&response);
-    KineticFree_Expect(&op);
+    KineticFree_Expect(&slot);
+
+    KineticAllocator_FreeOperation(&slot.operation);
+}
 
-    KineticAllocator_FreeOperation(&op);
+void test_KineticAllocator_should_not_allocate_in_steady_state(void)
+{
+    KineticOperationSlot slot;
+
+    KineticCalloc_ExpectAndReturn(1, sizeof(KineticOperationSlot), &slot);
+    KineticRequest_Init_Expect(&slot.request, &Session);
+    KineticOperation * operation = KineticAllocator_NewOperation(&Session);
+    KineticAllocator_FreeOperation(operation);
+
+    for (int i = 0; i < 9; i++) {
+        KineticRequest_Init_Expect(&slot.request, &Session);
+        operation = KineticAllocator_NewOperation(&Session);
+        TEST_ASSERT_EQUAL_PTR(&slot.operation, operation);
+        KineticAllocator_FreeOperation(operation);
+    }
+
+    KineticAllocatorStats stats;
+    KineticAllocator_GetStats(&Session, &stats);
+    TEST_ASSERT_EQUAL(10, stats.operations);
+    TEST_ASSERT_EQUAL(1, stats.operationAllocs);
 }
 
 void test_KineticAllocator_FreeP2PProtobuf_should_free_protobuf_message_P2P_operation_tree(void)
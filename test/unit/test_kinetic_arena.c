@@ -0,0 +1,117 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "kinetic_arena.h"
+#include "unity.h"
+#include "unity_helper.h"
+#include "kinetic_memory.h"
+#include "protobuf-c/protobuf-c.h"
+#include <stdint.h>
+#include <string.h>
+
+static KineticArena Arena;
+
+void setUp(void)
+{
+    KineticArena_Init(&Arena);
+}
+
+void tearDown(void)
+{
+    KineticArena_Destroy(&Arena);
+}
+
+void test_KineticArena_Init_should_expose_a_protobuf_allocator(void)
+{
+    TEST_ASSERT_NOT_NULL(Arena.allocator.alloc);
+    TEST_ASSERT_NOT_NULL(Arena.allocator.free);
+    TEST_ASSERT_EQUAL_PTR(&Arena, Arena.allocator.allocator_data);
+    TEST_ASSERT_NULL(Arena.chunks);
+}
+
+void test_KineticArena_Alloc_should_return_distinct_aligned_blocks(void)
+{
+    uint8_t* a = KineticArena_Alloc(&Arena, 3);
+    uint8_t* b = KineticArena_Alloc(&Arena, 17);
+    uint8_t* c = Arena.allocator.alloc(Arena.allocator.allocator_data, 8);
+
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_TRUE(b >= a + 3);
+    TEST_ASSERT_TRUE(c >= b + 17);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)a % sizeof(void*));
+    TEST_ASSERT_EQUAL(0, (uintptr_t)b % sizeof(void*));
+    TEST_ASSERT_EQUAL(0, (uintptr_t)c % sizeof(void*));
+
+    memset(a, 0xaa, 3);
+    memset(b, 0xbb, 17);
+    TEST_ASSERT_EQUAL_HEX8(0xaa, a[2]);
+}
+
+void test_KineticArena_Alloc_should_grow_for_requests_larger_than_a_chunk(void)
+{
+    uint8_t* small = KineticArena_Alloc(&Arena, 16);
+    uint8_t* big = KineticArena_Alloc(&Arena, 100000);
+
+    TEST_ASSERT_NOT_NULL(small);
+    TEST_ASSERT_NOT_NULL(big);
+    memset(big, 0x5a, 100000);
+    TEST_ASSERT_EQUAL_HEX8(0x5a, big[99999]);
+}
+
+void test_KineticArena_Reset_should_reuse_the_retained_chunk(void)
+{
+    uint8_t* first = KineticArena_Alloc(&Arena, 64);
+    Arena.allocator.free(Arena.allocator.allocator_data, first);
+    KineticArena_Reset(&Arena);
+
+    uint8_t* again = KineticArena_Alloc(&Arena, 64);
+    TEST_ASSERT_EQUAL_PTR(first, again);
+}
+
+void test_KineticArena_Reset_should_release_oversized_chunks(void)
+{
+    KineticArena_Alloc(&Arena, 1024 * 1024);
+    KineticArena_Reset(&Arena);
+    TEST_ASSERT_NULL(Arena.chunks);
+}
+
+void test_KineticArena_Alloc_should_recycle_large_chunks_across_arenas(void)
+{
+    uint8_t* frame = KineticArena_Alloc(&Arena, 1024 * 1024 + 100);
+    TEST_ASSERT_NOT_NULL(frame);
+    KineticArena_Reset(&Arena);
+
+    KineticArena other;
+    KineticArena_Init(&other);
+    uint8_t* again = KineticArena_Alloc(&other, 2 * 1024 * 1024);
+    TEST_ASSERT_EQUAL_PTR(frame, again);
+    KineticArena_Destroy(&other);
+}
+
+void test_KineticArena_Destroy_should_release_all_chunks(void)
+{
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_NOT_NULL(KineticArena_Alloc(&Arena, 1000));
+    }
+    KineticArena_Destroy(&Arena);
+    TEST_ASSERT_NULL(Arena.chunks);
+}
@@ -22,6 +22,8 @@
 #include "unity_helper.h"
 #include "kinetic_auth.h"
 #include "kinetic_hmac.h"
+#include "kinetic_hmac_batch.h"
+#include "kinetic_tag.h"
 #include "kinetic_nbo.h"
 #include "kinetic.pb-c.h"
 #include "kinetic_logger.h"
@@ -82,7 +84,7 @@ void test_KineticAuth_PopulateHmac_should_return_HMAC_REQUIRED_if_HMAC_not_speci
         }
     };
 
-    KineticStatus status = KineticAuth_PopulateHmac(&session.config, &Request);
+    KineticStatus status = KineticAuth_PopulateHmac(&session.config, &session.hmacKeySchedule, &Request);
 
     TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_HMAC_REQUIRED, status);
 }
@@ -106,9 +108,12 @@ void test_KineticAuth_PopulateHmac_should_add_and_populate_HMAC_authentication(v
         }
     };
     strcpy((char*)session.config.keyData, hmacKey);
+    TEST_ASSERT_TRUE(KineticHMAC_InitKey(&session.hmacKeySchedule, session.config.hmacKey));
 
-    KineticStatus status = KineticAuth_PopulateHmac(&session.config, &Request);
+    KineticStatus status = KineticAuth_PopulateHmac(&session.config, &session.hmacKeySchedule, &Request);
     TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_TRUE(KineticHMAC_Validate(&Request.message.message, &session.hmacKeySchedule));
+    KineticHMAC_DestroyKey(&session.hmacKeySchedule);
 
     TEST_ASSERT_NULL(Request.message.message.pinauth);
     TEST_ASSERT_TRUE(Request.message.message.has_authtype);
@@ -147,3 +152,108 @@ void test_KineticAuth_Populate_should_add_and_populate_PIN_authentication(void)
     TEST_ASSERT_EQUAL_PTR(testPin, Request.message.message.pinauth->pin.data);
     TEST_ASSERT_EQUAL(strlen(testPin), Request.message.message.pinauth->pin.len);
 }
+
+void test_KineticAuth_ValidateResponse_should_accept_a_response_with_a_valid_HMAC(void)
+{
+    uint8_t keyData[] = "asdfasdf";
+    KineticHMACKey key;
+    TEST_ASSERT_TRUE(KineticHMAC_InitKey(&key, ByteArray_Create(keyData, 8)));
+
+    uint8_t commandBytes[32] = {1, 2, 3, 4};
+    uint8_t hmacData[KINETIC_HMAC_SHA1_LEN];
+    Com__Seagate__Kinetic__Proto__Message__HMACauth hmacAuth = {
+        .has_hmac = true,
+        .hmac = {.data = hmacData, .len = sizeof(hmacData)},
+    };
+    Com__Seagate__Kinetic__Proto__Message proto = {
+        .has_authtype = true,
+        .authtype = COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__HMACAUTH,
+        .hmacauth = &hmacAuth,
+        .has_commandbytes = true,
+        .commandbytes = {.data = commandBytes, .len = sizeof(commandBytes)},
+    };
+    KineticHMAC hmac;
+    TEST_ASSERT_TRUE(KineticHMAC_Populate(&hmac, &proto, &key));
+    KineticResponse response = {.proto = &proto};
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS,
+        KineticAuth_ValidateResponse(&key, &response));
+
+    commandBytes[5] ^= 0x01;
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_HMAC_FAILURE,
+        KineticAuth_ValidateResponse(&key, &response));
+
+    KineticHMAC_DestroyKey(&key);
+}
+
+void test_KineticAuth_ValidateResponse_should_reject_a_response_without_command_bytes(void)
+{
+    uint8_t keyData[] = "asdfasdf";
+    KineticHMACKey key;
+    TEST_ASSERT_TRUE(KineticHMAC_InitKey(&key, ByteArray_Create(keyData, 8)));
+    Com__Seagate__Kinetic__Proto__Message proto = COM__SEAGATE__KINETIC__PROTO__MESSAGE__INIT;
+    KineticResponse response = {.proto = &proto};
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_HMAC_FAILURE,
+        KineticAuth_ValidateResponse(&key, &response));
+
+    KineticHMAC_DestroyKey(&key);
+}
+
+void test_KineticAuth_PopulateTag_should_compute_the_tag_and_set_its_length(void)
+{
+    uint8_t valueData[] = "123456789";
+    ByteArray value = ByteArray_Create(valueData, 9);
+    uint8_t tagData[KINETIC_TAG_MAX_LEN];
+    ByteBuffer tag = ByteBuffer_Create(tagData, sizeof(tagData), 0);
+    const uint8_t expected[] = {0xe3, 0x06, 0x92, 0x83};
+
+    KineticStatus status = KineticAuth_PopulateTag(&tag, KINETIC_ALGORITHM_CRC32, &value);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL(sizeof(expected), tag.bytesUsed);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, tagData, sizeof(expected));
+}
+
+void test_KineticAuth_PopulateTag_should_return_INVALID_REQUEST_for_unsupported_algorithm(void)
+{
+    uint8_t valueData[] = "value";
+    ByteArray value = ByteArray_Create(valueData, 5);
+    uint8_t tagData[KINETIC_TAG_MAX_LEN];
+    ByteBuffer tag = ByteBuffer_Create(tagData, sizeof(tagData), 0);
+
+    KineticStatus status = KineticAuth_PopulateTag(&tag, KINETIC_ALGORITHM_INVALID, &value);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_INVALID_REQUEST, status);
+    TEST_ASSERT_EQUAL(0, tag.bytesUsed);
+}
+
+void test_KineticAuth_PopulateTag_should_return_BUFFER_OVERRUN_if_tag_does_not_fit(void)
+{
+    uint8_t valueData[] = "value";
+    ByteArray value = ByteArray_Create(valueData, 5);
+    uint8_t tagData[KINETIC_HMAC_SHA1_LEN - 1];
+    ByteBuffer tag = ByteBuffer_Create(tagData, sizeof(tagData), 0);
+
+    KineticStatus status = KineticAuth_PopulateTag(&tag, KINETIC_ALGORITHM_SHA1, &value);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_BUFFER_OVERRUN, status);
+    TEST_ASSERT_EQUAL(0, tag.bytesUsed);
+}
+
+void test_KineticAuth_CopyAndPopulateTag_should_copy_the_value_and_compute_its_tag(void)
+{
+    uint8_t valueData[] = "123456789";
+    ByteArray value = ByteArray_Create(valueData, 9);
+    uint8_t copy[9] = {0};
+    uint8_t tagData[KINETIC_TAG_MAX_LEN];
+    ByteBuffer tag = ByteBuffer_Create(tagData, sizeof(tagData), 0);
+    const uint8_t expected[] = {0x99, 0x5d, 0xc9, 0xbb, 0xdf, 0x19, 0x39, 0xfa};
+
+    KineticStatus status = KineticAuth_CopyAndPopulateTag(&tag, KINETIC_ALGORITHM_CRC64, copy, &value);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(valueData, copy, sizeof(copy));
+    TEST_ASSERT_EQUAL(sizeof(expected), tag.bytesUsed);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, tagData, sizeof(expected));
+}
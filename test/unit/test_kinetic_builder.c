@@ -31,6 +31,7 @@
 #include "mock_kinetic_callbacks.h"
 #include "mock_kinetic_operation.h"
 #include "mock_kinetic_message.h"
+#include "kinetic_tag.h"
 
 static KineticSession Session;
 static KineticRequest Request;
@@ -129,7 +130,8 @@ void test_KineticBuilder_BuildPut_should_build_and_execute_a_PUT_operation_to_cr
     ByteArray value = ByteArray_CreateWithCString("Luke, I am your father");
     ByteArray key = ByteArray_CreateWithCString("foobar");
     ByteArray newVersion = ByteArray_CreateWithCString("v1.0");
-    ByteArray tag = ByteArray_CreateWithCString("some_tag");
+    uint8_t tagData[KINETIC_TAG_MAX_LEN];
+    ByteArray tag = {.data = tagData, .len = sizeof(tagData)};
 
     KineticEntry entry = {
         .key = ByteBuffer_CreateWithArray(key),
@@ -157,6 +159,53 @@ void test_KineticBuilder_BuildPut_should_build_and_execute_a_PUT_operation_to_cr
     TEST_ASSERT_FALSE(Request.pinAuth);
     TEST_ASSERT_EQUAL(0, Operation.timeoutSeconds);
     TEST_ASSERT_NULL(Operation.response);
+
+    // The tag is reserved here and computed as the value is packed
+    TEST_ASSERT_TRUE(Operation.computeValueTag);
+    TEST_ASSERT_EQUAL(20, entry.tag.bytesUsed);
+}
+
+void test_KineticBuilder_BuildPut_should_return_INVALID_REQUEST_if_tag_algorithm_is_unsupported(void)
+{
+    ByteArray value = ByteArray_CreateWithCString("Luke, I am your father");
+    ByteArray key = ByteArray_CreateWithCString("foobar");
+    uint8_t tagData[KINETIC_TAG_MAX_LEN];
+    ByteArray tag = {.data = tagData, .len = sizeof(tagData)};
+
+    KineticEntry entry = {
+        .key = ByteBuffer_CreateWithArray(key),
+        .tag = ByteBuffer_CreateWithArray(tag),
+        .algorithm = KINETIC_ALGORITHM_INVALID,
+        .value = ByteBuffer_CreateWithArray(value),
+        .computeTag = true,
+    };
+
+    KineticOperation_ValidateOperation_Expect(&Operation);
+
+    KineticStatus status = KineticBuilder_BuildPut(&Operation, &entry);
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_INVALID_REQUEST, status);
+    TEST_ASSERT_FALSE(Operation.computeValueTag);
+}
+
+void test_KineticBuilder_BuildPut_should_return_BUFFER_OVERRUN_if_tag_buffer_is_too_small(void)
+{
+    ByteArray value = ByteArray_CreateWithCString("Luke, I am your father");
+    ByteArray key = ByteArray_CreateWithCString("foobar");
+    ByteArray tag = ByteArray_CreateWithCString("some_tag");
+
+    KineticEntry entry = {
+        .key = ByteBuffer_CreateWithArray(key),
+        .tag = ByteBuffer_CreateWithArray(tag),
+        .algorithm = KINETIC_ALGORITHM_SHA2,
+        .value = ByteBuffer_CreateWithArray(value),
+        .computeTag = true,
+    };
+
+    KineticOperation_ValidateOperation_Expect(&Operation);
+
+    KineticStatus status = KineticBuilder_BuildPut(&Operation, &entry);
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_BUFFER_OVERRUN, status);
+    TEST_ASSERT_FALSE(Operation.computeValueTag);
 }
 
 uint8_t ValueData[KINETIC_OBJ_SIZE];
@@ -32,7 +32,7 @@
 #include "mock_kinetic_hmac.h"
 #include "mock_kinetic_controller.h"
 #include "mock_kinetic_allocator.h"
-#include "mock_kinetic_pdu_unpack.h"
+#include "mock_kinetic_pdu_scan.h"
 #include "mock_bus.h"
 #include "mock_bus_inward.h"
 #include "byte_array.h"
@@ -245,9 +245,7 @@ void test_sink_cb_should_yield_fully_received_body(void)
     TEST_ASSERT_EQUAL(si, res.full_msg_buffer);
 }
 
-bus_unpack_cb_res_t unpack_cb(void *msg, void *socket_udata);
-
-void test_unpack_cb_should_expose_error_codes(void)
+void test_KineticBus_UnpackResponse_should_expose_error_codes(void)
 {
     Session.socket = 123;
     socket_info *si = (socket_info *)si_buf;
@@ -265,13 +263,13 @@ void test_unpack_cb_should_expose_error_codes(void)
 
     for (size_t i = 0; i < sizeof(error_states) / sizeof(error_states[0]); i++) {
         si->unpack_status = error_states[i];
-        bus_unpack_cb_res_t res = unpack_cb((void *)si, &Session);
+        bus_unpack_cb_res_t res = KineticBus_UnpackResponse((void *)si, &Session);
         TEST_ASSERT_FALSE(res.ok);
         TEST_ASSERT_EQUAL(error_states[i], res.u.error.opaque_error_id);
     }
 }
 
-void test_unpack_cb_should_expose_alloc_failure(void)
+void test_KineticBus_UnpackResponse_should_expose_alloc_failure(void)
 {
     Session.socket = 123;
     socket_info si = {
@@ -284,19 +282,18 @@ void test_unpack_cb_should_expose_alloc_failure(void)
     };
     
     KineticAllocator_NewKineticResponse_ExpectAndReturn(8, NULL);
-    bus_unpack_cb_res_t res = unpack_cb((void*)&si, &Session);
+    bus_unpack_cb_res_t res = KineticBus_UnpackResponse((void*)&si, &Session);
     TEST_ASSERT_FALSE(res.ok);
     TEST_ASSERT_EQUAL(UNPACK_ERROR_PAYLOAD_MALLOC_FAIL, res.u.error.opaque_error_id);
 }
 
-void test_unpack_cb_should_skip_empty_commands(void)
+void test_KineticBus_UnpackResponse_should_skip_empty_commands(void)
 {
     /* Include trailing memory for si's .buf[]. */
     Session.socket = 123;
     socket_info *si = (socket_info *)si_buf;
     si->state = STATE_AWAITING_HEADER;
     si->unpack_status = UNPACK_ERROR_SUCCESS,
-    si->header.protobufLength = 0x01;
     si->header.valueLength = 0x01;
     si->header.protobufLength = 0x01;
     si->buf[0] = 0x00;
@@ -306,67 +303,82 @@ void test_unpack_cb_should_skip_empty_commands(void)
     memset(response_buf, 0, sizeof(response_buf));
     KineticResponse *response = (KineticResponse *)response_buf;
 
-    KineticAllocator_NewKineticResponse_ExpectAndReturn(1, response);
-
-    Com__Seagate__Kinetic__Proto__Message Proto;
-    memset(&Proto, 0, sizeof(Proto));
-    Proto.has_commandbytes = false;
+    KineticAllocator_NewKineticResponse_ExpectAndReturn(2, response);
 
-    KineticPDU_unpack_message_ExpectAndReturn(NULL, si->header.protobufLength,
-        si->buf, &Proto);
+    KineticPDUScan Scan;
+    memset(&Scan, 0, sizeof(Scan));
+    KineticPDU_Scan_ExpectAndReturn(si->buf, si->header.protobufLength, &response->scan, true);
+    KineticPDU_Scan_ReturnThruPtr_scan(&Scan);
 
-    bus_unpack_cb_res_t res = unpack_cb(si, &Session);
+    bus_unpack_cb_res_t res = KineticBus_UnpackResponse(si, &Session);
 
-    TEST_ASSERT_EQUAL(0xee, response->value[0]);
+    TEST_ASSERT_EQUAL(0x00, response->pdu[0]);
+    TEST_ASSERT_EQUAL(0xee, response->pdu[1]);
 
     TEST_ASSERT(res.ok);
     TEST_ASSERT_EQUAL(response, res.u.success.msg);
+    TEST_ASSERT_EQUAL(BUS_NO_SEQ_ID, res.u.success.seq_id);
 }
 
-void test_unpack_cb_should_unpack_command_bytes(void)
+void test_KineticBus_UnpackResponse_should_scan_ack_sequence_and_defer_unpacking(void)
 {
     Session.socket = 123;
     socket_info *si = (socket_info *)si_buf;
     si->state = STATE_AWAITING_HEADER;
     si->unpack_status = UNPACK_ERROR_SUCCESS,
-    si->header.protobufLength = 0x01;
     si->header.valueLength = 0x08;
     si->header.protobufLength = 0x02;
-    si->buf[0] = 0x00;
-    si->buf[1] = 0x01;
-    si->buf[2] = 0xee;
+    si->buf[0] = 0x3a;
+    si->buf[1] = 0x00;
+    memcpy(&si->buf[2], "valuexyz", 8);
 
-    uint8_t response_buf[sizeof(KineticResponse) + 1];
+    uint8_t response_buf[sizeof(KineticResponse) + 10];
     memset(response_buf, 0, sizeof(response_buf));
     KineticResponse *response = (KineticResponse *)response_buf;
 
-    KineticAllocator_NewKineticResponse_ExpectAndReturn(8, response);
-
-    Com__Seagate__Kinetic__Proto__Message Proto;
-    memset(&Proto, 0, sizeof(Proto));
-    Proto.has_commandbytes = true;
-    Proto.commandbytes.data = (uint8_t *)"data";
-    Proto.commandbytes.len = 4;
+    KineticAllocator_NewKineticResponse_ExpectAndReturn(10, response);
 
-    KineticPDU_unpack_message_ExpectAndReturn(NULL, si->header.protobufLength,
-        si->buf, &Proto);
+    KineticPDUScan Scan;
+    memset(&Scan, 0, sizeof(Scan));
+    Scan.hasHeader = true;
+    Scan.hasAckSequence = true;
+    Scan.ackSequence = 0x12345678;
+    KineticPDU_Scan_ExpectAndReturn(si->buf, si->header.protobufLength, &response->scan, true);
+    KineticPDU_Scan_ReturnThruPtr_scan(&Scan);
 
-    Com__Seagate__Kinetic__Proto__Command Command;
-    memset(&Command, 0, sizeof(Command));
-    Com__Seagate__Kinetic__Proto__Command__Header Header;
-    memset(&Header, 0, sizeof(Header));
-    Command.header = &Header;
-    response->header.valueLength = 1;
-    Header.acksequence = 0x12345678;
+    bus_unpack_cb_res_t res = KineticBus_UnpackResponse(si, &Session);
 
-    KineticPDU_unpack_command_ExpectAndReturn(NULL, Proto.commandbytes.len,
-        Proto.commandbytes.data, &Command);
-
-    bus_unpack_cb_res_t res = unpack_cb(si, &Session);
-
-    TEST_ASSERT_EQUAL(0xee, response->value[0]);
+    TEST_ASSERT_EQUAL_MEMORY(si->buf, response->pdu, 2);
+    TEST_ASSERT_EQUAL_MEMORY("valuexyz", &response->pdu[2], 8);
+    TEST_ASSERT_NULL(response->proto);
+    TEST_ASSERT_NULL(response->command);
 
     TEST_ASSERT(res.ok);
     TEST_ASSERT_EQUAL(response, res.u.success.msg);
     TEST_ASSERT_EQUAL(0x12345678, res.u.success.seq_id);
 }
+
+void test_KineticBus_UnpackResponse_should_reject_malformed_protobufs(void)
+{
+    Session.socket = 123;
+    socket_info *si = (socket_info *)si_buf;
+    si->state = STATE_AWAITING_HEADER;
+    si->unpack_status = UNPACK_ERROR_SUCCESS,
+    si->header.valueLength = 0x00;
+    si->header.protobufLength = 0x02;
+    si->buf[0] = 0x3a;
+    si->buf[1] = 0x7f;
+
+    uint8_t response_buf[sizeof(KineticResponse) + 2];
+    memset(response_buf, 0, sizeof(response_buf));
+    KineticResponse *response = (KineticResponse *)response_buf;
+
+    KineticAllocator_NewKineticResponse_ExpectAndReturn(2, response);
+    KineticPDU_Scan_ExpectAndReturn(si->buf, si->header.protobufLength, &response->scan, false);
+    KineticAllocator_FreeKineticResponse_Expect(response);
+
+    bus_unpack_cb_res_t res = KineticBus_UnpackResponse(si, &Session);
+
+    TEST_ASSERT_FALSE(res.ok);
+    TEST_ASSERT_EQUAL(UNPACK_ERROR_INVALID_PROTOBUF, res.u.error.opaque_error_id);
+}
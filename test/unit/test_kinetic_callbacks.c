@@ -35,10 +35,136 @@
 #include "mock_kinetic_request.h"
 #include "mock_kinetic_acl.h"
 #include "kinetic_callbacks.h"
+#include "kinetic_tag.h"
+#include <stdlib.h>
+#include <string.h>
 
-void test_kinetic_callbacks_needs_testing(void)
+static KineticSession Session;
+static KineticResponse* Response;
+static Com__Seagate__Kinetic__Proto__Command__KeyValue KeyValue;
+static uint8_t ValueData[16];
+static uint8_t TagData[KINETIC_TAG_MAX_LEN];
+static KineticEntry Entry;
+static KineticOperation Operation;
+
+// CRC32 (CRC-32C) of "123456789"
+static uint8_t CheckTag[] = {0xe3, 0x06, 0x92, 0x83};
+
+void setUp(void)
+{
+    memset(&Session, 0, sizeof(Session));
+    // A two byte protobuf ahead of the value
+    Response = calloc(1, sizeof(KineticResponse) + 2 + 9);
+    memcpy(&Response->pdu[2], "123456789", 9);
+    Response->header.protobufLength = 2;
+    Response->header.valueLength = 9;
+    KeyValue = (Com__Seagate__Kinetic__Proto__Command__KeyValue)
+        COM__SEAGATE__KINETIC__PROTO__COMMAND__KEY_VALUE__INIT;
+    KeyValue.has_tag = true;
+    KeyValue.tag = (ProtobufCBinaryData) {.data = CheckTag, .len = sizeof(CheckTag)};
+    KeyValue.has_algorithm = true;
+    KeyValue.algorithm = COM__SEAGATE__KINETIC__PROTO__COMMAND__ALGORITHM__CRC32;
+    Entry = (KineticEntry) {
+        .value = ByteBuffer_Create(ValueData, sizeof(ValueData), 0),
+        .tag = ByteBuffer_Create(TagData, sizeof(TagData), 0),
+        .verifyTag = true,
+    };
+    Operation = (KineticOperation) {
+        .session = &Session,
+        .response = Response,
+        .entry = &Entry,
+    };
+}
+
+void tearDown(void)
+{
+    free(Response);
+}
+
+void test_KineticCallbacks_Get_should_deliver_a_value_matching_its_tag(void)
+{
+    KineticController_UnpackResponse_ExpectAndReturn(&Operation, true);
+    KineticResponse_GetKeyValue_ExpectAndReturn(Response, &KeyValue);
+
+    KineticStatus status = KineticCallbacks_Get(&Operation, KINETIC_STATUS_SUCCESS);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL(9, Entry.value.bytesUsed);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY("123456789", ValueData, 9);
+    TEST_ASSERT_EQUAL(1, Session.tagStats.verified);
+    TEST_ASSERT_EQUAL(9, Session.tagStats.bytes);
+}
+
+void test_KineticCallbacks_Get_should_return_TAG_MISMATCH_for_a_corrupt_value(void)
+{
+    Response->pdu[2 + 4] ^= 0x01;
+    KineticController_UnpackResponse_ExpectAndReturn(&Operation, true);
+    KineticResponse_GetKeyValue_ExpectAndReturn(Response, &KeyValue);
+
+    KineticStatus status = KineticCallbacks_Get(&Operation, KINETIC_STATUS_SUCCESS);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_TAG_MISMATCH, status);
+    TEST_ASSERT_EQUAL(0, Entry.value.bytesUsed);
+    TEST_ASSERT_EQUAL(0, Session.tagStats.verified);
+    TEST_ASSERT_EQUAL(1, Session.tagStats.mismatched);
+}
+
+void test_KineticCallbacks_Get_should_verify_if_enabled_for_the_session(void)
 {
-    TEST_IGNORE_MESSAGE("TODO: Test operation callbacks.");
+    Entry.verifyTag = false;
+    Session.config.verifyTags = true;
+    Response->pdu[2] ^= 0x01;
+    KineticController_UnpackResponse_ExpectAndReturn(&Operation, true);
+    KineticResponse_GetKeyValue_ExpectAndReturn(Response, &KeyValue);
+
+    KineticStatus status = KineticCallbacks_Get(&Operation, KINETIC_STATUS_SUCCESS);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_TAG_MISMATCH, status);
+}
+
+void test_KineticCallbacks_Get_should_not_verify_unless_requested(void)
+{
+    Entry.verifyTag = false;
+    Response->pdu[2] ^= 0x01;
+    KineticController_UnpackResponse_ExpectAndReturn(&Operation, true);
+    KineticResponse_GetKeyValue_ExpectAndReturn(Response, &KeyValue);
+
+    KineticStatus status = KineticCallbacks_Get(&Operation, KINETIC_STATUS_SUCCESS);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL(9, Entry.value.bytesUsed);
+    TEST_ASSERT_EQUAL(0, Session.tagStats.bytes);
+}
+
+void test_KineticCallbacks_Get_should_deliver_and_count_values_stored_without_a_tag(void)
+{
+    KeyValue.has_tag = false;
+    KeyValue.has_algorithm = false;
+    KineticController_UnpackResponse_ExpectAndReturn(&Operation, true);
+    KineticResponse_GetKeyValue_ExpectAndReturn(Response, &KeyValue);
+
+    KineticStatus status = KineticCallbacks_Get(&Operation, KINETIC_STATUS_SUCCESS);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL(9, Entry.value.bytesUsed);
+    TEST_ASSERT_EQUAL(1, Session.tagStats.skipped);
+}
+
+void test_KineticCallbacks_Get_should_fail_if_the_response_cannot_be_unpacked(void)
+{
+    KineticController_UnpackResponse_ExpectAndReturn(&Operation, false);
+
+    KineticStatus status = KineticCallbacks_Get(&Operation, KINETIC_STATUS_SUCCESS);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SOCKET_ERROR, status);
+    TEST_ASSERT_EQUAL(0, Entry.value.bytesUsed);
+}
+
+void test_KineticCallbacks_Get_should_not_unpack_the_response_of_a_failed_operation(void)
+{
+    KineticStatus status = KineticCallbacks_Get(&Operation, KINETIC_STATUS_NOT_FOUND);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_NOT_FOUND, status);
 }
 
 // void test_KineticBuilder_GetLogCallback_should_copy_returned_device_info_into_dynamically_allocated_info_structure(void)
@@ -19,6 +19,8 @@
 */
 
 #include "kinetic_client.h"
+#include "kinetic_trace.h"
+#include "kinetic_stats.h"
 #include "unity.h"
 #include "unity_helper.h"
 #include "kinetic.pb-c.h"
@@ -113,8 +115,10 @@ void test_KineticClient_Init_should_free_client_if_bus_init_fails(void)
 
 static void ConnectSession(void)
 {
-    KineticClient client;
-    client.bus = &MessageBus;
+    KineticClient client = {
+        .bus = &MessageBus,
+        .sessionsMutex = PTHREAD_MUTEX_INITIALIZER,
+    };
     HmacKey = ByteArray_CreateWithCString("some hmac key");
     KineticSessionConfig config = {
         .host = "localhost",
@@ -266,3 +270,93 @@ void test_KineticClient_GetTerminationStatus_should_delegate_to_session(void)
     KineticStatus status = KineticClient_GetTerminationStatus(&Session);
     TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_DATA_ERROR, status);
 }
+
+void test_KineticClient_GetTagStats_should_report_the_session_verification_counters(void)
+{
+    Session.tagStats = (KineticTagStats) {
+        .verified = 3, .mismatched = 1, .skipped = 2, .bytes = 4096, .nanoseconds = 1000,
+    };
+    KineticTagStats stats;
+
+    KineticStatus status = KineticClient_GetTagStats(&Session, &stats);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL(3, stats.verified);
+    TEST_ASSERT_EQUAL(1, stats.mismatched);
+    TEST_ASSERT_EQUAL(2, stats.skipped);
+    TEST_ASSERT_EQUAL(4096, stats.bytes);
+    TEST_ASSERT_EQUAL(1000, stats.nanoseconds);
+}
+
+void test_KineticClient_GetSessionStats_should_report_totals_and_counters_by_message_type(void)
+{
+    KineticStats_Record(&Session.stats, KINETIC_MESSAGE_TYPE_PUT, KINETIC_STATUS_SUCCESS, 1000, 4200, 60);
+    KineticStats_Record(&Session.stats, KINETIC_MESSAGE_TYPE_GET, KINETIC_STATUS_NOT_FOUND, 3000, 50, 70);
+    static KineticStats stats;
+
+    KineticStatus status = KineticClient_GetSessionStats(&Session, &stats, false);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL(2, stats.total.latency.count);
+    TEST_ASSERT_EQUAL(4000, stats.total.latency.sumNanoseconds);
+    TEST_ASSERT_EQUAL(3000, stats.total.latency.maxNanoseconds);
+    TEST_ASSERT_EQUAL(4250, stats.total.bytesSent);
+    TEST_ASSERT_EQUAL(130, stats.total.bytesReceived);
+    TEST_ASSERT_EQUAL(1, stats.byType[KINETIC_MESSAGE_TYPE_PUT].statusCounts[KINETIC_STATUS_SUCCESS]);
+    TEST_ASSERT_EQUAL(1, stats.byType[KINETIC_MESSAGE_TYPE_GET].statusCounts[KINETIC_STATUS_NOT_FOUND]);
+    TEST_ASSERT_EQUAL(0, stats.byType[KINETIC_MESSAGE_TYPE_DELETE].latency.count);
+}
+
+void test_KineticClient_GetSessionStats_should_zero_the_counters_upon_reset(void)
+{
+    KineticStats_Record(&Session.stats, KINETIC_MESSAGE_TYPE_PUT, KINETIC_STATUS_SUCCESS, 1000, 4200, 60);
+    static KineticStats stats;
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, KineticClient_GetSessionStats(&Session, &stats, true));
+    TEST_ASSERT_EQUAL(1, stats.total.latency.count);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, KineticClient_GetSessionStats(&Session, &stats, false));
+    TEST_ASSERT_EQUAL(0, stats.total.latency.count);
+    TEST_ASSERT_EQUAL(0, stats.total.latency.maxNanoseconds);
+}
+
+void test_KineticClient_GetStats_should_include_live_and_destroyed_sessions(void)
+{
+    static KineticClient client;
+    static KineticSession other;
+    memset(&client, 0, sizeof(client));
+    memset(&other, 0, sizeof(other));
+    pthread_mutex_init(&client.sessionsMutex, NULL);
+    Session.client = &client;
+    other.client = &client;
+    other.nextSession = &Session;
+    client.sessions = &other;
+    KineticStats_Record(&Session.stats, KINETIC_MESSAGE_TYPE_PUT, KINETIC_STATUS_SUCCESS, 1000, 10, 1);
+    KineticStats_Record(&other.stats, KINETIC_MESSAGE_TYPE_PUT, KINETIC_STATUS_SUCCESS, 2000, 20, 2);
+
+    KineticSession_Disconnect_ExpectAndReturn(&other, KINETIC_STATUS_SUCCESS);
+    KineticSession_Destroy_ExpectAndReturn(&other, KINETIC_STATUS_SUCCESS);
+    KineticClient_DestroySession(&other);
+    TEST_ASSERT_EQUAL_PTR(&Session, client.sessions);
+
+    static KineticStats stats;
+    KineticStatus status = KineticClient_GetStats(&client, &stats, false);
+
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL(2, stats.byType[KINETIC_MESSAGE_TYPE_PUT].latency.count);
+    TEST_ASSERT_EQUAL(30, stats.total.bytesSent);
+    TEST_ASSERT_EQUAL(2000, stats.total.latency.maxNanoseconds);
+    pthread_mutex_destroy(&client.sessionsMutex);
+}
+
+void test_KineticClient_GetStats_should_reject_a_NULL_client(void)
+{
+    static KineticStats stats;
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_INVALID_REQUEST, KineticClient_GetStats(NULL, &stats, false));
+}
+
+void test_KineticClient_GetTagStats_should_reject_a_NULL_session(void)
+{
+    KineticTagStats stats;
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_SESSION_INVALID, KineticClient_GetTagStats(NULL, &stats));
+}
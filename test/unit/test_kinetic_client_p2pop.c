@@ -19,6 +19,8 @@
 *
 */
 #include "kinetic_client.h"
+#include "kinetic_trace.h"
+#include "kinetic_stats.h"
 #include "kinetic_types.h"
 #include "kinetic_types_internal.h"
 #include "mock_kinetic_session.h"
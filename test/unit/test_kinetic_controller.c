@@ -31,11 +31,13 @@
 #include "mock_kinetic_operation.h"
 #include "mock_kinetic_allocator.h"
 #include "mock_kinetic_resourcewaiter.h"
+#include "mock_kinetic_auth.h"
 #include <pthread.h>
 
 void setUp(void)
 {
-    KineticLogger_Init("stdout", 3);
+    // Below level 3, so responses are not unpacked just to log them
+    KineticLogger_Init("stdout", 2);
 }
 
 void tearDown(void)
@@ -117,3 +119,155 @@ void test_KineticController_ExecuteOperation_should_carry_out_an_operation_with_
 
     TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_OPERATION_INVALID, status);
 }
+
+static Com__Seagate__Kinetic__Proto__Command__Header ResponseHeader;
+static Com__Seagate__Kinetic__Proto__Command ResponseCommand;
+
+static void init_response(KineticResponse* response)
+{
+    ResponseHeader = (Com__Seagate__Kinetic__Proto__Command__Header) {.acksequence = 1};
+    ResponseCommand = (Com__Seagate__Kinetic__Proto__Command) {.header = &ResponseHeader};
+    *response = (KineticResponse) {.command = &ResponseCommand};
+}
+
+void test_KineticController_HandleResult_should_validate_the_response_HMAC_when_enabled(void)
+{
+    KineticSession session = {.config = {.verifyResponseHmac = true}};
+    KineticRequest request;
+    KineticOperation operation = {.session = &session, .request = &request};
+    KineticResponse response;
+    init_response(&response);
+    bus_msg_result_t result = {.status = BUS_SEND_SUCCESS, .u.response.opaque_msg = &response};
+
+    KineticResponse_GetStatus_ExpectAndReturn(&response, KINETIC_STATUS_SUCCESS);
+    KineticResponse_GetProtobufLength_IgnoreAndReturn(0);
+    KineticResponse_GetValueLength_IgnoreAndReturn(0);
+    KineticResponse_Unpack_ExpectAndReturn(&response, true);
+    KineticAuth_ValidateResponse_ExpectAndReturn(&session.hmacKeySchedule, &response, KINETIC_STATUS_SUCCESS);
+    KineticOperation_Complete_Expect(&operation, KINETIC_STATUS_SUCCESS);
+
+    KineticController_HandleResult(&result, &operation);
+
+    TEST_ASSERT_EQUAL_PTR(&response, operation.response);
+    TEST_ASSERT_EQUAL(1, session.responseAuthStats.validated);
+    TEST_ASSERT_EQUAL(0, session.responseAuthStats.failed);
+}
+
+void test_KineticController_HandleResult_should_fail_the_operation_if_the_response_HMAC_is_invalid(void)
+{
+    KineticSession session = {.config = {.verifyResponseHmac = true}};
+    KineticRequest request;
+    KineticOperation operation = {.session = &session, .request = &request};
+    KineticResponse response;
+    init_response(&response);
+    bus_msg_result_t result = {.status = BUS_SEND_SUCCESS, .u.response.opaque_msg = &response};
+
+    KineticResponse_GetStatus_ExpectAndReturn(&response, KINETIC_STATUS_SUCCESS);
+    KineticResponse_GetProtobufLength_IgnoreAndReturn(0);
+    KineticResponse_GetValueLength_IgnoreAndReturn(0);
+    KineticResponse_Unpack_ExpectAndReturn(&response, true);
+    KineticAuth_ValidateResponse_ExpectAndReturn(&session.hmacKeySchedule, &response, KINETIC_STATUS_HMAC_FAILURE);
+    KineticOperation_Complete_Expect(&operation, KINETIC_STATUS_HMAC_FAILURE);
+
+    KineticController_HandleResult(&result, &operation);
+
+    // The response is still attached so that it is freed with the operation
+    TEST_ASSERT_EQUAL_PTR(&response, operation.response);
+    TEST_ASSERT_EQUAL(0, session.responseAuthStats.validated);
+    TEST_ASSERT_EQUAL(1, session.responseAuthStats.failed);
+}
+
+void test_KineticController_HandleResult_should_fail_the_operation_if_the_response_cannot_be_unpacked_for_HMAC_validation(void)
+{
+    KineticSession session = {.config = {.verifyResponseHmac = true}};
+    KineticRequest request;
+    KineticOperation operation = {.session = &session, .request = &request};
+    KineticResponse response;
+    init_response(&response);
+    bus_msg_result_t result = {.status = BUS_SEND_SUCCESS, .u.response.opaque_msg = &response};
+
+    KineticResponse_GetStatus_ExpectAndReturn(&response, KINETIC_STATUS_SUCCESS);
+    KineticResponse_GetProtobufLength_IgnoreAndReturn(0);
+    KineticResponse_GetValueLength_IgnoreAndReturn(0);
+    KineticResponse_Unpack_ExpectAndReturn(&response, false);
+    KineticOperation_Complete_Expect(&operation, KINETIC_STATUS_SOCKET_ERROR);
+
+    KineticController_HandleResult(&result, &operation);
+
+    // The response is still attached so that it is freed with the operation
+    TEST_ASSERT_EQUAL_PTR(&response, operation.response);
+    TEST_ASSERT_EQUAL(0, session.responseAuthStats.validated);
+}
+
+void test_KineticController_HandleResult_should_not_validate_responses_to_PIN_operations(void)
+{
+    KineticSession session = {.config = {.verifyResponseHmac = true}};
+    ByteArray pin = ByteArray_CreateWithCString("1234");
+    KineticRequest request;
+    KineticOperation operation = {.session = &session, .request = &request, .pin = &pin};
+    KineticResponse response;
+    init_response(&response);
+    bus_msg_result_t result = {.status = BUS_SEND_SUCCESS, .u.response.opaque_msg = &response};
+
+    KineticResponse_GetStatus_ExpectAndReturn(&response, KINETIC_STATUS_SUCCESS);
+    KineticResponse_GetProtobufLength_IgnoreAndReturn(0);
+    KineticResponse_GetValueLength_IgnoreAndReturn(0);
+    KineticOperation_Complete_Expect(&operation, KINETIC_STATUS_SUCCESS);
+
+    KineticController_HandleResult(&result, &operation);
+
+    TEST_ASSERT_EQUAL(0, session.responseAuthStats.validated);
+}
+
+void test_KineticController_HandleResult_should_not_validate_the_response_HMAC_by_default(void)
+{
+    KineticSession session = {.connected = true};
+    KineticRequest request;
+    KineticOperation operation = {.session = &session, .request = &request};
+    KineticResponse response;
+    init_response(&response);
+    bus_msg_result_t result = {.status = BUS_SEND_SUCCESS, .u.response.opaque_msg = &response};
+
+    KineticResponse_GetStatus_ExpectAndReturn(&response, KINETIC_STATUS_NOT_FOUND);
+    KineticResponse_GetProtobufLength_IgnoreAndReturn(0);
+    KineticResponse_GetValueLength_IgnoreAndReturn(0);
+    KineticOperation_Complete_Expect(&operation, KINETIC_STATUS_NOT_FOUND);
+
+    KineticController_HandleResult(&result, &operation);
+
+    TEST_ASSERT_EQUAL(0, session.responseAuthStats.validated);
+    TEST_ASSERT_EQUAL(0, session.responseAuthStats.failed);
+}
+
+void test_KineticController_HandleResult_should_copy_the_bus_stage_timestamps_to_the_operation(void)
+{
+    KineticSession session = {.connected = true};
+    KineticRequest request;
+    KineticOperation operation = {.session = &session, .request = &request,
+        .timestamps = {.submitted = 100, .sendTurn = 200, .throttled = 300}};
+    KineticResponse response;
+    init_response(&response);
+    bus_msg_result_t result = {
+        .status = BUS_SEND_SUCCESS,
+        .u.response.opaque_msg = &response,
+        .sent_ns = 400,
+        .received_ns = 500,
+        .queued_ns = 600,
+        .dequeued_ns = 700,
+    };
+
+    KineticResponse_GetStatus_ExpectAndReturn(&response, KINETIC_STATUS_SUCCESS);
+    KineticResponse_GetProtobufLength_IgnoreAndReturn(0);
+    KineticResponse_GetValueLength_IgnoreAndReturn(0);
+    KineticOperation_Complete_Expect(&operation, KINETIC_STATUS_SUCCESS);
+
+    KineticController_HandleResult(&result, &operation);
+
+    TEST_ASSERT_EQUAL(100, operation.timestamps.submitted);
+    TEST_ASSERT_EQUAL(200, operation.timestamps.sendTurn);
+    TEST_ASSERT_EQUAL(300, operation.timestamps.throttled);
+    TEST_ASSERT_EQUAL(400, operation.timestamps.sent);
+    TEST_ASSERT_EQUAL(500, operation.timestamps.received);
+    TEST_ASSERT_EQUAL(600, operation.timestamps.queued);
+    TEST_ASSERT_EQUAL(700, operation.timestamps.dequeued);
+}
@@ -0,0 +1,240 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "unity.h"
+#include "unity_helper.h"
+#include "protobuf-c/protobuf-c.h"
+#include "kinetic.pb-c.h"
+#include "kinetic_encoder.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_ITERATIONS (10000)
+
+static Com__Seagate__Kinetic__Proto__Command Command;
+static Com__Seagate__Kinetic__Proto__Command__Header Header;
+static Com__Seagate__Kinetic__Proto__Command__Body Body;
+static Com__Seagate__Kinetic__Proto__Command__KeyValue KeyValue;
+static uint8_t FieldData[4][512];
+
+static uint8_t Expected[4096];
+static uint8_t Actual[4096];
+
+void setUp(void)
+{
+    com__seagate__kinetic__proto__command__init(&Command);
+    com__seagate__kinetic__proto__command__header__init(&Header);
+    com__seagate__kinetic__proto__command__body__init(&Body);
+    com__seagate__kinetic__proto__command__key_value__init(&KeyValue);
+    Command.header = &Header;
+}
+
+void tearDown(void)
+{
+}
+
+static void assert_matches_protobuf_c(void)
+{
+    KineticEncoderSizes sizes;
+    TEST_ASSERT_TRUE(KineticEncoder_SizeCommand(&Command, &sizes));
+
+    size_t expectedLen = com__seagate__kinetic__proto__command__get_packed_size(&Command);
+    TEST_ASSERT_EQUAL(expectedLen, sizes.command);
+    TEST_ASSERT_TRUE(expectedLen <= sizeof(Expected));
+
+    memset(Expected, 0xa5, sizeof(Expected));
+    memset(Actual, 0x5a, sizeof(Actual));
+    TEST_ASSERT_EQUAL(expectedLen, com__seagate__kinetic__proto__command__pack(&Command, Expected));
+    TEST_ASSERT_EQUAL(expectedLen, KineticEncoder_PackCommand(&Command, &sizes, Actual));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(Expected, Actual, expectedLen);
+}
+
+static int64_t random_int64(void)
+{
+    // Mix small, large and negative values to exercise every varint length
+    switch (rand() % 4) {
+    case 0: return rand() % 128;
+    case 1: return rand();
+    case 2: return -(int64_t)(rand() % 1000) - 1;
+    default: return ((int64_t)rand() << 32) | (int64_t)rand();
+    }
+}
+
+static void random_bytes(protobuf_c_boolean* has, ProtobufCBinaryData* bytes, uint8_t* buf)
+{
+    *has = rand() % 2;
+    size_t len = 0;
+    switch (rand() % 3) {
+    case 0: len = 0; break;
+    case 1: len = rand() % 127; break;
+    default: len = rand() % 512; break;
+    }
+    for (size_t i = 0; i < len; i++) { buf[i] = (uint8_t)rand(); }
+    *bytes = (ProtobufCBinaryData) {.data = buf, .len = len};
+}
+
+static void randomize_command(void)
+{
+    static const Com__Seagate__Kinetic__Proto__Command__MessageType types[] = {
+        COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET,
+        COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETNEXT,
+        COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETPREVIOUS,
+        COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PUT,
+        COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__DELETE,
+        COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__NOOP,
+    };
+
+    setUp();
+    Header.has_messagetype = true;
+    Header.messagetype = types[rand() % (sizeof(types) / sizeof(types[0]))];
+    Header.has_clusterversion = rand() % 2;
+    Header.clusterversion = random_int64();
+    Header.has_connectionid = rand() % 2;
+    Header.connectionid = random_int64();
+    Header.has_sequence = rand() % 2;
+    Header.sequence = random_int64();
+    Header.has_acksequence = rand() % 2;
+    Header.acksequence = random_int64();
+    Header.has_timeout = rand() % 2;
+    Header.timeout = random_int64();
+    Header.has_earlyexit = rand() % 2;
+    Header.earlyexit = rand() % 2;
+    Header.has_priority = rand() % 2;
+    Header.priority = (Com__Seagate__Kinetic__Proto__Command__Priority)(rand() % 11);
+    Header.has_timequanta = rand() % 2;
+    Header.timequanta = random_int64();
+
+    switch (rand() % 3) {
+    case 0: return;  // no body, like NOOP
+    case 1: Command.body = &Body; return;  // empty body
+    default: break;
+    }
+    Command.body = &Body;
+    Body.keyvalue = &KeyValue;
+    random_bytes(&KeyValue.has_newversion, &KeyValue.newversion, FieldData[0]);
+    random_bytes(&KeyValue.has_key, &KeyValue.key, FieldData[1]);
+    random_bytes(&KeyValue.has_dbversion, &KeyValue.dbversion, FieldData[2]);
+    random_bytes(&KeyValue.has_tag, &KeyValue.tag, FieldData[3]);
+    KeyValue.has_algorithm = rand() % 2;
+    KeyValue.algorithm = (Com__Seagate__Kinetic__Proto__Command__Algorithm)(rand() % 7) - 1;
+    KeyValue.has_metadataonly = rand() % 2;
+    KeyValue.metadataonly = rand() % 2;
+    KeyValue.has_force = rand() % 2;
+    KeyValue.force = rand() % 2;
+    KeyValue.has_synchronization = rand() % 2;
+    KeyValue.synchronization = (Com__Seagate__Kinetic__Proto__Command__Synchronization)(rand() % 4) - 1;
+}
+
+void test_KineticEncoder_VarintSize_should_count_7_bit_groups(void)
+{
+    TEST_ASSERT_EQUAL(1, KineticEncoder_VarintSize(0));
+    TEST_ASSERT_EQUAL(1, KineticEncoder_VarintSize(127));
+    TEST_ASSERT_EQUAL(2, KineticEncoder_VarintSize(128));
+    TEST_ASSERT_EQUAL(2, KineticEncoder_VarintSize(16383));
+    TEST_ASSERT_EQUAL(3, KineticEncoder_VarintSize(16384));
+    TEST_ASSERT_EQUAL(10, KineticEncoder_VarintSize((uint64_t)-1));
+}
+
+void test_KineticEncoder_PutVarint_should_emit_little_endian_base_128(void)
+{
+    uint8_t buf[10];
+    TEST_ASSERT_EQUAL(2, KineticEncoder_PutVarint(buf, 300));
+    TEST_ASSERT_EQUAL_HEX8(0xac, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, buf[1]);
+}
+
+void test_KineticEncoder_SizeCommand_should_reject_commands_it_does_not_specialize(void)
+{
+    KineticEncoderSizes sizes;
+
+    Command.header = NULL;
+    TEST_ASSERT_FALSE(KineticEncoder_SizeCommand(&Command, &sizes));
+
+    Command.header = &Header;
+    Header.has_messagetype = false;
+    TEST_ASSERT_FALSE(KineticEncoder_SizeCommand(&Command, &sizes));
+
+    Header.has_messagetype = true;
+    Header.messagetype = COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETKEYRANGE;
+    TEST_ASSERT_FALSE(KineticEncoder_SizeCommand(&Command, &sizes));
+
+    Header.messagetype = COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET;
+    Com__Seagate__Kinetic__Proto__Command__Range range;
+    com__seagate__kinetic__proto__command__range__init(&range);
+    Command.body = &Body;
+    Body.range = &range;
+    TEST_ASSERT_FALSE(KineticEncoder_SizeCommand(&Command, &sizes));
+
+    Body.range = NULL;
+    Com__Seagate__Kinetic__Proto__Command__Status status;
+    com__seagate__kinetic__proto__command__status__init(&status);
+    Command.status = &status;
+    TEST_ASSERT_FALSE(KineticEncoder_SizeCommand(&Command, &sizes));
+}
+
+void test_KineticEncoder_should_match_protobuf_c_for_a_NOOP(void)
+{
+    Header.has_clusterversion = true;
+    Header.clusterversion = 0;
+    Header.has_connectionid = true;
+    Header.connectionid = 1234567890123LL;
+    Header.has_sequence = true;
+    Header.sequence = 42;
+    Header.has_messagetype = true;
+    Header.messagetype = COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__NOOP;
+
+    assert_matches_protobuf_c();
+}
+
+void test_KineticEncoder_should_match_protobuf_c_for_a_PUT(void)
+{
+    uint8_t value[300];
+    memset(value, 'k', sizeof(value));
+
+    Header.has_sequence = true;
+    Header.sequence = 7;
+    Header.has_messagetype = true;
+    Header.messagetype = COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PUT;
+    Command.body = &Body;
+    Body.keyvalue = &KeyValue;
+    KeyValue.has_key = true;
+    KeyValue.key = (ProtobufCBinaryData) {.data = value, .len = sizeof(value)};
+    KeyValue.has_newversion = true;
+    KeyValue.newversion = (ProtobufCBinaryData) {.data = (uint8_t*)"v2", .len = 2};
+    KeyValue.has_tag = true;
+    KeyValue.tag = (ProtobufCBinaryData) {.data = (uint8_t*)"tag", .len = 3};
+    KeyValue.has_algorithm = true;
+    KeyValue.algorithm = COM__SEAGATE__KINETIC__PROTO__COMMAND__ALGORITHM__SHA1;
+    KeyValue.has_synchronization = true;
+    KeyValue.synchronization = COM__SEAGATE__KINETIC__PROTO__COMMAND__SYNCHRONIZATION__WRITEBACK;
+    KeyValue.has_force = true;
+    KeyValue.force = true;
+
+    assert_matches_protobuf_c();
+}
+
+void test_KineticEncoder_should_match_protobuf_c_for_random_commands(void)
+{
+    srand(0x5eed);
+    for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+        randomize_command();
+        assert_matches_protobuf_c();
+    }
+}
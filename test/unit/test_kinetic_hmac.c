@@ -21,6 +21,7 @@
 #include "unity_helper.h"
 #include "kinetic.pb-c.h"
 #include "kinetic_hmac.h"
+#include "kinetic_hmac_batch.h"
 #include "kinetic_nbo.h"
 #include "kinetic_message.h"
 #include "kinetic_logger.h"
@@ -31,13 +32,22 @@
 #include <string.h>
 #include <openssl/hmac.h>
 
+static KineticHMACKey Key;
+static KineticHMACBatchSigner Signer;
+
 void setUp(void)
 {
     KineticLogger_Init("stdout", 3);
+    TEST_ASSERT_TRUE(KineticHMAC_InitKey(&Key, ByteArray_CreateWithCString("1234567890ABCDEFGHIJK")));
 }
 
 void tearDown(void)
 {
+    KineticHMAC_DestroyKey(&Key);
+    if (Key.signer != NULL) {
+        KineticHMACBatch_DestroySigner(Key.signer);
+        Key.signer = NULL;
+    }
     KineticLogger_Close();
 }
 
@@ -87,7 +97,6 @@ void test_KineticHMAC_Populate_should_compute_and_populate_the_SHA1_HMAC_for_the
     Com__Seagate__Kinetic__Proto__Message__HMACauth hmacAuth = COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
     uint8_t data[KINETIC_HMAC_MAX_LEN];
     ProtobufCBinaryData hmac = {.len = KINETIC_HMAC_MAX_LEN, .data = data};
-    const ByteArray key = ByteArray_CreateWithCString("1234567890ABCDEFGHIJK");
     uint8_t commandBytes[123];
     ByteArray commandArray = ByteArray_Create(commandBytes, sizeof(commandBytes));
     ByteArray_FillWithDummyData(commandArray);
@@ -102,7 +111,7 @@ void test_KineticHMAC_Populate_should_compute_and_populate_the_SHA1_HMAC_for_the
     msg.hmacauth = &hmacAuth;
 
     KineticHMAC_Init(&actual, COM__SEAGATE__KINETIC__PROTO__COMMAND__SECURITY__ACL__HMACALGORITHM__HmacSHA1);
-    KineticHMAC_Populate(&actual, &msg, key);
+    KineticHMAC_Populate(&actual, &msg, &Key);
 
     TEST_ASSERT_TRUE(msg.hmacauth->has_hmac);
     TEST_ASSERT_EQUAL_PTR(hmac.data, msg.hmacauth->hmac.data);
@@ -131,7 +140,6 @@ void test_KineticHMAC_Validate_should_return_true_if_the_HMAC_for_the_supplied_m
     Com__Seagate__Kinetic__Proto__Message__HMACauth hmacAuth = COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
     uint8_t data[KINETIC_HMAC_MAX_LEN];
     ProtobufCBinaryData hmac = {.len = KINETIC_HMAC_MAX_LEN, .data = data};
-    const ByteArray key = ByteArray_CreateWithCString("1234567890ABCDEFGHIJK");
     proto.has_commandbytes = true;
     uint8_t packedCmd[128];
     size_t packedLen = com__seagate__kinetic__proto__command__pack(&command, packedCmd);
@@ -145,9 +153,9 @@ void test_KineticHMAC_Validate_should_return_true_if_the_HMAC_for_the_supplied_m
     proto.has_authtype = true;
 
     KineticHMAC_Init(&actual, COM__SEAGATE__KINETIC__PROTO__COMMAND__SECURITY__ACL__HMACALGORITHM__HmacSHA1);
-    KineticHMAC_Populate(&actual, &proto, key);
+    KineticHMAC_Populate(&actual, &proto, &Key);
 
-    TEST_ASSERT_TRUE(KineticHMAC_Validate(&proto, key));
+    TEST_ASSERT_TRUE(KineticHMAC_Validate(&proto, &Key));
 }
 
 void test_KineticHMAC_Validate_should_return_false_if_the_HMAC_value_of_the_supplied_message_and_key_is_incorrect(void)
@@ -162,7 +170,6 @@ void test_KineticHMAC_Validate_should_return_false_if_the_HMAC_value_of_the_supp
     Com__Seagate__Kinetic__Proto__Message__HMACauth hmacAuth = COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
     uint8_t data[KINETIC_HMAC_MAX_LEN];
     ProtobufCBinaryData hmac = {.len = KINETIC_HMAC_MAX_LEN, .data = data};
-    const ByteArray key = ByteArray_CreateWithCString("1234567890ABCDEFGHIJK");
     proto.has_commandbytes = true;
     uint8_t packedCmd[128];
     size_t packedLen = com__seagate__kinetic__proto__command__pack(&command, packedCmd);
@@ -176,14 +183,14 @@ void test_KineticHMAC_Validate_should_return_false_if_the_HMAC_value_of_the_supp
     proto.has_authtype = true;
 
     KineticHMAC_Init(&actual, COM__SEAGATE__KINETIC__PROTO__COMMAND__SECURITY__ACL__HMACALGORITHM__HmacSHA1);
-    KineticHMAC_Populate(&actual, &proto, key);
+    KineticHMAC_Populate(&actual, &proto, &Key);
 
-    TEST_ASSERT_TRUE(KineticHMAC_Validate(&proto, key));
+    TEST_ASSERT_TRUE(KineticHMAC_Validate(&proto, &Key));
 
     // Bork the HMAC
     hmacAuth.hmac.data[3]++;
 
-    TEST_ASSERT_FALSE(KineticHMAC_Validate(&proto, key));
+    TEST_ASSERT_FALSE(KineticHMAC_Validate(&proto, &Key));
 }
 
 void test_KineticHMAC_Validate_should_return_false_if_the_HMAC_length_of_the_supplied_message_and_key_is_incorrect(void)
@@ -198,7 +205,6 @@ void test_KineticHMAC_Validate_should_return_false_if_the_HMAC_length_of_the_sup
     Com__Seagate__Kinetic__Proto__Message__HMACauth hmacAuth = COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
     uint8_t data[KINETIC_HMAC_MAX_LEN];
     ProtobufCBinaryData hmac = {.len = KINETIC_HMAC_MAX_LEN, .data = data};
-    const ByteArray key = ByteArray_CreateWithCString("1234567890ABCDEFGHIJK");
     proto.has_commandbytes = true;
     uint8_t packedCmd[128];
     size_t packedLen = com__seagate__kinetic__proto__command__pack(&command, packedCmd);
@@ -212,14 +218,14 @@ void test_KineticHMAC_Validate_should_return_false_if_the_HMAC_length_of_the_sup
     proto.has_authtype = true;
 
     KineticHMAC_Init(&actual, COM__SEAGATE__KINETIC__PROTO__COMMAND__SECURITY__ACL__HMACALGORITHM__HmacSHA1);
-    KineticHMAC_Populate(&actual, &proto, key);
+    KineticHMAC_Populate(&actual, &proto, &Key);
 
-    TEST_ASSERT_TRUE(KineticHMAC_Validate(&proto, key));
+    TEST_ASSERT_TRUE(KineticHMAC_Validate(&proto, &Key));
 
     // Bork the HMAC
     hmacAuth.hmac.len--;
 
-    TEST_ASSERT_FALSE(KineticHMAC_Validate(&proto, key));
+    TEST_ASSERT_FALSE(KineticHMAC_Validate(&proto, &Key));
 }
 
 void test_KineticHMAC_Validate_should_return_false_if_the_HMAC_presence_is_false_for_the_supplied_message_and_key_is_incorrect(void)
@@ -234,7 +240,6 @@ void test_KineticHMAC_Validate_should_return_false_if_the_HMAC_presence_is_false
     Com__Seagate__Kinetic__Proto__Message__HMACauth hmacAuth = COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
     uint8_t data[KINETIC_HMAC_MAX_LEN];
     ProtobufCBinaryData hmac = {.len = KINETIC_HMAC_MAX_LEN, .data = data};
-    const ByteArray key = ByteArray_CreateWithCString("1234567890ABCDEFGHIJK");
     proto.has_commandbytes = true;
     uint8_t packedCmd[128];
     size_t packedLen = com__seagate__kinetic__proto__command__pack(&command, packedCmd);
@@ -248,12 +253,100 @@ void test_KineticHMAC_Validate_should_return_false_if_the_HMAC_presence_is_false
     proto.has_authtype = true;
 
     KineticHMAC_Init(&actual, COM__SEAGATE__KINETIC__PROTO__COMMAND__SECURITY__ACL__HMACALGORITHM__HmacSHA1);
-    KineticHMAC_Populate(&actual, &proto, key);
+    KineticHMAC_Populate(&actual, &proto, &Key);
 
-    TEST_ASSERT_TRUE(KineticHMAC_Validate(&proto, key));
+    TEST_ASSERT_TRUE(KineticHMAC_Validate(&proto, &Key));
 
     // Bork the HMAC
     hmacAuth.has_hmac = false;
 
-    TEST_ASSERT_FALSE(KineticHMAC_Validate(&proto, key));
+    TEST_ASSERT_FALSE(KineticHMAC_Validate(&proto, &Key));
+}
+
+static void populate_tag(const KineticHMACKey* key, uint8_t* tag)
+{
+    uint8_t commandBytes[] = "command bytes";
+    Com__Seagate__Kinetic__Proto__Message msg = COM__SEAGATE__KINETIC__PROTO__MESSAGE__INIT;
+    Com__Seagate__Kinetic__Proto__Message__HMACauth hmacAuth = COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
+    msg.commandbytes = (ProtobufCBinaryData){.data = commandBytes, .len = sizeof(commandBytes) - 1};
+    msg.has_commandbytes = true;
+    hmacAuth.hmac = (ProtobufCBinaryData){.data = tag, .len = KINETIC_HMAC_SHA1_LEN};
+    msg.hmacauth = &hmacAuth;
+
+    KineticHMAC actual;
+    TEST_ASSERT_TRUE(KineticHMAC_Populate(&actual, &msg, key));
+    TEST_ASSERT_EQUAL(KINETIC_HMAC_SHA1_LEN, actual.len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(actual.data, tag, KINETIC_HMAC_SHA1_LEN);
+}
+
+void test_KineticHMAC_Populate_should_sign_the_length_prefixed_command_with_the_key_schedule(void)
+{
+    // HMAC-SHA1(key, htonl(len) || commandBytes)
+    const uint8_t expected[KINETIC_HMAC_SHA1_LEN] = {
+        0x41, 0xac, 0x62, 0xac, 0x66, 0x12, 0xb2, 0x41, 0xcd, 0x4b,
+        0x9d, 0x45, 0x4c, 0x55, 0xab, 0x54, 0x4f, 0x59, 0xa1, 0x08};
+    uint8_t tag[KINETIC_HMAC_SHA1_LEN];
+
+    populate_tag(&Key, tag);
+
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, tag, sizeof(expected));
+}
+
+void test_KineticHMAC_InitKey_should_hash_keys_longer_than_a_block(void)
+{
+    const uint8_t expected[KINETIC_HMAC_SHA1_LEN] = {
+        0x3d, 0xad, 0xde, 0x2b, 0xbd, 0x94, 0x78, 0x5c, 0xdc, 0x44,
+        0xe7, 0xec, 0x47, 0x9a, 0xc6, 0x02, 0x4f, 0x0d, 0xa9, 0xec};
+    uint8_t keyData[100];
+    for (size_t i = 0; i < sizeof(keyData); i++) {
+        keyData[i] = (uint8_t)i;
+    }
+    KineticHMACKey longKey;
+    TEST_ASSERT_TRUE(KineticHMAC_InitKey(&longKey, ByteArray_Create(keyData, sizeof(keyData))));
+    uint8_t tag[KINETIC_HMAC_SHA1_LEN];
+
+    populate_tag(&longKey, tag);
+    KineticHMAC_DestroyKey(&longKey);
+
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, tag, sizeof(expected));
+    TEST_ASSERT_NULL(longKey.inner);
+    TEST_ASSERT_NULL(longKey.outer);
+}
+
+void test_KineticHMAC_Populate_should_sign_through_the_batch_signer_if_the_key_is_batched(void)
+{
+    const uint8_t expected[KINETIC_HMAC_SHA1_LEN] = {
+        0x41, 0xac, 0x62, 0xac, 0x66, 0x12, 0xb2, 0x41, 0xcd, 0x4b,
+        0x9d, 0x45, 0x4c, 0x55, 0xab, 0x54, 0x4f, 0x59, 0xa1, 0x08};
+    uint8_t tag[KINETIC_HMAC_SHA1_LEN];
+    TEST_ASSERT_TRUE(KineticHMACBatch_InitSigner(&Signer));
+    Key.signer = &Signer;
+
+    populate_tag(&Key, tag);
+
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, tag, sizeof(expected));
+}
+
+void test_KineticHMAC_Validate_should_validate_messages_for_a_batched_key(void)
+{
+    uint8_t commandBytes[] = "command bytes";
+    uint8_t tag[KINETIC_HMAC_SHA1_LEN];
+    Com__Seagate__Kinetic__Proto__Message msg = COM__SEAGATE__KINETIC__PROTO__MESSAGE__INIT;
+    Com__Seagate__Kinetic__Proto__Message__HMACauth hmacAuth = COM__SEAGATE__KINETIC__PROTO__MESSAGE__HMACAUTH__INIT;
+    msg.commandbytes = (ProtobufCBinaryData){.data = commandBytes, .len = sizeof(commandBytes) - 1};
+    msg.has_commandbytes = true;
+    msg.authtype = COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__HMACAUTH;
+    msg.has_authtype = true;
+    hmacAuth.hmac = (ProtobufCBinaryData){.data = tag, .len = KINETIC_HMAC_SHA1_LEN};
+    msg.hmacauth = &hmacAuth;
+    KineticHMAC hmac;
+    TEST_ASSERT_TRUE(KineticHMAC_Populate(&hmac, &msg, &Key));
+
+    // Validation bypasses the signer, so a busy one doesn't hold it up
+    TEST_ASSERT_TRUE(KineticHMACBatch_InitSigner(&Signer));
+    Signer.busy = true;
+    Key.signer = &Signer;
+    TEST_ASSERT_TRUE(KineticHMAC_Validate(&msg, &Key));
+    TEST_ASSERT_NULL(Signer.pending);
+    Signer.busy = false;
 }
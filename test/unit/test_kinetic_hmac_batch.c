@@ -0,0 +1,195 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "unity.h"
+#include "unity_helper.h"
+#include "kinetic_hmac_batch.h"
+#include "kinetic_hmac.h"
+#include "kinetic_nbo.h"
+#include "kinetic_logger.h"
+#include "kinetic_types.h"
+#include "kinetic_types_internal.h"
+#include "byte_array.h"
+#include <string.h>
+#include <pthread.h>
+#include <openssl/hmac.h>
+
+#define NUM_KEYS (3)
+#define MAX_DATA_LEN (4200)
+
+static const char* const EngineNames[] = {"openssl", "sse2", "avx2", "avx512", "simd"};
+static uint8_t KeyData[NUM_KEYS][100];
+static const size_t KeyLen[NUM_KEYS] = {21, 64, 100};
+static KineticHMACKey Keys[NUM_KEYS];
+static uint8_t Data[KINETIC_HMAC_BATCH_MAX + 3][MAX_DATA_LEN];
+static const char* DefaultEngine;
+static KineticHMACBatchSigner Signer;
+
+void setUp(void)
+{
+    KineticLogger_Init("stdout", 3);
+    DefaultEngine = KineticHMACBatch_EngineName();
+    TEST_ASSERT_TRUE(KineticHMACBatch_InitSigner(&Signer));
+    for (int k = 0; k < NUM_KEYS; k++) {
+        for (size_t i = 0; i < sizeof(KeyData[k]); i++) {
+            KeyData[k][i] = (uint8_t)(i * 7 + k);
+        }
+        TEST_ASSERT_TRUE(KineticHMAC_InitKey(&Keys[k], ByteArray_Create(KeyData[k], KeyLen[k])));
+    }
+    for (size_t j = 0; j < NUM_ELEMENTS(Data); j++) {
+        for (size_t i = 0; i < MAX_DATA_LEN; i++) {
+            Data[j][i] = (uint8_t)(i * 13 + j * 5);
+        }
+    }
+}
+
+void tearDown(void)
+{
+    TEST_ASSERT_TRUE(KineticHMACBatch_SetEngine(DefaultEngine));
+    KineticHMACBatch_DestroySigner(&Signer);
+    for (int k = 0; k < NUM_KEYS; k++) {
+        KineticHMAC_DestroyKey(&Keys[k]);
+    }
+    KineticLogger_Close();
+}
+
+static void expected_tag(const KineticHMACBatchJob* job, uint8_t* tag)
+{
+    uint8_t buf[sizeof(uint32_t) + MAX_DATA_LEN];
+    int k = (int)(job->key - Keys);
+    uint32_t lenNBO = KineticNBO_FromHostU32(job->len);
+    memcpy(buf, &lenNBO, sizeof(lenNBO));
+    memcpy(&buf[sizeof(lenNBO)], job->data, job->len);
+    unsigned int len = 0;
+    HMAC(EVP_sha1(), KeyData[k], KeyLen[k], buf, sizeof(lenNBO) + job->len, tag, &len);
+    TEST_ASSERT_EQUAL(KINETIC_HMAC_SHA1_LEN, len);
+}
+
+// Lengths cover every padding case around the block boundaries
+static size_t job_len(size_t i)
+{
+    static const size_t lens[] = {0, 1, 51, 52, 55, 56, 59, 60, 64, 100, 115, 116, 123, 124, 1024, 4096};
+    return lens[i % NUM_ELEMENTS(lens)] + (i / NUM_ELEMENTS(lens));
+}
+
+static void compute_and_check(size_t count)
+{
+    KineticHMACBatchJob jobs[NUM_ELEMENTS(Data)];
+    KineticHMACBatchJob* ptrs[NUM_ELEMENTS(Data)];
+    TEST_ASSERT_TRUE(count <= NUM_ELEMENTS(jobs));
+    for (size_t i = 0; i < count; i++) {
+        jobs[i] = (KineticHMACBatchJob) {
+            .key = &Keys[i % NUM_KEYS],
+            .data = Data[i],
+            .len = job_len(count - 1 - i),
+        };
+        ptrs[i] = &jobs[i];
+    }
+
+    KineticHMACBatch_Compute(ptrs, count);
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t expected[KINETIC_HMAC_SHA1_LEN];
+        expected_tag(&jobs[i], expected);
+        TEST_ASSERT_TRUE(jobs[i].success);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, jobs[i].tag, KINETIC_HMAC_SHA1_LEN);
+    }
+}
+
+void test_KineticHMACBatch_SetEngine_should_reject_unknown_engines(void)
+{
+    TEST_ASSERT_FALSE(KineticHMACBatch_SetEngine("md5"));
+    TEST_ASSERT_EQUAL_STRING(DefaultEngine, KineticHMACBatch_EngineName());
+}
+
+void test_KineticHMACBatch_SetEngine_should_always_support_openssl(void)
+{
+    TEST_ASSERT_TRUE(KineticHMACBatch_SetEngine("openssl"));
+    TEST_ASSERT_EQUAL_STRING("openssl", KineticHMACBatch_EngineName());
+}
+
+void test_KineticHMACBatch_Compute_should_match_OpenSSL_on_every_available_engine(void)
+{
+    for (size_t e = 0; e < NUM_ELEMENTS(EngineNames); e++) {
+        if (!KineticHMACBatch_SetEngine(EngineNames[e])) {
+            LOGF0("Skipping unavailable HMAC engine %s", EngineNames[e]);
+            continue;
+        }
+        // Full batches, partial lane groups, and batches split across calls
+        const size_t counts[] = {1, 2, 3, 4, 5, 8, 9, 16, 17, 31, KINETIC_HMAC_BATCH_MAX + 3};
+        for (size_t c = 0; c < NUM_ELEMENTS(counts); c++) {
+            compute_and_check(counts[c]);
+        }
+    }
+}
+
+static void* sign_concurrently(void* arg)
+{
+    size_t index = (size_t)arg;
+    for (size_t i = 0; i < 200; i++) {
+        KineticHMACBatchJob job = {
+            .key = &Keys[index % NUM_KEYS],
+            .data = Data[index],
+            .len = job_len(index + i),
+        };
+        KineticHMACBatch_Sign(&Signer, &job);
+
+        uint8_t expected[KINETIC_HMAC_SHA1_LEN];
+        expected_tag(&job, expected);
+        if (!job.complete || !job.success || memcmp(expected, job.tag, sizeof(expected)) != 0) {
+            return arg;
+        }
+    }
+    return NULL;
+}
+
+void test_KineticHMACBatch_Sign_should_sign_jobs_submitted_from_many_threads(void)
+{
+    pthread_t threads[8];
+    for (size_t t = 0; t < NUM_ELEMENTS(threads); t++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[t], NULL, sign_concurrently, (void*)(t + 1)));
+    }
+    for (size_t t = 0; t < NUM_ELEMENTS(threads); t++) {
+        void* failed = NULL;
+        pthread_join(threads[t], &failed);
+        TEST_ASSERT_NULL(failed);
+    }
+}
+
+void test_KineticHMACBatch_Sign_should_sign_directly_rather_than_wait_out_a_busy_signer(void)
+{
+    // Another thread is signing a batch that never finishes
+    Signer.busy = true;
+
+    KineticHMACBatchJob job = {
+        .key = &Keys[0],
+        .data = Data[0],
+        .len = job_len(0),
+    };
+    KineticHMACBatch_Sign(&Signer, &job);
+
+    uint8_t expected[KINETIC_HMAC_SHA1_LEN];
+    expected_tag(&job, expected);
+    TEST_ASSERT_TRUE(job.complete);
+    TEST_ASSERT_TRUE(job.success);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, job.tag, sizeof(expected));
+    TEST_ASSERT_NULL(Signer.pending);
+    Signer.busy = false;
+}
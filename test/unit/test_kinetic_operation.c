@@ -27,6 +27,7 @@
 #include "kinetic_logger.h"
 #include "kinetic_types_internal.h"
 #include "kinetic_device_info.h"
+#include "kinetic_stats.h"
 #include "mock_kinetic_allocator.h"
 #include "mock_kinetic_session.h"
 #include "mock_kinetic_response.h"
@@ -62,22 +63,15 @@ void tearDown(void)
     KineticLogger_Close();
 }
 
-void test_KineticOperation_SendRequest_should_error_out_on_lock_failure(void)
+void test_KineticOperation_SendRequest_should_return_MEMORY_ERROR_on_PackPDU_alloc_failure(void)
 {
-    KineticRequest_LockSend_ExpectAndReturn(Operation.session, false);
-    KineticStatus status = KineticOperation_SendRequest(&Operation);
-    TEST_ASSERT_EQUAL(KINETIC_STATUS_CONNECTION_ERROR, status);
-}
-
-
-void test_KineticOperation_SendRequest_should_return_MEMORY_ERROR_on_command_pack_failure(void)
-{
-    KineticRequest_LockSend_ExpectAndReturn(Operation.session, true);
     KineticSession *session = Operation.session;
     KineticSession_GetNextSequenceCount_ExpectAndReturn(session, 12345);
 
-    KineticRequest_PackCommand_ExpectAndReturn(Operation.request, KINETIC_REQUEST_PACK_FAILURE);
-    KineticRequest_UnlockSend_ExpectAndReturn(Operation.session, true);
+    KineticRequest_PackPDU_ExpectAndReturn(&Operation, &msg, &msgSize,
+        KINETIC_STATUS_MEMORY_ERROR);
+    KineticRequest_AwaitSendTurn_Expect(session, 12345);
+    KineticRequest_PassSendTurn_Expect(session, 12345);
 
     KineticStatus status = KineticOperation_SendRequest(&Operation);
     TEST_ASSERT_EQUAL(KINETIC_STATUS_MEMORY_ERROR, status);
@@ -85,54 +79,31 @@ void test_KineticOperation_SendRequest_should_return_MEMORY_ERROR_on_command_pac
 
 void test_KineticOperation_SendRequest_should_return_error_status_on_authentication_failure(void)
 {
-    KineticRequest_LockSend_ExpectAndReturn(Operation.session, true);
     KineticSession *session = Operation.session;
     KineticSession_GetNextSequenceCount_ExpectAndReturn(session, 12345);
 
-    KineticRequest_PackCommand_ExpectAndReturn(Operation.request, 100);
-    KineticRequest_PopulateAuthentication_ExpectAndReturn(&session->config,
-        Operation.request, NULL, KINETIC_STATUS_HMAC_REQUIRED);
-    KineticRequest_UnlockSend_ExpectAndReturn(Operation.session, true);
+    KineticRequest_PackPDU_ExpectAndReturn(&Operation, &msg, &msgSize,
+        KINETIC_STATUS_HMAC_REQUIRED);
+    KineticRequest_AwaitSendTurn_Expect(session, 12345);
+    KineticRequest_PassSendTurn_Expect(session, 12345);
 
     KineticStatus status = KineticOperation_SendRequest(&Operation);
     TEST_ASSERT_EQUAL(KINETIC_STATUS_HMAC_REQUIRED, status);
 }
 
-void test_KineticOperation_SendRequest_should_return_error_status_on_PackMessage_failure(void)
-{
-    KineticRequest_LockSend_ExpectAndReturn(Operation.session, true);
-    KineticSession *session = Operation.session;
-    KineticSession_GetNextSequenceCount_ExpectAndReturn(session, 12345);
-
-    KineticRequest_PackCommand_ExpectAndReturn(Operation.request, 100);
-    KineticRequest_PopulateAuthentication_ExpectAndReturn(&session->config,
-        Operation.request, NULL, KINETIC_STATUS_SUCCESS);
-
-    KineticRequest_PackMessage_ExpectAndReturn(&Operation, &msg, &msgSize,
-        KINETIC_STATUS_MEMORY_ERROR);
-    KineticRequest_UnlockSend_ExpectAndReturn(Operation.session, true);
-
-    KineticStatus status = KineticOperation_SendRequest(&Operation);
-    TEST_ASSERT_EQUAL(KINETIC_STATUS_MEMORY_ERROR, status);
-}
-
 void test_KineticOperation_SendRequest_should_return_REQUEST_REJECTED_if_SendRequest_fails(void)
 {
-    KineticRequest_LockSend_ExpectAndReturn(Operation.session, true);
     KineticSession *session = Operation.session;
     KineticSession_GetNextSequenceCount_ExpectAndReturn(session, 12345);
 
-    KineticRequest_PackCommand_ExpectAndReturn(Operation.request, 100);
-    KineticRequest_PopulateAuthentication_ExpectAndReturn(&session->config,
-        Operation.request, NULL, KINETIC_STATUS_SUCCESS);
-
-    KineticRequest_PackMessage_ExpectAndReturn(&Operation, &msg, &msgSize, KINETIC_STATUS_SUCCESS);
+    KineticRequest_PackPDU_ExpectAndReturn(&Operation, &msg, &msgSize, KINETIC_STATUS_SUCCESS);
+    KineticRequest_AwaitSendTurn_Expect(session, 12345);
 
     KineticCountingSemaphore_Take_Expect(Operation.session->outstandingOperations);
 
     KineticRequest_SendRequest_ExpectAndReturn(&Operation, msg, msgSize, false);
     KineticCountingSemaphore_Give_Expect(Operation.session->outstandingOperations);
-    KineticRequest_UnlockSend_ExpectAndReturn(Operation.session, true);
+    KineticRequest_PassSendTurn_Expect(session, 12345);
 
     KineticStatus status = KineticOperation_SendRequest(&Operation);
     TEST_ASSERT_EQUAL(KINETIC_STATUS_REQUEST_REJECTED, status);
@@ -140,20 +111,16 @@ void test_KineticOperation_SendRequest_should_return_REQUEST_REJECTED_if_SendReq
 
 void test_KineticOperation_SendRequest_should_acquire_and_increment_sequence_count_and_send_PDU_to_bus(void)
 {
-    KineticRequest_LockSend_ExpectAndReturn(Operation.session, true);
     KineticSession *session = Operation.session;
     KineticSession_GetNextSequenceCount_ExpectAndReturn(session, 12345);
 
-    KineticRequest_PackCommand_ExpectAndReturn(Operation.request, 100);
-    KineticRequest_PopulateAuthentication_ExpectAndReturn(&session->config,
-        Operation.request, NULL, KINETIC_STATUS_SUCCESS);
-
-    KineticRequest_PackMessage_ExpectAndReturn(&Operation, &msg, &msgSize, KINETIC_STATUS_SUCCESS);
+    KineticRequest_PackPDU_ExpectAndReturn(&Operation, &msg, &msgSize, KINETIC_STATUS_SUCCESS);
+    KineticRequest_AwaitSendTurn_Expect(session, 12345);
 
     KineticCountingSemaphore_Take_Expect(Operation.session->outstandingOperations);
 
     KineticRequest_SendRequest_ExpectAndReturn(&Operation, msg, msgSize, true);
-    KineticRequest_UnlockSend_ExpectAndReturn(Operation.session, true);
+    KineticRequest_PassSendTurn_Expect(session, 12345);
 
     KineticStatus status = KineticOperation_SendRequest(&Operation);
     TEST_ASSERT_EQUAL(KINETIC_STATUS_SUCCESS, status);
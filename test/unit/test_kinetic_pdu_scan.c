@@ -0,0 +1,137 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "unity.h"
+#include "unity_helper.h"
+#include "kinetic_pdu_scan.h"
+#include <string.h>
+
+static KineticPDUScan Scan;
+
+void setUp(void)
+{
+    memset(&Scan, 0xff, sizeof(Scan));
+}
+
+void tearDown(void)
+{
+}
+
+void test_KineticPDU_Scan_should_accept_an_empty_message(void)
+{
+    uint8_t msg[1] = {0};
+    TEST_ASSERT_TRUE(KineticPDU_Scan(msg, 0, &Scan));
+    TEST_ASSERT_FALSE(Scan.hasAuthType);
+    TEST_ASSERT_FALSE(Scan.hasHeader);
+    TEST_ASSERT_FALSE(Scan.hasStatusCode);
+}
+
+void test_KineticPDU_Scan_should_extract_ack_sequence_and_status_from_a_response(void)
+{
+    uint8_t msg[] = {
+        0x20, 0x01,                     // authType = HMACAUTH
+        0x2a, 0x06,                     // hmacAuth
+            0x08, 0x01,                 //   identity = 1
+            0x12, 0x02, 0xaa, 0xbb,     //   hmac
+        0x3a, 0x0b,                     // commandBytes
+            0x0a, 0x05,                 //   header
+                0x30, 0xac, 0x02,       //     ackSequence = 300
+                0x38, 0x03,             //     messageType = GET_RESPONSE
+            0x1a, 0x02,                 //   status
+                0x08, 0x01,             //     code = SUCCESS
+    };
+
+    TEST_ASSERT_TRUE(KineticPDU_Scan(msg, sizeof(msg), &Scan));
+    TEST_ASSERT_TRUE(Scan.hasAuthType);
+    TEST_ASSERT_EQUAL(1, Scan.authType);
+    TEST_ASSERT_TRUE(Scan.hasHeader);
+    TEST_ASSERT_TRUE(Scan.hasAckSequence);
+    TEST_ASSERT_EQUAL(300, Scan.ackSequence);
+    TEST_ASSERT_FALSE(Scan.hasConnectionID);
+    TEST_ASSERT_TRUE(Scan.hasStatusCode);
+    TEST_ASSERT_EQUAL(1, Scan.statusCode);
+}
+
+void test_KineticPDU_Scan_should_extract_connection_ID_from_an_unsolicited_status(void)
+{
+    uint8_t msg[] = {
+        0x20, 0x03,                     // authType = UNSOLICITEDSTATUS
+        0x3a, 0x0c,                     // commandBytes
+            0x0a, 0x06,                 //   header
+                0x18, 0xb9, 0x60,       //     connectionID = 12345
+                0x08, 0x80, 0x00,       //     clusterVersion = 0 (padded varint)
+            0x1a, 0x02,                 //   status
+                0x08, 0x01,             //     code = SUCCESS
+    };
+
+    TEST_ASSERT_TRUE(KineticPDU_Scan(msg, sizeof(msg), &Scan));
+    TEST_ASSERT_EQUAL(3, Scan.authType);
+    TEST_ASSERT_TRUE(Scan.hasHeader);
+    TEST_ASSERT_FALSE(Scan.hasAckSequence);
+    TEST_ASSERT_TRUE(Scan.hasConnectionID);
+    TEST_ASSERT_EQUAL(12345, Scan.connectionID);
+}
+
+void test_KineticPDU_Scan_should_handle_negative_ack_sequences(void)
+{
+    uint8_t msg[] = {
+        0x3a, 0x0d,                     // commandBytes
+            0x0a, 0x0b,                 //   header
+                0x30, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,  // ackSequence = -1
+    };
+
+    TEST_ASSERT_TRUE(KineticPDU_Scan(msg, sizeof(msg), &Scan));
+    TEST_ASSERT_FALSE(Scan.hasAuthType);
+    TEST_ASSERT_TRUE(Scan.hasAckSequence);
+    TEST_ASSERT_EQUAL(-1, Scan.ackSequence);
+}
+
+void test_KineticPDU_Scan_should_skip_unknown_fields(void)
+{
+    uint8_t msg[] = {
+        0x09, 1, 2, 3, 4, 5, 6, 7, 8,   // field 1, fixed64
+        0x15, 1, 2, 3, 4,               // field 2, fixed32
+        0x3a, 0x04,                     // commandBytes
+            0x0a, 0x02,                 //   header
+                0x30, 0x07,             //     ackSequence = 7
+        0x50, 0x01,                     // field 10, varint
+    };
+
+    TEST_ASSERT_TRUE(KineticPDU_Scan(msg, sizeof(msg), &Scan));
+    TEST_ASSERT_EQUAL(7, Scan.ackSequence);
+}
+
+void test_KineticPDU_Scan_should_reject_malformed_messages(void)
+{
+    uint8_t truncatedLength[] = {0x3a, 0x05, 0x0a, 0x00};
+    TEST_ASSERT_FALSE(KineticPDU_Scan(truncatedLength, sizeof(truncatedLength), &Scan));
+
+    uint8_t truncatedVarint[] = {0x20, 0x80};
+    TEST_ASSERT_FALSE(KineticPDU_Scan(truncatedVarint, sizeof(truncatedVarint), &Scan));
+
+    uint8_t group[] = {0x0b, 0x0c};
+    TEST_ASSERT_FALSE(KineticPDU_Scan(group, sizeof(group), &Scan));
+
+    uint8_t fieldZero[] = {0x00, 0x01};
+    TEST_ASSERT_FALSE(KineticPDU_Scan(fieldZero, sizeof(fieldZero), &Scan));
+
+    uint8_t badHeader[] = {0x3a, 0x03, 0x0a, 0x01, 0x30};
+    TEST_ASSERT_FALSE(KineticPDU_Scan(badHeader, sizeof(badHeader), &Scan));
+}
@@ -21,6 +21,7 @@
 #include "unity_helper.h"
 #include "protobuf-c/protobuf-c.h"
 #include "kinetic_request.h"
+#include "kinetic_encoder.h"
 
 #include "kinetic_logger.h"
 #include "byte_array.h"
@@ -34,8 +35,8 @@
 #include "mock_kinetic_session.h"
 #include "mock_kinetic_countingsemaphore.h"
 #include "mock_kinetic.pb-c.h"
+#include <pthread.h>
 
-extern uint8_t *cmdBuf;
 extern uint8_t *msg;
 
 void setUp(void)
@@ -48,67 +49,37 @@ void tearDown(void)
     KineticLogger_Close();
 }
 
-void test_KineticRequest_PackCommand_should_return_KINETIC_REQUEST_PACK_FAILURE_on_malloc_fail(void)
-{
-    KineticMessage message;
-    memset(&message, 0, sizeof(message));
-    KineticRequest request;
-    memset(&request, 0, sizeof(request));
-    request.message = message;
-
-    com__seagate__kinetic__proto__command__get_packed_size_ExpectAndReturn(&request.message.command,
-        ((size_t)-1));
-
-    cmdBuf = NULL;  // fake malloc failure
-    TEST_ASSERT_EQUAL(KINETIC_REQUEST_PACK_FAILURE, KineticRequest_PackCommand(&request));
-}
-
-void test_KineticRequest_PackCommand_should_return_size_when_packing_command(void)
-{
-    KineticMessage message;
-    memset(&message, 0, sizeof(message));
-    KineticRequest request;
-    memset(&request, 0, sizeof(request));
-    request.message = message;
-
-    uint8_t buf[12345];
-    cmdBuf = buf;
-    com__seagate__kinetic__proto__command__get_packed_size_ExpectAndReturn(&request.message.command,
-        (size_t)12345);
-
-    com__seagate__kinetic__proto__command__pack_ExpectAndReturn(&request.message.command,
-        cmdBuf, 12345);
-    TEST_ASSERT_EQUAL(12345, KineticRequest_PackCommand(&request));
-
-    TEST_ASSERT_EQUAL(12345, request.message.message.commandbytes.len);
-    TEST_ASSERT_TRUE(request.message.message.has_commandbytes);
-}
-
 void test_KineticRequest_PopulateAuthentication_should_use_PIN_if_provided(void)
 {
     KineticSessionConfig config;
+    KineticHMACKey key;
     KineticRequest request;
     ByteArray pin;
 
     KineticAuth_PopulatePin_ExpectAndReturn(&config, &request, pin, KINETIC_STATUS_SUCCESS);
-    KineticStatus res = KineticRequest_PopulateAuthentication(&config, &request, &pin);
+    KineticStatus res = KineticRequest_PopulateAuthentication(&config, &key, &request, &pin);
     TEST_ASSERT_EQUAL(KINETIC_STATUS_SUCCESS, res);
 }
 
 void test_KineticRequest_PopulateAuthentication_should_use_HMAC_if_PIN_is_NULL(void)
 {
     KineticSessionConfig config;
+    KineticHMACKey key;
     KineticRequest request;
 
-    KineticAuth_PopulateHmac_ExpectAndReturn(&config, &request, KINETIC_STATUS_SUCCESS);
-    KineticStatus res = KineticRequest_PopulateAuthentication(&config, &request, NULL);
+    KineticAuth_PopulateHmac_ExpectAndReturn(&config, &key, &request, KINETIC_STATUS_SUCCESS);
+    KineticStatus res = KineticRequest_PopulateAuthentication(&config, &key, &request, NULL);
     TEST_ASSERT_EQUAL(KINETIC_STATUS_SUCCESS, res);
 }
 
-void test_KineticRequest_PackMessage_should_return_MEMORY_ERROR_on_alloc_fail(void)
+void test_KineticRequest_PackPDU_should_return_MEMORY_ERROR_on_alloc_fail(void)
 {
+    KineticSession session;
+    memset(&session, 0, sizeof(session));
     KineticRequest request;
+    memset(&request, 0, sizeof(request));
     KineticOperation operation = {
+        .session = &session,
         .request = &request,
         .value.len = 9999,
     };
@@ -116,80 +87,344 @@ void test_KineticRequest_PackMessage_should_return_MEMORY_ERROR_on_alloc_fail(vo
     uint8_t *out_msg = NULL;
     size_t msgSize = 0;
 
-    Com__Seagate__Kinetic__Proto__Message* proto = &operation.request->message.message;
-    com__seagate__kinetic__proto__message__get_packed_size_ExpectAndReturn(proto, 12345);
-
-    KineticNBO_FromHostU32_ExpectAndReturn(12345, 0xaabbccdd);
+    com__seagate__kinetic__proto__command__get_packed_size_ExpectAndReturn(&request.message.command, 100);
+    KineticNBO_FromHostU32_ExpectAndReturn(2 + 26 + 102, 0xaabbccdd);
     KineticNBO_FromHostU32_ExpectAndReturn(9999, 0xddccbbaa);
 
     msg = NULL;  // fake malloc failure
-    KineticStatus status = KineticRequest_PackMessage(&operation, &out_msg, &msgSize);
+    KineticStatus status = KineticRequest_PackPDU(&operation, &out_msg, &msgSize);
     TEST_ASSERT_EQUAL(KINETIC_STATUS_MEMORY_ERROR, status);
 }
 
-void test_KineticRequest_PackMessage_should_return_SUCCESS_on_message_packing(void)
+void test_KineticRequest_PackPDU_should_return_authentication_failure(void)
 {
+    KineticSession session;
+    memset(&session, 0, sizeof(session));
     KineticRequest request;
     memset(&request, 0, sizeof(request));
+    KineticOperation operation = {
+        .session = &session,
+        .request = &request,
+    };
 
-    size_t valueLen = 5;
-    size_t packedSize = 6 + 16;  // mostly for nice alignment in hexdump
+    uint8_t *out_msg = NULL;
+    size_t msgSize = 0;
+    uint8_t buf[256];
+    msg = buf;  // fake malloc
+
+    com__seagate__kinetic__proto__command__get_packed_size_ExpectAndReturn(&request.message.command, 4);
+    KineticNBO_FromHostU32_ExpectAndReturn(2 + 26 + 6, 0);
+    KineticNBO_FromHostU32_ExpectAndReturn(0, 0);
+    com__seagate__kinetic__proto__command__pack_ExpectAndReturn(&request.message.command,
+        &buf[9 + 2 + 26 + 2], 4);
+    KineticAuth_PopulateHmac_ExpectAndReturn(&session.config, &session.hmacKeySchedule, &request, KINETIC_STATUS_HMAC_REQUIRED);
 
+    KineticStatus status = KineticRequest_PackPDU(&operation, &out_msg, &msgSize);
+    TEST_ASSERT_EQUAL(KINETIC_STATUS_HMAC_REQUIRED, status);
+}
+
+void test_KineticRequest_PackPDU_should_frame_HMAC_authenticated_command_and_value_in_one_pass(void)
+{
+    KineticSession session;
+    memset(&session, 0, sizeof(session));
+    session.config.identity = 300;  // two byte varint
+    KineticRequest request;
+    memset(&request, 0, sizeof(request));
+    request.message.message.hmacauth = &request.message.hmacAuth;
+    request.message.hmacAuth.hmac.data = request.message.hmacData;
+    request.message.hmacAuth.hmac.len = KINETIC_HMAC_SHA1_LEN;
+    memset(request.message.hmacData, 0x77, KINETIC_HMAC_SHA1_LEN);
+
+    uint8_t valueBuf[] = "value";
+    KineticOperation operation = {
+        .session = &session,
+        .request = &request,
+        .value.data = valueBuf,
+        .value.len = 5,
+    };
+
+    uint8_t *out_msg = NULL;
+    size_t msgSize = 0;
+    uint8_t buf[256];
+    memset(buf, 0, sizeof(buf));
+    msg = buf;  // fake malloc
+
+    size_t cmdLen = 3;
+    size_t protoLen = 2 + (2 + 1 + 2 + 2 + 20) + (2 + cmdLen);
+    com__seagate__kinetic__proto__command__get_packed_size_ExpectAndReturn(&request.message.command, cmdLen);
+    KineticNBO_FromHostU32_ExpectAndReturn(protoLen, 0xddccbbaa);
+    KineticNBO_FromHostU32_ExpectAndReturn(5, 0xaabbccdd);
+
+    size_t cmdOffset = 9 + protoLen - cmdLen;
+    buf[cmdOffset] = 0xc0;  // filler where the command would be packed
+    buf[cmdOffset + 1] = 0xc1;
+    buf[cmdOffset + 2] = 0xc2;
+    com__seagate__kinetic__proto__command__pack_ExpectAndReturn(&request.message.command,
+        &buf[cmdOffset], cmdLen);
+    KineticAuth_PopulateHmac_ExpectAndReturn(&session.config, &session.hmacKeySchedule, &request, KINETIC_STATUS_SUCCESS);
+
+    KineticStatus status = KineticRequest_PackPDU(&operation, &out_msg, &msgSize);
+    TEST_ASSERT_EQUAL(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL_PTR(buf, out_msg);
+    TEST_ASSERT_EQUAL(9 + protoLen + 5, msgSize);
+
+    // command bytes are referenced where they sit in the PDU
+    TEST_ASSERT_TRUE(request.message.message.has_commandbytes);
+    TEST_ASSERT_EQUAL_PTR(&buf[cmdOffset], request.message.message.commandbytes.data);
+    TEST_ASSERT_EQUAL(cmdLen, request.message.message.commandbytes.len);
+
+    uint8_t expected[] = {
+        'F',  // versionPrefix
+        0xaa, 0xbb, 0xcc, 0xdd,  // proto length
+        0xdd, 0xcc, 0xbb, 0xaa,  // value length
+        0x20, 0x01,  // authType = HMACAUTH
+        0x2a, 0x19,  // hmacAuth, length
+        0x08, 0xac, 0x02,  // identity = 300
+        0x12, 0x14,  // hmac, length
+        0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77,
+        0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77,
+        0x3a, 0x03,  // commandBytes, length
+        0xc0, 0xc1, 0xc2,
+        'v', 'a', 'l', 'u', 'e',
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), msgSize);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out_msg, sizeof(expected));
+}
+
+void test_KineticRequest_PackPDU_should_copy_the_value_while_computing_a_requested_tag(void)
+{
+    KineticSession session;
+    memset(&session, 0, sizeof(session));
+    KineticRequest request;
+    memset(&request, 0, sizeof(request));
+    request.message.message.hmacauth = &request.message.hmacAuth;
+    request.message.hmacAuth.hmac.data = request.message.hmacData;
+    request.message.hmacAuth.hmac.len = KINETIC_HMAC_SHA1_LEN;
+
+    uint8_t valueBuf[] = "value";
+    uint8_t tagBuf[4];
+    KineticEntry entry = {
+        .tag = {.array = {.data = tagBuf, .len = sizeof(tagBuf)}},
+        .algorithm = KINETIC_ALGORITHM_CRC32,
+        .computeTag = true,
+    };
     KineticOperation operation = {
+        .session = &session,
         .request = &request,
-        .value.len = valueLen,
+        .entry = &entry,
+        .value.data = valueBuf,
+        .value.len = 5,
+        .computeValueTag = true,
     };
 
+    uint8_t *out_msg = NULL;
+    size_t msgSize = 0;
+    uint8_t buf[256];
+    memset(buf, 0, sizeof(buf));
+    msg = buf;  // fake malloc
+
+    size_t cmdLen = 3;
+    size_t protoLen = 2 + (2 + 1 + 1 + 2 + 20) + (2 + cmdLen);
+    size_t cmdOffset = 9 + protoLen - cmdLen;
+    com__seagate__kinetic__proto__command__get_packed_size_ExpectAndReturn(&request.message.command, cmdLen);
+    KineticNBO_FromHostU32_ExpectAndReturn(protoLen, 0);
+    KineticNBO_FromHostU32_ExpectAndReturn(5, 0);
+    // The tag must be in place before the command holding it is packed
+    KineticAuth_CopyAndPopulateTag_ExpectAndReturn(&entry.tag, KINETIC_ALGORITHM_CRC32,
+        &buf[9 + protoLen], &operation.value, KINETIC_STATUS_SUCCESS);
+    com__seagate__kinetic__proto__command__pack_ExpectAndReturn(&request.message.command,
+        &buf[cmdOffset], cmdLen);
+    KineticAuth_PopulateHmac_ExpectAndReturn(&session.config, &session.hmacKeySchedule, &request, KINETIC_STATUS_SUCCESS);
+
+    KineticStatus status = KineticRequest_PackPDU(&operation, &out_msg, &msgSize);
+    TEST_ASSERT_EQUAL(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL(9 + protoLen + 5, msgSize);
+
+    // The value is not copied a second time
+    uint8_t untouched[5] = {0};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(untouched, &buf[9 + protoLen], sizeof(untouched));
+}
+
+void test_KineticRequest_PackPDU_should_return_tag_failure(void)
+{
+    KineticSession session;
+    memset(&session, 0, sizeof(session));
+    KineticRequest request;
+    memset(&request, 0, sizeof(request));
+
     uint8_t valueBuf[] = "value";
-    operation.value.data = valueBuf;
+    uint8_t tagBuf[2];
+    KineticEntry entry = {
+        .tag = {.array = {.data = tagBuf, .len = sizeof(tagBuf)}},
+        .algorithm = KINETIC_ALGORITHM_CRC32,
+    };
+    KineticOperation operation = {
+        .session = &session,
+        .request = &request,
+        .entry = &entry,
+        .value.data = valueBuf,
+        .value.len = 5,
+        .computeValueTag = true,
+    };
 
     uint8_t *out_msg = NULL;
     size_t msgSize = 0;
+    uint8_t buf[256];
+    msg = buf;  // fake malloc
 
-    Com__Seagate__Kinetic__Proto__Message* proto = &operation.request->message.message;
-    com__seagate__kinetic__proto__message__get_packed_size_ExpectAndReturn(proto, packedSize);
+    com__seagate__kinetic__proto__command__get_packed_size_ExpectAndReturn(&request.message.command, 4);
+    KineticNBO_FromHostU32_ExpectAndReturn(2 + 26 + 6, 0);
+    KineticNBO_FromHostU32_ExpectAndReturn(5, 0);
+    KineticAuth_CopyAndPopulateTag_ExpectAndReturn(&entry.tag, KINETIC_ALGORITHM_CRC32,
+        &buf[9 + 2 + 26 + 6], &operation.value, KINETIC_STATUS_BUFFER_OVERRUN);
+
+    KineticStatus status = KineticRequest_PackPDU(&operation, &out_msg, &msgSize);
+    TEST_ASSERT_EQUAL(KINETIC_STATUS_BUFFER_OVERRUN, status);
+}
 
-    // size of filler protobuf, mainly to get things nicely aligned w/ 9-byte header
-    KineticNBO_FromHostU32_ExpectAndReturn(packedSize, 0xaabbccdd);
+void test_KineticRequest_PackPDU_should_frame_PIN_authenticated_command(void)
+{
+    KineticSession session;
+    memset(&session, 0, sizeof(session));
+    KineticRequest request;
+    memset(&request, 0, sizeof(request));
 
-    KineticNBO_FromHostU32_ExpectAndReturn(valueLen, 0xddccbbaa);
+    uint8_t pinData[] = "1234";
+    ByteArray pin = {.data = pinData, .len = 4};
+    KineticOperation operation = {
+        .session = &session,
+        .request = &request,
+        .pin = &pin,
+    };
 
-    uint8_t buf[64 * 1024];
+    uint8_t *out_msg = NULL;
+    size_t msgSize = 0;
+    uint8_t buf[256];
     memset(buf, 0, sizeof(buf));
-    msg = &buf[0];  // fake malloc
-    size_t offset = sizeof(uint8_t) + 2*sizeof(uint32_t);
+    msg = buf;  // fake malloc
 
-    // filler where protobuf message would be
-    for (size_t i = 0; i < packedSize; i++) { buf[i + offset] = 0x33; }
+    size_t cmdLen = 2;
+    size_t protoLen = 2 + (2 + 2 + 4) + (2 + cmdLen);
+    com__seagate__kinetic__proto__command__get_packed_size_ExpectAndReturn(&request.message.command, cmdLen);
+    KineticNBO_FromHostU32_ExpectAndReturn(protoLen, 0x00000000);
+    KineticNBO_FromHostU32_ExpectAndReturn(0, 0x00000000);
 
-    com__seagate__kinetic__proto__message__pack_ExpectAndReturn(&request.message.message, &buf[offset], packedSize);
+    size_t cmdOffset = 9 + protoLen - cmdLen;
+    buf[cmdOffset] = 0xc0;
+    buf[cmdOffset + 1] = 0xc1;
+    com__seagate__kinetic__proto__command__pack_ExpectAndReturn(&request.message.command,
+        &buf[cmdOffset], cmdLen);
+    KineticAuth_PopulatePin_ExpectAndReturn(&session.config, &request, pin, KINETIC_STATUS_SUCCESS);
 
-    KineticStatus status = KineticRequest_PackMessage(&operation, &out_msg, &msgSize);
-    TEST_ASSERT_EQUAL(out_msg, msg);
-    TEST_ASSERT(msgSize > 0);
+    KineticStatus status = KineticRequest_PackPDU(&operation, &out_msg, &msgSize);
+    TEST_ASSERT_EQUAL(KINETIC_STATUS_SUCCESS, status);
 
-    #if 0
-    for (size_t i = 0; i < msgSize; i++) {
-        if (i > 0 && (i & 15) == 15) { printf("\n"); }
-        printf("%02x ", out_msg[i]);
-    }
-    printf("\n");
-    #endif
+    uint8_t expected[] = {
+        'F', 0, 0, 0, 0, 0, 0, 0, 0,
+        0x20, 0x02,  // authType = PINAUTH
+        0x32, 0x06,  // pinAuth, length
+        0x0a, 0x04, '1', '2', '3', '4',  // pin
+        0x3a, 0x02,  // commandBytes, length
+        0xc0, 0xc1,
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), msgSize);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out_msg, sizeof(expected));
+}
+
+void test_KineticRequest_PackPDU_should_use_the_specialized_encoder_for_hot_commands(void)
+{
+    KineticSession session;
+    memset(&session, 0, sizeof(session));
+    KineticRequest request;
+    memset(&request, 0, sizeof(request));
+    request.message.message.hmacauth = &request.message.hmacAuth;
+    request.message.hmacAuth.hmac.data = request.message.hmacData;
+    request.message.hmacAuth.hmac.len = KINETIC_HMAC_SHA1_LEN;
+    request.message.command.header = &request.message.header;
+    request.message.header.has_sequence = true;
+    request.message.header.sequence = 5;
+    request.message.header.has_messagetype = true;
+    request.message.header.messagetype = COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__NOOP;
+
+    KineticOperation operation = {
+        .session = &session,
+        .request = &request,
+    };
+
+    uint8_t *out_msg = NULL;
+    size_t msgSize = 0;
+    uint8_t buf[256];
+    memset(buf, 0, sizeof(buf));
+    msg = buf;  // fake malloc
 
+    // No protobuf-c sizing or packing is expected for the command
+    size_t cmdLen = 2 + 2 + 2;
+    size_t protoLen = 2 + 26 + (2 + cmdLen);
+    KineticNBO_FromHostU32_ExpectAndReturn(protoLen, 0);
+    KineticNBO_FromHostU32_ExpectAndReturn(0, 0);
+    KineticAuth_PopulateHmac_ExpectAndReturn(&session.config, &session.hmacKeySchedule, &request, KINETIC_STATUS_SUCCESS);
+
+    KineticStatus status = KineticRequest_PackPDU(&operation, &out_msg, &msgSize);
     TEST_ASSERT_EQUAL(KINETIC_STATUS_SUCCESS, status);
+    TEST_ASSERT_EQUAL(9 + protoLen, msgSize);
 
-    uint8_t expected[] = {
-        'F',  // versionPrefix
-        0xdd, 0xcc, 0xbb, 0xaa,  // proto length
-        0xaa, 0xbb, 0xcc, 0xdd,  // value length
+    uint8_t expectedCommand[] = {
+        0x0a, 0x04,  // header, length
+        0x20, 0x05,  // sequence = 5
+        0x38, 0x1e,  // messageType = NOOP
     };
-    for (size_t i = 0; i < sizeof(expected); i++) {
-        TEST_ASSERT_EQUAL(expected[i], out_msg[i]);
+    TEST_ASSERT_EQUAL(sizeof(expectedCommand), request.message.message.commandbytes.len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expectedCommand, &out_msg[msgSize - cmdLen], cmdLen);
+}
+
+typedef struct {
+    KineticSession* session;
+    int64_t seq_id;
+    int64_t* sent;
+    size_t* sentCount;
+} sender;
+
+static void* send_in_turn(void* arg)
+{
+    sender* s = arg;
+    KineticRequest_AwaitSendTurn(s->session, s->seq_id);
+    s->sent[(*s->sentCount)++] = s->seq_id;
+    KineticRequest_PassSendTurn(s->session, s->seq_id);
+    return NULL;
+}
+
+void test_KineticRequest_AwaitSendTurn_should_hand_off_in_sequence_order(void)
+{
+    KineticSession session;
+    memset(&session, 0, sizeof(session));
+    TEST_ASSERT_EQUAL(0, pthread_mutex_init(&session.sendMutex, NULL));
+    TEST_ASSERT_EQUAL(0, pthread_cond_init(&session.sendTurnCond, NULL));
+    session.sendTurn = 100;
+
+    // Start the senders in reverse order; they must still send in order
+    int64_t sent[4];
+    size_t sentCount = 0;
+    sender senders[4];
+    pthread_t threads[4];
+    for (int i = 3; i >= 0; i--) {
+        senders[i] = (sender) {
+            .session = &session,
+            .seq_id = 100 + i,
+            .sent = sent,
+            .sentCount = &sentCount,
+        };
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, send_in_turn, &senders[i]));
     }
-    for (size_t i = 0; i < packedSize; i++) {
-        TEST_ASSERT_EQUAL(0x33, out_msg[i + offset]);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(0, pthread_join(threads[i], NULL));
     }
-    for (size_t i = 0; i < valueLen; i++) {
-        TEST_ASSERT_EQUAL(valueBuf[i], out_msg[i + offset + packedSize]);
+
+    TEST_ASSERT_EQUAL(4, sentCount);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(100 + i, sent[i]);
     }
+    TEST_ASSERT_EQUAL(104, session.sendTurn);
+
+    pthread_cond_destroy(&session.sendTurnCond);
+    pthread_mutex_destroy(&session.sendMutex);
 }
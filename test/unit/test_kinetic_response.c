@@ -128,3 +128,89 @@ void test_KineticResponse_GetKeyRange_should_return_the_Com__Seagate__Kinetic__P
     range = KineticResponse_GetKeyRange(&Response);
     TEST_ASSERT_EQUAL_PTR(&Range, range);
 }
+
+void test_KineticResponse_Unpack_should_unpack_the_protobuf_ahead_of_the_value(void)
+{
+    uint8_t response_buf[sizeof(KineticResponse) + 6];
+    memset(response_buf, 0, sizeof(response_buf));
+    KineticResponse *response = (KineticResponse *)response_buf;
+    response->header.valueLength = 2;
+    response->header.protobufLength = 4;
+
+    Com__Seagate__Kinetic__Proto__Message Message;
+    memset(&Message, 0, sizeof(Message));
+    Message.has_commandbytes = true;
+    Message.commandbytes.data = (uint8_t *)"cmd";
+    Message.commandbytes.len = 3;
+    Com__Seagate__Kinetic__Proto__Command Command;
+    memset(&Command, 0, sizeof(Command));
+
+    KineticPDU_unpack_message_ExpectAndReturn(&response->arena.allocator, 4,
+        response->pdu, &Message);
+    KineticPDU_unpack_command_ExpectAndReturn(&response->arena.allocator, 3,
+        Message.commandbytes.data, &Command);
+
+    TEST_ASSERT_TRUE(KineticResponse_Unpack(response));
+    TEST_ASSERT_EQUAL_PTR(&Message, response->proto);
+    TEST_ASSERT_EQUAL_PTR(&Command, response->command);
+
+    // Already unpacked
+    TEST_ASSERT_TRUE(KineticResponse_Unpack(response));
+}
+
+void test_KineticResponse_Unpack_should_skip_empty_commands(void)
+{
+    Com__Seagate__Kinetic__Proto__Message Message;
+    memset(&Message, 0, sizeof(Message));
+    Response.header.protobufLength = 0;
+
+    KineticPDU_unpack_message_ExpectAndReturn(&Response.arena.allocator, 0,
+        Response.pdu, &Message);
+
+    TEST_ASSERT_TRUE(KineticResponse_Unpack(&Response));
+    TEST_ASSERT_EQUAL_PTR(&Message, Response.proto);
+    TEST_ASSERT_NULL(Response.command);
+}
+
+void test_KineticResponse_Unpack_should_report_unpack_failures(void)
+{
+    KineticPDU_unpack_message_ExpectAndReturn(&Response.arena.allocator, 0,
+        Response.pdu, NULL);
+    TEST_ASSERT_FALSE(KineticResponse_Unpack(&Response));
+
+    Com__Seagate__Kinetic__Proto__Message Message;
+    memset(&Message, 0, sizeof(Message));
+    Message.has_commandbytes = true;
+    Message.commandbytes.data = (uint8_t *)"cmd";
+    Message.commandbytes.len = 3;
+    memset(&Response, 0, sizeof(Response));
+
+    KineticPDU_unpack_message_ExpectAndReturn(&Response.arena.allocator, 0,
+        Response.pdu, &Message);
+    KineticPDU_unpack_command_ExpectAndReturn(&Response.arena.allocator, 3,
+        Message.commandbytes.data, NULL);
+    TEST_ASSERT_FALSE(KineticResponse_Unpack(&Response));
+}
+
+void test_KineticResponse_GetStatus_should_use_the_status_scanned_on_the_listener(void)
+{
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_INVALID, KineticResponse_GetStatus(NULL));
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_INVALID, KineticResponse_GetStatus(&Response));
+
+    // Nothing is unpacked to read it
+    Response.scan.hasStatusCode = true;
+    Response.scan.statusCode = COM__SEAGATE__KINETIC__PROTO__COMMAND__STATUS__STATUS_CODE__NOT_FOUND;
+    TEST_ASSERT_EQUAL_KineticStatus(KINETIC_STATUS_NOT_FOUND, KineticResponse_GetStatus(&Response));
+    TEST_ASSERT_NULL(Response.proto);
+}
+
+void test_KineticResponse_GetConnectionID_should_only_report_the_ID_of_an_unsolicited_status(void)
+{
+    Response.scan.hasConnectionID = true;
+    Response.scan.connectionID = 1234;
+    TEST_ASSERT_EQUAL_INT64(0, KineticResponse_GetConnectionID(&Response));
+
+    Response.scan.hasAuthType = true;
+    Response.scan.authType = COM__SEAGATE__KINETIC__PROTO__MESSAGE__AUTH_TYPE__UNSOLICITEDSTATUS;
+    TEST_ASSERT_EQUAL_INT64(1234, KineticResponse_GetConnectionID(&Response));
+}
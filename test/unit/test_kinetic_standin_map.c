@@ -0,0 +1,198 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "unity.h"
+#include "unity_helper.h"
+#include "kinetic_standin_map.h"
+#include "byte_array.h"
+#include <stdio.h>
+#include <string.h>
+
+static KineticStandinMap* Map;
+
+void setUp(void)
+{
+    Map = KineticStandinMap_Create();
+    TEST_ASSERT_NOT_NULL(Map);
+}
+
+void tearDown(void)
+{
+    KineticStandinMap_Destroy(Map);
+}
+
+static ByteArray key(const char* str)
+{
+    return ByteArray_CreateWithCString(str);
+}
+
+static void put(const char* k, const char* value, const char* version)
+{
+    KineticStandinEntry entry = {
+        .key = key(k),
+        .value = key(value),
+        .version = key(version),
+    };
+    TEST_ASSERT_TRUE(KineticStandinMap_Put(Map, &entry));
+}
+
+static void assert_key(const char* expected, const KineticStandinEntry* entry)
+{
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL(strlen(expected), entry->key.len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, entry->key.data, entry->key.len);
+}
+
+void test_KineticStandinMap_CompareKeys_should_order_keys_as_unsigned_bytes_then_by_length(void)
+{
+    TEST_ASSERT_TRUE(KineticStandinMap_CompareKeys(key("a"), key("b")) < 0);
+    TEST_ASSERT_TRUE(KineticStandinMap_CompareKeys(key("ab"), key("a")) > 0);
+    TEST_ASSERT_TRUE(KineticStandinMap_CompareKeys(key(""), key("a")) < 0);
+    TEST_ASSERT_EQUAL(0, KineticStandinMap_CompareKeys(key("abc"), key("abc")));
+
+    uint8_t high = 0xff, low = 0x01;
+    TEST_ASSERT_TRUE(KineticStandinMap_CompareKeys(ByteArray_Create(&high, 1), ByteArray_Create(&low, 1)) > 0);
+}
+
+void test_KineticStandinMap_Put_should_store_a_copy_of_the_entry(void)
+{
+    char k[] = "key";
+    char value[] = "value";
+    KineticStandinEntry entry = {
+        .key = key(k),
+        .value = key(value),
+        .version = key("v1"),
+        .tag = key("tag"),
+        .algorithm = 1,
+    };
+    TEST_ASSERT_TRUE(KineticStandinMap_Put(Map, &entry));
+    memset(k, 'x', strlen(k));
+    memset(value, 'x', strlen(value));
+
+    const KineticStandinEntry* found = KineticStandinMap_Find(Map, key("key"));
+    assert_key("key", found);
+    TEST_ASSERT_EQUAL_MEMORY("value", found->value.data, 5);
+    TEST_ASSERT_EQUAL_MEMORY("v1", found->version.data, 2);
+    TEST_ASSERT_EQUAL_MEMORY("tag", found->tag.data, 3);
+    TEST_ASSERT_EQUAL(1, found->algorithm);
+    TEST_ASSERT_EQUAL(1, KineticStandinMap_Count(Map));
+}
+
+void test_KineticStandinMap_Put_should_replace_an_entry_with_the_same_key(void)
+{
+    put("key", "old", "v1");
+    put("key", "newer", "v2");
+
+    const KineticStandinEntry* found = KineticStandinMap_Find(Map, key("key"));
+    TEST_ASSERT_NOT_NULL(found);
+    TEST_ASSERT_EQUAL(5, found->value.len);
+    TEST_ASSERT_EQUAL_MEMORY("newer", found->value.data, 5);
+    TEST_ASSERT_EQUAL_MEMORY("v2", found->version.data, 2);
+    TEST_ASSERT_EQUAL(1, KineticStandinMap_Count(Map));
+}
+
+void test_KineticStandinMap_Find_should_return_NULL_for_a_missing_key(void)
+{
+    TEST_ASSERT_NULL(KineticStandinMap_Find(Map, key("key")));
+    put("key", "value", "");
+    TEST_ASSERT_NULL(KineticStandinMap_Find(Map, key("ke")));
+    TEST_ASSERT_NULL(KineticStandinMap_Find(Map, key("key0")));
+}
+
+void test_KineticStandinMap_Delete_should_remove_only_the_given_key(void)
+{
+    put("a", "1", "");
+    put("b", "2", "");
+    put("c", "3", "");
+
+    TEST_ASSERT_TRUE(KineticStandinMap_Delete(Map, key("b")));
+    TEST_ASSERT_FALSE(KineticStandinMap_Delete(Map, key("b")));
+
+    TEST_ASSERT_NULL(KineticStandinMap_Find(Map, key("b")));
+    TEST_ASSERT_EQUAL(2, KineticStandinMap_Count(Map));
+    const KineticStandinEntry* a = KineticStandinMap_Find(Map, key("a"));
+    assert_key("c", KineticStandinMap_Next(a));
+    assert_key("a", KineticStandinMap_Previous(KineticStandinMap_Next(a)));
+}
+
+void test_KineticStandinMap_Ceiling_and_Floor_should_find_the_neighbors_of_a_key(void)
+{
+    put("b", "", "");
+    put("d", "", "");
+
+    assert_key("b", KineticStandinMap_Ceiling(Map, key("a"), false));
+    assert_key("b", KineticStandinMap_Ceiling(Map, key("b"), true));
+    assert_key("d", KineticStandinMap_Ceiling(Map, key("b"), false));
+    TEST_ASSERT_NULL(KineticStandinMap_Ceiling(Map, key("d"), false));
+
+    assert_key("d", KineticStandinMap_Floor(Map, key("e"), false));
+    assert_key("d", KineticStandinMap_Floor(Map, key("d"), true));
+    assert_key("b", KineticStandinMap_Floor(Map, key("d"), false));
+    TEST_ASSERT_NULL(KineticStandinMap_Floor(Map, key("b"), false));
+}
+
+void test_KineticStandinMap_First_and_Last_should_find_the_ends_of_the_map(void)
+{
+    TEST_ASSERT_NULL(KineticStandinMap_First(Map));
+    TEST_ASSERT_NULL(KineticStandinMap_Last(Map));
+
+    put("m", "", "");
+    put("z", "", "");
+    put("a", "", "");
+
+    assert_key("a", KineticStandinMap_First(Map));
+    assert_key("z", KineticStandinMap_Last(Map));
+}
+
+void test_KineticStandinMap_should_keep_many_keys_in_order_in_both_directions(void)
+{
+    const int count = 2000;
+    char k[16];
+    // Insert in a scrambled order, then delete every third key
+    for (int i = 0; i < count; i++) {
+        snprintf(k, sizeof(k), "key%05d", (i * 7919) % count);
+        put(k, k, "");
+    }
+    for (int i = 0; i < count; i += 3) {
+        snprintf(k, sizeof(k), "key%05d", i);
+        TEST_ASSERT_TRUE(KineticStandinMap_Delete(Map, key(k)));
+    }
+    TEST_ASSERT_EQUAL(count - (count + 2) / 3, KineticStandinMap_Count(Map));
+
+    size_t seen = 0;
+    const KineticStandinEntry* last = NULL;
+    for (const KineticStandinEntry* e = KineticStandinMap_First(Map);
+      e != NULL; e = KineticStandinMap_Next(e)) {
+        if (last != NULL) {
+            TEST_ASSERT_TRUE(KineticStandinMap_CompareKeys(last->key, e->key) < 0);
+        }
+        TEST_ASSERT_EQUAL_MEMORY(e->key.data, e->value.data, e->key.len);
+        last = e;
+        seen++;
+    }
+    TEST_ASSERT_EQUAL(KineticStandinMap_Count(Map), seen);
+    TEST_ASSERT_EQUAL_PTR(KineticStandinMap_Last(Map), last);
+
+    seen = 0;
+    for (const KineticStandinEntry* e = last; e != NULL; e = KineticStandinMap_Previous(e)) {
+        seen++;
+    }
+    TEST_ASSERT_EQUAL(KineticStandinMap_Count(Map), seen);
+}
@@ -0,0 +1,119 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "unity.h"
+#include "unity_helper.h"
+#include "kinetic_stats.h"
+#include "kinetic_types.h"
+#include <string.h>
+
+static KineticStats Stats;
+static KineticStats Snapshot;
+
+void setUp(void)
+{
+    memset(&Stats, 0, sizeof(Stats));
+    memset(&Snapshot, 0, sizeof(Snapshot));
+}
+
+void tearDown(void)
+{
+}
+
+void test_KineticStats_LatencyBucket_should_split_each_power_of_two_into_8_buckets(void)
+{
+    TEST_ASSERT_EQUAL(0, KineticStats_LatencyBucket(0));
+    TEST_ASSERT_EQUAL(7, KineticStats_LatencyBucket(7));
+    TEST_ASSERT_EQUAL(8, KineticStats_LatencyBucket(8));
+    TEST_ASSERT_EQUAL(15, KineticStats_LatencyBucket(15));
+    TEST_ASSERT_EQUAL(16, KineticStats_LatencyBucket(16));
+    TEST_ASSERT_EQUAL(16, KineticStats_LatencyBucket(17));
+    TEST_ASSERT_EQUAL(17, KineticStats_LatencyBucket(18));
+    TEST_ASSERT_EQUAL(63, KineticStats_LatencyBucket(1000));
+    TEST_ASSERT_EQUAL(KINETIC_LATENCY_BUCKETS - 1, KineticStats_LatencyBucket((1ull << 36) - 1));
+    TEST_ASSERT_EQUAL(KINETIC_LATENCY_BUCKETS - 1, KineticStats_LatencyBucket(UINT64_MAX));
+}
+
+void test_KineticStats_LatencyBucket_should_never_decrease_as_latency_grows(void)
+{
+    size_t last = 0;
+    for (uint64_t ns = 1; ns < (1ull << 40); ns = ns * 3 / 2 + 1) {
+        size_t bucket = KineticStats_LatencyBucket(ns);
+        TEST_ASSERT_TRUE(bucket >= last);
+        last = bucket;
+    }
+}
+
+void test_KineticStats_Record_should_count_by_message_type_and_status(void)
+{
+    KineticStats_Record(&Stats, KINETIC_MESSAGE_TYPE_PUT, KINETIC_STATUS_SUCCESS, 2000, 1100, 30);
+    KineticStats_Record(&Stats, KINETIC_MESSAGE_TYPE_PUT, KINETIC_STATUS_VERSION_MISMATCH, 1000, 1100, 30);
+
+    KineticOperationStats* put = &Stats.byType[KINETIC_MESSAGE_TYPE_PUT];
+    TEST_ASSERT_EQUAL(2, put->latency.count);
+    TEST_ASSERT_EQUAL(3000, put->latency.sumNanoseconds);
+    TEST_ASSERT_EQUAL(2000, put->latency.maxNanoseconds);
+    TEST_ASSERT_EQUAL(1, put->latency.buckets[KineticStats_LatencyBucket(1000)]);
+    TEST_ASSERT_EQUAL(1, put->latency.buckets[KineticStats_LatencyBucket(2000)]);
+    TEST_ASSERT_EQUAL(2200, put->bytesSent);
+    TEST_ASSERT_EQUAL(60, put->bytesReceived);
+    TEST_ASSERT_EQUAL(1, put->statusCounts[KINETIC_STATUS_SUCCESS]);
+    TEST_ASSERT_EQUAL(1, put->statusCounts[KINETIC_STATUS_VERSION_MISMATCH]);
+}
+
+void test_KineticStats_Record_should_count_unknown_types_and_statuses_as_invalid(void)
+{
+    KineticStats_Record(&Stats, (KineticMessageType)1000, KINETIC_STATUS_INVALID, 10, 0, 0);
+    KineticStats_Record(&Stats, KINETIC_MESSAGE_TYPE_GET, KINETIC_STATUS_COUNT, 10, 0, 0);
+
+    TEST_ASSERT_EQUAL(1, Stats.byType[KINETIC_MESSAGE_TYPE_INVALID].invalidStatusCount);
+    TEST_ASSERT_EQUAL(1, Stats.byType[KINETIC_MESSAGE_TYPE_GET].invalidStatusCount);
+}
+
+void test_KineticStats_Collect_should_accumulate_and_optionally_reset(void)
+{
+    KineticStats_Record(&Stats, KINETIC_MESSAGE_TYPE_GET, KINETIC_STATUS_SUCCESS, 500, 40, 1040);
+
+    KineticStats_Collect(&Stats, &Snapshot, false);
+    KineticStats_Collect(&Stats, &Snapshot, true);
+    TEST_ASSERT_EQUAL(2, Snapshot.byType[KINETIC_MESSAGE_TYPE_GET].latency.count);
+    TEST_ASSERT_EQUAL(2080, Snapshot.byType[KINETIC_MESSAGE_TYPE_GET].bytesReceived);
+    TEST_ASSERT_EQUAL(500, Snapshot.byType[KINETIC_MESSAGE_TYPE_GET].latency.maxNanoseconds);
+
+    static KineticStats zero;
+    TEST_ASSERT_EQUAL_MEMORY(&zero, &Stats, sizeof(Stats));
+}
+
+void test_KineticStats_Total_should_sum_all_message_types(void)
+{
+    KineticStats_Record(&Stats, KINETIC_MESSAGE_TYPE_GET, KINETIC_STATUS_SUCCESS, 500, 40, 1040);
+    KineticStats_Record(&Stats, KINETIC_MESSAGE_TYPE_DELETE, KINETIC_STATUS_NOT_FOUND, 700, 50, 30);
+    KineticStats_Collect(&Stats, &Snapshot, false);
+
+    KineticStats_Total(&Snapshot);
+
+    TEST_ASSERT_EQUAL(2, Snapshot.total.latency.count);
+    TEST_ASSERT_EQUAL(1200, Snapshot.total.latency.sumNanoseconds);
+    TEST_ASSERT_EQUAL(700, Snapshot.total.latency.maxNanoseconds);
+    TEST_ASSERT_EQUAL(90, Snapshot.total.bytesSent);
+    TEST_ASSERT_EQUAL(1070, Snapshot.total.bytesReceived);
+    TEST_ASSERT_EQUAL(1, Snapshot.total.statusCounts[KINETIC_STATUS_SUCCESS]);
+    TEST_ASSERT_EQUAL(1, Snapshot.total.statusCounts[KINETIC_STATUS_NOT_FOUND]);
+}
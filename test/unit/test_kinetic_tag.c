@@ -0,0 +1,125 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "unity.h"
+#include "unity_helper.h"
+#include "kinetic_tag.h"
+#include "kinetic_logger.h"
+#include "kinetic_types.h"
+#include <string.h>
+
+static const uint8_t Check[] = "123456789";
+
+void setUp(void)
+{
+    KineticLogger_Init("stdout", 3);
+}
+
+void tearDown(void)
+{
+    KineticLogger_Close();
+}
+
+static void assert_tag(KineticAlgorithm algorithm, const uint8_t* expected, size_t len)
+{
+    KineticTagContext ctx;
+    uint8_t tag[KINETIC_TAG_MAX_LEN];
+    TEST_ASSERT_EQUAL(len, KineticTag_Length(algorithm));
+    TEST_ASSERT_TRUE(KineticTag_Init(&ctx, algorithm));
+    TEST_ASSERT_TRUE(KineticTag_Update(&ctx, Check, sizeof(Check) - 1));
+    TEST_ASSERT_TRUE(KineticTag_Final(&ctx, tag));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, tag, len);
+}
+
+void test_KineticTag_should_compute_CRC32C_for_CRC32(void)
+{
+    const uint8_t expected[] = {0xe3, 0x06, 0x92, 0x83};
+    assert_tag(KINETIC_ALGORITHM_CRC32, expected, sizeof(expected));
+}
+
+void test_KineticTag_should_compute_CRC64_XZ_for_CRC64(void)
+{
+    const uint8_t expected[] = {0x99, 0x5d, 0xc9, 0xbb, 0xdf, 0x19, 0x39, 0xfa};
+    assert_tag(KINETIC_ALGORITHM_CRC64, expected, sizeof(expected));
+}
+
+void test_KineticTag_should_compute_SHA1(void)
+{
+    const uint8_t expected[] = {
+        0xf7, 0xc3, 0xbc, 0x1d, 0x80, 0x8e, 0x04, 0x73, 0x2a, 0xdf,
+        0x67, 0x99, 0x65, 0xcc, 0xc3, 0x4c, 0xa7, 0xae, 0x34, 0x41};
+    assert_tag(KINETIC_ALGORITHM_SHA1, expected, sizeof(expected));
+}
+
+void test_KineticTag_should_compute_SHA256_for_SHA2(void)
+{
+    const uint8_t expected[] = {
+        0x15, 0xe2, 0xb0, 0xd3, 0xc3, 0x38, 0x91, 0xeb, 0xb0, 0xf1, 0xef, 0x60, 0x9e, 0xc4, 0x19, 0x42,
+        0x0c, 0x20, 0xe3, 0x20, 0xce, 0x94, 0xc6, 0x5f, 0xbc, 0x8c, 0x33, 0x12, 0x44, 0x8e, 0xb2, 0x25};
+    assert_tag(KINETIC_ALGORITHM_SHA2, expected, sizeof(expected));
+}
+
+void test_KineticTag_should_compute_SHA3_256_for_SHA3(void)
+{
+    const uint8_t expected[] = {
+        0x87, 0xcd, 0x08, 0x4d, 0x19, 0x0e, 0x43, 0x6f, 0x14, 0x73, 0x22, 0xb9, 0x0e, 0x73, 0x84, 0xf6,
+        0xa8, 0xe0, 0x67, 0x6c, 0x99, 0xd2, 0x1e, 0xf5, 0x19, 0xea, 0x71, 0x8e, 0x51, 0xd4, 0x5f, 0x9c};
+    assert_tag(KINETIC_ALGORITHM_SHA3, expected, sizeof(expected));
+}
+
+void test_KineticTag_Init_should_reject_unsupported_algorithms(void)
+{
+    KineticTagContext ctx;
+    TEST_ASSERT_EQUAL(0, KineticTag_Length(KINETIC_ALGORITHM_INVALID));
+    TEST_ASSERT_FALSE(KineticTag_Init(&ctx, KINETIC_ALGORITHM_INVALID));
+}
+
+static uint8_t Src[100003];
+static uint8_t Dst[sizeof(Src)];
+
+void test_KineticTag_CopyAndUpdate_should_copy_and_match_a_separate_pass(void)
+{
+    const KineticAlgorithm algorithms[] = {
+        KINETIC_ALGORITHM_CRC32, KINETIC_ALGORITHM_CRC64, KINETIC_ALGORITHM_SHA2};
+    for (size_t i = 0; i < sizeof(Src); i++) {
+        Src[i] = (uint8_t)(i * 31 + (i >> 8));
+    }
+
+    for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+        // Unaligned, spanning several copy chunks
+        for (size_t offset = 0; offset < 3; offset++) {
+            KineticTagContext separate, fused;
+            uint8_t expected[KINETIC_TAG_MAX_LEN], actual[KINETIC_TAG_MAX_LEN];
+            size_t len = sizeof(Src) - offset;
+            memset(Dst, 0, sizeof(Dst));
+
+            TEST_ASSERT_TRUE(KineticTag_Init(&separate, algorithms[a]));
+            TEST_ASSERT_TRUE(KineticTag_Update(&separate, &Src[offset], len));
+            TEST_ASSERT_TRUE(KineticTag_Final(&separate, expected));
+
+            TEST_ASSERT_TRUE(KineticTag_Init(&fused, algorithms[a]));
+            TEST_ASSERT_TRUE(KineticTag_CopyAndUpdate(&fused, Dst, &Src[offset], len));
+            TEST_ASSERT_TRUE(KineticTag_Final(&fused, actual));
+
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, actual, KineticTag_Length(algorithms[a]));
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(&Src[offset], Dst, len);
+        }
+    }
+}
@@ -0,0 +1,158 @@
+/*
+* kinetic-c
+* Copyright (C) 2015 Seagate Technology.
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "unity.h"
+#include "unity_helper.h"
+#include "kinetic_trace.h"
+#include "kinetic.pb-c.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#define PUT COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__PUT
+#define GET COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET
+
+static char Output[8192];
+
+void setUp(void)
+{
+    KineticTrace_Reset();
+}
+
+void tearDown(void)
+{
+    KineticTrace_Enable(false);
+}
+
+static const char* export(bool (*write)(FILE*))
+{
+    FILE* out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_TRUE(write(out));
+    rewind(out);
+    size_t len = fread(Output, 1, sizeof(Output) - 1, out);
+    Output[len] = '\0';
+    fclose(out);
+    return Output;
+}
+
+void test_KineticTrace_Enable_should_toggle_recording(void)
+{
+    TEST_ASSERT_FALSE(KineticTraceEnabled);
+    KineticTrace_Enable(true);
+    TEST_ASSERT_TRUE(KineticTraceEnabled);
+    KineticTrace_Enable(false);
+    TEST_ASSERT_FALSE(KineticTraceEnabled);
+}
+
+void test_KineticTrace_WriteChromeJSON_should_export_spans_as_complete_events(void)
+{
+    KineticTrace_Record(KINETIC_TRACE_PACK, 7, 42, PUT, 1000000, 1003000);
+    KineticTrace_Record(KINETIC_TRACE_SOCKET_WRITE, 7, 42, PUT, 1004000, 1010500);
+
+    const char* json = export(KineticTrace_WriteChromeJSON);
+
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"traceEvents\":["));
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"name\":\"pack\",\"cat\":\"PUT\",\"ph\":\"X\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"ts\":0.000,\"dur\":3.000,\"args\":{\"fd\":7,\"seq\":42}"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"name\":\"socket_write\",\"cat\":\"PUT\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"ts\":4.000,\"dur\":6.500"));
+}
+
+void test_KineticTrace_WriteFolded_should_nest_HMAC_within_packing(void)
+{
+    KineticTrace_Record(KINETIC_TRACE_PACK, 7, 1, PUT, 0, 5000);
+    KineticTrace_Record(KINETIC_TRACE_HMAC, 7, 1, PUT, 1000, 3000);
+    KineticTrace_Record(KINETIC_TRACE_CALLBACK, 7, 2, GET, 0, 700);
+
+    const char* folded = export(KineticTrace_WriteFolded);
+
+    TEST_ASSERT_NOT_NULL(strstr(folded, "kinetic-c;PUT;pack 3000\n"));
+    TEST_ASSERT_NOT_NULL(strstr(folded, "kinetic-c;PUT;pack;hmac 2000\n"));
+    TEST_ASSERT_NOT_NULL(strstr(folded, "kinetic-c;GET;callback 700\n"));
+}
+
+void test_KineticTrace_should_resolve_message_types_of_bus_spans_from_their_request(void)
+{
+    KineticTrace_Record(KINETIC_TRACE_SOCKET_WRITE, 9, 3, GET, 0, 100);
+    KineticTrace_Record(KINETIC_TRACE_QUEUE_WAIT, 9, 3, KINETIC_TRACE_TYPE_UNKNOWN, 200, 450);
+    KineticTrace_Record(KINETIC_TRACE_QUEUE_WAIT, 9, 4, KINETIC_TRACE_TYPE_UNKNOWN, 300, 400);
+
+    const char* folded = export(KineticTrace_WriteFolded);
+
+    TEST_ASSERT_NOT_NULL(strstr(folded, "kinetic-c;GET;queue_wait 250\n"));
+    TEST_ASSERT_NOT_NULL(strstr(folded, "kinetic-c;UNKNOWN;queue_wait 100\n"));
+}
+
+void test_KineticTrace_Reset_should_discard_recorded_spans(void)
+{
+    KineticTrace_Record(KINETIC_TRACE_BUILD, 7, 1, PUT, 0, 100);
+    KineticTrace_Reset();
+
+    const char* folded = export(KineticTrace_WriteFolded);
+
+    TEST_ASSERT_EQUAL_STRING("", folded);
+}
+
+void test_KineticTrace_should_retain_only_the_most_recent_spans(void)
+{
+    for (int64_t seq = 0; seq < 10000; seq++) {
+        KineticTrace_Record(KINETIC_TRACE_BUILD, 7, seq, PUT, 0, 1);
+    }
+
+    const char* folded = export(KineticTrace_WriteFolded);
+
+    unsigned long long retained = 0;
+    TEST_ASSERT_EQUAL(1, sscanf(folded, "kinetic-c;PUT;build %llu", &retained));
+    TEST_ASSERT_TRUE(retained >= 4000);
+    TEST_ASSERT_TRUE(retained < 10000);
+}
+
+static void* record_one_span(void* arg)
+{
+    int64_t seq = (int64_t)(intptr_t)arg;
+    KineticTrace_Record(KINETIC_TRACE_CALLBACK, 9, seq, GET, 2000 * seq, 2000 * seq + 1000);
+    return NULL;
+}
+
+void test_KineticTrace_should_keep_spans_of_exited_threads_whose_rings_are_reused(void)
+{
+    // One thread after another, as the threadpool retires and starts workers
+    for (intptr_t seq = 1; seq <= 3; seq++) {
+        pthread_t thread;
+        TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, record_one_span, (void*)seq));
+        TEST_ASSERT_EQUAL(0, pthread_join(thread, NULL));
+    }
+
+    const char* json = export(KineticTrace_WriteChromeJSON);
+
+    unsigned tids[3];
+    const char* p = json;
+    for (int i = 0; i < 3; i++) {
+        p = strstr(p, "{\"name\":\"callback\"");
+        TEST_ASSERT_NOT_NULL(p);
+        TEST_ASSERT_NOT_NULL(strstr(p, "\"tid\":"));
+        TEST_ASSERT_EQUAL(1, sscanf(strstr(p, "\"tid\":"), "\"tid\":%u", &tids[i]));
+        p++;
+    }
+    TEST_ASSERT_TRUE(tids[0] != tids[1]);
+    TEST_ASSERT_TRUE(tids[1] != tids[2]);
+    TEST_ASSERT_TRUE(tids[0] != tids[2]);
+}
@@ -90,4 +90,31 @@ void test_Kinetic_GetStatusDescription_should_return_appropriate_descriptions(vo
     TEST_ASSERT_EQUAL_STRING("DEVICE_NAME_REQUIRED", Kinetic_GetStatusDescription(KINETIC_STATUS_DEVICE_NAME_REQUIRED));
     TEST_ASSERT_EQUAL_STRING("INVALID_LOG_TYPE", Kinetic_GetStatusDescription(KINETIC_STATUS_INVALID_LOG_TYPE));
     TEST_ASSERT_EQUAL_STRING("SESSION_TERMINATED", Kinetic_GetStatusDescription(KINETIC_STATUS_SESSION_TERMINATED));
+    TEST_ASSERT_EQUAL_STRING("TAG_MISMATCH", Kinetic_GetStatusDescription(KINETIC_STATUS_TAG_MISMATCH));
+}
+
+void test_KineticMessageType_GetName_should_return_the_name_of_each_type(void)
+{
+    TEST_ASSERT_EQUAL_STRING("<UNKNOWN>", KineticMessageType_GetName(KINETIC_MESSAGE_TYPE_INVALID));
+    TEST_ASSERT_EQUAL_STRING("GET_RESPONSE", KineticMessageType_GetName(KINETIC_MESSAGE_TYPE_GET_RESPONSE));
+    TEST_ASSERT_EQUAL_STRING("PUT", KineticMessageType_GetName(KINETIC_MESSAGE_TYPE_PUT));
+    TEST_ASSERT_EQUAL_STRING("MEDIAOPTIMIZE", KineticMessageType_GetName(KINETIC_MESSAGE_TYPE_MEDIAOPTIMIZE));
+}
+
+void test_KineticLatencyHistogram_Percentile_should_return_the_bound_of_the_bucket_holding_the_percentile(void)
+{
+    static KineticLatencyHistogram histogram;
+    memset(&histogram, 0, sizeof(histogram));
+    TEST_ASSERT_EQUAL(0, KineticLatencyHistogram_Percentile(&histogram, 50.0));
+
+    // 90 latencies of 5ns, 10 in the 960..1023ns bucket
+    histogram.count = 100;
+    histogram.buckets[5] = 90;
+    histogram.buckets[63] = 10;
+    histogram.maxNanoseconds = 1010;
+
+    TEST_ASSERT_EQUAL(5, KineticLatencyHistogram_Percentile(&histogram, 50.0));
+    TEST_ASSERT_EQUAL(5, KineticLatencyHistogram_Percentile(&histogram, 90.0));
+    TEST_ASSERT_EQUAL(1010, KineticLatencyHistogram_Percentile(&histogram, 99.0));
+    TEST_ASSERT_EQUAL(1010, KineticLatencyHistogram_Percentile(&histogram, 100.0));
 }
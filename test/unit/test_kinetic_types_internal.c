@@ -221,6 +221,22 @@ void test_KineticLogInfo_Type_to_Com__Seagate__Kinetic__Proto__Command__GetLog__
         KineticLogInfo_Type_to_Com__Seagate__Kinetic__Proto__Command__GetLog__Type((KineticLogInfo_Type)1000));
 }
 
+void test_Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType_should_map_across_the_gaps_in_the_protocol_numbering(void)
+{
+    TEST_ASSERT_EQUAL(KINETIC_MESSAGE_TYPE_GET,
+        Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType(COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GET));
+    TEST_ASSERT_EQUAL(KINETIC_MESSAGE_TYPE_GETKEYRANGE,
+        Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType(COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETKEYRANGE));
+    TEST_ASSERT_EQUAL(KINETIC_MESSAGE_TYPE_GETVERSION,
+        Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType(COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__GETVERSION));
+    TEST_ASSERT_EQUAL(KINETIC_MESSAGE_TYPE_NOOP,
+        Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType(COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__NOOP));
+    TEST_ASSERT_EQUAL(KINETIC_MESSAGE_TYPE_MEDIAOPTIMIZE,
+        Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType(COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__MEDIAOPTIMIZE));
+    TEST_ASSERT_EQUAL(KINETIC_MESSAGE_TYPE_INVALID,
+        Com__Seagate__Kinetic__Proto__Command__MessageType_to_KineticMessageType(COM__SEAGATE__KINETIC__PROTO__COMMAND__MESSAGE_TYPE__INVALID_MESSAGE_TYPE));
+}
+
 void test_Copy_Com__Seagate__Kinetic__Proto__Command__Range_to_ByteBufferArray_should_copy_keys_into_byte_buffers(void)
 {
     ByteBuffer buffers[5];